@@ -0,0 +1,610 @@
+/****************************************************************************
+* File name: mb_bench.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  Micro benchmarks for the individual phases of the MB compute engine.
+*  Results are written to stdout as JSON (ns/op, allocations/op, bytes/op,
+*  regex constructions/op and regex runs/op) so that they can be compared
+*  across commits.
+*
+*  Usage: mb_bench [--min-time-ms=N] [--filter=name]
+****************************************************************************/
+
+/* Includes */
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <cstdlib>
+#include <cmath>
+#include <filesystem>
+
+/* Custom libraries */
+#include "mbcomputengine_lib.hpp"
+#include "mbcct_lib.hpp"
+#include "mbclog_lib.hpp"
+#include "mbcjournal_lib.hpp"
+#include "mbcsupport_lib.hpp"
+/* Count the allocations of the benchmark cases */
+#include "mbcprofiler_alloc.hpp"
+
+/* Structure to hold a single benchmark case */
+struct BenchCase{
+    /* Name of the benchmarked operation */
+    std::string name;
+    /* Parameters of this case as a JSON object */
+    std::string params;
+    /* Called (untimed) before every timed batch with the batch size */
+    std::function<void(std::size_t)> prepare;
+    /* The timed operation, called with the iteration index */
+    std::function<void(std::size_t)> op;
+};
+
+/* Structure to hold the measured result of a benchmark case */
+struct BenchResult{
+    std::size_t iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+    double regex_built_per_op;
+    double regex_runs_per_op;
+};
+
+/* Results of the cases that the compiler could otherwise optimise away */
+volatile double bench_sink = 0;
+
+/* Expression generator
+*  Builds an expression with `length` operands, `si_density` is the fraction
+*  of numeric operands that carry an SI prefix and `var_names` (if any) are
+*  used in place of every other operand.
+*  The generator is deterministic so results are comparable across runs.
+*/
+std::string make_expr(std::size_t length, double si_density, const std::vector<std::string>& var_names = {}){
+    static const char oops[] = {'+', '-', '*', '/'};
+    static const char prefixes[] = {'k', 'm', 'M', 'u', 'n', 'G'};
+    std::string expr;
+    std::size_t si_added = 0;
+    for (std::size_t index = 0; index < length; ++index){
+        if (index != 0)
+            expr += oops[index%4];
+        if (!var_names.empty() && (index%2 == 1 || var_names.size() >= length))
+            expr += var_names[index%var_names.size()];
+        else{
+            expr += std::to_string(index%97+1)+"."+std::to_string(index%7+1);
+            /* Spread the SI prefixes evenly over the numeric operands */
+            if (static_cast<double>(si_added) < si_density*static_cast<double>(index+1)){
+                expr += prefixes[si_added%6];
+                ++si_added;
+            }
+        }
+    }
+    return expr;
+}
+
+/* Relative error of the postfix program on T when adding 0.1 1024 times (the exact sum is 102.4) */
+template<typename T>
+double precision_error(void){
+    std::string expr = "0.1";
+    for (std::size_t index = 1; index < 1024; ++index)
+        expr += "+0.1";
+    mbc::Evaluator parsed;
+    parsed.parseExpr(expr);
+    parsed.convertToPostfix();
+    mbc::BasicProgram<T> program;
+    program.compile(parsed.getPostfixBuffer());
+    return static_cast<double>(std::abs((static_cast<long double>(program.run())-102.4L)/102.4L));
+}
+
+/* Adds the precisionRun case of T, a 64 operand program whose first operand changes every iteration */
+template<typename T>
+void add_precision_case(std::vector<BenchCase>& cases, const std::string& type_name){
+    mbc::Evaluator parsed;
+    parsed.parseExpr("x+"+make_expr(63, 0));
+    parsed.convertToPostfix();
+    auto program = std::make_shared<mbc::BasicProgram<T>>();
+    program->compile(parsed.getPostfixBuffer(), {"x"});
+    std::ostringstream params;
+    params << "{\"type\": \"" << type_name << "\", \"length\": 64, \"sum_rel_error\": " << precision_error<T>() << "}";
+    cases.push_back({"precisionRun", params.str(), [](std::size_t){},
+        [program](std::size_t index){
+            T input = static_cast<T>(index);
+            bench_sink = static_cast<double>(program->run(&input));
+        }});
+}
+
+/* Operator mixes for the postfix evaluation benchmarks */
+struct OperatorMix{
+    std::string name;
+    std::vector<std::string> oops;
+};
+
+/* Builds an expression with `length` operands joined by the operators of the given mix in turn
+* Small integer operands are used so the bitwise and logical operators see meaningful values.
+*/
+std::string make_mix_expr(std::size_t length, const OperatorMix& mix){
+    std::string expr;
+    for (std::size_t index = 0; index < length; ++index){
+        if (index != 0)
+            expr += mix.oops[index%mix.oops.size()];
+        expr += std::to_string(index%7+1);
+    }
+    return expr;
+}
+
+/* Run a benchmark case, doubling the batch size until the minimum time is reached
+* Allocations and regex usage are read from the engine's resource counters.
+*/
+BenchResult run_case(BenchCase& bench_case, double min_time_ns){
+    std::size_t batch = 1;
+    while (true){
+        bench_case.prepare(batch);
+        mbc::ResourceCounters start_resources = mbc::resourceCounters();
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t index = 0; index < batch; ++index)
+            bench_case.op(index);
+        auto stop = std::chrono::steady_clock::now();
+        mbc::ResourceCounters used = mbc::resourceCounters()-start_resources;
+        double elapsed = std::chrono::duration<double, std::nano>(stop-start).count();
+        if (elapsed >= min_time_ns || batch >= (std::size_t(1) << 24)){
+            BenchResult result;
+            result.iterations = batch;
+            result.ns_per_op = elapsed/batch;
+            result.allocs_per_op = static_cast<double>(used.allocs)/batch;
+            result.bytes_per_op = static_cast<double>(used.bytes)/batch;
+            result.regex_built_per_op = static_cast<double>(used.regex_built)/batch;
+            result.regex_runs_per_op = static_cast<double>(used.regex_runs)/batch;
+            return result;
+        }
+        batch *= 2;
+    }
+}
+
+/* Defines `count` variables named v0..vN in the given engine and returns their names */
+std::vector<std::string> define_vars(mbc::Engine& eng, std::size_t count){
+    std::vector<std::string> names;
+    for (std::size_t index = 0; index < count; ++index){
+        names.push_back("v"+std::to_string(index));
+        eng.load(names.back()+"="+std::to_string(index+1)+".5");
+        eng.eval();
+    }
+    return names;
+}
+
+/* Defines a chain of functions f1..fN where each one calls the previous and returns the outer call
+* Note that the definition check rejects bare integer literals in function bodies, hence the decimals.
+*/
+std::string define_fun_chain(mbc::Engine& eng, std::size_t depth){
+    eng.load("f1(x) : x*2.5+1.5");
+    eng.eval();
+    for (std::size_t index = 2; index <= depth; ++index){
+        eng.load("f"+std::to_string(index)+"(x) : f"+std::to_string(index-1)+"(x)+1.5");
+        eng.eval();
+    }
+    return "f"+std::to_string(depth)+"(1.5)";
+}
+
+int main(int argc, char *argv[]){
+    /* Handle CLI flags and options */
+    mbcs::CLIParser CLIparser(argc, argv);
+    double min_time_ms = 200;
+    std::string filter = "";
+    if (CLIparser.cmdOptionExists("--min-time-ms"))
+        min_time_ms = std::atof(CLIparser.getCmdOption("--min-time-ms").substr(14).c_str());
+    if (CLIparser.cmdOptionExists("--filter"))
+        filter = CLIparser.getCmdOption("--filter").substr(9);
+
+    /* Programs are only compiled to native code by the cases measuring the JIT
+    * so that the other cases keep measuring the interpreter and the VM.
+    */
+    mbc::setJitThreshold(0);
+
+    /* Parameter sweeps */
+    const std::vector<std::size_t> lengths{4, 16, 64, 256};
+    const std::vector<double> si_densities{0, 0.25, 0.5, 1};
+    const std::vector<std::size_t> var_counts{1, 8, 64};
+    const std::vector<std::size_t> depths{1, 2, 4, 8};
+    const std::vector<OperatorMix> mixes{
+        {"arithmetic", {"+", "-", "*", "/"}},
+        {"power", {"**", "%", "+"}},
+        {"bitwise", {"&", "|", "^", "<<", ">>"}},
+        {"logical", {"<", ">", "==", "!=", "&&", "||", "^^"}},
+        {"mixed", {"+", "*", "<", "&", "-", "||", "/", "^"}}
+    };
+
+    /* Shared state for the cases below */
+    std::vector<mbc::Evaluator> evaluators;
+    std::vector<BenchCase> cases;
+
+    /* Evaluator::parseExpr over expression length and SI literal density */
+    for (std::size_t length : lengths)
+        for (double si_density : si_densities){
+            std::string expr = make_expr(length, si_density);
+            cases.push_back({"parseExpr",
+                "{\"length\": "+std::to_string(length)+", \"si_density\": "+std::to_string(si_density)+"}",
+                [&evaluators](std::size_t batch){ evaluators.assign(batch, mbc::Evaluator()); },
+                [&evaluators, expr](std::size_t index){ evaluators[index].parseExpr(expr); }});
+        }
+
+    /* Evaluator::convertToPostfix over expression length */
+    for (std::size_t length : lengths){
+        std::string expr = make_expr(length, 0);
+        cases.push_back({"convertToPostfix",
+            "{\"length\": "+std::to_string(length)+"}",
+            [&evaluators, expr](std::size_t batch){
+                mbc::Evaluator parsed;
+                parsed.parseExpr(expr);
+                evaluators.assign(batch, parsed);
+            },
+            [&evaluators](std::size_t index){ evaluators[index].convertToPostfix(); }});
+    }
+
+    /* Evaluator::evaluatePostfix over expression length
+    * Every iteration evaluates a fresh copy so the bytecode compilation is included as it is in Engine::eval.
+    */
+    for (std::size_t length : lengths){
+        std::string expr = make_expr(length, 0);
+        cases.push_back({"evaluatePostfix",
+            "{\"length\": "+std::to_string(length)+"}",
+            [&evaluators, expr](std::size_t batch){
+                mbc::Evaluator parsed;
+                parsed.parseExpr(expr);
+                parsed.convertToPostfix();
+                evaluators.assign(batch, parsed);
+            },
+            [&evaluators](std::size_t index){ evaluators[index].evaluatePostfix(); }});
+    }
+
+    /* Repeated evaluation on the bytecode VM (Evaluator::evaluatePostfix) against the
+    * string interpreter (Evaluator::interpretPostfix) per operator mix.
+    * The program is compiled in the untimed prepare step, see the evaluatePostfix cases for the cost including compilation.
+    */
+    for (const OperatorMix& mix : mixes)
+        for (const std::string name : {"vm", "interpreter"}){
+            std::string expr = make_mix_expr(64, mix);
+            bool flag_vm = name == "vm";
+            cases.push_back({"postfixMix",
+                "{\"mix\": \""+mix.name+"\", \"length\": 64, \"backend\": \""+name+"\"}",
+                [&evaluators, expr, flag_vm](std::size_t){
+                    evaluators.assign(1, mbc::Evaluator());
+                    evaluators[0].parseExpr(expr);
+                    evaluators[0].convertToPostfix();
+                    if (flag_vm)
+                        evaluators[0].getProgram();
+                },
+                [&evaluators, flag_vm](std::size_t){
+                    if (flag_vm)
+                        evaluators[0].evaluatePostfix();
+                    else
+                        evaluators[0].interpretPostfix();
+                }});
+        }
+
+    /* Compiled programs on the bytecode VM against native code per operator mix (Linux x86-64 only) */
+    if (mbc::jitSupported())
+        for (const OperatorMix& mix : mixes)
+            for (const std::string name : {"vm", "jit"}){
+                std::string expr = make_mix_expr(64, mix);
+                auto program = std::make_shared<mbc::Program>();
+                cases.push_back({"programRun",
+                    "{\"mix\": \""+mix.name+"\", \"length\": 64, \"backend\": \""+name+"\"}",
+                    [program, expr, name](std::size_t){
+                        mbc::Evaluator parsed;
+                        parsed.parseExpr(expr);
+                        parsed.convertToPostfix();
+                        program->compile(parsed.getPostfixBuffer());
+                        if (name == "jit")
+                            program->jit();
+                    },
+                    [program](std::size_t){ program->run(); }});
+            }
+
+    /* The same program run by the bytecode VM on float, double and long double registers,
+    * the parameters also hold the accuracy of each type on a long sum of 0.1.
+    */
+    add_precision_case<float>(cases, "float");
+    add_precision_case<double>(cases, "double");
+    add_precision_case<long double>(cases, "longdouble");
+
+#if __cplusplus >= 202002L
+    /* A fixed formula parsed at compile time (mbc::ct::expr) against the same formula
+    * written by hand and compiled for the bytecode VM, the inputs change every iteration.
+    */
+    {
+        static constexpr mbc::ct::expr<"a*2k+b*c-a/b"> ct_formula;
+        mbc::Evaluator parsed;
+        parsed.parseExpr("a*2k+b*c-a/b");
+        parsed.convertToPostfix();
+        auto program = std::make_shared<mbc::Program>();
+        program->compile(parsed.getPostfixBuffer(), {"a", "b", "c"});
+        cases.push_back({"ctExpr", "{\"backend\": \"ct\"}", [](std::size_t){},
+            [](std::size_t index){ double value = static_cast<double>(index); bench_sink = ct_formula(value, value+1.5, 0.5); }});
+        cases.push_back({"ctExpr", "{\"backend\": \"native\"}", [](std::size_t){},
+            [](std::size_t index){ double value = static_cast<double>(index); bench_sink = value*(2*1E+3)+(value+1.5)*0.5-value/(value+1.5); }});
+        cases.push_back({"ctExpr", "{\"backend\": \"vm\"}", [](std::size_t){},
+            [program](std::size_t index){
+                double inputs[3] = {static_cast<double>(index), static_cast<double>(index)+1.5, 0.5};
+                bench_sink = program->run(inputs);
+            }});
+    }
+#endif
+
+    /* The same formula built with the expression DSL (Engine::evaluate) against the text assembled and run through Engine::eval */
+    {
+        auto eng = std::make_shared<mbc::Engine>();
+        define_vars(*eng, 2);
+        define_fun_chain(*eng, 1);
+        auto plan = std::make_shared<mbc::Plan>(mbc::var("v0")*2.5+mbc::fn("f1")(mbc::var("v1"))/mbc::fn("sin")(mbc::var("v0")));
+        cases.push_back({"planEval", "{\"backend\": \"plan\"}", [](std::size_t){},
+            [eng, plan](std::size_t){ bench_sink = eng->evaluate(*plan); }});
+        cases.push_back({"planEval", "{\"backend\": \"text\"}", [](std::size_t){},
+            [eng](std::size_t){
+                eng->load("v0*"+std::to_string(2.5)+"+f1(v1)/sin(v0)");
+                eng->eval();
+            }});
+    }
+
+    /* Root finding with the solve builtin against the loop an external script runs, 20 Newton
+    * iterations of two Engine::eval calls each (the derivative is a finite difference).
+    */
+    {
+        auto eng = std::make_shared<mbc::Engine>();
+        eng->load("g(x) : cos(x)-x*0.5+x*x*0.1");
+        eng->eval();
+        cases.push_back({"solve", "{\"backend\": \"builtin\"}", [](std::size_t){},
+            [eng](std::size_t){ eng->load("solve(g,1.5)"); eng->eval(); }});
+        cases.push_back({"solve", "{\"backend\": \"script\"}", [](std::size_t){},
+            [eng](std::size_t){
+                double x = 1.5;
+                for (std::size_t iteration = 0; iteration < 20; ++iteration){
+                    eng->load("g("+std::to_string(x)+")");
+                    eng->eval();
+                    double value = std::atof(eng->getResult().c_str());
+                    eng->load("g("+std::to_string(x+1E-4)+")");
+                    eng->eval();
+                    double slope = (std::atof(eng->getResult().c_str())-value)/1E-4;
+                    x -= slope != 0 ? value/slope : 0;
+                }
+                bench_sink = x;
+            }});
+    }
+
+    /* Reductions inside the engine on one thread and on every core (the results are identical) */
+    for (unsigned int threads : {1u, 0u}){
+        auto eng = std::make_shared<mbc::Engine>();
+        cases.push_back({"reduce", "{\"kind\": \"sum\", \"terms\": 1000000, \"threads\": "+std::to_string(threads)+"}",
+            [threads](std::size_t){ mbc::setReduceThreads(threads); },
+            [eng](std::size_t){ eng->evalFunctions("sum(i,1,1E+6,1/i)"); }});
+        cases.push_back({"reduce", "{\"kind\": \"integrate\", \"threads\": "+std::to_string(threads)+"}",
+            [threads](std::size_t){ mbc::setReduceThreads(threads); },
+            [eng](std::size_t){ eng->evalFunctions("integrate(x,0,100,sin(x)*x)"); }});
+    }
+
+    /* A piecewise sum whose expensive branch is taken for one term in 100: if() only runs the branch
+    * it takes against the same sum written with masks (both branches run for every term).
+    */
+    {
+        auto eng = std::make_shared<mbc::Engine>();
+        cases.push_back({"conditional", "{\"kind\": \"if\", \"terms\": 1000000}", [](std::size_t){ mbc::setReduceThreads(1); },
+            [eng](std::size_t){ eng->evalFunctions("sum(i,1,1E+6,if(i%100==0,sin(i)*cos(i)+ln(i)*tanh(i),i))"); }});
+        cases.push_back({"conditional", "{\"kind\": \"mask\", \"terms\": 1000000}", [](std::size_t){ mbc::setReduceThreads(1); },
+            [eng](std::size_t){ eng->evalFunctions("sum(i,1,1E+6,(i%100==0)*(sin(i)*cos(i)+ln(i)*tanh(i))+(i%100!=0)*i)"); }});
+    }
+
+    /* Sweep of a grid streamed to a sink on one thread and on every core */
+    for (unsigned int threads : {1u, 0u}){
+        auto eng = std::make_shared<mbc::Engine>();
+        eng->setSweepSink([](const double* rows, std::size_t row_count, std::size_t column_count){
+            bench_sink = rows[row_count*column_count-1];
+        });
+        cases.push_back({"sweep", "{\"points\": 1000001, \"threads\": "+std::to_string(threads)+"}",
+            [threads](std::size_t){ mbc::setReduceThreads(threads); },
+            [eng](std::size_t){
+                eng->load("sweep x=0:1E-6:1 : sin(x)*x+1");
+                eng->eval();
+            }});
+    }
+
+    /* A vector of 65536 elements: the program run element-wise (BasicProgram::map) against one run per
+    * element, the sum of the elements and a whole line of vectors evaluated by the engine.
+    */
+    {
+        const std::size_t element_count = 65536;
+        auto elements = std::make_shared<std::vector<double>>(element_count);
+        auto results = std::make_shared<std::vector<double>>(element_count);
+        for (std::size_t index = 0; index < element_count; ++index)
+            (*elements)[index] = static_cast<double>(index)*1E-3;
+        mbc::Evaluator parsed;
+        parsed.parseExpr("(x*2.5+1)*x-x/3");
+        parsed.convertToPostfix();
+        auto program = std::make_shared<mbc::Program>();
+        program->compile(parsed.getPostfixBuffer(), {"x"});
+        const std::string params = ", \"elements\": "+std::to_string(element_count)+"}";
+        cases.push_back({"vector", "{\"kind\": \"map\""+params, [](std::size_t){},
+            [program, elements, results](std::size_t){
+                const double* inputs[1] = {elements->data()};
+                program->map(inputs, elements->size(), results->data());
+                bench_sink = results->back();
+            }});
+        cases.push_back({"vector", "{\"kind\": \"run\""+params, [](std::size_t){},
+            [program, elements, results](std::size_t){
+                for (std::size_t index = 0; index < elements->size(); ++index)
+                    (*results)[index] = program->run(&(*elements)[index]);
+                bench_sink = results->back();
+            }});
+        cases.push_back({"vector", "{\"kind\": \"sum\""+params, [](std::size_t){},
+            [elements](std::size_t){ bench_sink = mbc::vectorSum(elements->data(), elements->size()); }});
+        auto eng = std::make_shared<mbc::Engine>();
+        eng->_vecValues["v"] = *elements;
+        cases.push_back({"vector", "{\"kind\": \"eval\""+params, [](std::size_t){},
+            [eng](std::size_t){
+                eng->load("w=(v*2.5+1)*v-v/3");
+                eng->eval();
+                bench_sink = static_cast<double>(eng->getResult().size());
+            }});
+    }
+
+    /* Session startup from a library of definitions, replayed through Engine::eval or restored from a snapshot */
+    {
+        std::vector<std::string> library;
+        for (std::size_t index = 0; index < 500; ++index){
+            library.push_back("lib_f"+std::to_string(index)+"(x, y) : x*y+x");
+            library.push_back("lib_c"+std::to_string(index)+" = "+std::to_string(index)+".5");
+        }
+        const std::string snapshot_file = (std::filesystem::temp_directory_path()/"mb_bench.snap").string();
+        mbc::Engine library_eng;
+        for (const std::string& line : library)
+            library_eng.load(line).eval();
+        library_eng.saveSnapshot(snapshot_file);
+        cases.push_back({"snapshot", "{\"kind\": \"replay\", \"definitions\": 1000}", [](std::size_t){},
+            [library](std::size_t){
+                mbc::Engine eng;
+                for (const std::string& line : library)
+                    eng.load(line).eval();
+                bench_sink = static_cast<double>(eng.getResult().size());
+            }});
+        cases.push_back({"snapshot", "{\"kind\": \"load\", \"definitions\": 1000}", [](std::size_t){},
+            [snapshot_file](std::size_t){
+                mbc::Engine eng;
+                bench_sink = eng.loadSnapshot(snapshot_file);
+            }});
+    }
+
+    /* Replay of a journal of a session, every result is verified */
+    {
+        const std::string journal_file = (std::filesystem::temp_directory_path()/"mb_bench.journal").string();
+        {
+            mbc::Engine journal_eng;
+            mbc::JournalWriter writer;
+            writer.open(journal_file);
+            std::vector<std::string> session{"a = 0.5", "b = a*3+1", "f(x, y) : x*y+x", "f(a, b)", "sin(a)**2+cos(b)**2", "a = f(b, a)"};
+            for (std::size_t index = 0; index < 200; ++index){
+                const std::string& line = session[index%session.size()];
+                const auto start = std::chrono::steady_clock::now();
+                journal_eng.load(line).eval();
+                writer.append(mbc::makeJournalEntry(journal_eng, line, std::chrono::system_clock::now(), std::chrono::steady_clock::now()-start));
+            }
+            writer.close();
+        }
+        cases.push_back({"journal", "{\"kind\": \"replay\", \"entries\": 200}", [](std::size_t){},
+            [journal_file](std::size_t){
+                mbc::Engine eng;
+                bench_sink = static_cast<double>(mbc::replayJournal(eng, journal_file, [](std::size_t, const mbc::JournalEntry&, const mbc::JournalEntry&){}).mismatches);
+            }});
+    }
+
+    /* One line of console output written to the log file, flushed on every line or queued for the background writer */
+    {
+        const std::string log_file = (std::filesystem::temp_directory_path()/"mb_bench.log").string();
+        const std::string log_line = "MB> f(a)+sin(b)*2\n";
+        auto sync_log = std::make_shared<std::ofstream>();
+        auto async_log = std::make_shared<mbc::AsyncLogWriter>();
+        cases.push_back({"log", "{\"kind\": \"sync\"}",
+            [sync_log, log_file](std::size_t){ if (!sync_log->is_open()) sync_log->open(log_file); },
+            [sync_log, log_line](std::size_t){ *sync_log << log_line << std::flush; }});
+        cases.push_back({"log", "{\"kind\": \"async\"}",
+            [async_log, log_file](std::size_t){ if (!async_log->isOpen()) async_log->open(log_file); },
+            [async_log, log_line](std::size_t){ async_log->write(log_line); }});
+    }
+
+    /* Engine::replaceVars over variable count */
+    for (std::size_t var_count : var_counts){
+        auto eng = std::make_shared<mbc::Engine>();
+        std::string expr = make_expr(64, 0, define_vars(*eng, var_count));
+        cases.push_back({"replaceVars",
+            "{\"length\": 64, \"vars\": "+std::to_string(var_count)+"}",
+            [](std::size_t){},
+            [eng, expr](std::size_t){ eng->replaceVars(expr); }});
+    }
+
+    /* Engine::evalFunctions over function nesting depth */
+    for (std::size_t depth : depths){
+        auto eng = std::make_shared<mbc::Engine>();
+        std::string expr = define_fun_chain(*eng, depth)+"+sin(0.5)";
+        cases.push_back({"evalFunctions",
+            "{\"depth\": "+std::to_string(depth)+"}",
+            [](std::size_t){},
+            [eng, expr](std::size_t){ eng->evalFunctions(expr); }});
+    }
+
+    /* Full Engine::load + Engine::eval over every parameter */
+    for (std::size_t length : lengths){
+        auto eng = std::make_shared<mbc::Engine>();
+        std::string expr = make_expr(length, 0);
+        cases.push_back({"eval",
+            "{\"length\": "+std::to_string(length)+", \"si_density\": 0, \"vars\": 0, \"depth\": 0}",
+            [](std::size_t){},
+            [eng, expr](std::size_t){ eng->load(expr); eng->eval(); }});
+    }
+    for (double si_density : si_densities){
+        auto eng = std::make_shared<mbc::Engine>();
+        std::string expr = make_expr(64, si_density);
+        cases.push_back({"eval",
+            "{\"length\": 64, \"si_density\": "+std::to_string(si_density)+", \"vars\": 0, \"depth\": 0}",
+            [](std::size_t){},
+            [eng, expr](std::size_t){ eng->load(expr); eng->eval(); }});
+    }
+    for (std::size_t var_count : var_counts){
+        auto eng = std::make_shared<mbc::Engine>();
+        std::string expr = "r="+make_expr(64, 0, define_vars(*eng, var_count));
+        cases.push_back({"eval",
+            "{\"length\": 64, \"si_density\": 0, \"vars\": "+std::to_string(var_count)+", \"depth\": 0}",
+            [](std::size_t){},
+            [eng, expr](std::size_t){ eng->load(expr); eng->eval(); }});
+    }
+    for (std::size_t depth : depths){
+        auto eng = std::make_shared<mbc::Engine>();
+        std::string expr = define_fun_chain(*eng, depth);
+        cases.push_back({"eval",
+            "{\"length\": 1, \"si_density\": 0, \"vars\": 0, \"depth\": "+std::to_string(depth)+"}",
+            [](std::size_t){},
+            [eng, expr](std::size_t){ eng->load(expr); eng->eval(); }});
+    }
+
+    /* Run all the cases and print the results */
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"suite\": \"mb_bench\",\n";
+    json << "  \"engine_version\": \"" << mbc::ENGINE_VERSION << "\",\n";
+    json << "  \"min_time_ms\": " << min_time_ms << ",\n";
+    json << "  \"results\": [";
+    bool flag_first = true;
+    for (BenchCase& bench_case : cases){
+        if (!filter.empty() && bench_case.name != filter)
+            continue;
+        BenchResult result = run_case(bench_case, min_time_ms*1e6);
+        json << (flag_first ? "\n" : ",\n");
+        json << "    {\"benchmark\": \"" << bench_case.name << "\", \"params\": " << bench_case.params
+            << ", \"iterations\": " << result.iterations
+            << ", \"ns_per_op\": " << result.ns_per_op
+            << ", \"allocs_per_op\": " << result.allocs_per_op
+            << ", \"bytes_per_op\": " << result.bytes_per_op
+            << ", \"regex_built_per_op\": " << result.regex_built_per_op
+            << ", \"regex_runs_per_op\": " << result.regex_runs_per_op << "}";
+        flag_first = false;
+        /* Progress goes to stderr so stdout stays valid JSON */
+        std::cerr << bench_case.name << " " << bench_case.params << ": " << result.ns_per_op << " ns/op" << std::endl;
+    }
+    json << "\n  ]\n}\n";
+    std::cout << json.str();
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+/****************************************************************************
+* File name: mb_linalg.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  Dense linear algebra benchmark for the MB compute engine.
+*  Multiplies square matrices of 64, 128, ... up to the maximum size with
+*  matrixMultiply on one thread and on every core, against the textbook
+*  triple loop (up to NAIVE_MAX_SIZE), and factors and solves them with
+*  LUDecomposition. Reports the GFLOP/s of every operation as JSON (a
+*  product of n x n matrices is 2n^3 floating point operations, an LU
+*  factorisation 2n^3/3) and checks the results: the largest difference
+*  to the triple loop and the relative residual of the solution.
+*
+*  Usage: mb_linalg [--max-size=N] [--min-time-ms=N]
+****************************************************************************/
+
+/* Includes */
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+
+/* Custom libraries */
+#include "mbcmatrix_lib.hpp"
+#include "mbcreduce_lib.hpp"
+#include "mbcsimd_lib.hpp"
+#include "mbcsupport_lib.hpp"
+
+typedef std::chrono::steady_clock bench_clock;
+
+/* Largest size multiplied with the textbook triple loop */
+const std::size_t NAIVE_MAX_SIZE = 512;
+
+/* Results of the cases that the compiler could otherwise optimise away */
+volatile double bench_sink = 0;
+
+/* Returns the mean time in seconds of the operation, run until the minimum time is reached */
+double time_op(const std::function<void(void)>& op, double min_time_s){
+    std::size_t runs = 0;
+    const auto start = bench_clock::now();
+    double elapsed = 0;
+    do{
+        op();
+        ++runs;
+        elapsed = std::chrono::duration<double>(bench_clock::now()-start).count();
+    } while (elapsed < min_time_s);
+    return elapsed/runs;
+}
+
+/* Returns a matrix of the given size with uniformly distributed elements in [-1, 1] (the same for the same seed) */
+mbc::Matrix random_matrix(std::size_t rows, std::size_t cols, unsigned int seed){
+    std::mt19937_64 generator(seed);
+    std::uniform_real_distribution<double> distribution(-1, 1);
+    mbc::Matrix matrix(rows, cols);
+    for (double& value : matrix.values())
+        value = distribution(generator);
+    return matrix;
+}
+
+/* Returns the product of the matrices computed with the textbook triple loop */
+mbc::Matrix naive_multiply(const mbc::Matrix& left, const mbc::Matrix& right){
+    mbc::Matrix result(left.rows(), right.cols());
+    for (std::size_t row = 0; row < left.rows(); ++row)
+        for (std::size_t col = 0; col < right.cols(); ++col){
+            double sum = 0;
+            for (std::size_t k = 0; k < left.cols(); ++k)
+                sum += left(row, k)*right(k, col);
+            result(row, col) = sum;
+        }
+    return result;
+}
+
+/* Returns the largest absolute difference of the elements of the matrices */
+double max_difference(const mbc::Matrix& first, const mbc::Matrix& second){
+    double difference = 0;
+    for (std::size_t index = 0; index < first.size(); ++index)
+        difference = std::max(difference, std::abs(first.values()[index]-second.values()[index]));
+    return difference;
+}
+
+int main(int argc, char *argv[]){
+    /* Handle CLI flags and options */
+    mbcs::CLIParser CLIparser(argc, argv);
+    std::size_t max_size = 2048;
+    double min_time_ms = 200;
+    if (CLIparser.cmdOptionExists("--max-size"))
+        max_size = std::strtoull(CLIparser.getCmdOption("--max-size").substr(11).c_str(), nullptr, 10);
+    if (CLIparser.cmdOptionExists("--min-time-ms"))
+        min_time_ms = std::atof(CLIparser.getCmdOption("--min-time-ms").substr(14).c_str());
+    const double min_time_s = min_time_ms*1E-3;
+
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"suite\": \"mb_linalg\",\n";
+    json << "  \"simd_lanes\": " << (MBC_SIMD ? mbc::SIMD_LANES : 1) << ",\n";
+    json << "  \"results\": [";
+    bool flag_first = true;
+    bool flag_ok = true;
+    for (std::size_t size = 64; size <= max_size; size *= 2){
+        const mbc::Matrix left = random_matrix(size, size, 1);
+        const mbc::Matrix right = random_matrix(size, size, 2);
+        const mbc::Matrix rhs = random_matrix(size, 1, 3);
+        const double product_flops = 2.0*size*size*size;
+        const double factor_flops = 2.0*size*size*size/3;
+
+        /* Product on one thread and on every core (the results are identical) */
+        mbc::Matrix product;
+        mbc::setReduceThreads(1);
+        const double multiply_s = time_op([&](void){ product = mbc::matrixMultiply(left, right); }, min_time_s);
+        mbc::setReduceThreads(0);
+        mbc::Matrix parallel_product;
+        const double parallel_multiply_s = time_op([&](void){ parallel_product = mbc::matrixMultiply(left, right); }, min_time_s);
+        bool flag_size_ok = max_difference(product, parallel_product) == 0;
+
+        /* Textbook triple loop, also used to check the product */
+        double naive_s = 0;
+        if (size <= NAIVE_MAX_SIZE){
+            mbc::Matrix naive_product;
+            naive_s = time_op([&](void){ naive_product = naive_multiply(left, right); }, min_time_s);
+            flag_size_ok = flag_size_ok && max_difference(product, naive_product) <= 1E-12*size;
+        }
+
+        /* LU factorisation and the solution of one right hand side */
+        mbc::LUDecomposition decomposition;
+        const double factor_s = time_op([&](void){ decomposition.factor(left); }, min_time_s);
+        mbc::Matrix solution;
+        const double solve_s = time_op([&](void){ solution = decomposition.solve(rhs); }, min_time_s);
+        const mbc::Matrix residual = mbc::matrixMultiply(left, solution);
+        double residual_norm = 0, rhs_norm = 0;
+        for (std::size_t index = 0; index < size; ++index){
+            residual_norm = std::max(residual_norm, std::abs(residual.values()[index]-rhs.values()[index]));
+            rhs_norm = std::max(rhs_norm, std::abs(rhs.values()[index]));
+        }
+        const double relative_residual = residual_norm/rhs_norm;
+        flag_size_ok = flag_size_ok && !decomposition.singular() && relative_residual <= 1E-8;
+        flag_ok = flag_ok && flag_size_ok;
+        bench_sink = product.values()[0]+solution.values()[0];
+
+        json << (flag_first ? "\n" : ",\n");
+        flag_first = false;
+        json << "    {\"size\": " << size
+            << ", \"multiply_gflops\": " << product_flops/multiply_s*1E-9
+            << ", \"parallel_multiply_gflops\": " << product_flops/parallel_multiply_s*1E-9;
+        if (size <= NAIVE_MAX_SIZE)
+            json << ", \"naive_multiply_gflops\": " << product_flops/naive_s*1E-9;
+        json << ", \"lu_factor_gflops\": " << factor_flops/factor_s*1E-9
+            << ", \"lu_solve_ms\": " << solve_s*1E3
+            << ", \"relative_residual\": " << relative_residual
+            << ", \"result_ok\": " << (flag_size_ok ? "true" : "false") << "}";
+        /* Progress goes to stderr so stdout stays valid JSON */
+        std::cerr << "size " << size << ": " << product_flops/multiply_s*1E-9 << " GFLOP/s (multiply), "
+            << factor_flops/factor_s*1E-9 << " GFLOP/s (LU)" << std::endl;
+    }
+    json << "\n  ]\n}\n";
+    std::cout << json.str();
+
+    return flag_ok ? 0 : 1;
+}
@@ -0,0 +1,413 @@
+/****************************************************************************
+* File name: mb_loadtest.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  End to end throughput and tail latency driver for the MB console.
+*  Feeds a script (see mb_workload) to mbconsole and reports lines/s,
+*  per-line latency percentiles and the peak RSS of the console as JSON.
+*
+*  Three modes are supported:
+*   - piped:   a single `mbconsole -p -s` process is fed one line at a
+*              time, the latency of a line is the time from writing it
+*              to reading its result back.
+*   - command: the script is passed through `--command=` in chunks (one
+*              process per chunk, argument size is limited by the OS),
+*              the latency of a line is the time between consecutive
+*              results, the first result of each process is reported
+*              separately as the startup latency.
+*   - serve:   a `mbconsole --serve=path` server is started and the script
+*              is sent one line at a time over a single connection, the
+*              latency of a line is the time from sending it to reading its
+*              result back (the startup is reported as the time to connect).
+*  This driver uses POSIX process APIs and is only supported on Linux.
+*
+*  Usage: mb_loadtest --app=path --script=file [--mode=piped|command|serve|both|all]
+*                     [--chunk-bytes=N]
+****************************************************************************/
+
+/* Includes */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+/* Custom libraries */
+#include "mbcsupport_lib.hpp"
+
+typedef std::chrono::steady_clock bench_clock;
+
+/* Structure to hold the measurements of one mode */
+struct ModeResult{
+    std::string mode;
+    std::size_t processes = 0;
+    std::size_t lines = 0;
+    double wall_s = 0;
+    std::vector<double> latencies_us;
+    std::vector<double> startups_us;
+    long peak_rss_kb = 0;
+    std::size_t error_lines = 0;
+    std::size_t missing_output_lines = 0;
+};
+
+/* Child process with its stdin/stdout connected to pipes */
+struct Child{
+    pid_t pid = -1;
+    int in_fd = -1;
+    int out_fd = -1;
+    std::string pending;
+};
+
+/* Start the given program with its arguments connected to pipes */
+bool spawn(Child& child, const std::vector<std::string>& args){
+    int to_child[2];
+    int from_child[2];
+    if (pipe(to_child) != 0 || pipe(from_child) != 0)
+        return false;
+    child.pid = fork();
+    if (child.pid < 0)
+        return false;
+    if (child.pid == 0){
+        dup2(to_child[0], STDIN_FILENO);
+        dup2(from_child[1], STDOUT_FILENO);
+        close(to_child[0]);
+        close(to_child[1]);
+        close(from_child[0]);
+        close(from_child[1]);
+        std::vector<char*> argv;
+        for (const std::string& arg : args)
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    close(to_child[0]);
+    close(from_child[1]);
+    child.in_fd = to_child[1];
+    child.out_fd = from_child[0];
+    return true;
+}
+
+/* Blocking read of one output line, returns false on end of stream */
+bool read_line(Child& child, std::string& line){
+    char buffer[4096];
+    std::size_t pos;
+    while ((pos = child.pending.find('\n')) == std::string::npos){
+        ssize_t count = read(child.out_fd, buffer, sizeof(buffer));
+        if (count <= 0)
+            return false;
+        child.pending.append(buffer, count);
+    }
+    line = child.pending.substr(0, pos);
+    child.pending.erase(0, pos+1);
+    return true;
+}
+
+/* Write the whole string to the child's stdin */
+bool write_all(Child& child, const std::string& data){
+    std::size_t done = 0;
+    while (done < data.size()){
+        ssize_t count = write(child.in_fd, data.data()+done, data.size()-done);
+        if (count <= 0)
+            return false;
+        done += count;
+    }
+    return true;
+}
+
+/* Close the pipes and wait for the child, returns its peak RSS in KB */
+long finish(Child& child){
+    if (child.in_fd >= 0)
+        close(child.in_fd);
+    if (child.out_fd >= 0)
+        close(child.out_fd);
+    int status = 0;
+    struct rusage usage;
+    std::memset(&usage, 0, sizeof(usage));
+    wait4(child.pid, &status, 0, &usage);
+    return usage.ru_maxrss;
+}
+
+bool is_error_line(const std::string& line){
+    return line.find("ERROR") != std::string::npos;
+}
+
+/* Piped mode: one process fed one line at a time */
+ModeResult run_piped(const std::string& app, const std::vector<std::string>& script){
+    ModeResult result;
+    result.mode = "piped";
+    Child child;
+    if (!spawn(child, {app, "-p", "-s"})){
+        std::cerr << "[ERROR] Could not start " << app << std::endl;
+        return result;
+    }
+    result.processes = 1;
+    std::string output;
+    auto start = bench_clock::now();
+    for (const std::string& line : script){
+        auto line_start = bench_clock::now();
+        if (!write_all(child, line+"\n") || !read_line(child, output)){
+            ++result.missing_output_lines;
+            break;
+        }
+        auto line_stop = bench_clock::now();
+        result.latencies_us.push_back(std::chrono::duration<double, std::micro>(line_stop-line_start).count());
+        if (is_error_line(output))
+            ++result.error_lines;
+        ++result.lines;
+    }
+    write_all(child, "exit\n");
+    result.wall_s = std::chrono::duration<double>(bench_clock::now()-start).count();
+    /* Anything left over means some lines produced more than one output line */
+    while (read_line(child, output))
+        if (is_error_line(output))
+            ++result.error_lines;
+    result.peak_rss_kb = finish(child);
+    result.missing_output_lines += script.size()-result.lines;
+    return result;
+}
+
+/* Command mode: the script is passed through --command= in chunks */
+ModeResult run_command(const std::string& app, const std::vector<std::string>& script, std::size_t chunk_bytes){
+    ModeResult result;
+    result.mode = "command";
+    auto start = bench_clock::now();
+    std::size_t index = 0;
+    while (index < script.size()){
+        /* Build the next chunk, lines are joined with a literal \n as on the command line */
+        std::string command = "--command=";
+        std::size_t chunk_lines = 0;
+        while (index < script.size() && (chunk_lines == 0 || command.size()+script[index].size() < chunk_bytes)){
+            command += script[index++]+"\\n";
+            ++chunk_lines;
+        }
+        command += "exit";
+
+        Child child;
+        auto process_start = bench_clock::now();
+        if (!spawn(child, {app, "-s", command})){
+            std::cerr << "[ERROR] Could not start " << app << std::endl;
+            return result;
+        }
+        ++result.processes;
+        close(child.in_fd);
+        child.in_fd = -1;
+        auto last = process_start;
+        std::string output;
+        std::size_t received = 0;
+        while (read_line(child, output)){
+            auto now = bench_clock::now();
+            double elapsed = std::chrono::duration<double, std::micro>(now-last).count();
+            if (received == 0)
+                result.startups_us.push_back(elapsed);
+            else if (received < chunk_lines)
+                result.latencies_us.push_back(elapsed);
+            if (is_error_line(output))
+                ++result.error_lines;
+            last = now;
+            ++received;
+        }
+        result.peak_rss_kb = std::max(result.peak_rss_kb, finish(child));
+        result.lines += std::min(received, chunk_lines);
+        if (received < chunk_lines)
+            result.missing_output_lines += chunk_lines-received;
+    }
+    result.wall_s = std::chrono::duration<double>(bench_clock::now()-start).count();
+    return result;
+}
+
+/* Connect to the server socket, retried until the server is listening */
+int connect_server(const std::string& socket_path, std::chrono::milliseconds timeout){
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path))
+        return -1;
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size());
+    auto deadline = bench_clock::now()+timeout;
+    while (bench_clock::now() < deadline){
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        if (connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == 0)
+            return fd;
+        close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return -1;
+}
+
+/* Serve mode: one server process, the script is sent over one connection */
+ModeResult run_serve(const std::string& app, const std::vector<std::string>& script){
+    ModeResult result;
+    result.mode = "serve";
+    const std::string socket_path = "/tmp/mb_loadtest_"+std::to_string(getpid())+".sock";
+    Child server;
+    auto process_start = bench_clock::now();
+    if (!spawn(server, {app, "-s", "--serve="+socket_path, "--workers=1"})){
+        std::cerr << "[ERROR] Could not start " << app << std::endl;
+        return result;
+    }
+    result.processes = 1;
+    /* The connection is used as both ends of a child so the line helpers can be shared */
+    Child connection;
+    connection.in_fd = connection.out_fd = connect_server(socket_path, std::chrono::seconds(10));
+    if (connection.in_fd < 0){
+        std::cerr << "[ERROR] Could not connect to " << socket_path << std::endl;
+        kill(server.pid, SIGKILL);
+        finish(server);
+        result.missing_output_lines = script.size();
+        return result;
+    }
+    result.startups_us.push_back(std::chrono::duration<double, std::micro>(bench_clock::now()-process_start).count());
+    std::string output;
+    auto start = bench_clock::now();
+    for (const std::string& line : script){
+        auto line_start = bench_clock::now();
+        if (!write_all(connection, line+"\n") || !read_line(connection, output)){
+            ++result.missing_output_lines;
+            break;
+        }
+        auto line_stop = bench_clock::now();
+        result.latencies_us.push_back(std::chrono::duration<double, std::micro>(line_stop-line_start).count());
+        if (is_error_line(output))
+            ++result.error_lines;
+        ++result.lines;
+    }
+    write_all(connection, "exit\n");
+    result.wall_s = std::chrono::duration<double>(bench_clock::now()-start).count();
+    while (read_line(connection, output))
+        if (is_error_line(output))
+            ++result.error_lines;
+    close(connection.in_fd);
+    kill(server.pid, SIGTERM);
+    result.peak_rss_kb = finish(server);
+    result.missing_output_lines += script.size()-result.lines;
+    return result;
+}
+
+/* Nearest rank percentile of an already sorted list */
+double percentile(const std::vector<double>& sorted, double pct){
+    if (sorted.empty())
+        return 0;
+    std::size_t rank = static_cast<std::size_t>(pct/100.0*sorted.size()+0.5);
+    rank = std::min(std::max<std::size_t>(rank, 1), sorted.size());
+    return sorted[rank-1];
+}
+
+std::string latency_json(std::vector<double> values){
+    std::sort(values.begin(), values.end());
+    double total = 0;
+    for (double value : values)
+        total += value;
+    std::ostringstream json;
+    json << "{\"count\": " << values.size()
+        << ", \"mean\": " << (values.empty() ? 0 : total/values.size())
+        << ", \"p50\": " << percentile(values, 50)
+        << ", \"p99\": " << percentile(values, 99)
+        << ", \"p99.9\": " << percentile(values, 99.9)
+        << ", \"max\": " << (values.empty() ? 0 : values.back()) << "}";
+    return json.str();
+}
+
+int main(int argc, char *argv[]){
+    /* Handle CLI flags and options */
+    mbcs::CLIParser CLIparser(argc, argv);
+    std::string app = "";
+    std::string script_file = "";
+    std::string mode = "both";
+    std::size_t chunk_bytes = 64*1024;
+    if (CLIparser.cmdOptionExists("--app"))
+        app = CLIparser.getCmdOption("--app").substr(6);
+    if (CLIparser.cmdOptionExists("--script"))
+        script_file = CLIparser.getCmdOption("--script").substr(9);
+    if (CLIparser.cmdOptionExists("--mode"))
+        mode = CLIparser.getCmdOption("--mode").substr(7);
+    if (CLIparser.cmdOptionExists("--chunk-bytes"))
+        chunk_bytes = std::strtoull(CLIparser.getCmdOption("--chunk-bytes").substr(14).c_str(), nullptr, 10);
+    if (app.empty() || script_file.empty()){
+        std::cerr << "Usage: mb_loadtest --app=path --script=file [--mode=piped|command|serve|both|all] [--chunk-bytes=N]" << std::endl;
+        return 1;
+    }
+
+    /* Load the script, empty lines are skipped as the console does not answer them */
+    std::ifstream fin(script_file);
+    if (!fin.good()){
+        std::cerr << "[ERROR] Could not open " << script_file << std::endl;
+        return 1;
+    }
+    std::vector<std::string> script;
+    std::string line;
+    /* FNV-1a hash of the script so results can be matched to their workload */
+    uint64_t hash = 0xcbf29ce484222325ull;
+    while (std::getline(fin, line)){
+        if (line.empty())
+            continue;
+        for (unsigned char chr : line+"\n")
+            hash = (hash ^ chr) * 0x100000001b3ull;
+        script.push_back(line);
+    }
+
+    std::vector<ModeResult> results;
+    if (mode == "piped" || mode == "both" || mode == "all")
+        results.push_back(run_piped(app, script));
+    if (mode == "command" || mode == "both" || mode == "all")
+        results.push_back(run_command(app, script, chunk_bytes));
+    if (mode == "serve" || mode == "all")
+        results.push_back(run_serve(app, script));
+
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"suite\": \"mb_loadtest\",\n";
+    json << "  \"app\": \"" << app << "\",\n";
+    json << "  \"script\": \"" << script_file << "\",\n";
+    json << "  \"script_lines\": " << script.size() << ",\n";
+    json << "  \"script_hash\": \"" << std::hex << hash << std::dec << "\",\n";
+    json << "  \"results\": [";
+    for (std::size_t index = 0; index < results.size(); ++index){
+        const ModeResult& result = results[index];
+        json << (index ? ",\n" : "\n");
+        json << "    {\"mode\": \"" << result.mode << "\""
+            << ", \"processes\": " << result.processes
+            << ", \"lines\": " << result.lines
+            << ", \"wall_s\": " << result.wall_s
+            << ", \"lines_per_s\": " << (result.wall_s > 0 ? result.lines/result.wall_s : 0)
+            << ", \"latency_us\": " << latency_json(result.latencies_us);
+        if (!result.startups_us.empty())
+            json << ", \"startup_us\": " << latency_json(result.startups_us);
+        json << ", \"peak_rss_kb\": " << result.peak_rss_kb
+            << ", \"error_lines\": " << result.error_lines
+            << ", \"missing_output_lines\": " << result.missing_output_lines << "}";
+    }
+    json << "\n  ]\n}\n";
+    std::cout << json.str();
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+/****************************************************************************
+* File name: mb_scaling.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  Input size scaling benchmark for the MB compute engine.
+*  Evaluates a single generated expression of 1KB, 10KB, ... up to the
+*  maximum size (numbers, a variable, nested calls and parentheses) with
+*  Engine::load and Engine::eval and reports the time per input byte of
+*  the load and of the evaluation and the memory per input byte as JSON.
+*  The time per byte stays flat if parsing is linear in the size of the
+*  expression.
+*
+*  Every size is evaluated in its own process so the peak RSS of one size
+*  is not hidden by a larger one. The memory per byte is the growth of the
+*  RSS while the expression is loaded and evaluated (the expression text
+*  itself is not included).
+*  This benchmark uses POSIX process APIs and is only supported on Linux.
+*
+*  Usage: mb_scaling [--max-bytes=N]
+****************************************************************************/
+
+/* Includes */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+/* Custom libraries */
+#include "mbcomputengine_lib.hpp"
+#include "mbcsupport_lib.hpp"
+
+typedef std::chrono::steady_clock bench_clock;
+
+/* Repeated part of the expression and the value of the variable it uses */
+const std::string SCALING_UNIT = "+sin(x*0.5)*(2.5+cos(x))+pow(x,2)/4+(x+1.25)*3";
+const std::string SCALING_SETUP = "x=2";
+
+/* Structure to hold the measurements of one size */
+struct SizeResult{
+    std::size_t bytes = 0;
+    double load_s = 0;
+    double eval_s = 0;
+    long rss_growth_kb = 0;
+    long peak_rss_kb = 0;
+    double result = 0;
+    double expected = 0;
+    bool ok = false;
+};
+
+/* Returns the current resident set size of this process in KB */
+long current_rss_kb(void){
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident*(sysconf(_SC_PAGESIZE)/1024);
+}
+
+/* Evaluates the given expression and returns the last result as a number (NaN on errors) */
+double evaluate(mbc::Engine& eng, const std::string& expression){
+    eng.load(expression);
+    eng.eval();
+    std::string result, last;
+    while ((result = eng.getResult()) != mbc::RESULT_END)
+        last = result;
+    if (eng.hasErrors() || last.empty())
+        return NAN;
+    return std::strtod(last.c_str(), nullptr);
+}
+
+/* Evaluates an expression of (at least) the given size, runs in the child process */
+SizeResult run_size(std::size_t bytes){
+    SizeResult size;
+    mbc::Engine eng;
+    evaluate(eng, SCALING_SETUP);
+    const double unit_value = evaluate(eng, "0"+SCALING_UNIT);
+
+    std::string expression = "0";
+    expression.reserve(bytes+SCALING_UNIT.size());
+    std::size_t units = 0;
+    for (; expression.size() < bytes; ++units)
+        expression += SCALING_UNIT;
+    size.bytes = expression.size();
+    size.expected = units*unit_value;
+
+    const long rss_before = current_rss_kb();
+    auto start = bench_clock::now();
+    eng.load(expression);
+    auto loaded = bench_clock::now();
+    eng.eval();
+    auto stop = bench_clock::now();
+    size.load_s = std::chrono::duration<double>(loaded-start).count();
+    size.eval_s = std::chrono::duration<double>(stop-loaded).count();
+
+    std::string result, last;
+    while ((result = eng.getResult()) != mbc::RESULT_END)
+        last = result;
+    size.result = std::strtod(last.c_str(), nullptr);
+    /* The result is printed with 6 significant digits */
+    size.ok = !eng.hasErrors() && !last.empty() && std::fabs(size.result-size.expected) <= 1E-5*std::fabs(size.expected)+1E-9;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    size.rss_growth_kb = usage.ru_maxrss-rss_before;
+    return size;
+}
+
+/* Runs one size in a child process, the child writes its measurements to a pipe */
+bool measure(std::size_t bytes, SizeResult& size){
+    int fds[2];
+    if (pipe(fds) != 0)
+        return false;
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0)
+        return false;
+    if (pid == 0){
+        close(fds[0]);
+        SizeResult measured = run_size(bytes);
+        ssize_t written = write(fds[1], &measured, sizeof(measured));
+        _exit(written == sizeof(measured) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t received = 0;
+    while (received < static_cast<ssize_t>(sizeof(size))){
+        ssize_t count = read(fds[0], reinterpret_cast<char*>(&size)+received, sizeof(size)-received);
+        if (count <= 0)
+            break;
+        received += count;
+    }
+    close(fds[0]);
+    int status = 0;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    size.peak_rss_kb = usage.ru_maxrss;
+    return received == sizeof(size) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char *argv[]){
+    /* Handle CLI flags and options */
+    mbcs::CLIParser CLIparser(argc, argv);
+    std::size_t max_bytes = 100*1024*1024;
+    if (CLIparser.cmdOptionExists("--max-bytes"))
+        max_bytes = std::strtoull(CLIparser.getCmdOption("--max-bytes").substr(12).c_str(), nullptr, 10);
+
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"suite\": \"mb_scaling\",\n";
+    json << "  \"unit\": \"" << SCALING_UNIT << "\",\n";
+    json << "  \"results\": [";
+    bool flag_first = true;
+    bool flag_ok = true;
+    for (std::size_t bytes = 1024; bytes <= max_bytes; bytes *= 10){
+        SizeResult size;
+        if (!measure(bytes, size)){
+            /* Most likely out of memory, larger sizes would fail as well */
+            std::cerr << "[ERROR] The expression of " << bytes << " bytes could not be evaluated" << std::endl;
+            flag_ok = false;
+            break;
+        }
+        flag_ok = flag_ok && size.ok;
+        json << (flag_first ? "\n" : ",\n");
+        flag_first = false;
+        json << "    {\"bytes\": " << size.bytes
+            << ", \"load_s\": " << size.load_s
+            << ", \"eval_s\": " << size.eval_s
+            << ", \"load_ns_per_byte\": " << size.load_s*1E9/size.bytes
+            << ", \"eval_ns_per_byte\": " << size.eval_s*1E9/size.bytes
+            << ", \"peak_rss_kb\": " << size.peak_rss_kb
+            << ", \"memory_bytes_per_byte\": " << size.rss_growth_kb*1024.0/size.bytes
+            << ", \"result_ok\": " << (size.ok ? "true" : "false") << "}";
+    }
+    json << "\n  ]\n}\n";
+    std::cout << json.str();
+
+    return flag_ok ? 0 : 1;
+}
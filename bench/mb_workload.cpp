@@ -0,0 +1,203 @@
+/****************************************************************************
+* File name: mb_workload.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  Workload generator for the MB console end to end benchmark.
+*  Prints a script made of assignments, function definitions, nested
+*  calls, `;` separated lines and comments to stdout.
+*  The output only depends on the given seed and line count, and every
+*  generated line produces exactly one line of output from mbconsole
+*  (this is what mb_loadtest relies on to measure per-line latency).
+*
+*  Usage: mb_workload [--lines=N] [--seed=S]
+****************************************************************************/
+
+/* Includes */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+/* Custom libraries */
+#include "mbcsupport_lib.hpp"
+
+/* Small self contained PRNG (xorshift64*)
+* The standard distributions are implementation defined so they are not
+* used, this keeps the generated scripts identical across toolchains.
+*/
+class Random{
+private:
+    uint64_t state;
+public:
+    Random(uint64_t seed) : state(seed ? seed : 0x9E3779B97F4A7C15ull){}
+    uint64_t next(void){
+        this->state ^= this->state >> 12;
+        this->state ^= this->state << 25;
+        this->state ^= this->state >> 27;
+        return this->state * 0x2545F4914F6CDD1Dull;
+    }
+    /* Returns a value in the range [0, bound) */
+    std::size_t below(std::size_t bound){
+        return static_cast<std::size_t>(this->next() % bound);
+    }
+};
+
+/* Structure to hold a function known to the generated script */
+struct WorkloadFunction{
+    std::string name;
+    std::size_t arg_count;
+};
+
+/* Generator state */
+class Workload{
+private:
+    Random rng;
+    std::vector<WorkloadFunction> functions;
+    std::vector<std::string> variables;
+    std::size_t next_function;
+
+    /* Decimal literal, optionally with an SI prefix.
+    * Bare integers are avoided as the function definition check rejects them.
+    */
+    std::string literal(bool allow_si){
+        static const char prefixes[] = {'k', 'M', 'm', 'u', 'n', 'G'};
+        std::string lit = std::to_string(this->rng.below(99)+1)+"."+std::to_string(this->rng.below(9)+1);
+        if (allow_si && this->rng.below(4) == 0)
+            lit += prefixes[this->rng.below(6)];
+        return lit;
+    }
+
+    /* Random expression over the given operand names with up to `depth` levels of nested calls */
+    std::string expr(std::size_t depth, const std::vector<std::string>& names, bool allow_si){
+        static const std::vector<std::string> oops{" + ", " - ", " * ", " + ", " * "};
+        std::size_t terms = this->rng.below(3)+1;
+        std::string out;
+        for (std::size_t index = 0; index < terms; ++index){
+            if (index != 0)
+                out += oops[this->rng.below(oops.size())];
+            std::size_t kind = this->rng.below(4);
+            if (kind == 0 && depth > 0){
+                /* Nested call */
+                const WorkloadFunction& fun = this->functions[this->rng.below(this->functions.size())];
+                out += fun.name+"(";
+                for (std::size_t arg = 0; arg < fun.arg_count; ++arg)
+                    out += (arg ? ", " : "")+this->expr(depth-1, names, allow_si);
+                out += ")";
+            } else if (kind == 1 && !names.empty())
+                out += names[this->rng.below(names.size())];
+            else if (kind == 2)
+                out += "("+this->literal(allow_si)+" / "+this->literal(false)+")";
+            else
+                out += this->literal(allow_si);
+        }
+        return out;
+    }
+
+    std::string assignment(void){
+        std::string name = "w"+std::to_string(this->rng.below(32));
+        std::string line = name+" = "+this->expr(2, this->variables, true);
+        if (std::find(this->variables.cbegin(), this->variables.cend(), name) == this->variables.cend())
+            this->variables.push_back(name);
+        return line;
+    }
+
+    std::string definition(void){
+        static const std::vector<std::string> arg_names{"xa", "xb", "xc"};
+        WorkloadFunction fun{"g"+std::to_string(++this->next_function), this->rng.below(3)+1};
+        std::vector<std::string> args(arg_names.cbegin(), arg_names.cbegin()+fun.arg_count);
+        std::string line = fun.name+"(";
+        for (std::size_t arg = 0; arg < fun.arg_count; ++arg)
+            line += (arg ? ", " : "")+args[arg];
+        /* Function bodies only use their arguments, decimals and existing functions */
+        line += ") : "+args[0]+" * "+this->expr(1, args, false);
+        if (this->rng.below(2) == 0)
+            line += " \"generated function "+std::to_string(this->next_function)+"\"";
+        this->functions.push_back(fun);
+        return line;
+    }
+
+public:
+    Workload(uint64_t seed) : rng(seed), next_function(0){
+        /* Start with a small library of common helpers */
+        this->functions = {{"sin", 1}, {"cos", 1}, {"abs", 1}, {"pow", 2}, {"tanh", 1}};
+    }
+
+    /* Returns the fixed preamble defining the helper library */
+    std::vector<std::string> preamble(void){
+        this->functions.push_back({"sq", 1});
+        this->functions.push_back({"lerp", 3});
+        this->functions.push_back({"damp", 2});
+        this->functions.push_back({"poly", 1});
+        return {
+            "sq(xa) : xa*xa \"Square\"",
+            "lerp(xa, xb, xc) : xa+(xb-xa)*xc \"Linear interpolation\"",
+            "damp(xa, xb=2.5) : xa/pow(2.0, xb) \"Damping with a default argument\"",
+            "poly(xa) : sq(xa)*3.5+xa*2.5+1.5 \"Quadratic\"",
+            "w0 = 1.5"
+        };
+    }
+
+    /* Returns the next line of the script */
+    std::string line(void){
+        std::size_t kind = this->rng.below(20);
+        if (kind < 7)
+            return this->assignment();
+        else if (kind < 11)
+            /* Nested call expression */
+            return this->expr(3, this->variables, true);
+        else if (kind < 14){
+            /* `;` separated line, only the last result is printed */
+            std::string line = this->assignment();
+            std::size_t parts = this->rng.below(3)+1;
+            for (std::size_t part = 0; part < parts; ++part)
+                line += "; "+(part+1 == parts ? this->expr(2, this->variables, true) : this->assignment());
+            return line;
+        } else if (kind < 16)
+            /* Trailing comment */
+            return this->assignment()+" \"note "+std::to_string(this->rng.below(1000))+"\"";
+        else if (kind < 17)
+            /* Comment only line */
+            return "\"checkpoint "+std::to_string(this->rng.below(1000))+"\"";
+        else if (kind < 18 && this->next_function < 64)
+            return this->definition();
+        return this->expr(1, this->variables, true);
+    }
+};
+
+int main(int argc, char *argv[]){
+    /* Handle CLI flags and options */
+    mbcs::CLIParser CLIparser(argc, argv);
+    std::size_t lines = 1000;
+    uint64_t seed = 1;
+    if (CLIparser.cmdOptionExists("--lines"))
+        lines = std::strtoull(CLIparser.getCmdOption("--lines").substr(8).c_str(), nullptr, 10);
+    if (CLIparser.cmdOptionExists("--seed"))
+        seed = std::strtoull(CLIparser.getCmdOption("--seed").substr(7).c_str(), nullptr, 10);
+
+    Workload workload(seed);
+    std::vector<std::string> script = workload.preamble();
+    while (script.size() < lines)
+        script.push_back(workload.line());
+    script.resize(lines);
+
+    for (const std::string& line : script)
+        std::cout << line << "\n";
+    return 0;
+}
@@ -23,31 +23,70 @@
 /* Includes */
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
 #include <regex>
 #include <signal.h>
 
 /* Custom libraries */
 #include "mbcomputengine_lib.hpp"
+#include "mbchistory_lib.hpp"
+#include "mbclog_lib.hpp"
+#include "mbcjournal_lib.hpp"
 #include "mbcsupport_lib.hpp"
+#include "mb_compute_server.hpp"
+#ifdef MBC_COUNT_ALLOCATIONS
+/* Count the allocations of every engine phase (shown by the stats command and --verbose) */
+#include "mbcprofiler_alloc.hpp"
+#endif
 
 /* Common definitions */
 #define CONSOLE_READY_MSG "MB> "
 
 /* Global variable to hold the current verbosity level */
 int verbose = 0;
-std::string session_history = "";
+/* Last lines of the session, older lines are spilled to the history file if given */
+mbc::History session_history;
+/* Trace event writer, only open if a trace file is given */
+mbc::TraceWriter trace_writer;
+/* Binary output of the sweeps, only open if a sweep output file is given */
+std::ofstream sweep_out;
+/* Journal of the evaluated lines, only open if a journal file is given */
+mbc::JournalWriter journal;
 
 /* Class to handle printing and logging
 * Reference link: https://stackoverflow.com/a/14155788/7261761
+* In asynchronous mode the log file is written by a background thread (see mbc::AsyncLogWriter),
+* the output is queued instead of being written and flushed on every line. Output written by a
+* signal handler while the interrupted code was queueing output is printed but not logged.
 */
 class log_stream{
 private:
     std::ofstream fout;
     bool flag_log_set;
+    bool flag_async;
+    mbc::AsyncLogWriter async_writer;
+    std::ostringstream async_format;
+    /* Set while output is queued for the writer */
+    std::atomic<bool> async_busy;
+
+    /* Queue the text formatted into async_format */
+    template<typename F> void queue(F format){
+        if (this->async_busy.exchange(true))
+            return;
+        format(this->async_format);
+        this->async_writer.write(this->async_format.str());
+        this->async_format.str("");
+        this->async_busy = false;
+    }
 
 public:
-    log_stream(std::string log_file = ""){
+    log_stream(std::string log_file = "") : flag_async(false), async_busy(false){
         // Check if opening the file succeeded
         if (log_file.empty()){
             this->flag_log_set = false;
@@ -67,50 +106,85 @@ public:
             /* Close the log file stream */
             this->fout.close();
         }
+        /* Write out everything queued */
+        this->async_writer.close();
     };
-    void open(std::string log_file){
+    void open(std::string log_file, bool async = false){
         /* Close existing handle */
         if (this->fout)
             this->fout.close();
+        this->async_writer.close();
+        this->flag_async = async;
         /* Open new handle */
-        this->fout.open(log_file);
-        if (this->fout.good())
-            this->flag_log_set = true;
-        else
-            this->flag_log_set = false;
+        if (async)
+            this->flag_log_set = !log_file.empty() && this->async_writer.open(log_file);
+        else{
+            this->fout.open(log_file);
+            this->flag_log_set = this->fout.good();
+        }
     }
     void flush(){
         std::cout.flush();
-        if (this->flag_log_set)
+        /* The asynchronous writer flushes the file after every batch */
+        if (this->flag_log_set && !this->flag_async)
             this->fout.flush();
     }
+    /* Wait (at most the given time) until the queued output is in the log file, returns false on timeout */
+    bool sync(std::chrono::milliseconds timeout = std::chrono::milliseconds::max()){
+        this->flush();
+        return !this->flag_async || this->async_writer.sync(timeout);
+    }
     void log(std::string message){
-        if (this->flag_log_set)
-            this->fout << message;
+        if (this->flag_log_set){
+            if (this->flag_async)
+                this->queue([&message](std::ostream& out){ out << message; });
+            else
+                this->fout << message;
+        }
     }
     // For regular output of variables and stuff
     template<typename T> log_stream& operator<<(const T& something){
         std::cout << something;
-        if (this->flag_log_set)
-            fout << something;
+        if (this->flag_log_set){
+            if (this->flag_async)
+                this->queue([&something](std::ostream& out){ out << something; });
+            else
+                fout << something;
+        }
         return *this;
     }
     // For manipulators like std::endl
     typedef std::ostream& (*stream_function)(std::ostream&);
     log_stream& operator<<(stream_function func){
         func(std::cout);
-        if (this->flag_log_set)
-            func(fout);
+        if (this->flag_log_set){
+            if (this->flag_async)
+                this->queue(func);
+            else
+                func(fout);
+        }
         return *this;
     }
 } flog;
 
+/* Longest time a fatal signal waits for the queued log output before the console exits */
+const std::chrono::milliseconds SIGNAL_LOG_SYNC_TIMEOUT(1000);
+
 /* Function to print based on verbosity level */
 void print_verbose(std::string msg, int verbosity=1){
     if (verbose >= verbosity)
         flog << msg << std::endl;
 }
 
+/* Function to exit on a fatal signal, the output queued for an asynchronous log is written
+* out first (waiting at most SIGNAL_LOG_SYNC_TIMEOUT) and the log is closed by exit
+*/
+void exit_on_signal(int signal_num){
+    flog.sync(SIGNAL_LOG_SYNC_TIMEOUT);
+    journal.sync(SIGNAL_LOG_SYNC_TIMEOUT);
+    exit(signal_num);
+}
+
 /* Callback function to handle console/system signals sent to application
 * Reference link: https://www.cplusplus.com/reference/csignal/signal/
 * +---------+---------------------------------+----------------------------------------------------------------------------------------------------------------------------------------------+
@@ -123,21 +197,22 @@ void print_verbose(std::string msg, int verbosity=1){
 * | SIGSEGV | Segmentation Violation signal   | Invalid access to storage: When a program tries to read or write outside the memory it has allocated.                                        |
 * | SIGTERM | Terminate signal                | Termination request sent to program.                                                                                                         |
 * +---------+---------------------------------+----------------------------------------------------------------------------------------------------------------------------------------------+
+* Every signal but SIGINT exits through exit_on_signal, SIGINT leaves the queued log output to the writer.
 */
 void signal_callback_handler(int signal_num) {
    switch (signal_num)
    {
         case SIGABRT:
             std::cerr << std::endl << "[ERROR] An Abort signal was raised by OS" << std::endl;
-            exit(signal_num);
+            exit_on_signal(signal_num);
             break;
         case SIGFPE:
             std::cerr << std::endl << "[ERROR] A Floating-Point Exception signal was raised by OS" << std::endl;
-            exit(signal_num);
+            exit_on_signal(signal_num);
             break;
         case SIGILL:
             std::cerr << std::endl << "[ERROR] An Illegal Instruction signal was raised by OS" << std::endl;
-            exit(signal_num);
+            exit_on_signal(signal_num);
             break;
         case SIGINT:
             /* Handle and continue if a console interrupt is received */
@@ -149,15 +224,15 @@ void signal_callback_handler(int signal_num) {
             break;
         case SIGSEGV:
             std::cerr << std::endl << "[ERROR] A Segmentation Violation signal was raised by OS" << std::endl;
-            exit(signal_num);
+            exit_on_signal(signal_num);
             break;
         case SIGTERM:
             std::cerr << std::endl << "[ERROR] A Terminate signal was raised by OS" << std::endl;
-            exit(signal_num);
+            exit_on_signal(signal_num);
             break;
         default:
             std::cerr << std::endl << "[ERROR] An unknown signal was raised by OS" << std::endl;
-            exit(signal_num);
+            exit_on_signal(signal_num);
             break;
    }
 }
@@ -166,6 +241,97 @@ void signal_callback_handler(int signal_num) {
 void self_cleanup(bool silentFlag = false){
     if (!silentFlag)
         flog << "Exiting..." << std::endl;
+    /* Write out the remaining trace events */
+    trace_writer.close();
+    sweep_out.close();
+    session_history.close();
+    journal.close();
+}
+
+/* Function to stream the rows of a sweep, as native doubles to the sweep output file if open
+* otherwise as text (one row per line) to the console
+*/
+void write_sweep_rows(const double* rows, std::size_t row_count, std::size_t column_count){
+    if (sweep_out.is_open()){
+        sweep_out.write(reinterpret_cast<const char*>(rows), static_cast<std::streamsize>(row_count*column_count*sizeof(double)));
+        return;
+    }
+    std::string rows_str;
+    for (std::size_t index = 0; index < row_count; ++index)
+        rows_str += mbc::formatSweepRow(rows+index*column_count, column_count)+"\n";
+    flog << rows_str;
+}
+
+/* Function to handle the history commands, returns true if the line was handled
+* `history` (or `history #n` for the last n entries) prints the numbered entries in memory,
+* `recall #n` replaces the line with entry n of the history so it is evaluated again.
+*/
+bool run_history_command(std::string& line){
+    static const std::regex history_regex("^\\s*history\\s*(#\\s*(\\d+))?\\s*$");
+    static const std::regex recall_regex("^\\s*recall\\s*#\\s*(\\d+)\\s*$");
+    std::smatch match;
+    if (std::regex_match(line, match, history_regex)){
+        const std::size_t count = match[2].matched ? std::strtoull(match[2].str().c_str(), nullptr, 10) : session_history.size();
+        std::string entries_str;
+        for (const mbc::HistoryEntry& entry : session_history.last(count))
+            entries_str += std::to_string(entry.number)+" "+entry.line+"\n";
+        flog << entries_str;
+        return true;
+    }
+    if (std::regex_match(line, match, recall_regex)){
+        if (!session_history.find(std::strtoull(match[1].str().c_str(), nullptr, 10), line)){
+            flog << "[ERROR] History entry " << match[1].str() << " is not in memory" << std::endl;
+            return true;
+        }
+        print_verbose("[DEBUG] Recalled line: "+line);
+    }
+    return false;
+}
+
+/* Function to load and evaluate a single line, traced as a span if a trace is open */
+void run_line(mbc::Engine& eng, const std::string& line, std::size_t line_number){
+    const std::string span_name = trace_writer.isOpen() ? "line "+std::to_string(line_number) : "";
+    mbc::TraceSpan line_span(eng.getProfiler(), span_name, "line");
+    if (line_span.active())
+        line_span.setDetail(line);
+    const auto timestamp = std::chrono::system_clock::now();
+    const auto start = std::chrono::steady_clock::now();
+    eng.load(line);
+    eng.eval();
+    if (journal.isOpen())
+        journal.append(mbc::makeJournalEntry(eng, line, timestamp, std::chrono::steady_clock::now()-start));
+}
+
+/* Function to describe the result of a journal entry */
+std::string describe_journal_result(const mbc::JournalEntry& entry){
+    std::string result = entry.result;
+    while (!result.empty() && result.back() == '\n')
+        result.pop_back();
+    if (entry.status == mbc::JOURNAL_ERROR)
+        return "error `"+result+"`";
+    if (entry.status == mbc::JOURNAL_TEXT)
+        return "`"+result+"`";
+    char str_value[32];
+    std::snprintf(str_value, sizeof(str_value), "%.17G", entry.value);
+    return "`"+result+"` ("+str_value+")";
+}
+
+/* Function to replay a journal with the engine, returns the exit code of the console */
+int replay_journal(mbc::Engine& eng, const std::string& replay_file){
+    const mbc::ReplayReport report = mbc::replayJournal(eng, replay_file,
+        [](std::size_t index, const mbc::JournalEntry& expected, const mbc::JournalEntry& actual){
+            flog << "[ERROR] Replay mismatch at entry " << index << " `" << expected.line << "`: expected "
+                << describe_journal_result(expected) << ", got " << describe_journal_result(actual) << std::endl;
+        });
+    if (!report.error_message.empty()){
+        std::cerr << "[ERROR] " << report.error_message << std::endl;
+        return 1;
+    }
+    if (report.truncated)
+        flog << "[WARNING] The journal ends in a partial entry (ignored)" << std::endl;
+    flog << "[Info] Replayed " << report.entries << " entries in " << report.replay_s*1E3 << " ms (recorded "
+        << report.recorded_s*1E3 << " ms), " << report.mismatches << " mismatch(es)" << std::endl;
+    return report.mismatches == 0 ? 0 : 1;
 }
 
 int main(int argc, char *argv[]){
@@ -185,6 +351,15 @@ int main(int argc, char *argv[]){
     bool silentFlag = false;
     std::string command = "";
     std::string log_file = "";
+    bool asyncLogFlag = false;
+    std::string trace_file = "";
+    std::string snapshot_file = "";
+    std::string serve_path = "";
+    unsigned int server_workers = 0;
+    std::string journal_file = "";
+    std::string replay_file = "";
+    std::size_t history_entries = mbc::HISTORY_DEFAULT_ENTRIES;
+    std::string history_file = "";
     if (CLIparser.cmdOptionExists("-h") || CLIparser.cmdOptionExists("--help")){
         flog << "Usage mbconsole [OPTIONS]" << std::endl;
         flog << std::endl;
@@ -193,8 +368,21 @@ int main(int argc, char *argv[]){
         flog << "                       (This option will take the highest precedence)" << std::endl;
         flog << "  -p, --piped-input    Operates in piped input/output mode" << std::endl;
         flog << "  -s, --silent         Operates in silent mode" << std::endl;
+        flog << "  -v, --verbose        Prints debug information (variables and resources used) after each line" << std::endl;
         flog << "  -l=s, --log=s        Saves all terminal interactions to given log file" << std::endl;
+        flog << "  --async-log          Writes the log file from a background thread (flushed in batches, on exit and on signals)" << std::endl;
         flog << "  -c=s, --command=s    Executes given command before continuing" << std::endl;
+        flog << "  --trace=s            Writes Chrome/Perfetto trace events of the session to given file" << std::endl;
+        flog << "  --jit-threshold=n    Compiles function bodies to native code after n calls (default " << mbc::JIT_DEFAULT_THRESHOLD << ", 0 disables)" << std::endl;
+        flog << "  --threads=n          Number of threads used by sum, integrate and sweep (default 0, one per core)" << std::endl;
+        flog << "  --snapshot=s         Restores the variables and functions saved to given snapshot file (see `save #file`)" << std::endl;
+        flog << "  --serve=s            Serves isolated sessions to the clients of the given Unix domain socket instead of reading input" << std::endl;
+        flog << "  --workers=n          Number of threads evaluating the requests of --serve (default 0, one per core)" << std::endl;
+        flog << "  --sweep-out=s        Writes the rows of the sweeps to given file as native doubles instead of printing them" << std::endl;
+        flog << "  --journal=s          Records the evaluated lines with their exact results and timestamps to given binary journal" << std::endl;
+        flog << "  --replay=s           Evaluates the lines of given journal as fast as possible, verifies every result and exits" << std::endl;
+        flog << "  --history=n          Number of lines kept in memory for `history` and `recall #n` (default " << mbc::HISTORY_DEFAULT_ENTRIES << ")" << std::endl;
+        flog << "  --history-file=s     Appends the lines that no longer fit in memory (and the rest on exit) to given file" << std::endl;
         /* Perform all cleanup duties and exiting */
         self_cleanup();
         return 0;
@@ -203,6 +391,8 @@ int main(int argc, char *argv[]){
         silentFlag = true;
     if (CLIparser.cmdOptionExists("--piped-input") || CLIparser.cmdOptionExists("-p"))
         pipeFlag = true;
+    if (CLIparser.cmdOptionExists("--verbose") || CLIparser.cmdOptionExists("-v"))
+        verbose = 1;
     if (CLIparser.cmdOptionExists("--command")){
         command = CLIparser.getCmdOption("--command");
         /* Remove the option part */
@@ -221,41 +411,115 @@ int main(int argc, char *argv[]){
         /* Remove the option part */
         log_file.erase(0, 3);
     }
+    if (CLIparser.cmdOptionExists("--async-log"))
+        asyncLogFlag = true;
+    if (CLIparser.cmdOptionExists("--trace")){
+        trace_file = CLIparser.getCmdOption("--trace");
+        /* Remove the option part */
+        trace_file.erase(0, 8);
+    }
+    if (CLIparser.cmdOptionExists("--jit-threshold"))
+        mbc::setJitThreshold(std::strtoul(CLIparser.getCmdOption("--jit-threshold").substr(16).c_str(), nullptr, 10));
+    if (CLIparser.cmdOptionExists("--threads"))
+        mbc::setReduceThreads(std::strtoul(CLIparser.getCmdOption("--threads").substr(10).c_str(), nullptr, 10));
+    if (CLIparser.cmdOptionExists("--snapshot"))
+        snapshot_file = CLIparser.getCmdOption("--snapshot").substr(11);
+    if (CLIparser.cmdOptionExists("--serve"))
+        serve_path = CLIparser.getCmdOption("--serve").substr(8);
+    if (CLIparser.cmdOptionExists("--workers"))
+        server_workers = std::strtoul(CLIparser.getCmdOption("--workers").substr(10).c_str(), nullptr, 10);
+    if (CLIparser.cmdOptionExists("--sweep-out")){
+        const std::string sweep_file = CLIparser.getCmdOption("--sweep-out").substr(12);
+        sweep_out.open(sweep_file, std::ios::binary);
+        if (!sweep_out.good())
+            std::cerr << "[ERROR] Sweep output file `" << sweep_file << "` could not be opened" << std::endl;
+    }
+    if (CLIparser.cmdOptionExists("--journal"))
+        journal_file = CLIparser.getCmdOption("--journal").substr(10);
+    if (CLIparser.cmdOptionExists("--replay"))
+        replay_file = CLIparser.getCmdOption("--replay").substr(9);
+    if (CLIparser.cmdOptionExists("--history"))
+        history_entries = std::strtoull(CLIparser.getCmdOption("--history").substr(10).c_str(), nullptr, 10);
+    if (CLIparser.cmdOptionExists("--history-file"))
+        history_file = CLIparser.getCmdOption("--history-file").substr(15);
     if (!command.empty()){
         command = std::regex_replace(command, std::regex("\\\\n"), "\n");
         if (!std::regex_search(command, std::regex("\n$")))
             command += "\n";
     }
 
+    /* Serve the sessions of the socket clients (every session starts from the snapshot) */
+    if (!serve_path.empty())
+        return run_server({serve_path, server_workers, snapshot_file});
+
     /* Init compute engine */
     mbc::Engine eng;
+    eng.setSweepSink(write_sweep_rows);
+    /* The per line resource counters are only collected while profiling */
+    if (verbose)
+        eng.getProfiler().enable(true);
     std::string result_old;
     std::string result;
+    std::size_t line_number = 0;
+
+    /* Init trace file */
+    if (!trace_file.empty()){
+        if (trace_writer.open(trace_file))
+            eng.getProfiler().setTrace(&trace_writer);
+        else
+            std::cerr << "[ERROR] Trace file `" << trace_file << "` could not be opened" << std::endl;
+    }
 
     /* Init log file */
-    flog.open(log_file);
+    flog.open(log_file, asyncLogFlag);
+
+    /* Init history (the text of the entries is limited to 1 KB per entry on average) */
+    session_history.setLimits(history_entries, std::min(history_entries*1024, mbc::HISTORY_DEFAULT_BYTES*64));
+    if (!history_file.empty() && !session_history.spillTo(history_file))
+        std::cerr << "[ERROR] History file `" << history_file << "` could not be opened" << std::endl;
+
+    /* Restore the session saved to the snapshot file */
+    if (!snapshot_file.empty() && !eng.loadSnapshot(snapshot_file))
+        std::cerr << eng.getErrorMsg();
+
+    /* Replay the journal (the snapshot the session started from can be given with --snapshot) */
+    if (!replay_file.empty()){
+        const int exit_code = replay_journal(eng, replay_file);
+        self_cleanup(true);
+        return exit_code;
+    }
+
+    /* Init journal */
+    if (!journal_file.empty() && !journal.open(journal_file))
+        std::cerr << "[ERROR] Journal file `" << journal_file << "` could not be opened" << std::endl;
 
     /* Process the given commands one line at a time */
     if (!command.empty()){
-        /* If the command has multiple lines */
+        /* If the command has multiple lines (read in place, the lines are not erased from the front) */
         std::size_t pos = 0;
+        std::size_t line_start = 0;
         std::string cmd_line;
-        while ((pos = command.find("\n")) != std::string::npos) {
-            cmd_line = command.substr(0, pos);
+        while ((pos = command.find("\n", line_start)) != std::string::npos) {
+            cmd_line = command.substr(line_start, pos-line_start);
             /* Check the line is an exit command */
             if (cmd_line == "exit"){
                 /* If so cleanup and exit */
                 self_cleanup(silentFlag);
                 return 0;
             }
+            if (run_history_command(cmd_line)){
+                line_start = pos + 1;
+                continue;
+            }
+            session_history.add(cmd_line);
             /* Load and execute the line */
-            eng.load(cmd_line);
-            eng.eval();
+            run_line(eng, cmd_line, ++line_number);
+            print_verbose("[DEBUG] Line resources: "+eng.getProfiler().lineSummary());
             /* Check and print any warnings */
-            if (!eng.getWarningMsg().empty())
+            if (eng.hasWarnings())
                 flog << eng.getWarningMsg();
             /* Check for any errors if there are none print the result to output */
-            if (!eng.getErrorMsg().empty())
+            if (eng.hasErrors())
                 flog << eng.getErrorMsg();
             else{
                 /* Get the last result */
@@ -263,8 +527,8 @@ int main(int argc, char *argv[]){
                     result_old = result;
                 flog << result_old << std::endl;
             }
-            /* Clear command buffer for reading the next line */
-            command.erase(0, pos + 1);
+            /* Move on to the next line */
+            line_start = pos + 1;
         }
     }
 
@@ -297,21 +561,22 @@ int main(int argc, char *argv[]){
             continue;
         } else if (input == "exit")
             break;
+        else if (run_history_command(input))
+            continue;
+        session_history.add(input);
 
-        /* Load the input expression into the engine */
-        eng.load(input);
-
-        /* Evaluate the loaded expression.
+        /* Load the input expression into the engine and evaluate it.
         * Note that multiple expression can be loaded before the eval method is called
         */
-        eng.eval();
+        run_line(eng, input, ++line_number);
         print_verbose("[DEBUG] Variable names: "+mbcs::get_printable_vector(eng._varNames));
         print_verbose("[DEBUG] Variable values: "+mbcs::get_printable_vector(eng._varValues));
+        print_verbose("[DEBUG] Line resources: "+eng.getProfiler().lineSummary());
         /* Check and print any warnings */
-        if (!eng.getWarningMsg().empty())
+        if (eng.hasWarnings())
             flog << eng.getWarningMsg();
         /* Check for any errors if there are none print the result to output */
-        if (!eng.getErrorMsg().empty())
+        if (eng.hasErrors())
             flog << eng.getErrorMsg();
         else{
             /* Get the last result */
@@ -0,0 +1,500 @@
+/****************************************************************************
+* File name: mb_compute_server.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  Evaluation server of the console, an epoll event loop accepting the
+*  clients and reading/writing their sockets with the evaluation of the
+*  requests done by a pool of worker threads.
+****************************************************************************/
+
+/* Includes */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <csignal>
+
+#ifdef __linux__
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+/* Custom libraries */
+#include "mb_compute_server.hpp"
+#include "mbcomputengine_lib.hpp"
+#include "mbcthreads_lib.hpp"
+
+#if defined(__linux__) && defined(MBC_THREADS)
+
+/* Event file descriptor waking the event loop (workers and signals) */
+static int wake_fd = -1;
+static std::atomic<bool> stop_requested(false);
+
+/* Function wakes the event loop (async signal safe) */
+static void wake_loop(void){
+    uint64_t one = 1;
+    ssize_t written = write(wake_fd, &one, sizeof(one));
+    (void)written;
+}
+
+/* Callback function stopping the server on SIGINT and SIGTERM */
+static void stop_signal_handler(int){
+    stop_requested = true;
+    wake_loop();
+}
+
+/* Protocols of a session, decided by the first byte received */
+enum SessionProtocol{
+    PROTOCOL_UNKNOWN,
+    PROTOCOL_TEXT,
+    PROTOCOL_BINARY
+};
+
+/* Structure to hold a client session
+*   The buffers and flags are shared by the event loop and the workers and
+*   are guarded by the lock, the engine is only used by the worker that
+*   scheduled the session (a session is scheduled at most once at a time).
+*/
+struct Session{
+    int fd;
+    mbc::Engine engine;
+    /* Rows of the sweeps of the request being evaluated */
+    std::string sweep_rows;
+    /* Last result printed (the console prints it again for lines without a result) */
+    std::string last_result;
+
+    std::mutex lock;
+    SessionProtocol protocol;
+    /* Bytes received and not evaluated yet, bytes not sent yet */
+    std::string input;
+    std::string output;
+    /* True while the session is queued for or evaluated by a worker */
+    bool scheduled;
+    /* True once the client closed its side of the connection or sent exit */
+    bool input_closed;
+    /* True while the event loop waits for the socket to become writable */
+    bool write_armed;
+
+    Session(int socket_fd) : fd(socket_fd), protocol(PROTOCOL_UNKNOWN), scheduled(false), input_closed(false), write_armed(false){
+        this->engine.setSweepSink([this](const double* rows, std::size_t row_count, std::size_t column_count){
+            for (std::size_t index = 0; index < row_count; ++index)
+                this->sweep_rows += mbc::formatSweepRow(rows+index*column_count, column_count)+"\n";
+        });
+    }
+    ~Session(void){
+        close(this->fd);
+    }
+};
+
+/* Structure to hold the state shared by the event loop and the workers */
+struct ServerState{
+    int epoll_fd;
+    /* Sessions waiting for a worker */
+    std::mutex queue_lock;
+    std::condition_variable queue_ready;
+    std::deque<std::shared_ptr<Session>> queue;
+    bool stopping;
+    /* Sessions the workers handed back to the event loop (output left or closed) */
+    std::mutex handback_lock;
+    std::vector<std::shared_ptr<Session>> handback;
+};
+
+/* Function returns true if the session is sending a text line longer than
+* SERVER_MAX_REQUEST. Must be called with the session locked.
+*/
+static bool text_request_too_long(const Session& session){
+    if (session.input.size() <= SERVER_MAX_REQUEST)
+        return false;
+    if (session.protocol == PROTOCOL_BINARY || (session.protocol == PROTOCOL_UNKNOWN && session.input[0] == '\0'))
+        return false;
+    /* Lines before the last new line character are checked by next_request */
+    std::size_t pos = session.input.rfind('\n');
+    return pos == std::string::npos || session.input.size()-pos-1 > SERVER_MAX_REQUEST;
+}
+
+/* Function moves the next complete request of the session to the given string,
+* returns false if there is none. Must be called with the session locked.
+*/
+static bool next_request(Session& session, std::string& request){
+    if (session.input.empty())
+        return false;
+    if (session.protocol == PROTOCOL_UNKNOWN){
+        session.protocol = session.input[0] == '\0' ? PROTOCOL_BINARY : PROTOCOL_TEXT;
+        if (session.protocol == PROTOCOL_BINARY)
+            session.input.erase(0, 1);
+    }
+    if (session.protocol == PROTOCOL_TEXT){
+        std::size_t pos = session.input.find('\n');
+        if ((pos == std::string::npos && session.input.size() > SERVER_MAX_REQUEST) || (pos != std::string::npos && pos > SERVER_MAX_REQUEST)){
+            /* A broken client, stop reading from it (like an oversized binary request) */
+            session.input.clear();
+            session.input_closed = true;
+            return false;
+        }
+        if (pos == std::string::npos){
+            /* The last line does not need a new line character */
+            if (!session.input_closed)
+                return false;
+            pos = session.input.size();
+        }
+        request.assign(session.input, 0, pos);
+        session.input.erase(0, pos+1);
+        if (!request.empty() && request.back() == '\r')
+            request.pop_back();
+        return true;
+    }
+    if (session.input.size() < 4)
+        return false;
+    const unsigned char* header = reinterpret_cast<const unsigned char*>(session.input.data());
+    const uint32_t length = header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<uint32_t>(header[3]) << 24);
+    if (length > SERVER_MAX_REQUEST){
+        /* A broken client, stop reading from it */
+        session.input.clear();
+        session.input_closed = true;
+        return false;
+    }
+    if (session.input.size()-4 < length)
+        return false;
+    request.assign(session.input, 4, length);
+    session.input.erase(0, 4+length);
+    return true;
+}
+
+/* Function evaluates a request line and returns the output the console prints for it */
+static std::string evaluate_request(Session& session, const std::string& request, bool& error){
+    error = false;
+    if (request.empty())
+        return "";
+    session.sweep_rows.clear();
+    session.engine.load(request);
+    session.engine.eval();
+    std::string response = session.sweep_rows;
+    if (session.engine.hasWarnings())
+        response += session.engine.getWarningMsg();
+    if (session.engine.hasErrors()){
+        response += session.engine.getErrorMsg();
+        error = true;
+    } else{
+        /* Get the last result */
+        std::string result;
+        while ((result = session.engine.getResult()) != mbc::RESULT_END)
+            session.last_result = result;
+        response += session.last_result+"\n";
+    }
+    return response;
+}
+
+/* Function sends as much of the output of the session as the socket takes.
+* Must be called with the session locked.
+*/
+static void flush_output(Session& session){
+    while (!session.output.empty()){
+        ssize_t count = send(session.fd, session.output.data(), session.output.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (count > 0){
+            session.output.erase(0, count);
+            continue;
+        }
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        /* The client is gone */
+        session.output.clear();
+        session.input.clear();
+        session.input_closed = true;
+        return;
+    }
+}
+
+/* Function evaluates every complete request of the session (run by a worker) */
+static void process_session(ServerState& state, const std::shared_ptr<Session>& session){
+    std::string request;
+    while (true){
+        {
+            std::lock_guard<std::mutex> guard(session->lock);
+            if (!next_request(*session, request)){
+                session->scheduled = false;
+                /* The event loop sends the rest of the output and closes finished sessions */
+                if (session->output.empty() && !session->input_closed)
+                    return;
+                break;
+            }
+        }
+        std::string response;
+        bool error = false;
+        if (request == "exit"){
+            std::lock_guard<std::mutex> guard(session->lock);
+            session->input.clear();
+            session->input_closed = true;
+            continue;
+        }
+        response = evaluate_request(*session, request, error);
+
+        std::lock_guard<std::mutex> guard(session->lock);
+        if (session->protocol == PROTOCOL_BINARY){
+            const uint32_t length = static_cast<uint32_t>(response.size());
+            const char header[5] = {static_cast<char>(error ? SERVER_STATUS_ERROR : SERVER_STATUS_OK),
+                static_cast<char>(length & 0xFF), static_cast<char>((length >> 8) & 0xFF),
+                static_cast<char>((length >> 16) & 0xFF), static_cast<char>((length >> 24) & 0xFF)};
+            session->output.append(header, sizeof(header));
+        }
+        session->output += response;
+        /* Send right away, the event loop only takes over if the socket is full */
+        if (!session->write_armed)
+            flush_output(*session);
+    }
+    {
+        std::lock_guard<std::mutex> guard(state.handback_lock);
+        state.handback.push_back(session);
+    }
+    wake_loop();
+}
+
+/* Function run by the worker threads */
+static void worker_loop(ServerState& state){
+    while (true){
+        std::shared_ptr<Session> session;
+        {
+            std::unique_lock<std::mutex> guard(state.queue_lock);
+            state.queue_ready.wait(guard, [&state]{ return state.stopping || !state.queue.empty(); });
+            if (state.queue.empty())
+                return;
+            session = state.queue.front();
+            state.queue.pop_front();
+        }
+        process_session(state, session);
+    }
+}
+
+/* Function queues the session for a worker if it has input and is not queued yet.
+* Must be called with the session locked.
+*/
+static void schedule_session(ServerState& state, const std::shared_ptr<Session>& session){
+    if (session->scheduled || (session->input.empty() && !session->input_closed))
+        return;
+    session->scheduled = true;
+    {
+        std::lock_guard<std::mutex> guard(state.queue_lock);
+        state.queue.push_back(session);
+    }
+    state.queue_ready.notify_one();
+}
+
+/* Function updates the events the event loop waits for on the session's socket.
+* Must be called with the session locked.
+*/
+static void update_events(ServerState& state, Session& session){
+    struct epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.data.fd = session.fd;
+    event.events = (session.input_closed ? 0 : EPOLLIN) | (session.write_armed ? EPOLLOUT : 0);
+    epoll_ctl(state.epoll_fd, EPOLL_CTL_MOD, session.fd, &event);
+}
+
+int run_server(const ServerOptions& options){
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (options.socket_path.empty() || options.socket_path.size() >= sizeof(address.sun_path)){
+        std::cerr << "[ERROR] Invalid socket path `" << options.socket_path << "`" << std::endl;
+        return 1;
+    }
+    std::strncpy(address.sun_path, options.socket_path.c_str(), sizeof(address.sun_path)-1);
+
+    /* Check the snapshot once so a bad file is reported at startup */
+    if (!options.snapshot_file.empty()){
+        mbc::Engine check_eng;
+        if (!check_eng.loadSnapshot(options.snapshot_file)){
+            std::cerr << check_eng.getErrorMsg();
+            return 1;
+        }
+    }
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(options.socket_path.c_str());
+    if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listen_fd, SOMAXCONN) != 0){
+        std::cerr << "[ERROR] [ERROR_CODE=" << errno << "] Could not listen on `" << options.socket_path << "`" << std::endl;
+        if (listen_fd >= 0)
+            close(listen_fd);
+        return 1;
+    }
+
+    ServerState state;
+    state.stopping = false;
+    state.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd;
+    epoll_ctl(state.epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    event.data.fd = wake_fd;
+    epoll_ctl(state.epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+
+    /* Stop cleanly on SIGINT/SIGTERM, a client closing its socket must not kill the server */
+    signal(SIGINT, stop_signal_handler);
+    signal(SIGTERM, stop_signal_handler);
+    signal(SIGPIPE, SIG_IGN);
+
+    unsigned int worker_count = options.workers;
+    if (worker_count == 0)
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+    for (unsigned int index = 0; index < worker_count; ++index)
+        workers.emplace_back(worker_loop, std::ref(state));
+    std::cout << "[Info] Serving on `" << options.socket_path << "` with " << worker_count << " worker(s)" << std::endl;
+
+    std::map<int, std::shared_ptr<Session>> sessions;
+    auto drop_session = [&state, &sessions](const std::shared_ptr<Session>& session){
+        auto session_it = sessions.find(session->fd);
+        if (session_it == sessions.end() || session_it->second != session)
+            return;
+        epoll_ctl(state.epoll_fd, EPOLL_CTL_DEL, session->fd, nullptr);
+        sessions.erase(session_it);
+    };
+
+    struct epoll_event events[64];
+    char buffer[65536];
+    while (!stop_requested){
+        int event_count = epoll_wait(state.epoll_fd, events, 64, -1);
+        for (int event_index = 0; event_index < event_count; ++event_index){
+            const int fd = events[event_index].data.fd;
+            if (fd == listen_fd){
+                /* New clients */
+                int client_fd;
+                while ((client_fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0){
+                    auto session = std::make_shared<Session>(client_fd);
+                    if (!options.snapshot_file.empty())
+                        session->engine.loadSnapshot(options.snapshot_file);
+                    sessions[client_fd] = session;
+                    struct epoll_event client_event;
+                    std::memset(&client_event, 0, sizeof(client_event));
+                    client_event.events = EPOLLIN;
+                    client_event.data.fd = client_fd;
+                    epoll_ctl(state.epoll_fd, EPOLL_CTL_ADD, client_fd, &client_event);
+                }
+                continue;
+            }
+            if (fd == wake_fd){
+                /* Sessions handed back by the workers */
+                uint64_t count;
+                ssize_t read_count = read(wake_fd, &count, sizeof(count));
+                (void)read_count;
+                std::vector<std::shared_ptr<Session>> handback;
+                {
+                    std::lock_guard<std::mutex> guard(state.handback_lock);
+                    handback.swap(state.handback);
+                }
+                for (const std::shared_ptr<Session>& session : handback){
+                    std::lock_guard<std::mutex> guard(session->lock);
+                    flush_output(*session);
+                    if (session->output.empty() && session->input_closed && !session->scheduled)
+                        drop_session(session);
+                    else if (!session->output.empty() && !session->write_armed){
+                        session->write_armed = true;
+                        update_events(state, *session);
+                    }
+                }
+                continue;
+            }
+            auto session_it = sessions.find(fd);
+            if (session_it == sessions.end())
+                continue;
+            std::shared_ptr<Session> session = session_it->second;
+            std::lock_guard<std::mutex> guard(session->lock);
+            if (events[event_index].events & (EPOLLHUP | EPOLLERR)){
+                /* Both sides are closed, nothing can be sent any more (the socket is no longer
+                * polled, a worker evaluating the session hands it back to be dropped)
+                */
+                session->input.clear();
+                session->output.clear();
+                session->input_closed = true;
+                epoll_ctl(state.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+            } else if (events[event_index].events & EPOLLIN){
+                /* Read everything available */
+                while (!session->input_closed){
+                    ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+                    if (count > 0){
+                        session->input.append(buffer, count);
+                        /* Do not buffer a text line beyond the request size limit */
+                        if (text_request_too_long(*session)){
+                            session->input.clear();
+                            session->input_closed = true;
+                        }
+                    } else if (count < 0 && errno == EINTR)
+                        continue;
+                    else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                        break;
+                    else
+                        session->input_closed = true;
+                }
+                if (session->input_closed)
+                    update_events(state, *session);
+                schedule_session(state, session);
+            }
+            if (events[event_index].events & EPOLLOUT){
+                flush_output(*session);
+                if (session->output.empty()){
+                    session->write_armed = false;
+                    update_events(state, *session);
+                }
+            }
+            if (session->input_closed && session->output.empty() && !session->scheduled)
+                drop_session(session);
+        }
+    }
+
+    /* Stop the workers and close every session */
+    {
+        std::lock_guard<std::mutex> guard(state.queue_lock);
+        state.stopping = true;
+        state.queue.clear();
+    }
+    state.queue_ready.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+    sessions.clear();
+    close(listen_fd);
+    close(state.epoll_fd);
+    close(wake_fd);
+    unlink(options.socket_path.c_str());
+    std::cout << "[Info] Server stopped" << std::endl;
+    return 0;
+}
+
+#else
+
+int run_server(const ServerOptions& options){
+    std::cerr << "[ERROR] The evaluation server (`--serve=" << options.socket_path << "`) is only supported on Linux builds with threads" << std::endl;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,64 @@
+/****************************************************************************
+* File name: mb_compute_server.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  Evaluation server of the console (see `mbconsole --serve=path`).
+*
+*  Clients connect to a Unix domain socket, every connection is a session
+*  with its own engine. Requests are evaluated on a pool of worker threads,
+*  the requests of a session are evaluated in order.
+*  Two protocols are supported (chosen by the first byte of a connection):
+*   - text:   lines as typed into `mbconsole --silent`, every line is
+*             answered with the output the console prints for it. An
+*             `exit` line closes the session.
+*   - binary: a connection starting with a NUL byte. Requests are a 32 bit
+*             length (little endian) followed by the line, every request
+*             is answered with a status byte (SERVER_STATUS_OK or
+*             SERVER_STATUS_ERROR), a 32 bit length and the output text.
+*  The server is only supported on Linux (epoll).
+****************************************************************************/
+#ifndef __MB_COMPUTE_SERVER__
+
+#define __MB_COMPUTE_SERVER__
+/* Includes */
+#include <string>
+#include <cstdint>
+
+/* Status bytes of the responses of the binary protocol */
+const uint8_t SERVER_STATUS_OK = 0;
+const uint8_t SERVER_STATUS_ERROR = 1;
+
+/* Maximum size of a request of either protocol (bigger requests close the session) */
+const uint32_t SERVER_MAX_REQUEST = 16*1024*1024;
+
+/* Structure to hold the options of the evaluation server */
+struct ServerOptions{
+    /* Path of the Unix domain socket (replaced if it exists) */
+    std::string socket_path;
+    /* Number of worker threads (0 for one per core) */
+    unsigned int workers;
+    /* Snapshot every session starts from (none if empty, see Engine::loadSnapshot) */
+    std::string snapshot_file;
+};
+
+/* Function runs the evaluation server until SIGINT or SIGTERM is received,
+* returns the exit code of the console.
+*/
+int run_server(const ServerOptions&);
+
+#endif
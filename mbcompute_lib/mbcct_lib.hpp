@@ -0,0 +1,507 @@
+/****************************************************************************
+* File name: mbcct_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine compile time expression header (header only).
+*  Expressions written in the engine's syntax are parsed by the compiler
+*  and turned into plain inline C++, there is no parsing at run time.
+*
+*  Usage (requires C++20):
+*   constexpr mbc::ct::expr<"a*2k+b"> fun;
+*   double result = fun(a, b);
+*  The inputs are the variable names of the expression in the order they
+*  first appear. Errors in the expression fail the compilation.
+****************************************************************************/
+#ifndef __MB_COMPUTE_CT_LIB__
+
+#define __MB_COMPUTE_CT_LIB__
+/* Includes */
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <string_view>
+
+/* Custom libraries */
+#include "mbcvm_lib.hpp"
+
+namespace mbc{
+namespace ct{
+
+/* Structure to hold a compile time operator
+* The table mirrors SUPPORTED_OOPS (same symbols and precedence order).
+*/
+struct Operator{
+    const char* symbol;
+    /* Operator precedence (lower value = higher precedence) */
+    unsigned int order;
+    OpCode op;
+    unsigned int arity;
+};
+
+/* List of supported operators (see SUPPORTED_OOPS) */
+constexpr Operator OPERATORS[]{
+    {"++", 1,  OP_INC,     1},
+    {"--", 1,  OP_DEC,     1},
+    {"**", 2,  OP_POW,     2},
+    {"*",  3,  OP_MUL,     2},
+    {"/",  3,  OP_DIV,     2},
+    {"%",  3,  OP_MOD,     2},
+    {"+",  4,  OP_ADD,     2},
+    {"-",  4,  OP_SUB,     2},
+    {"<<", 5,  OP_SHL,     2},
+    {">>", 5,  OP_SHR,     2},
+    {"<",  6,  OP_LT,      2},
+    {">",  6,  OP_GT,      2},
+    {"==", 7,  OP_EQ,      2},
+    {"!=", 8,  OP_NE,      2},
+    {"&",  9,  OP_BIT_AND, 2},
+    {"^",  10, OP_BIT_XOR, 2},
+    {"|",  11, OP_BIT_OR,  2},
+    {"!",  12, OP_NOT,     1},
+    {"&&", 13, OP_AND,     2},
+    {"^^", 14, OP_XOR,     2},
+    {"||", 15, OP_OR,      2},
+};
+
+/* Structure to hold a compile time inbuilt function (see SUPPORTED_FUNS) */
+struct Function{
+    const char* name;
+    OpCode op;
+    unsigned int arity;
+};
+
+/* List of supported inbuilt functions
+* Unlike the engine the results are not rounded to the 6 decimals of the
+* textual function expansion.
+*/
+constexpr Function FUNCTIONS[]{
+    {"ln",    OP_LN,    1},
+    {"log",   OP_LOG10, 1},
+    {"ceil",  OP_CEIL,  1},
+    {"floor", OP_FLOOR, 1},
+    {"abs",   OP_ABS,   1},
+    {"cos",   OP_COS,   1},
+    {"sin",   OP_SIN,   1},
+    {"tan",   OP_TAN,   1},
+    {"cosh",  OP_COSH,  1},
+    {"sinh",  OP_SINH,  1},
+    {"tanh",  OP_TANH,  1},
+    {"pow",   OP_POW,   2},
+};
+
+/* Structure to hold an SI prefix and its scale (see Evaluator::parseExpr) */
+struct Prefix{
+    const char* symbol;
+    double scale;
+};
+
+/* List of supported SI prefixes, "da" is listed before "d" so it is matched first */
+constexpr Prefix PREFIXES[]{
+    {"Y", 1E+24}, {"Z", 1E+21}, {"E", 1E+18}, {"P", 1E+15}, {"T", 1E+12},
+    {"G", 1E+9}, {"M", 1E+6}, {"k", 1E+3}, {"h", 1E+2}, {"da", 1E+1},
+    {"d", 1E-1}, {"c", 1E-2}, {"m", 1E-3}, {"u", 1E-6}, {"n", 1E-9},
+    {"p", 1E-12}, {"f", 1E-15}, {"a", 1E-18}, {"z", 1E-21}, {"y", 1E-24},
+};
+
+/* Method applies the given opcode, the operations are the ones of the virtual machine (see mbcvm_lib.cpp) */
+template<OpCode Op>
+constexpr double apply(double lhs, double rhs = 0){
+    if constexpr (Op == OP_INC) return lhs + 1;
+    else if constexpr (Op == OP_DEC) return lhs - 1;
+    else if constexpr (Op == OP_POW) return std::pow(lhs, rhs);
+    else if constexpr (Op == OP_MUL) return lhs * rhs;
+    else if constexpr (Op == OP_DIV) return lhs / rhs;
+    else if constexpr (Op == OP_MOD) return std::fmod(lhs, rhs);
+    else if constexpr (Op == OP_ADD) return lhs + rhs;
+    else if constexpr (Op == OP_SUB) return lhs - rhs;
+    else if constexpr (Op == OP_SHL) return static_cast<double>(static_cast<long long>(lhs) << static_cast<long long>(rhs));
+    else if constexpr (Op == OP_SHR) return static_cast<double>(static_cast<long long>(lhs) >> static_cast<long long>(rhs));
+    else if constexpr (Op == OP_LT) return static_cast<double>(lhs < rhs);
+    else if constexpr (Op == OP_GT) return static_cast<double>(lhs > rhs);
+    else if constexpr (Op == OP_EQ) return static_cast<double>(lhs == rhs);
+    else if constexpr (Op == OP_NE) return static_cast<double>(lhs != rhs);
+    else if constexpr (Op == OP_BIT_AND) return static_cast<double>(static_cast<long long>(lhs) & static_cast<long long>(rhs));
+    else if constexpr (Op == OP_BIT_XOR) return static_cast<double>(static_cast<long long>(lhs) ^ static_cast<long long>(rhs));
+    else if constexpr (Op == OP_BIT_OR) return static_cast<double>(static_cast<long long>(lhs) | static_cast<long long>(rhs));
+    else if constexpr (Op == OP_NOT) return static_cast<double>(!lhs);
+    else if constexpr (Op == OP_AND) return static_cast<double>(lhs && rhs);
+    else if constexpr (Op == OP_XOR) return static_cast<double>(!lhs != !rhs);
+    else if constexpr (Op == OP_OR) return static_cast<double>(lhs || rhs);
+    else if constexpr (Op == OP_LN) return std::log(lhs);
+    else if constexpr (Op == OP_LOG10) return std::log10(lhs);
+    else if constexpr (Op == OP_CEIL) return std::ceil(lhs);
+    else if constexpr (Op == OP_FLOOR) return std::floor(lhs);
+    else if constexpr (Op == OP_ABS) return std::abs(lhs);
+    else if constexpr (Op == OP_COS) return std::cos(lhs);
+    else if constexpr (Op == OP_SIN) return std::sin(lhs);
+    else if constexpr (Op == OP_TAN) return std::tan(lhs);
+    else if constexpr (Op == OP_COSH) return std::cosh(lhs);
+    else if constexpr (Op == OP_SINH) return std::sinh(lhs);
+    else if constexpr (Op == OP_TANH) return std::tanh(lhs);
+    else static_assert(Op == OP_TANH, "mbc::ct::apply: opcode has no operation");
+}
+
+}
+}
+
+#if __cplusplus >= 202002L
+
+namespace mbc{
+namespace ct{
+
+/* FixedString class holding a string literal given as a template argument */
+template<std::size_t N>
+struct FixedString{
+    char value[N]{};
+    constexpr FixedString(const char (&str)[N]){
+        for (std::size_t index = 0; index < N; ++index)
+            this->value[index] = str[index];
+    }
+    constexpr std::string_view view(void) const{ return std::string_view(this->value, N-1); }
+};
+
+/* Method reports an error in an expression
+* It is not constexpr so reaching it while parsing fails the compilation,
+* the compiler diagnostic shows the message.
+*/
+inline void parseError(const char* message){
+    (void)message;
+}
+
+/* Node of a parsed expression tree */
+enum class NodeKind : uint8_t{ CONSTANT, INPUT, OPERATION };
+struct Node{
+    NodeKind kind = NodeKind::CONSTANT;
+    OpCode op = OP_COUNT;
+    unsigned int arity = 0;
+    /* Operand nodes (lhs, rhs), rhs is unused by unary opcodes */
+    std::size_t a = 0;
+    std::size_t b = 0;
+    double value = 0;
+    std::size_t input = 0;
+};
+
+/* Tree class holding a parsed expression, N is the length of the source
+* (an expression never has more tokens, nodes or inputs than characters)
+*/
+template<std::size_t N>
+struct Tree{
+    std::array<Node, N> nodes{};
+    std::size_t node_count = 0;
+    std::size_t root = 0;
+    std::array<std::string_view, N> inputs{};
+    std::size_t input_count = 0;
+};
+
+/* Methods to classify characters (std::isdigit and friends are not constexpr) */
+constexpr bool isDigit(char c){ return c >= '0' && c <= '9'; }
+constexpr bool isNameStart(char c){ return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+constexpr bool isSpace(char c){ return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; }
+
+/* Method returns 10^exponent for 0 <= exponent <= 22 (exact in a double) */
+constexpr double pow10(int exponent){
+    double result = 1;
+    for (; exponent > 0; --exponent)
+        result *= 10;
+    return result;
+}
+
+/* Method converts a number literal (digits, an optional fraction and an optional E+/-exponent).
+* Literals with up to 15 significant digits and exponents up to 22 are converted
+* exactly as std::atof does, longer literals may differ in the last bit.
+*/
+constexpr double parseNumber(std::string_view literal){
+    unsigned long long mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    std::size_t index = 0;
+    bool flag_fraction = false;
+    for (; index < literal.size() && (isDigit(literal[index]) || literal[index] == '.'); ++index){
+        if (literal[index] == '.'){
+            if (flag_fraction)
+                parseError("mbc::ct: number with more than one decimal point");
+            flag_fraction = true;
+        } else if (digits < 19){
+            if (mantissa != 0 || literal[index] != '0')
+                ++digits;
+            mantissa = mantissa*10+static_cast<unsigned long long>(literal[index]-'0');
+            if (flag_fraction)
+                --exponent;
+        } else if (!flag_fraction)
+            /* Digits beyond the precision of the mantissa only scale the value */
+            ++exponent;
+    }
+    if (index < literal.size()){
+        /* Scientific exponent (E+n or E-n) */
+        bool flag_negative = literal[index+1] == '-';
+        int value = 0;
+        for (index += 2; index < literal.size(); ++index)
+            value = value*10+(literal[index]-'0');
+        exponent += flag_negative ? -value : value;
+    }
+    double result = static_cast<double>(mantissa);
+    /* Scale in steps that keep each factor exact */
+    while (exponent > 22){
+        result *= 1E+22;
+        exponent -= 22;
+    }
+    while (exponent < -22){
+        result /= 1E+22;
+        exponent += 22;
+    }
+    return exponent < 0 ? result/pow10(-exponent) : result*pow10(exponent);
+}
+
+/* Method parses an expression in the engine's syntax into an expression tree
+*  The tokens are the ones produced by Evaluator::parseExpr (numbers with SI
+*  prefixes, negative literals, names and one or two character operators)
+*  and the postfix conversion follows Evaluator::convertToPostfix so the
+*  result is the one the engine gives for the same expression.
+*/
+template<std::size_t N>
+constexpr Tree<N> parse(std::string_view source){
+    Tree<N> tree;
+
+    /* Postfix output, an entry is either a node (operand) or an operation */
+    struct Entry{
+        bool flag_operation = false;
+        std::size_t node = 0;
+        OpCode op = OP_COUNT;
+        unsigned int arity = 0;
+    };
+    std::array<Entry, N> postfix{};
+    std::size_t postfix_count = 0;
+
+    /* Operator stack, brackets are kept with the function they call (if any) */
+    struct StackEntry{
+        /* Opening bracket character or 0 for an operator */
+        char bracket = 0;
+        unsigned int order = 0;
+        OpCode op = OP_COUNT;
+        unsigned int arity = 0;
+        /* Function called by this bracket and the number of arguments seen */
+        bool flag_call = false;
+        unsigned int args = 1;
+    };
+    std::array<StackEntry, N> stack{};
+    std::size_t stack_count = 0;
+
+    auto add_constant = [&](double value){
+        tree.nodes[tree.node_count] = Node{NodeKind::CONSTANT, OP_COUNT, 0, 0, 0, value, 0};
+        postfix[postfix_count++] = Entry{false, tree.node_count++, OP_COUNT, 0};
+    };
+    auto pop_operator = [&](){
+        --stack_count;
+        postfix[postfix_count++] = Entry{true, 0, stack[stack_count].op, stack[stack_count].arity};
+    };
+    /* Pops operators up to the matching opening bracket (which is left on the stack) */
+    auto pop_to_bracket = [&](char close){
+        while (stack_count != 0 && stack[stack_count-1].bracket == 0)
+            pop_operator();
+        if (stack_count == 0)
+            parseError("mbc::ct: unmatched closing bracket");
+        char open = stack[stack_count-1].bracket;
+        if ((close == ')' && open != '(') || (close == ']' && open != '[') || (close == '}' && open != '{'))
+            parseError("mbc::ct: mismatched brackets");
+    };
+
+    /* True if the previous token ends an operand (a '-' following it is a subtraction) */
+    bool flag_operand = false;
+    for (std::size_t index = 0; index < source.size();){
+        char c = source[index];
+        if (isSpace(c)){
+            ++index;
+            continue;
+        }
+        if (isDigit(c) || c == '.' || (c == '-' && !flag_operand && index+1 < source.size() && isDigit(source[index+1]))){
+            /* Number literal with an optional scientific exponent and SI prefixes */
+            std::size_t start = index;
+            if (c == '-')
+                ++index;
+            while (index < source.size() && (isDigit(source[index]) || source[index] == '.'))
+                ++index;
+            if (index+2 < source.size() && source[index] == 'E' && (source[index+1] == '+' || source[index+1] == '-') && isDigit(source[index+2])){
+                index += 2;
+                while (index < source.size() && isDigit(source[index]))
+                    ++index;
+            }
+            double value = parseNumber(source.substr(c == '-' ? start+1 : start, index-(c == '-' ? start+1 : start)));
+            if (c == '-')
+                value = -value;
+            /* Every prefix is a multiplication as in the engine (2kk is 2*1E+3*1E+3) */
+            bool flag_prefix = true;
+            while (flag_prefix && index < source.size()){
+                flag_prefix = false;
+                for (const Prefix& prefix : PREFIXES){
+                    std::string_view symbol(prefix.symbol);
+                    if (source.substr(index, symbol.size()) == symbol){
+                        value *= prefix.scale;
+                        index += symbol.size();
+                        flag_prefix = true;
+                        break;
+                    }
+                }
+            }
+            add_constant(value);
+            flag_operand = true;
+        } else if (isNameStart(c)){
+            /* Variable name or inbuilt function call */
+            std::size_t start = index;
+            while (index < source.size() && (isNameStart(source[index]) || isDigit(source[index])))
+                ++index;
+            std::string_view name = source.substr(start, index-start);
+            std::size_t next = index;
+            while (next < source.size() && isSpace(source[next]))
+                ++next;
+            if (next < source.size() && source[next] == '('){
+                const Function* function = nullptr;
+                for (const Function& item : FUNCTIONS)
+                    if (name == std::string_view(item.name))
+                        function = &item;
+                if (function == nullptr)
+                    parseError("mbc::ct: unknown function");
+                stack[stack_count++] = StackEntry{'(', 0, function->op, function->arity, true, 1};
+                index = next+1;
+                flag_operand = false;
+                continue;
+            }
+            std::size_t input = 0;
+            while (input < tree.input_count && tree.inputs[input] != name)
+                ++input;
+            if (input == tree.input_count)
+                tree.inputs[tree.input_count++] = name;
+            tree.nodes[tree.node_count] = Node{NodeKind::INPUT, OP_COUNT, 0, 0, 0, 0, input};
+            postfix[postfix_count++] = Entry{false, tree.node_count++, OP_COUNT, 0};
+            flag_operand = true;
+        } else if (c == '(' || c == '[' || c == '{'){
+            stack[stack_count++] = StackEntry{c, 0, OP_COUNT, 0, false, 1};
+            ++index;
+            flag_operand = false;
+        } else if (c == ')' || c == ']' || c == '}'){
+            pop_to_bracket(c);
+            StackEntry bracket = stack[--stack_count];
+            if (bracket.flag_call){
+                if (bracket.args != bracket.arity)
+                    parseError("mbc::ct: wrong number of function arguments");
+                postfix[postfix_count++] = Entry{true, 0, bracket.op, bracket.arity};
+            }
+            ++index;
+            flag_operand = true;
+        } else if (c == ','){
+            pop_to_bracket(')');
+            if (!stack[stack_count-1].flag_call)
+                parseError("mbc::ct: argument separator outside of a function call");
+            ++stack[stack_count-1].args;
+            ++index;
+            flag_operand = false;
+        } else{
+            /* Operator, two character operators are matched first */
+            const Operator* oop = nullptr;
+            for (const Operator& item : OPERATORS){
+                std::string_view symbol(item.symbol);
+                if (source.substr(index, symbol.size()) == symbol && (oop == nullptr || symbol.size() > std::string_view(oop->symbol).size()))
+                    oop = &item;
+            }
+            if (oop == nullptr)
+                parseError("mbc::ct: unknown operator");
+            /* Only the top of the stack is popped (see Evaluator::convertToPostfix) */
+            if (stack_count != 0 && stack[stack_count-1].bracket == 0 && stack[stack_count-1].order <= oop->order)
+                pop_operator();
+            stack[stack_count++] = StackEntry{0, oop->order, oop->op, oop->arity, false, 1};
+            index += std::string_view(oop->symbol).size();
+            flag_operand = false;
+        }
+    }
+    while (stack_count != 0){
+        if (stack[stack_count-1].bracket != 0)
+            parseError("mbc::ct: unmatched opening bracket");
+        pop_operator();
+    }
+
+    /* Build the tree from the postfix expression */
+    std::array<std::size_t, N> operands{};
+    std::size_t operand_count = 0;
+    for (std::size_t index = 0; index < postfix_count; ++index){
+        const Entry& entry = postfix[index];
+        if (!entry.flag_operation){
+            operands[operand_count++] = entry.node;
+            continue;
+        }
+        if (operand_count < entry.arity)
+            parseError("mbc::ct: missing operand");
+        std::size_t rhs = operands[--operand_count];
+        std::size_t lhs = entry.arity == 2 ? operands[--operand_count] : rhs;
+        tree.nodes[tree.node_count] = Node{NodeKind::OPERATION, entry.op, entry.arity, lhs, rhs, 0, 0};
+        operands[operand_count++] = tree.node_count++;
+    }
+    if (operand_count == 0)
+        parseError("mbc::ct: empty expression");
+    if (operand_count > 1)
+        parseError("mbc::ct: multiple results");
+    tree.root = operands[0];
+    return tree;
+}
+
+/* expr class for an expression parsed at compile time
+*  The call operator takes one value per input (see inputs) and evaluates
+*  the expression as inline code, the same as writing it by hand.
+*/
+template<FixedString Source>
+class expr{
+private:
+    static constexpr Tree<sizeof(Source.value)> _tree = parse<sizeof(Source.value)>(Source.view());
+public:
+    /* Number of inputs */
+    static constexpr std::size_t arity = _tree.input_count;
+
+    /* Input names in the order the call operator takes them */
+    static constexpr std::array<std::string_view, arity> inputs = [](){
+        std::array<std::string_view, arity> names{};
+        for (std::size_t index = 0; index < arity; ++index)
+            names[index] = _tree.inputs[index];
+        return names;
+    }();
+
+    /* Method evaluates the given node on the inputs */
+    template<std::size_t I>
+    static constexpr double eval(const std::array<double, arity>& values){
+        constexpr Node node = _tree.nodes[I];
+        if constexpr (node.kind == NodeKind::CONSTANT)
+            return node.value;
+        else if constexpr (node.kind == NodeKind::INPUT)
+            return values[node.input];
+        else if constexpr (node.arity == 1)
+            return apply<node.op>(eval<node.a>(values));
+        else
+            return apply<node.op>(eval<node.a>(values), eval<node.b>(values));
+    }
+
+    /* Method evaluates the expression on the given inputs */
+    template<typename... Args>
+    constexpr double operator()(Args... args) const{
+        static_assert(sizeof...(Args) == arity, "mbc::ct::expr: one argument is needed per input of the expression");
+        return eval<_tree.root>(std::array<double, arity>{static_cast<double>(args)...});
+    }
+};
+
+}
+}
+
+#endif
+
+#endif
@@ -0,0 +1,193 @@
+/****************************************************************************
+* File name: mbcdiag_lib.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine diagnostics library containing the messages of
+*  the diagnostic codes and their formatting.
+****************************************************************************/
+
+#include <algorithm>
+#include <iterator>
+
+#include "mbcdiag_lib.hpp"
+
+namespace mbc{
+
+/* Descriptions of the diagnostic codes (indexed by DiagCode) */
+static constexpr DiagInfo DIAG_TABLE[]{
+    {DIAG_UNBALANCED_PARENTHESES, SEVERITY_ERROR, "unbalanced-parentheses", "[Engine] ERROR: Unbalanced parentheses in expression `{0}`!"},
+    {DIAG_UNBALANCED_QUOTES, SEVERITY_ERROR, "unbalanced-quotes", "[Engine] ERROR: Unbalanced quotes in expression `{0}`!"},
+    {DIAG_UNDEFINED_FUNCTION, SEVERITY_ERROR, "undefined-function", "[Engine] ERROR: Undefined function `{0}` called!"},
+    {DIAG_UNDEFINED_VARIABLE, SEVERITY_ERROR, "undefined-variable", "[Engine] ERROR: Undefined variable `{0}` used!"},
+    {DIAG_INVALID_EXPRESSION, SEVERITY_ERROR, "invalid-expression", "[Engine] ERROR: Invalid expression `{0}`!"},
+    {DIAG_TOO_MANY_ARGUMENTS, SEVERITY_ERROR, "too-many-arguments", "[Engine] ERROR: Too many arguments passed to function `{0}`! `{0}` got {1} argument(s) but it's definition only takes {2} argument(s)"},
+    {DIAG_TOO_FEW_ARGUMENTS, SEVERITY_ERROR, "too-few-arguments", "[Engine] ERROR: Insufficent number of arguments passed to function `{0}`! `{0}` got {1} argument(s) but it's definition requires {2} argument(s) out of which {3} {4} optional"},
+    {DIAG_INLINE_TOO_MANY_ARGUMENTS, SEVERITY_ERROR, "inline-too-many-arguments", "[Engine] ERROR: Too many arguments passed to function `{0}`!"},
+    {DIAG_INLINE_NO_DEFAULT, SEVERITY_ERROR, "inline-no-default", "[Engine] ERROR: Insufficent number of arguments passed to function `{0}`! The argument `{1}` has no default value"},
+    {DIAG_INLINE_TOO_DEEP, SEVERITY_ERROR, "inline-too-deep", "[Engine] ERROR: Function calls are nested too deep to be inlined (recursive function?)!"},
+    {DIAG_CALLS_TOO_DEEP, SEVERITY_ERROR, "calls-too-deep", "[Engine] ERROR: Function calls are nested more than {0} levels deep (recursive function?)!"},
+    {DIAG_EXPANSION_TOO_LARGE, SEVERITY_ERROR, "expansion-too-large", "[Engine] ERROR: The expression grows beyond {0} bytes once its function calls are expanded!"},
+    {DIAG_OPERATION_ARITY, SEVERITY_ERROR, "operation-arity", "[Engine] ERROR: `{0}` takes {1} argument(s)!"},
+    {DIAG_UNKNOWN_RESERVED, SEVERITY_ERROR, "unknown-reserved", "[Engine] ERROR: An unknown function call was detected `{0}`!"},
+    {DIAG_EMPTY_FUNCTION, SEVERITY_WARNING, "empty-function", "[Warning] Function `{0}` does not have a body, it will always return 0 by default!"},
+    {DIAG_UNDEFINED_FUNCTION_ARGUMENT, SEVERITY_ERROR, "undefined-function-argument", "[Engine] ERROR: Undefined function `{0}` passed to `{1}`!"},
+    {DIAG_SOLVER_USAGE, SEVERITY_ERROR, "solver-usage", "[Engine] ERROR: `{0}` takes a function name and a start value!"},
+    {DIAG_SOLVER_FUNCTION, SEVERITY_ERROR, "solver-function", "[Engine] ERROR: The function `{0}` passed to `{1}` must have a body and take an argument!"},
+    {DIAG_SOLVER_NOT_EVALUABLE, SEVERITY_ERROR, "solver-not-evaluable", "[Engine] ERROR: The function `{0}` can not be evaluated by `{1}`!"},
+    {DIAG_SOLVER_NOT_CONVERGED, SEVERITY_ERROR, "solver-not-converged", "[Engine] ERROR: `{0}` did not converge for the function `{1}` starting at {2}!"},
+    {DIAG_BOUND_NOT_FINITE, SEVERITY_ERROR, "bound-not-finite", "[Engine] ERROR: The bound `{0}` of `{1}` is not a finite number!"},
+    {DIAG_REDUCTION_USAGE, SEVERITY_ERROR, "reduction-usage", "[Engine] ERROR: `{0}` takes a function name and two bounds, or a variable name, two bounds and an expression!"},
+    {DIAG_REDUCTION_VARIABLE, SEVERITY_ERROR, "reduction-variable", "[Engine] ERROR: `{0}` can not be used as the variable of `{1}` (is it a defined variable?)!"},
+    {DIAG_REDUCTION_NOT_EVALUABLE, SEVERITY_ERROR, "reduction-not-evaluable", "[Engine] ERROR: The expression of `{0}` can not be evaluated!"},
+    {DIAG_REDUCTION_NOT_FINITE, SEVERITY_ERROR, "reduction-not-finite", "[Engine] ERROR: The result of `{0}` is not a finite number!"},
+    {DIAG_REDUCTION_TOO_LARGE, SEVERITY_ERROR, "reduction-too-large", "[Engine] ERROR: `{0}` can not add more than {1} terms!"},
+    {DIAG_INTEGRATE_INACCURATE, SEVERITY_WARNING, "integrate-inaccurate", "[Engine] WARNING: `integrate` did not reach the requested accuracy, the result may be inaccurate!"},
+    {DIAG_SWEEP_INVALID, SEVERITY_ERROR, "sweep-invalid", "[Engine] ERROR: Invalid sweep `sweep {0}`!"},
+    {DIAG_SWEEP_USAGE, SEVERITY_INFO, "sweep-usage", "[Engine] INFO: Please use `sweep x=start:step:stop[, y=start:step:stop ...] : expression`"},
+    {DIAG_SWEEP_STEP, SEVERITY_ERROR, "sweep-step", "[Engine] ERROR: The step of the sweep axis `{0}` does not lead from {1} to {2}!"},
+    {DIAG_SWEEP_TOO_LARGE, SEVERITY_ERROR, "sweep-too-large", "[Engine] ERROR: The sweep has too many points!"},
+    {DIAG_SWEEP_NOT_EVALUABLE, SEVERITY_ERROR, "sweep-not-evaluable", "[Engine] ERROR: The expression of the sweep can not be evaluated!"},
+    {DIAG_STATS_UNKNOWN, SEVERITY_ERROR, "stats-unknown", "[Engine] ERROR: Unknown stats operation `{0}`!"},
+    {DIAG_STATS_USAGE, SEVERITY_INFO, "stats-usage", "[Engine] INFO: Please use `stats`, `stats #on`, `stats #off` or `stats #clear`"},
+    {DIAG_MODE_UNKNOWN, SEVERITY_ERROR, "mode-unknown", "[Engine] ERROR: Unknown number mode `{0}`!"},
+    {DIAG_MODE_USAGE, SEVERITY_INFO, "mode-usage", "[Engine] INFO: Please use `mode #auto`, `mode #float`, `mode #double`, `mode #longdouble`, `mode #int64` or `mode #uint64`"},
+    {DIAG_RESET_ALL, SEVERITY_INFO, "reset-all", "[Engine] INFO: Resetting all inbuilt functions..."},
+    {DIAG_RESET_NO_NAME, SEVERITY_ERROR, "reset-no-name", "[Engine] ERROR: No function name was given for reset operation! Nothing has been reset"},
+    {DIAG_RESET_USAGE, SEVERITY_INFO, "reset-usage", "[Engine] INFO: Please use `reset #function_name` to reset a function or `reset *` to reset all functions"},
+    {DIAG_RESET_DONE, SEVERITY_INFO, "reset-done", "[Engine] INFO: The function `{0}` has been successfully reset"},
+    {DIAG_RESET_NOT_FOUND, SEVERITY_ERROR, "reset-not-found", "[Engine] ERROR: The function `{0}` could not be reset as it's reference definition could not be found"},
+    {DIAG_SNAPSHOT_WRITE, SEVERITY_ERROR, "snapshot-write", "[Engine] ERROR: The snapshot could not be written to `{0}`!"},
+    {DIAG_SNAPSHOT_OPEN, SEVERITY_ERROR, "snapshot-open", "[Engine] ERROR: {0}!"},
+    {DIAG_SNAPSHOT_CORRUPT, SEVERITY_ERROR, "snapshot-corrupt", "[Engine] ERROR: The snapshot `{0}` is corrupt!"},
+    {DIAG_VECTOR_LENGTH, SEVERITY_ERROR, "vector-length", "[Engine] ERROR: The vectors used by `{0}` have different lengths ({1} and {2})!"},
+    {DIAG_VECTOR_NOT_EVALUABLE, SEVERITY_ERROR, "vector-not-evaluable", "[Engine] ERROR: The vector expression `{0}` can not be evaluated element-wise!"},
+    {DIAG_VECTOR_MODE, SEVERITY_WARNING, "vector-mode", "[Engine] WARNING: Vectors are evaluated on double, the number mode `{0}` is not used!"},
+    {DIAG_DOUBLE_MODE, SEVERITY_WARNING, "double-mode", "[Engine] WARNING: `{0}` is evaluated on double, the number mode `{1}` is not used!"},
+    {DIAG_MATRIX_SHAPE, SEVERITY_ERROR, "matrix-shape", "[Engine] ERROR: The values used by `{0}` have incompatible shapes ({1} and {2})!"},
+    {DIAG_MATRIX_NOT_SQUARE, SEVERITY_ERROR, "matrix-not-square", "[Engine] ERROR: `{0}` needs a square matrix, not {1}!"},
+    {DIAG_MATRIX_SINGULAR, SEVERITY_ERROR, "matrix-singular", "[Engine] ERROR: The matrix used by `{0}` is singular!"},
+    {DIAG_MULTIPLE_RESULTS, SEVERITY_WARNING, "multiple-results", "[Evaluator] WARNING: Multiple results in stack!"},
+    {DIAG_NO_OPERANDS, SEVERITY_ERROR, "no-operands", "[Evaluator] ERROR: No operands where given to the operator {0}!"},
+    {DIAG_MISSING_OPERAND, SEVERITY_ERROR, "missing-operand", "[Evaluator] ERROR: Operator {0} requires 2 operands however only one ({1}) was given!"},
+    {DIAG_UNSUPPORTED_OPERATOR, SEVERITY_ERROR, "unsupported-operator", "[Evaluator] ERROR: Unsupported operator `{0}`! You can use the `help` command to get a list of supported operators."},
+    {DIAG_NOT_INT64, SEVERITY_ERROR, "not-int64", "[Evaluator] ERROR: `{0}` is not a 64 bit integer!"},
+    {DIAG_NOT_INTEGER_OPERATION, SEVERITY_ERROR, "not-integer-operation", "[Evaluator] ERROR: `{0}` can not be evaluated on integers!"},
+    {DIAG_DIVISION_BY_ZERO, SEVERITY_ERROR, "division-by-zero", "[Evaluator] ERROR: Division by zero!"},
+    {DIAG_SHIFT_RANGE, SEVERITY_ERROR, "shift-range", "[Evaluator] ERROR: Shift count {0} is out of range!"},
+};
+
+/* Function returns true if every code has its entry at its index in DIAG_TABLE */
+static constexpr bool diag_table_ordered(void){
+    for (std::size_t index = 0; index < DIAG_COUNT; ++index)
+        if (DIAG_TABLE[index].code != index)
+            return false;
+    return true;
+}
+static_assert(sizeof(DIAG_TABLE)/sizeof(DIAG_TABLE[0]) == DIAG_COUNT && diag_table_ordered(), "Every diagnostic code needs an entry at its index in DIAG_TABLE");
+
+const DiagInfo& getDiagInfo(DiagCode code){
+    return DIAG_TABLE[code];
+}
+
+/* Diagnostic struct definitions */
+std::string Diagnostic::str(void) const{
+    std::string message;
+    for (const char* chr = getDiagInfo(this->code).message; *chr != '\0'; ++chr){
+        /* `{N}` is replaced by the N-th argument */
+        if (chr[0] == '{' && chr[1] >= '0' && chr[1] <= '9' && chr[2] == '}'){
+            const std::size_t index = static_cast<std::size_t>(chr[1]-'0');
+            if (index < this->args.size())
+                message += this->args[index];
+            chr += 2;
+        } else
+            message += *chr;
+    }
+    return message;
+}
+
+/* Diagnostics class definitions */
+Diagnostic& Diagnostics::add(DiagCode code, std::vector<std::string> args){
+    this->_records.push_back({code, std::move(args), 0, std::string::npos, 0});
+    return this->_records.back();
+}
+
+void Diagnostics::append(const Diagnostics& other){
+    this->_records.insert(this->_records.end(), other._records.cbegin(), other._records.cend());
+}
+
+bool Diagnostics::contains(DiagCode code) const{
+    return std::any_of(this->_records.cbegin(), this->_records.cend(), [code](const Diagnostic& record){ return record.code == code; });
+}
+
+std::string Diagnostics::str(void) const{
+    std::string messages;
+    for (const Diagnostic& record : this->_records)
+        messages += record.str()+"\n";
+    return messages;
+}
+
+/* SourceMap class definitions */
+void SourceMap::find(std::size_t pos, std::size_t& begin, std::size_t& end) const{
+    auto anchor_it = std::upper_bound(this->_anchors.cbegin(), this->_anchors.cend(), pos, [](std::size_t value, const Anchor& anchor){ return value < anchor.pos; });
+    if (anchor_it == this->_anchors.cbegin()){
+        begin = pos;
+        end = pos+1;
+        return;
+    }
+    const Anchor& anchor = *std::prev(anchor_it);
+    if (anchor.source_length != 0){
+        begin = anchor.source_pos;
+        end = anchor.source_pos+anchor.source_length;
+    } else{
+        begin = anchor.source_pos+(pos-anchor.pos);
+        end = begin+1;
+    }
+}
+
+void SourceMap::copy(std::size_t pos, std::size_t source_pos){
+    /* A copy that goes on from the last one needs no anchor */
+    if (this->_anchors.empty() ? pos == source_pos
+        : (this->_anchors.back().source_length == 0 && pos-this->_anchors.back().pos == source_pos-this->_anchors.back().source_pos))
+        return;
+    this->replace(pos, source_pos, 0);
+}
+
+void SourceMap::replace(std::size_t pos, std::size_t source_pos, std::size_t source_length){
+    /* An anchor at the same position as the last one takes its place (the text between them is empty) */
+    if (!this->_anchors.empty() && this->_anchors.back().pos == pos)
+        this->_anchors.back() = {pos, source_pos, source_length};
+    else
+        this->_anchors.push_back({pos, source_pos, source_length});
+}
+
+void SourceMap::map(std::size_t& offset, std::size_t& length) const{
+    if (offset == std::string::npos || this->_anchors.empty())
+        return;
+    std::size_t begin, end;
+    this->find(offset, begin, end);
+    if (length > 1){
+        std::size_t last_begin, last_end;
+        this->find(offset+length-1, last_begin, last_end);
+        begin = std::min(begin, last_begin);
+        end = std::max(end, last_end);
+    }
+    offset = begin;
+    length = length == 0 ? 0 : end-begin;
+}
+
+}
@@ -0,0 +1,216 @@
+/****************************************************************************
+* File name: mbcdiag_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine diagnostics header containing declarations for
+*  the errors, warnings and notes raised while evaluating expressions.
+*
+*  A diagnostic is recorded as a code, the arguments of its message and
+*  the span of the line it refers to. The message text is only built
+*  when it is asked for (see Diagnostic::str), nothing is formatted and
+*  nothing is allocated while no diagnostic is raised. Spans found in a
+*  rewritten text are mapped back to the line with a SourceMap.
+****************************************************************************/
+#ifndef __MB_COMPUTE_DIAG_LIB__
+
+#define __MB_COMPUTE_DIAG_LIB__
+/* Includes */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mbc{
+
+/* Diagnostic codes (the order of the enum is the order of DIAG_TABLE) */
+enum DiagCode : uint16_t{
+    /* Engine */
+    DIAG_UNBALANCED_PARENTHESES,
+    DIAG_UNBALANCED_QUOTES,
+    DIAG_UNDEFINED_FUNCTION,
+    DIAG_UNDEFINED_VARIABLE,
+    DIAG_INVALID_EXPRESSION,
+    DIAG_TOO_MANY_ARGUMENTS,
+    DIAG_TOO_FEW_ARGUMENTS,
+    DIAG_INLINE_TOO_MANY_ARGUMENTS,
+    DIAG_INLINE_NO_DEFAULT,
+    DIAG_INLINE_TOO_DEEP,
+    DIAG_CALLS_TOO_DEEP,
+    DIAG_EXPANSION_TOO_LARGE,
+    DIAG_OPERATION_ARITY,
+    DIAG_UNKNOWN_RESERVED,
+    DIAG_EMPTY_FUNCTION,
+    DIAG_UNDEFINED_FUNCTION_ARGUMENT,
+    DIAG_SOLVER_USAGE,
+    DIAG_SOLVER_FUNCTION,
+    DIAG_SOLVER_NOT_EVALUABLE,
+    DIAG_SOLVER_NOT_CONVERGED,
+    DIAG_BOUND_NOT_FINITE,
+    DIAG_REDUCTION_USAGE,
+    DIAG_REDUCTION_VARIABLE,
+    DIAG_REDUCTION_NOT_EVALUABLE,
+    DIAG_REDUCTION_NOT_FINITE,
+    DIAG_REDUCTION_TOO_LARGE,
+    DIAG_INTEGRATE_INACCURATE,
+    DIAG_SWEEP_INVALID,
+    DIAG_SWEEP_USAGE,
+    DIAG_SWEEP_STEP,
+    DIAG_SWEEP_TOO_LARGE,
+    DIAG_SWEEP_NOT_EVALUABLE,
+    DIAG_STATS_UNKNOWN,
+    DIAG_STATS_USAGE,
+    DIAG_MODE_UNKNOWN,
+    DIAG_MODE_USAGE,
+    DIAG_RESET_ALL,
+    DIAG_RESET_NO_NAME,
+    DIAG_RESET_USAGE,
+    DIAG_RESET_DONE,
+    DIAG_RESET_NOT_FOUND,
+    DIAG_SNAPSHOT_WRITE,
+    DIAG_SNAPSHOT_OPEN,
+    DIAG_SNAPSHOT_CORRUPT,
+    DIAG_VECTOR_LENGTH,
+    DIAG_VECTOR_NOT_EVALUABLE,
+    DIAG_VECTOR_MODE,
+    DIAG_DOUBLE_MODE,
+    DIAG_MATRIX_SHAPE,
+    DIAG_MATRIX_NOT_SQUARE,
+    DIAG_MATRIX_SINGULAR,
+    /* Evaluator and virtual machine */
+    DIAG_MULTIPLE_RESULTS,
+    DIAG_NO_OPERANDS,
+    DIAG_MISSING_OPERAND,
+    DIAG_UNSUPPORTED_OPERATOR,
+    DIAG_NOT_INT64,
+    DIAG_NOT_INTEGER_OPERATION,
+    DIAG_DIVISION_BY_ZERO,
+    DIAG_SHIFT_RANGE,
+    /* Number of codes (not a code) */
+    DIAG_COUNT
+};
+
+/* Severity of a diagnostic */
+enum DiagSeverity : uint8_t{
+    SEVERITY_ERROR,
+    SEVERITY_WARNING,
+    SEVERITY_INFO
+};
+
+/* Structure to hold the description of a diagnostic code.
+* `{N}` in the message is replaced by the N-th argument of the diagnostic.
+*/
+struct DiagInfo{
+    DiagCode code;
+    DiagSeverity severity;
+    /* Stable name of the code (for scripts and tests) */
+    const char* name;
+    const char* message;
+};
+
+/* Function returns the description of the given code */
+const DiagInfo& getDiagInfo(DiagCode);
+
+/* Structure to hold a diagnostic */
+struct Diagnostic{
+    DiagCode code;
+    std::vector<std::string> args;
+    /* Index of the command of the line (commands are separated by SEP_CHAR) and the
+    * span of the subject of the diagnostic in the line given to Engine::load, offset
+    * is npos if it is not known. The records of an Evaluator hold the span in the
+    * expression it parsed, the records of an IntegerProgram the index of the postfix
+    * token in offset (the engine maps them to the line).
+    */
+    std::size_t command;
+    std::size_t offset;
+    std::size_t length;
+
+    /* Method returns the severity of the code */
+    DiagSeverity severity(void) const{ return getDiagInfo(this->code).severity; }
+
+    /* Method returns the message (without a new line) */
+    std::string str(void) const;
+};
+
+/* Diagnostics class holding the diagnostics raised in order */
+class Diagnostics{
+private:
+    std::vector<Diagnostic> _records;
+public:
+    /* Method records a diagnostic with the given arguments and no span, returns the record */
+    Diagnostic& add(DiagCode, std::vector<std::string> = {});
+
+    /* Method appends the diagnostics of the given list */
+    void append(const Diagnostics&);
+
+    /* Method removes all diagnostics (the storage is kept) */
+    void clear(void){ this->_records.clear(); }
+
+    /* Method returns true if no diagnostic was raised */
+    bool empty(void) const{ return this->_records.empty(); }
+
+    /* Method returns the number of diagnostics */
+    std::size_t size(void) const{ return this->_records.size(); }
+
+    /* Method returns true if a diagnostic with the given code was raised */
+    bool contains(DiagCode) const;
+
+    /* Method returns the diagnostics in the order they were raised */
+    const std::vector<Diagnostic>& records(void) const{ return this->_records; }
+
+    /* Method returns the diagnostic at the given index (used to locate appended records) */
+    Diagnostic& at(std::size_t index){ return this->_records[index]; }
+
+    /* Method returns the messages, one per line */
+    std::string str(void) const;
+};
+
+/* SourceMap class mapping the positions of a rewritten text back to the text it was rewritten from.
+*  From a copy anchor on the rewritten text is a copy of the original text (up to the next anchor),
+*  from a replacement anchor on it stands for the whole span of the original text it replaced.
+*  Positions before the first anchor are the same in both texts.
+*/
+class SourceMap{
+private:
+    struct Anchor{
+        std::size_t pos;
+        std::size_t source_pos;
+        /* Length of the replaced span (0 for a copy) */
+        std::size_t source_length;
+    };
+    /* Anchors in the order of their positions */
+    std::vector<Anchor> _anchors;
+
+    /* Method stores the span of the original text the given position comes from in the last two arguments */
+    void find(std::size_t, std::size_t&, std::size_t&) const;
+public:
+    /* Method removes all anchors (the storage is kept) */
+    void clear(void){ this->_anchors.clear(); }
+
+    /* Method records that the text from the given position on is copied from the given position of the original text */
+    void copy(std::size_t, std::size_t);
+
+    /* Method records that the text from the given position on replaces the given span (position and length) of the original text */
+    void replace(std::size_t, std::size_t, std::size_t);
+
+    /* Method maps the given span (offset and length) to the original text, an offset of npos is kept */
+    void map(std::size_t&, std::size_t&) const;
+};
+
+}
+
+#endif
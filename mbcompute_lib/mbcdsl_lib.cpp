@@ -0,0 +1,105 @@
+/****************************************************************************
+* File name: mbcdsl_lib.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine expression DSL containing implementations for
+*  building engine expressions from C++ without going through text.
+****************************************************************************/
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+#include "mbcdsl_lib.hpp"
+
+namespace mbc{
+
+const std::string PlanCall::inputName(std::size_t index){
+    /* Names starting with double underscores are reserved so they can not clash with a variable */
+    return "__call"+std::to_string(index)+"__";
+}
+
+/* Plan class definitions */
+Plan::Plan(void) : _program_ready(false){
+}
+
+void Plan::emitConstant(double value){
+    /* Postfix numbers are read back with std::atof, enough digits are kept to get the exact value */
+    if (std::isfinite(value)){
+        char str_value[32];
+        std::snprintf(str_value, sizeof(str_value), "%.17G", value);
+        this->_postfix.push_back(str_value);
+    } else{
+        /* There are no literals for infinity and NaN, they are the results of a division */
+        this->_postfix.push_back(std::isnan(value) ? "0" : (value > 0 ? "1" : "-1"));
+        this->_postfix.push_back("0");
+        this->_postfix.push_back("/");
+    }
+    this->_program_ready = false;
+}
+
+void Plan::emitVariable(const std::string& name){
+    if (std::find(this->_variables.cbegin(), this->_variables.cend(), name) == this->_variables.cend())
+        this->_variables.push_back(name);
+    this->_postfix.push_back(name);
+    this->_program_ready = false;
+}
+
+void Plan::emitOperator(const std::string& oop){
+    this->_postfix.push_back(oop);
+    this->_program_ready = false;
+}
+
+void Plan::emitCall(const std::string& name, std::vector<Plan> args){
+    this->_postfix.push_back(PlanCall::inputName(this->_calls.size()));
+    this->_calls.push_back({name, std::move(args)});
+    this->_program_ready = false;
+}
+
+Program& Plan::getProgram(void) const{
+    if (!this->_program_ready){
+        std::vector<std::string> inputs = this->_variables;
+        for (std::size_t index = 0; index < this->_calls.size(); ++index)
+            inputs.push_back(PlanCall::inputName(index));
+        this->_program.compile(this->_postfix, inputs);
+        this->_program_ready = true;
+    }
+    return this->_program;
+}
+
+const std::string Plan::str(void) const{
+    std::string plan_str;
+    for (const std::string& token : this->_postfix){
+        auto call_it = std::find_if(this->_calls.cbegin(), this->_calls.cend(),
+            [this, &token](const PlanCall& call){ return PlanCall::inputName(&call-this->_calls.data()) == token; });
+        if (!plan_str.empty())
+            plan_str += " ";
+        if (call_it == this->_calls.cend()){
+            plan_str += token;
+            continue;
+        }
+        /* Calls are shown with their argument plans */
+        plan_str += call_it->name+"(";
+        for (const Plan& arg : call_it->args)
+            plan_str += (&arg == call_it->args.data() ? "" : ", ")+arg.str();
+        plan_str += ")";
+    }
+    return plan_str;
+}
+
+}
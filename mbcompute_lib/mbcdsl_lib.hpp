@@ -0,0 +1,240 @@
+/****************************************************************************
+* File name: mbcdsl_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine expression DSL header containing declarations for
+*  building engine expressions from C++ without going through text.
+*
+*  Usage:
+*   mbc::Plan plan = mbc::var("a")*2 + mbc::fn("sin")(mbc::var("x"));
+*   double result = engine.evaluate(plan);
+*  The expression is lowered straight to the engine's postfix representation
+*  (constants keep every bit of their value), variables are read from the
+*  engine and functions are called through the engine's function machinery
+*  so user defined functions can be used as well.
+*  The grouping of the expression is the grouping of the C++ expression.
+****************************************************************************/
+#ifndef __MB_COMPUTE_DSL_LIB__
+
+#define __MB_COMPUTE_DSL_LIB__
+/* Includes */
+#include <vector>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+/* Custom libraries */
+#include "mbcvm_lib.hpp"
+
+namespace mbc{
+
+class Plan;
+
+/* Structure to hold a function call of a plan
+*   The result of the call is read by the plan's postfix expression through
+*   the input named by PlanCall::inputName (see Plan).
+*/
+struct PlanCall{
+    /* Function name */
+    std::string name;
+    /* Argument expressions */
+    std::vector<Plan> args;
+
+    /* Method returns the name of the input holding the result of the given call */
+    static const std::string inputName(std::size_t);
+};
+
+/* Plan class holding an expression lowered to the engine's postfix representation
+*  The inputs of the postfix expression are the variables (in order) followed
+*  by the results of the calls (in order), the program is compiled once and
+*  reused by every evaluation.
+*/
+class Plan{
+private:
+    std::vector<std::string> _postfix;
+    std::vector<std::string> _variables;
+    std::vector<PlanCall> _calls;
+
+    /* Compiled postfix expression, compiled on the first evaluation */
+    mutable Program _program;
+    mutable bool _program_ready;
+public:
+    /* Constructor for Plan class (empty plan, evaluates to 0) */
+    Plan(void);
+
+    /* Constructor for Plan class from an expression (see var, fn) */
+    template<typename E, typename = typename std::enable_if<E::is_expr>::type>
+    Plan(const E& expr) : Plan(){
+        expr.lower(*this);
+    }
+
+    /* Methods append a constant, a variable, an operator (a SUPPORTED_OOPS symbol) or a call */
+    void emitConstant(double);
+    void emitVariable(const std::string&);
+    void emitOperator(const std::string&);
+    void emitCall(const std::string&, std::vector<Plan>);
+
+    /* Methods return the postfix expression, the variables read and the calls made */
+    const std::vector<std::string>& getPostfix(void) const{ return this->_postfix; }
+    const std::vector<std::string>& getVariables(void) const{ return this->_variables; }
+    const std::vector<PlanCall>& getCalls(void) const{ return this->_calls; }
+
+    /* Method returns the compiled postfix expression */
+    Program& getProgram(void) const;
+
+    /* Method returns a printable form of the plan (the postfix tokens) */
+    const std::string str(void) const;
+};
+
+/* Expression templates
+*  Every expression type has `is_expr` set and a `lower` method that appends
+*  the expression to a plan, operands are held by value.
+*/
+
+/* Constant operand */
+struct ConstantExpr{
+    static constexpr bool is_expr = true;
+    double value;
+    void lower(Plan& plan) const{ plan.emitConstant(this->value); }
+};
+
+/* Variable operand, the value is read from the engine at evaluation */
+struct VariableExpr{
+    static constexpr bool is_expr = true;
+    std::string name;
+    void lower(Plan& plan) const{ plan.emitVariable(this->name); }
+};
+
+/* Operator applied to one or two operands */
+template<typename L>
+struct UnaryExpr{
+    static constexpr bool is_expr = true;
+    const char* oop;
+    L operand;
+    void lower(Plan& plan) const{
+        this->operand.lower(plan);
+        plan.emitOperator(this->oop);
+    }
+};
+
+template<typename L, typename R>
+struct BinaryExpr{
+    static constexpr bool is_expr = true;
+    const char* oop;
+    L lhs;
+    R rhs;
+    void lower(Plan& plan) const{
+        this->lhs.lower(plan);
+        this->rhs.lower(plan);
+        plan.emitOperator(this->oop);
+    }
+};
+
+/* Call of a function known to the engine */
+template<typename... Args>
+struct CallExpr{
+    static constexpr bool is_expr = true;
+    std::string name;
+    std::tuple<Args...> args;
+    void lower(Plan& plan) const{
+        std::vector<Plan> arg_plans;
+        std::apply([&arg_plans](const Args&... arg){ (arg_plans.emplace_back(arg), ...); }, this->args);
+        plan.emitCall(this->name, std::move(arg_plans));
+    }
+};
+
+/* Traits to accept expressions and arithmetic values as operands */
+template<typename T, typename = void>
+struct IsExpr : std::false_type{};
+template<typename T>
+struct IsExpr<T, typename std::enable_if<T::is_expr>::type> : std::true_type{};
+
+template<typename T, typename = void>
+struct AsExpr{ using type = T; };
+template<typename T>
+struct AsExpr<T, typename std::enable_if<std::is_arithmetic<T>::value>::type>{ using type = ConstantExpr; };
+
+template<typename T>
+typename std::enable_if<IsExpr<T>::value, const T&>::type asExpr(const T& value){ return value; }
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, ConstantExpr>::type asExpr(T value){ return ConstantExpr{static_cast<double>(value)}; }
+
+/* True if the operands can form an expression (at least one of them is an expression) */
+template<typename L, typename R>
+using EnableBinary = typename std::enable_if<
+    (IsExpr<L>::value && (IsExpr<R>::value || std::is_arithmetic<R>::value))
+    || (std::is_arithmetic<L>::value && IsExpr<R>::value),
+    BinaryExpr<typename AsExpr<L>::type, typename AsExpr<R>::type>>::type;
+
+/* Function class returned by fn, calling it builds a call expression */
+struct FunctionRef{
+    std::string name;
+    template<typename... Args>
+    CallExpr<typename AsExpr<Args>::type...> operator()(const Args&... args) const{
+        return CallExpr<typename AsExpr<Args>::type...>{this->name, std::make_tuple(asExpr(args)...)};
+    }
+};
+
+/* Methods return a variable of the engine and a function of the engine by name */
+inline VariableExpr var(const std::string& name){ return VariableExpr{name}; }
+inline FunctionRef fn(const std::string& name){ return FunctionRef{name}; }
+
+/* Operators of SUPPORTED_OOPS that have a C++ operator */
+#define MBC_DSL_BINARY_OPERATOR(cpp_oop, oop) \
+template<typename L, typename R> \
+EnableBinary<L, R> operator cpp_oop(const L& lhs, const R& rhs){ \
+    return EnableBinary<L, R>{oop, asExpr(lhs), asExpr(rhs)}; \
+}
+MBC_DSL_BINARY_OPERATOR(*,  "*")
+MBC_DSL_BINARY_OPERATOR(/,  "/")
+MBC_DSL_BINARY_OPERATOR(%,  "%")
+MBC_DSL_BINARY_OPERATOR(+,  "+")
+MBC_DSL_BINARY_OPERATOR(-,  "-")
+MBC_DSL_BINARY_OPERATOR(<<, "<<")
+MBC_DSL_BINARY_OPERATOR(>>, ">>")
+MBC_DSL_BINARY_OPERATOR(<,  "<")
+MBC_DSL_BINARY_OPERATOR(>,  ">")
+MBC_DSL_BINARY_OPERATOR(==, "==")
+MBC_DSL_BINARY_OPERATOR(!=, "!=")
+MBC_DSL_BINARY_OPERATOR(&,  "&")
+MBC_DSL_BINARY_OPERATOR(^,  "^")
+MBC_DSL_BINARY_OPERATOR(|,  "|")
+MBC_DSL_BINARY_OPERATOR(&&, "&&")
+MBC_DSL_BINARY_OPERATOR(||, "||")
+#undef MBC_DSL_BINARY_OPERATOR
+
+/* Operators of SUPPORTED_OOPS without a C++ operator (**, ^^, ++ and --) */
+template<typename L, typename R>
+EnableBinary<L, R> pow(const L& lhs, const R& rhs){ return EnableBinary<L, R>{"**", asExpr(lhs), asExpr(rhs)}; }
+template<typename L, typename R>
+EnableBinary<L, R> logicalXor(const L& lhs, const R& rhs){ return EnableBinary<L, R>{"^^", asExpr(lhs), asExpr(rhs)}; }
+template<typename L, typename = typename std::enable_if<IsExpr<L>::value>::type>
+UnaryExpr<L> increment(const L& operand){ return UnaryExpr<L>{"++", operand}; }
+template<typename L, typename = typename std::enable_if<IsExpr<L>::value>::type>
+UnaryExpr<L> decrement(const L& operand){ return UnaryExpr<L>{"--", operand}; }
+
+/* Logical NOT and negation (the engine has no unary minus, -x is -1*x) */
+template<typename L, typename = typename std::enable_if<IsExpr<L>::value>::type>
+UnaryExpr<L> operator!(const L& operand){ return UnaryExpr<L>{"!", operand}; }
+template<typename L, typename = typename std::enable_if<IsExpr<L>::value>::type>
+BinaryExpr<ConstantExpr, L> operator-(const L& operand){ return BinaryExpr<ConstantExpr, L>{"*", ConstantExpr{-1}, operand}; }
+
+}
+
+#endif
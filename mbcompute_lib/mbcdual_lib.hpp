@@ -0,0 +1,131 @@
+/****************************************************************************
+* File name: mbcdual_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine dual number header (header only) used for forward
+*  mode automatic differentiation of compiled programs.
+*
+*  Usage:
+*   mbc::BasicProgram<mbc::Dual<double>> program;
+*   mbc::Dual<double> x(2.0, 1.0);
+*   mbc::Dual<double> result = program.run(&x);
+*  result.value() is f(2) and result.derivative() is f'(2). Nesting the type
+*  (Dual<Dual<double>>) gives the second derivative as well.
+****************************************************************************/
+#ifndef __MB_COMPUTE_DUAL_LIB__
+
+#define __MB_COMPUTE_DUAL_LIB__
+/* Includes */
+#include <cmath>
+#include <ostream>
+#include <type_traits>
+
+namespace mbc{
+
+/* Dual class holding a value and its derivative
+*  Every operation of the virtual machine is supported, the comparison,
+*  logical and bitwise operations work on the values (their derivative is 0)
+*  as do ceil and floor.
+*/
+template<typename T>
+class Dual{
+private:
+    T _value;
+    T _derivative;
+public:
+    /* Constructors for Dual class (a constant has a derivative of 0) */
+    Dual(void) : _value(0), _derivative(0){}
+    template<typename U, typename = typename std::enable_if<std::is_arithmetic<U>::value>::type>
+    Dual(U value) : _value(static_cast<T>(value)), _derivative(0){}
+    Dual(const T& value, const T& derivative) : _value(value), _derivative(derivative){}
+
+    /* Methods return the value and the derivative */
+    const T& value(void) const{ return this->_value; }
+    const T& derivative(void) const{ return this->_derivative; }
+
+    /* Conversions used by the logical and bitwise operations */
+    explicit operator bool(void) const{ return static_cast<bool>(this->_value); }
+    explicit operator long long(void) const{ return static_cast<long long>(this->_value); }
+
+    /* Arithmetic */
+    friend Dual operator+(const Dual& lhs, const Dual& rhs){ return Dual(lhs._value+rhs._value, lhs._derivative+rhs._derivative); }
+    friend Dual operator-(const Dual& lhs, const Dual& rhs){ return Dual(lhs._value-rhs._value, lhs._derivative-rhs._derivative); }
+    friend Dual operator*(const Dual& lhs, const Dual& rhs){
+        return Dual(lhs._value*rhs._value, lhs._derivative*rhs._value+lhs._value*rhs._derivative);
+    }
+    friend Dual operator/(const Dual& lhs, const Dual& rhs){
+        return Dual(lhs._value/rhs._value, (lhs._derivative*rhs._value-lhs._value*rhs._derivative)/(rhs._value*rhs._value));
+    }
+
+    /* Comparisons */
+    friend bool operator<(const Dual& lhs, const Dual& rhs){ return lhs._value < rhs._value; }
+    friend bool operator>(const Dual& lhs, const Dual& rhs){ return lhs._value > rhs._value; }
+    friend bool operator==(const Dual& lhs, const Dual& rhs){ return lhs._value == rhs._value; }
+    friend bool operator!=(const Dual& lhs, const Dual& rhs){ return lhs._value != rhs._value; }
+
+    /* Math functions (found by argument dependent lookup, see BasicProgram::run) */
+    friend Dual pow(const Dual& base, const Dual& exponent){
+        using std::pow;
+        using std::log;
+        const T value = pow(base._value, exponent._value);
+        /* A constant exponent does not need the logarithm of the base (which may be negative) */
+        if (exponent._derivative == 0)
+            return Dual(value, exponent._value*pow(base._value, exponent._value-1)*base._derivative);
+        return Dual(value, value*(exponent._derivative*log(base._value)+exponent._value*base._derivative/base._value));
+    }
+    friend Dual fmod(const Dual& lhs, const Dual& rhs){
+        using std::fmod;
+        using std::trunc;
+        return Dual(fmod(lhs._value, rhs._value), lhs._derivative-rhs._derivative*trunc(lhs._value/rhs._value));
+    }
+    friend Dual trunc(const Dual& operand){ using std::trunc; return Dual(trunc(operand._value), 0); }
+    friend Dual ceil(const Dual& operand){ using std::ceil; return Dual(ceil(operand._value), 0); }
+    friend Dual floor(const Dual& operand){ using std::floor; return Dual(floor(operand._value), 0); }
+    friend Dual abs(const Dual& operand){
+        using std::abs;
+        return Dual(abs(operand._value), operand._value < 0 ? T(0)-operand._derivative : operand._derivative);
+    }
+    friend Dual log(const Dual& operand){ using std::log; return Dual(log(operand._value), operand._derivative/operand._value); }
+    friend Dual log10(const Dual& operand){
+        using std::log;
+        using std::log10;
+        return Dual(log10(operand._value), operand._derivative/(operand._value*log(T(10))));
+    }
+    friend Dual sin(const Dual& operand){ using std::sin; using std::cos; return Dual(sin(operand._value), cos(operand._value)*operand._derivative); }
+    friend Dual cos(const Dual& operand){ using std::sin; using std::cos; return Dual(cos(operand._value), T(0)-sin(operand._value)*operand._derivative); }
+    friend Dual tan(const Dual& operand){
+        using std::cos;
+        using std::tan;
+        const T cosine = cos(operand._value);
+        return Dual(tan(operand._value), operand._derivative/(cosine*cosine));
+    }
+    friend Dual sinh(const Dual& operand){ using std::sinh; using std::cosh; return Dual(sinh(operand._value), cosh(operand._value)*operand._derivative); }
+    friend Dual cosh(const Dual& operand){ using std::sinh; using std::cosh; return Dual(cosh(operand._value), sinh(operand._value)*operand._derivative); }
+    friend Dual tanh(const Dual& operand){
+        using std::tanh;
+        const T value = tanh(operand._value);
+        return Dual(value, (T(1)-value*value)*operand._derivative);
+    }
+
+    /* Dual numbers are printed as their value */
+    friend std::ostream& operator<<(std::ostream& stream, const Dual& operand){ return stream << operand._value; }
+};
+
+}
+
+#endif
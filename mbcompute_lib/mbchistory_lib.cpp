@@ -0,0 +1,157 @@
+/****************************************************************************
+* File name: mbchistory_lib.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine history library containing implementations for
+*  the bounded command history of console sessions.
+****************************************************************************/
+
+#include <algorithm>
+
+#include "mbchistory_lib.hpp"
+
+namespace mbc{
+
+/* History class definitions */
+History::History(std::size_t entries, std::size_t bytes) : _first(0), _count(0), _used(0), _next_number(1){
+    this->_slots.resize(entries);
+    this->_bytes.resize(bytes);
+}
+
+History::~History(void){
+    this->close();
+}
+
+std::string History::text(const Slot& slot) const{
+    /* The text wraps around the end of the byte ring at most once */
+    const std::size_t head = std::min(slot.length, this->_bytes.size()-slot.offset);
+    std::string line(this->_bytes.data()+slot.offset, head);
+    line.append(this->_bytes.data(), slot.length-head);
+    return line;
+}
+
+void History::evict(void){
+    const Slot& oldest = this->_slots[this->_first];
+    this->spill(this->text(oldest));
+    this->_used -= oldest.length;
+    this->_first = (this->_first+1)%this->_slots.size();
+    --this->_count;
+}
+
+void History::spill(const std::string& line){
+    if (this->_spill.is_open())
+        this->_spill << line << '\n';
+}
+
+void History::setLimits(std::size_t entries, std::size_t bytes){
+    /* Keep the newest entries that fit the new limits */
+    std::vector<HistoryEntry> kept = this->last(this->_count);
+    std::size_t kept_bytes = 0;
+    std::size_t start = kept.size();
+    while (start > 0 && kept.size()-start < entries && kept_bytes+kept[start-1].line.size() <= bytes)
+        kept_bytes += kept[--start].line.size();
+    for (std::size_t index = 0; index < start; ++index)
+        this->spill(kept[index].line);
+
+    this->_slots.assign(entries, Slot());
+    this->_bytes.assign(bytes, 0);
+    this->_bytes.shrink_to_fit();
+    this->_slots.shrink_to_fit();
+    this->_first = 0;
+    this->_count = 0;
+    this->_used = 0;
+    for (std::size_t index = start; index < kept.size(); ++index){
+        Slot& slot = this->_slots[this->_count++];
+        slot.number = kept[index].number;
+        slot.offset = this->_used;
+        slot.length = kept[index].line.size();
+        std::copy(kept[index].line.begin(), kept[index].line.end(), this->_bytes.begin()+this->_used);
+        this->_used += slot.length;
+    }
+}
+
+bool History::spillTo(const std::string& file_name){
+    if (this->_spill.is_open())
+        this->_spill.close();
+    this->_spill.open(file_name, std::ios::app);
+    return this->_spill.good();
+}
+
+void History::add(const std::string& line){
+    const uint64_t number = this->_next_number++;
+    if (this->_slots.empty() || line.size() > this->_bytes.size()){
+        /* Does not fit in memory, the older entries stay as they were spilled in order */
+        while (this->_count > 0)
+            this->evict();
+        this->spill(line);
+        return;
+    }
+    while (this->_count == this->_slots.size() || this->_used+line.size() > this->_bytes.size())
+        this->evict();
+
+    /* The text of the new entry follows the text of the newest entry */
+    std::size_t offset = 0;
+    if (this->_count == 0)
+        this->_first = 0;
+    else{
+        offset = this->_slots[this->_first].offset+this->_used;
+        if (offset >= this->_bytes.size())
+            offset -= this->_bytes.size();
+    }
+    Slot& slot = this->_slots[(this->_first+this->_count)%this->_slots.size()];
+    slot.number = number;
+    slot.offset = offset;
+    slot.length = line.size();
+    const std::size_t head = std::min(line.size(), this->_bytes.size()-offset);
+    std::copy(line.begin(), line.begin()+head, this->_bytes.begin()+offset);
+    std::copy(line.begin()+head, line.end(), this->_bytes.begin());
+    this->_used += line.size();
+    ++this->_count;
+}
+
+bool History::find(uint64_t number, std::string& line) const{
+    if (this->_count == 0)
+        return false;
+    /* Entries in memory are numbered consecutively */
+    const uint64_t oldest = this->_slots[this->_first].number;
+    if (number < oldest || number-oldest >= this->_count)
+        return false;
+    line = this->text(this->_slots[(this->_first+(number-oldest))%this->_slots.size()]);
+    return true;
+}
+
+std::vector<HistoryEntry> History::last(std::size_t count) const{
+    count = std::min(count, this->_count);
+    std::vector<HistoryEntry> entries;
+    entries.reserve(count);
+    for (std::size_t index = this->_count-count; index < this->_count; ++index){
+        const Slot& slot = this->_slots[(this->_first+index)%this->_slots.size()];
+        entries.push_back({slot.number, this->text(slot)});
+    }
+    return entries;
+}
+
+void History::close(void){
+    if (!this->_spill.is_open())
+        return;
+    for (const HistoryEntry& entry : this->last(this->_count))
+        this->spill(entry.line);
+    this->_spill.close();
+}
+
+}
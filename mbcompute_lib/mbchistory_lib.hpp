@@ -0,0 +1,124 @@
+/****************************************************************************
+* File name: mbchistory_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine history header containing declarations for the
+*  bounded command history of console sessions.
+*
+*  The history keeps the last entries in a fixed size ring of slots whose
+*  text is stored in a fixed size ring of bytes, the memory used does not
+*  grow with the length of the session. Entries pushed out of the rings are
+*  appended to the spill file (if one is set), one line per entry.
+*  Every entry is numbered from 1 in the order it was added.
+****************************************************************************/
+#ifndef __MB_COMPUTE_HISTORY_LIB__
+
+#define __MB_COMPUTE_HISTORY_LIB__
+/* Includes */
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace mbc{
+
+/* Default number of entries kept in memory */
+const std::size_t HISTORY_DEFAULT_ENTRIES = 1000;
+
+/* Default number of bytes of entry text kept in memory */
+const std::size_t HISTORY_DEFAULT_BYTES = 1024*1024;
+
+/* Structure to hold an entry of the history */
+struct HistoryEntry{
+    uint64_t number;
+    std::string line;
+};
+
+/* History class holding the last entries of a session */
+class History{
+private:
+    /* Entry whose text starts at offset in the byte ring */
+    struct Slot{
+        uint64_t number;
+        std::size_t offset;
+        std::size_t length;
+    };
+    std::vector<char> _bytes;
+    std::vector<Slot> _slots;
+    /* Index of the oldest slot and number of slots used */
+    std::size_t _first;
+    std::size_t _count;
+    /* Bytes of the byte ring in use (ending at the text of the newest entry) */
+    std::size_t _used;
+    uint64_t _next_number;
+    std::ofstream _spill;
+
+    /* Method returns the text of the given slot */
+    std::string text(const Slot&) const;
+
+    /* Method removes the oldest entry (appended to the spill file if open) */
+    void evict(void);
+
+    /* Method appends a line to the spill file if open */
+    void spill(const std::string&);
+public:
+    /* Constructor for History class with the number of entries and bytes kept in memory */
+    History(std::size_t = HISTORY_DEFAULT_ENTRIES, std::size_t = HISTORY_DEFAULT_BYTES);
+
+    /* Destructor for History class (see close) */
+    ~History(void);
+
+    History(const History&) = delete;
+    History& operator=(const History&) = delete;
+
+    /* Method sets the number of entries and bytes kept in memory, the entries
+    * that do not fit any more are spilled. A limit of 0 keeps nothing in memory.
+    */
+    void setLimits(std::size_t, std::size_t);
+
+    /* Method opens the given file (appended to) as the spill file, returns false if it can not be opened */
+    bool spillTo(const std::string&);
+
+    /* Method adds a line to the history, an entry longer than the byte limit is only spilled */
+    void add(const std::string&);
+
+    /* Method returns the line of the entry with the given number, false if it is no longer in memory */
+    bool find(uint64_t, std::string&) const;
+
+    /* Method returns the last entries in memory (at most the given number), oldest first */
+    std::vector<HistoryEntry> last(std::size_t) const;
+
+    /* Method returns the number of entries in memory */
+    std::size_t size(void) const{ return this->_count; }
+
+    /* Method returns the number of bytes of entry text in memory */
+    std::size_t bytes(void) const{ return this->_used; }
+
+    /* Method returns the number of entries added so far */
+    uint64_t added(void) const{ return this->_next_number-1; }
+
+    /* Method appends the entries in memory to the spill file and closes it,
+    * the spill file then holds the whole session. The entries stay in memory.
+    */
+    void close(void);
+};
+
+}
+
+#endif
@@ -0,0 +1,327 @@
+/****************************************************************************
+* File name: mbcjit_lib.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine JIT containing the x86-64 native code generator
+*  used for hot virtual machine programs.
+****************************************************************************/
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <math.h>
+
+#include "mbcjit_lib.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define MBC_JIT_SUPPORTED 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define MBC_JIT_SUPPORTED 0
+#endif
+
+namespace mbc{
+
+static std::atomic<unsigned int> jit_threshold(JIT_DEFAULT_THRESHOLD);
+
+bool jitSupported(void){
+    return MBC_JIT_SUPPORTED;
+}
+
+unsigned int getJitThreshold(void){
+    return jit_threshold.load(std::memory_order_relaxed);
+}
+
+void setJitThreshold(unsigned int threshold){
+    jit_threshold.store(threshold, std::memory_order_relaxed);
+}
+
+#if MBC_JIT_SUPPORTED
+
+/* Helpers for the operators without an SSE2 equivalent, they match the virtual machine */
+static double jit_shl(double lhs, double rhs){ return static_cast<double>(static_cast<long long>(lhs) << static_cast<long long>(rhs)); }
+static double jit_shr(double lhs, double rhs){ return static_cast<double>(static_cast<long long>(lhs) >> static_cast<long long>(rhs)); }
+static double jit_bit_and(double lhs, double rhs){ return static_cast<double>(static_cast<long long>(lhs) & static_cast<long long>(rhs)); }
+static double jit_bit_xor(double lhs, double rhs){ return static_cast<double>(static_cast<long long>(lhs) ^ static_cast<long long>(rhs)); }
+static double jit_bit_or(double lhs, double rhs){ return static_cast<double>(static_cast<long long>(lhs) | static_cast<long long>(rhs)); }
+
+/* Returns the function called for the given opcode (nullptr if the opcode is generated inline) */
+static void* jit_callee(OpCode op){
+    typedef double (*unary_fn)(double);
+    typedef double (*binary_fn)(double, double);
+    switch (op){
+        case OP_POW:     return reinterpret_cast<void*>(static_cast<binary_fn>(::pow));
+        case OP_MOD:     return reinterpret_cast<void*>(static_cast<binary_fn>(::fmod));
+        case OP_SHL:     return reinterpret_cast<void*>(jit_shl);
+        case OP_SHR:     return reinterpret_cast<void*>(jit_shr);
+        case OP_BIT_AND: return reinterpret_cast<void*>(jit_bit_and);
+        case OP_BIT_XOR: return reinterpret_cast<void*>(jit_bit_xor);
+        case OP_BIT_OR:  return reinterpret_cast<void*>(jit_bit_or);
+        case OP_LN:      return reinterpret_cast<void*>(static_cast<unary_fn>(::log));
+        case OP_LOG10:   return reinterpret_cast<void*>(static_cast<unary_fn>(::log10));
+        case OP_CEIL:    return reinterpret_cast<void*>(static_cast<unary_fn>(::ceil));
+        case OP_FLOOR:   return reinterpret_cast<void*>(static_cast<unary_fn>(::floor));
+        case OP_ABS:     return reinterpret_cast<void*>(static_cast<unary_fn>(::fabs));
+        case OP_COS:     return reinterpret_cast<void*>(static_cast<unary_fn>(::cos));
+        case OP_SIN:     return reinterpret_cast<void*>(static_cast<unary_fn>(::sin));
+        case OP_TAN:     return reinterpret_cast<void*>(static_cast<unary_fn>(::tan));
+        case OP_COSH:    return reinterpret_cast<void*>(static_cast<unary_fn>(::cosh));
+        case OP_SINH:    return reinterpret_cast<void*>(static_cast<unary_fn>(::sinh));
+        case OP_TANH:    return reinterpret_cast<void*>(static_cast<unary_fn>(::tanh));
+        default:         return nullptr;
+    }
+}
+
+/* Assembler class for the handful of x86-64 instructions used by the JIT
+*  The register file pointer is kept in rbx, only xmm0-xmm3 are used.
+*/
+class Assembler{
+private:
+    std::vector<uint8_t> _code;
+    /* Start of the code of every instruction and the jumps to patch (displacement position, target instruction) */
+    std::vector<std::size_t> _labels;
+    std::vector<std::pair<std::size_t, uint32_t>> _jumps;
+
+    void bytes(std::initializer_list<uint8_t> values){
+        this->_code.insert(this->_code.end(), values);
+    }
+    void imm32(uint32_t value){
+        for (int shift = 0; shift < 32; shift += 8)
+            this->_code.push_back(static_cast<uint8_t>(value >> shift));
+    }
+    void imm64(uint64_t value){
+        for (int shift = 0; shift < 64; shift += 8)
+            this->_code.push_back(static_cast<uint8_t>(value >> shift));
+    }
+    /* ModRM byte for [rbx+disp32] with the given xmm register, followed by the displacement */
+    void memory(unsigned int xmm, uint32_t index){
+        this->_code.push_back(static_cast<uint8_t>(0x80 | (xmm << 3) | 0x3));
+        this->imm32(index*8);
+    }
+    /* ModRM byte for a register to register operation */
+    void registers(unsigned int dst, unsigned int src){
+        this->_code.push_back(static_cast<uint8_t>(0xC0 | (dst << 3) | src));
+    }
+public:
+    const std::vector<uint8_t>& code(void) const{ return this->_code; }
+
+    /* push rbx; mov rbx, rdi (also aligns the stack for calls) */
+    void prologue(void){ this->bytes({0x53, 0x48, 0x89, 0xFB}); }
+    /* pop rbx; ret */
+    void epilogue(void){ this->bytes({0x5B, 0xC3}); }
+
+    /* movsd xmm, [rbx+8*index] */
+    void load(unsigned int xmm, uint32_t index){ this->bytes({0xF2, 0x0F, 0x10}); this->memory(xmm, index); }
+    /* movsd [rbx+8*index], xmm */
+    void store(uint32_t index, unsigned int xmm){ this->bytes({0xF2, 0x0F, 0x11}); this->memory(xmm, index); }
+    /* addsd/subsd/mulsd/divsd xmm, [rbx+8*index] (opcode 0x58/0x5C/0x59/0x5E) */
+    void arithmetic(uint8_t opcode, unsigned int xmm, uint32_t index){ this->bytes({0xF2, 0x0F, opcode}); this->memory(xmm, index); }
+    /* addsd/subsd xmm, xmm */
+    void arithmeticRegisters(uint8_t opcode, unsigned int dst, unsigned int src){ this->bytes({0xF2, 0x0F, opcode}); this->registers(dst, src); }
+    /* cmpsd xmm, xmm, predicate (0 = EQ, 1 = LT, 4 = NEQ) */
+    void compare(unsigned int dst, unsigned int src, uint8_t predicate){ this->bytes({0xF2, 0x0F, 0xC2}); this->registers(dst, src); this->_code.push_back(predicate); }
+    /* andpd/orpd/xorpd xmm, xmm (opcode 0x54/0x56/0x57) */
+    void logical(uint8_t opcode, unsigned int dst, unsigned int src){ this->bytes({0x66, 0x0F, opcode}); this->registers(dst, src); }
+    /* mov rax, imm64; movq xmm, rax */
+    void constant(unsigned int xmm, double value){
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        this->bytes({0x48, 0xB8});
+        this->imm64(bits);
+        this->bytes({0x66, 0x48, 0x0F, 0x6E});
+        this->registers(xmm, 0);
+    }
+    /* ucomisd xmm, xmm */
+    void compareOrdered(unsigned int dst, unsigned int src){ this->bytes({0x66, 0x0F, 0x2E}); this->registers(dst, src); }
+    /* jmp rel32 (condition 0) or jcc rel32 to the given instruction, the displacement is set by link */
+    void jump(uint8_t condition, uint32_t target){
+        if (condition == 0)
+            this->bytes({0xE9});
+        else
+            this->bytes({0x0F, condition});
+        this->_jumps.push_back({this->_code.size(), target});
+        this->imm32(0);
+    }
+    /* jp rel8 over the next conditional jump */
+    void skipIfUnordered(void){ this->bytes({0x7A, 0x06}); }
+    /* Marks the start of the code of the next instruction */
+    void label(void){ this->_labels.push_back(this->_code.size()); }
+    /* Sets the displacements of the jumps once the code of every instruction is known */
+    void link(void){
+        for (const std::pair<std::size_t, uint32_t>& jump : this->_jumps){
+            const uint32_t displacement = static_cast<uint32_t>(this->_labels[jump.second]-(jump.first+4));
+            for (int shift = 0; shift < 32; shift += 8)
+                this->_code[jump.first+shift/8] = static_cast<uint8_t>(displacement >> shift);
+        }
+    }
+    /* mov rax, imm64; call rax */
+    void call(void* function){
+        this->bytes({0x48, 0xB8});
+        this->imm64(reinterpret_cast<uint64_t>(function));
+        this->bytes({0xFF, 0xD0});
+    }
+};
+
+/* SSE2 opcodes */
+static const uint8_t SSE_ADD = 0x58;
+static const uint8_t SSE_MUL = 0x59;
+static const uint8_t SSE_SUB = 0x5C;
+static const uint8_t SSE_DIV = 0x5E;
+static const uint8_t SSE_AND = 0x54;
+static const uint8_t SSE_ANDN = 0x55;
+static const uint8_t SSE_OR = 0x56;
+static const uint8_t SSE_XOR = 0x57;
+static const uint8_t CMP_EQ = 0;
+static const uint8_t CMP_LT = 1;
+static const uint8_t CMP_NEQ = 4;
+static const uint8_t JUMP_ALWAYS = 0;
+static const uint8_t JUMP_EQUAL = 0x84;
+static const uint8_t JUMP_NOT_EQUAL = 0x85;
+static const uint8_t JUMP_PARITY = 0x8A;
+
+/* Emits the code of a single instruction, returns false if the instruction is not supported */
+static bool emit(Assembler& as, const Instruction& ins){
+    switch (ins.op){
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+            as.load(0, ins.a);
+            as.arithmetic(ins.op == OP_ADD ? SSE_ADD : ins.op == OP_SUB ? SSE_SUB : ins.op == OP_MUL ? SSE_MUL : SSE_DIV, 0, ins.b);
+            break;
+        case OP_INC: case OP_DEC:
+            as.load(0, ins.a);
+            as.constant(1, 1.0);
+            as.arithmeticRegisters(ins.op == OP_INC ? SSE_ADD : SSE_SUB, 0, 1);
+            break;
+        case OP_LT: case OP_GT: case OP_EQ: case OP_NE:
+            /* The compare mask is turned into 1.0 or 0.0 by masking 1.0 with it */
+            as.load(0, ins.op == OP_GT ? ins.b : ins.a);
+            as.load(1, ins.op == OP_GT ? ins.a : ins.b);
+            as.compare(0, 1, ins.op == OP_EQ ? CMP_EQ : ins.op == OP_NE ? CMP_NEQ : CMP_LT);
+            as.constant(1, 1.0);
+            as.logical(SSE_AND, 0, 1);
+            break;
+        case OP_NOT:
+            as.load(0, ins.a);
+            as.logical(SSE_XOR, 2, 2);
+            as.compare(0, 2, CMP_EQ);
+            as.constant(1, 1.0);
+            as.logical(SSE_AND, 0, 1);
+            break;
+        case OP_AND: case OP_OR: case OP_XOR:
+            /* Logical operators work on the truth masks (value != 0) of both operands */
+            as.logical(SSE_XOR, 2, 2);
+            as.load(0, ins.a);
+            as.compare(0, 2, CMP_NEQ);
+            as.load(3, ins.b);
+            as.compare(3, 2, CMP_NEQ);
+            as.logical(ins.op == OP_AND ? SSE_AND : ins.op == OP_OR ? SSE_OR : SSE_XOR, 0, 3);
+            as.constant(1, 1.0);
+            as.logical(SSE_AND, 0, 1);
+            break;
+        case OP_IF:
+            /* The mask of the condition (in the destination) selects the operand */
+            as.logical(SSE_XOR, 2, 2);
+            as.load(0, ins.dst);
+            as.compare(0, 2, CMP_NEQ);
+            as.load(1, ins.a);
+            as.logical(SSE_AND, 1, 0);
+            as.load(3, ins.b);
+            as.logical(SSE_ANDN, 0, 3);
+            as.logical(SSE_OR, 0, 1);
+            break;
+        case OP_JUMP:
+            as.jump(JUMP_ALWAYS, ins.b);
+            return true;
+        case OP_JUMP_IF_ZERO: case OP_JUMP_IF_NONZERO:
+            /* NaN compares unordered (parity set), it is not 0 */
+            as.logical(SSE_XOR, 2, 2);
+            as.load(0, ins.a);
+            as.compareOrdered(0, 2);
+            if (ins.op == OP_JUMP_IF_ZERO){
+                as.skipIfUnordered();
+                as.jump(JUMP_EQUAL, ins.b);
+            } else{
+                as.jump(JUMP_PARITY, ins.b);
+                as.jump(JUMP_NOT_EQUAL, ins.b);
+            }
+            return true;
+        case OP_RET:
+            as.load(0, ins.a);
+            as.epilogue();
+            return true;
+        default:{
+            void* callee = jit_callee(ins.op);
+            if (callee == nullptr)
+                return false;
+            as.load(0, ins.a);
+            if (OPCODES[ins.op].arity == 2)
+                as.load(1, ins.b);
+            as.call(callee);
+            break;
+        }
+    }
+    as.store(ins.dst, 0);
+    return true;
+}
+
+JitCode::~JitCode(void){
+    munmap(this->_code, this->_size);
+}
+
+std::shared_ptr<JitCode> JitCode::compile(const std::vector<Instruction>& code){
+    /* Registers are addressed with a 32 bit displacement */
+    const uint32_t max_index = 0x0FFFFFFF;
+    Assembler as;
+    as.prologue();
+    for (const Instruction& ins : code){
+        as.label();
+        if (ins.dst > max_index || ins.a > max_index || ins.b > max_index || !emit(as, ins))
+            return nullptr;
+    }
+    if (code.empty() || code.back().op != OP_RET)
+        return nullptr;
+    as.link();
+
+    /* Copy the code to a new mapping and make it executable */
+    std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::size_t size = (as.code().size()+page-1)/page*page;
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+    std::memcpy(mapping, as.code().data(), as.code().size());
+    if (mprotect(mapping, size, PROT_READ | PROT_EXEC) != 0){
+        munmap(mapping, size);
+        return nullptr;
+    }
+    return std::shared_ptr<JitCode>(new JitCode(mapping, size));
+}
+
+#else
+
+JitCode::~JitCode(void){
+}
+
+std::shared_ptr<JitCode> JitCode::compile(const std::vector<Instruction>&){
+    /* Native code generation is not supported on this target */
+    return nullptr;
+}
+
+#endif
+
+}
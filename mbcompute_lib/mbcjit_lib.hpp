@@ -0,0 +1,84 @@
+/****************************************************************************
+* File name: mbcjit_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine JIT header containing declarations for the
+*  native code generator used for hot virtual machine programs.
+****************************************************************************/
+#ifndef __MB_COMPUTE_JIT_LIB__
+
+#define __MB_COMPUTE_JIT_LIB__
+/* Includes */
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+/* Custom libraries */
+#include "mbcvm_lib.hpp"
+
+namespace mbc{
+
+/* Default number of runs of a program before it is compiled to native code */
+const unsigned int JIT_DEFAULT_THRESHOLD = 100;
+
+/* Method returns true if native code generation is supported on this target (Linux x86-64) */
+bool jitSupported(void);
+
+/* Methods to get and set the number of runs of a program before it is compiled
+* to native code, 0 disables the JIT.
+*/
+unsigned int getJitThreshold(void);
+void setJitThreshold(unsigned int);
+
+/* JitCode class holding the native code of a compiled program
+*  The code is generated for x86-64 (System V ABI) using scalar SSE2
+*  instructions, operators without an SSE2 equivalent and the reserved
+*  internal functions are calls to the C library, the jumps of the lazy
+*  operators are native jumps. The code is written to
+*  an anonymous mapping that is made executable (and read only) once
+*  complete. The native function takes the register file of the program.
+*/
+class JitCode{
+private:
+    void* _code;
+    std::size_t _size;
+    JitCode(void* code, std::size_t size) : _code(code), _size(size){}
+public:
+    JitCode(const JitCode&) = delete;
+    JitCode& operator=(const JitCode&) = delete;
+
+    /* Destructor for JitCode class, releases the native code */
+    ~JitCode(void);
+
+    /* Method compiles the given instructions to native code.
+    * Returns nullptr if the target is not supported or compilation failed.
+    */
+    static std::shared_ptr<JitCode> compile(const std::vector<Instruction>&);
+
+    /* Method returns the size of the generated code in bytes */
+    std::size_t size(void) const{ return this->_size; }
+
+    /* Method runs the native code on the given register file and returns the result */
+    double run(double* registers) const{
+        return reinterpret_cast<double (*)(double*)>(this->_code)(registers);
+    }
+};
+
+}
+
+#endif
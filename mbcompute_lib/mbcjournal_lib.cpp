@@ -0,0 +1,186 @@
+/****************************************************************************
+* File name: mbcjournal_lib.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine journal library containing implementations for
+*  the binary journal of the lines evaluated by a session and its replay.
+****************************************************************************/
+
+#include <cstring>
+
+#include "mbcjournal_lib.hpp"
+
+namespace mbc{
+
+/* Size of the fixed part of an entry (timestamp, evaluation time, status and value) */
+static const std::size_t JOURNAL_ENTRY_FIXED = 8+8+1+8;
+
+/* Functions append a number to / read a number from a record */
+template<typename T> static void put(std::string& record, T value){
+    record.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename T> static bool get(const std::string& record, std::size_t& pos, T& value){
+    if (record.size()-pos < sizeof(value))
+        return false;
+    std::memcpy(&value, record.data()+pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+static bool get(const std::string& record, std::size_t& pos, std::string& value){
+    uint32_t size;
+    if (!get(record, pos, size) || record.size()-pos < size)
+        return false;
+    value.assign(record.data()+pos, size);
+    pos += size;
+    return true;
+}
+
+JournalEntry makeJournalEntry(Engine& eng, const std::string& line, std::chrono::system_clock::time_point timestamp, std::chrono::nanoseconds eval_time){
+    JournalEntry entry;
+    entry.timestamp_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count());
+    entry.eval_ns = static_cast<uint64_t>(eval_time.count());
+    entry.value = 0;
+    entry.line = line;
+    if (eng.hasErrors()){
+        entry.status = JOURNAL_ERROR;
+        entry.result = eng.getErrorMsg();
+    } else
+        entry.status = eng.getLastResult(entry.result, entry.value) ? JOURNAL_VALUE : JOURNAL_TEXT;
+    return entry;
+}
+
+bool sameJournalResult(const JournalEntry& expected, const JournalEntry& actual){
+    if (expected.status != actual.status || expected.result != actual.result)
+        return false;
+    return expected.status != JOURNAL_VALUE || std::memcmp(&expected.value, &actual.value, sizeof(double)) == 0;
+}
+
+/* JournalWriter class definitions */
+bool JournalWriter::open(const std::string& file_name){
+    if (!this->_out.open(file_name, std::ios::binary))
+        return false;
+    this->_out.write(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    this->_record.clear();
+    put(this->_record, JOURNAL_VERSION);
+    put(this->_record, JOURNAL_BYTE_ORDER);
+    this->_out.write(this->_record);
+    return true;
+}
+
+void JournalWriter::append(const JournalEntry& entry){
+    /* The size of the entry is written first so a partial entry can be detected */
+    this->_record.clear();
+    put(this->_record, static_cast<uint32_t>(JOURNAL_ENTRY_FIXED+4+entry.line.size()+4+entry.result.size()));
+    put(this->_record, entry.timestamp_ns);
+    put(this->_record, entry.eval_ns);
+    put(this->_record, static_cast<uint8_t>(entry.status));
+    put(this->_record, entry.value);
+    put(this->_record, static_cast<uint32_t>(entry.line.size()));
+    this->_record += entry.line;
+    put(this->_record, static_cast<uint32_t>(entry.result.size()));
+    this->_record += entry.result;
+    this->_out.write(this->_record);
+}
+
+/* JournalReader class definitions */
+bool JournalReader::open(const std::string& file_name){
+    this->_truncated = false;
+    this->_error_message.clear();
+    if (this->_fin.is_open())
+        this->_fin.close();
+    this->_fin.open(file_name, std::ios::binary | std::ios::ate);
+    if (!this->_fin.good()){
+        this->_error_message = "The journal file `"+file_name+"` could not be opened";
+        return false;
+    }
+    this->_file_size = this->_fin.tellg();
+    this->_fin.seekg(0);
+    char magic[sizeof(JOURNAL_MAGIC)];
+    uint32_t version = 0;
+    uint32_t byte_order = 0;
+    this->_fin.read(magic, sizeof(magic));
+    this->_fin.read(reinterpret_cast<char*>(&version), sizeof(version));
+    this->_fin.read(reinterpret_cast<char*>(&byte_order), sizeof(byte_order));
+    if (!this->_fin.good() || std::memcmp(magic, JOURNAL_MAGIC, sizeof(magic)) != 0){
+        this->_error_message = "The file `"+file_name+"` is not a journal";
+        return false;
+    }
+    if (version != JOURNAL_VERSION || byte_order != JOURNAL_BYTE_ORDER){
+        this->_error_message = "The journal `"+file_name+"` was written by an incompatible version or machine";
+        return false;
+    }
+    return true;
+}
+
+bool JournalReader::next(JournalEntry& entry){
+    uint32_t size = 0;
+    this->_fin.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (this->_fin.gcount() == 0)
+        return false;
+    /* The size is not trusted before it is known to fit in the rest of the file */
+    if (this->_fin.gcount() != sizeof(size) || static_cast<std::streamoff>(size) > this->_file_size-this->_fin.tellg()){
+        this->_truncated = true;
+        return false;
+    }
+    this->_record.resize(size);
+    this->_fin.read(&this->_record[0], size);
+    std::size_t pos = 0;
+    uint8_t status = 0;
+    if (!this->_fin.good() || !get(this->_record, pos, entry.timestamp_ns) || !get(this->_record, pos, entry.eval_ns)
+        || !get(this->_record, pos, status) || !get(this->_record, pos, entry.value)
+        || !get(this->_record, pos, entry.line) || !get(this->_record, pos, entry.result) || status > JOURNAL_ERROR){
+        this->_truncated = true;
+        return false;
+    }
+    entry.status = static_cast<JournalStatus>(status);
+    return true;
+}
+
+ReplayReport replayJournal(Engine& eng, const std::string& file_name, const std::function<void(std::size_t, const JournalEntry&, const JournalEntry&)>& mismatch){
+    ReplayReport report;
+    JournalReader reader;
+    if (!reader.open(file_name)){
+        report.error_message = reader.getErrorMsg();
+        return report;
+    }
+    JournalEntry expected;
+    uint64_t recorded_ns = 0;
+    std::chrono::nanoseconds replay_time(0);
+    while (reader.next(expected)){
+        const auto start = std::chrono::steady_clock::now();
+        eng.load(expected.line);
+        eng.eval();
+        const auto eval_time = std::chrono::steady_clock::now()-start;
+        replay_time += eval_time;
+        recorded_ns += expected.eval_ns;
+        ++report.entries;
+        const JournalEntry actual = makeJournalEntry(eng, expected.line, std::chrono::system_clock::now(), eval_time);
+        if (!sameJournalResult(expected, actual)){
+            ++report.mismatches;
+            mismatch(report.entries, expected, actual);
+        }
+    }
+    report.truncated = reader.truncated();
+    report.recorded_s = recorded_ns*1E-9;
+    report.replay_s = std::chrono::duration<double>(replay_time).count();
+    return report;
+}
+
+}
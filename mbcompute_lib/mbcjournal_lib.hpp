@@ -0,0 +1,155 @@
+/****************************************************************************
+* File name: mbcjournal_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine journal header containing declarations for the
+*  binary journal of the lines evaluated by a session and its replay.
+*
+*  A journal starts with a header (magic, format version and byte order
+*  mark) followed by one entry per evaluated line: the size of the entry,
+*  the time the line was evaluated (ns since the epoch), the time taken to
+*  evaluate it (ns), the status, the exact value of the result, the line
+*  and the result text. Numbers are stored in the byte order of the machine
+*  that wrote the journal. The journal is written by a background thread
+*  (see mbclog_lib.hpp), an entry cut off by a crash is ignored on replay.
+****************************************************************************/
+#ifndef __MB_COMPUTE_JOURNAL_LIB__
+
+#define __MB_COMPUTE_JOURNAL_LIB__
+/* Includes */
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <string>
+
+/* Custom libraries */
+#include "mbcomputengine_lib.hpp"
+#include "mbclog_lib.hpp"
+
+namespace mbc{
+
+/* Magic bytes at the start of every journal */
+const char JOURNAL_MAGIC[8] = {'M', 'B', 'C', 'J', 'R', 'N', 'L', '\0'};
+
+/* Version of the journal format, journals of other versions are rejected */
+const uint32_t JOURNAL_VERSION = 1;
+
+/* Byte order mark (read back swapped on a machine of the other byte order) */
+const uint32_t JOURNAL_BYTE_ORDER = 0x01020304;
+
+/* Status of a journal entry */
+enum JournalStatus : uint8_t{
+    /* The result is the value of an expression (compared bit for bit on replay) */
+    JOURNAL_VALUE = 0,
+    /* The result is a message (definitions, commands) */
+    JOURNAL_TEXT = 1,
+    /* The line failed, the result is the error message */
+    JOURNAL_ERROR = 2
+};
+
+/* Structure to hold an entry of a journal */
+struct JournalEntry{
+    uint64_t timestamp_ns;
+    uint64_t eval_ns;
+    JournalStatus status;
+    double value;
+    std::string line;
+    std::string result;
+};
+
+/* Function returns the journal entry of the line last evaluated by the engine,
+* the results of the engine are not removed from its results queue.
+*/
+JournalEntry makeJournalEntry(Engine&, const std::string&, std::chrono::system_clock::time_point, std::chrono::nanoseconds);
+
+/* Function returns true if the given entries have the same status and result,
+* values are compared bit for bit.
+*/
+bool sameJournalResult(const JournalEntry&, const JournalEntry&);
+
+/* JournalWriter class appending entries to a journal file */
+class JournalWriter{
+private:
+    AsyncLogWriter _out;
+    std::string _record;
+public:
+    /* Method creates (truncates) the given journal file, returns false if it can not be opened */
+    bool open(const std::string&);
+
+    /* Method returns true if a journal is open */
+    bool isOpen(void) const{ return this->_out.isOpen(); }
+
+    /* Method appends an entry */
+    void append(const JournalEntry&);
+
+    /* Method waits (at most the given time) until the appended entries are in the file */
+    bool sync(std::chrono::milliseconds timeout = std::chrono::milliseconds::max()){ return this->_out.sync(timeout); }
+
+    /* Method writes the appended entries and closes the journal */
+    void close(void){ this->_out.close(); }
+};
+
+/* JournalReader class reading the entries of a journal file in order */
+class JournalReader{
+private:
+    std::ifstream _fin;
+    std::streamoff _file_size;
+    std::string _record;
+    bool _truncated;
+    std::string _error_message;
+public:
+    /* Constructor for JournalReader class (no file) */
+    JournalReader(void) : _file_size(0), _truncated(false){}
+
+    /* Method opens the given journal and checks its header.
+    * Returns false (and sets the error message) if the file can not be read or is not a journal.
+    */
+    bool open(const std::string&);
+
+    /* Method reads the next entry, returns false at the end of the journal */
+    bool next(JournalEntry&);
+
+    /* Method returns true if the journal ended in a partial entry */
+    bool truncated(void) const{ return this->_truncated; }
+
+    /* Method to return the error message of open (if any) */
+    const std::string getErrorMsg(void) const{ return this->_error_message; }
+};
+
+/* Structure to hold the outcome of a replay */
+struct ReplayReport{
+    std::size_t entries = 0;
+    std::size_t mismatches = 0;
+    /* Time the recorded session and the replay spent evaluating the lines */
+    double recorded_s = 0;
+    double replay_s = 0;
+    bool truncated = false;
+    std::string error_message;
+};
+
+/* Function evaluates the lines of the given journal with the engine as fast as possible
+* and compares every result with the recorded one. The recorded and the replayed entry
+* are passed to the given function for every mismatch.
+*/
+ReplayReport replayJournal(Engine&, const std::string&, const std::function<void(std::size_t, const JournalEntry&, const JournalEntry&)>&);
+
+}
+
+#endif
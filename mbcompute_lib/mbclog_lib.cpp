@@ -0,0 +1,164 @@
+/****************************************************************************
+* File name: mbclog_lib.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine log library containing implementations for the
+*  asynchronous log file writer of the console.
+****************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <pthread.h>
+#define MBC_LOG_SIGMASK
+#endif
+
+#include "mbclog_lib.hpp"
+
+namespace mbc{
+
+/* AsyncLogWriter class definitions */
+AsyncLogWriter::AsyncLogWriter(std::size_t capacity) : _ring(new char[capacity]), _capacity(capacity),
+    _head(0), _tail(0), _written(0), _stop(false), _idle(false){
+}
+
+AsyncLogWriter::~AsyncLogWriter(void){
+    this->close();
+}
+
+bool AsyncLogWriter::open(const std::string& file_name, std::ios::openmode mode){
+    this->close();
+    this->_fout.open(file_name, mode | std::ios::out | std::ios::trunc);
+    if (!this->_fout.good())
+        return false;
+    this->_head = 0;
+    this->_tail = 0;
+    this->_written = 0;
+    this->_stop = false;
+#ifdef MBC_THREADS
+#ifdef MBC_LOG_SIGMASK
+    /* The writer blocks every signal so the handlers of the console run on the producer thread */
+    sigset_t all_signals, old_signals;
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_BLOCK, &all_signals, &old_signals);
+#endif
+    this->_writer = std::thread(&AsyncLogWriter::writerLoop, this);
+#ifdef MBC_LOG_SIGMASK
+    pthread_sigmask(SIG_SETMASK, &old_signals, nullptr);
+#endif
+#endif
+    return true;
+}
+
+#ifdef MBC_THREADS
+void AsyncLogWriter::writerLoop(void){
+    while (true){
+        const uint64_t head = this->_head.load(std::memory_order_acquire);
+        const uint64_t tail = this->_tail.load(std::memory_order_relaxed);
+        if (head == tail){
+            if (this->_stop.load())
+                return;
+            std::unique_lock<std::mutex> guard(this->_wake_lock);
+            this->_idle = true;
+            this->_wake.wait_for(guard, LOG_WRITER_IDLE, [this, tail]{ return this->_head.load() != tail || this->_stop.load(); });
+            this->_idle = false;
+            continue;
+        }
+        /* Write everything queued in one batch (two pieces if it wraps around the ring) */
+        const std::size_t start = static_cast<std::size_t>(tail%this->_capacity);
+        const std::size_t size = static_cast<std::size_t>(head-tail);
+        const std::size_t first = std::min(size, this->_capacity-start);
+        this->_fout.write(this->_ring.get()+start, static_cast<std::streamsize>(first));
+        this->_fout.write(this->_ring.get(), static_cast<std::streamsize>(size-first));
+        this->_tail.store(head, std::memory_order_release);
+        this->_fout.flush();
+        this->_written.store(head, std::memory_order_release);
+    }
+}
+#endif
+
+void AsyncLogWriter::write(const char* data, std::size_t size){
+    if (!this->isOpen())
+        return;
+#ifndef MBC_THREADS
+    /* No writer thread, write the text right away */
+    this->_fout.write(data, static_cast<std::streamsize>(size));
+    this->_fout.flush();
+#else
+    while (size > 0){
+        const uint64_t head = this->_head.load(std::memory_order_relaxed);
+        const std::size_t free = this->_capacity-static_cast<std::size_t>(head-this->_tail.load(std::memory_order_acquire));
+        if (free == 0){
+            /* Full, the writer is busy with the file */
+            std::this_thread::yield();
+            continue;
+        }
+        const std::size_t count = std::min(size, free);
+        const std::size_t start = static_cast<std::size_t>(head%this->_capacity);
+        const std::size_t first = std::min(count, this->_capacity-start);
+        std::memcpy(this->_ring.get()+start, data, first);
+        std::memcpy(this->_ring.get(), data+first, count-first);
+        this->_head.store(head+count, std::memory_order_seq_cst);
+        data += count;
+        size -= count;
+        /* The idle flag is read after the head is published, an idle writer either sees the
+        * new head or is woken here
+        */
+        if (this->_idle.load()){
+            std::lock_guard<std::mutex> guard(this->_wake_lock);
+            this->_wake.notify_one();
+        }
+    }
+#endif
+}
+
+bool AsyncLogWriter::sync(std::chrono::milliseconds timeout){
+    if (!this->isOpen())
+        return true;
+#ifdef MBC_THREADS
+    const uint64_t head = this->_head.load(std::memory_order_acquire);
+    const auto start = std::chrono::steady_clock::now();
+    while (this->_written.load(std::memory_order_acquire) < head){
+        if (timeout != std::chrono::milliseconds::max() && std::chrono::steady_clock::now()-start >= timeout)
+            return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+#else
+    /* Everything is written by write itself */
+    (void)timeout;
+#endif
+    return true;
+}
+
+void AsyncLogWriter::close(void){
+    if (!this->isOpen())
+        return;
+    /* The writer drains the ring before it stops, it is not woken under the lock
+    * so closing from a signal handler can not deadlock (it wakes up on its own)
+    */
+#ifdef MBC_THREADS
+    this->_stop = true;
+    this->_wake.notify_one();
+    this->_writer.join();
+#endif
+    this->_fout.close();
+}
+
+}
@@ -0,0 +1,120 @@
+/****************************************************************************
+* File name: mbclog_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine log header containing declarations for the
+*  asynchronous log file writer of the console.
+*
+*  One producer thread copies the text into a fixed size ring buffer (a
+*  single producer single consumer queue, the producer only takes a lock
+*  to wake the writer when it is idle) and a background thread writes
+*  everything queued since its last write in one batch, flushing the file
+*  after every batch. The producer only waits for the disk if the ring is
+*  full. Without threads (see mbcthreads_lib.hpp) the text is written and
+*  flushed right away by the producer.
+****************************************************************************/
+#ifndef __MB_COMPUTE_LOG_LIB__
+
+#define __MB_COMPUTE_LOG_LIB__
+/* Includes */
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+
+/* Custom libraries */
+#include "mbcthreads_lib.hpp"
+
+#ifdef MBC_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace mbc{
+
+/* Default size of the ring buffer of the asynchronous log */
+const std::size_t LOG_BUFFER_BYTES = 1024*1024;
+
+/* Longest time the idle writer sleeps before looking at the ring again */
+const std::chrono::milliseconds LOG_WRITER_IDLE(5);
+
+/* AsyncLogWriter class writing a file from a background thread */
+class AsyncLogWriter{
+private:
+    std::ofstream _fout;
+    std::unique_ptr<char[]> _ring;
+    std::size_t _capacity;
+    /* Bytes queued by the producer, taken by the writer and written to the file so far */
+    std::atomic<uint64_t> _head;
+    std::atomic<uint64_t> _tail;
+    std::atomic<uint64_t> _written;
+    std::atomic<bool> _stop;
+    std::atomic<bool> _idle;
+#ifdef MBC_THREADS
+    std::mutex _wake_lock;
+    std::condition_variable _wake;
+    std::thread _writer;
+
+    /* Method run by the writer thread */
+    void writerLoop(void);
+#endif
+public:
+    /* Constructor for AsyncLogWriter class with the size of the ring buffer */
+    AsyncLogWriter(std::size_t = LOG_BUFFER_BYTES);
+
+    /* Destructor for AsyncLogWriter class (see close) */
+    ~AsyncLogWriter(void);
+
+    AsyncLogWriter(const AsyncLogWriter&) = delete;
+    AsyncLogWriter& operator=(const AsyncLogWriter&) = delete;
+
+    /* Method opens (truncates) the given file in the given mode (text by default) and starts
+    * the writer, returns false if it can not be opened
+    */
+    bool open(const std::string&, std::ios::openmode = std::ios::out);
+
+    /* Method returns true if a file is open */
+#ifdef MBC_THREADS
+    bool isOpen(void) const{ return this->_writer.joinable(); }
+#else
+    bool isOpen(void) const{ return this->_fout.is_open(); }
+#endif
+
+    /* Method queues the given text, waits for the writer only while the ring is full.
+    * Must only be called from one thread at a time.
+    */
+    void write(const char*, std::size_t);
+    void write(const std::string& text){ this->write(text.data(), text.size()); }
+
+    /* Method waits until everything queued so far has been written and flushed,
+    * returns false if that did not happen within the given time. Takes no lock
+    * (polls) so it may be called from a signal handler.
+    */
+    bool sync(std::chrono::milliseconds = std::chrono::milliseconds::max());
+
+    /* Method writes everything queued, stops the writer and closes the file */
+    void close(void);
+};
+
+}
+
+#endif
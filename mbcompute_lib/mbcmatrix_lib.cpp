@@ -0,0 +1,309 @@
+/****************************************************************************
+* File name: mbcmatrix_lib.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine matrix library containing implementations for the
+*  dense matrix product, transpose and LU factorisation.
+****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "mbcmatrix_lib.hpp"
+#include "mbcreduce_lib.hpp"
+#include "mbcsimd_lib.hpp"
+#include "mbcthreads_lib.hpp"
+
+#ifdef MBC_THREADS
+#include <thread>
+#endif
+
+namespace mbc{
+
+/* Number of columns of the tile of the result held in registers by the product kernel (two SIMD vectors) */
+static const std::size_t MATRIX_TILE_COLS = 2*SIMD_LANES;
+
+/* Number of rows and columns of the tiles copied at a time by the transpose */
+static const std::size_t TRANSPOSE_TILE = 32;
+
+Matrix Matrix::identity(std::size_t size){
+    Matrix result(size, size);
+    for (std::size_t index = 0; index < size; ++index)
+        result(index, index) = 1;
+    return result;
+}
+
+/* Copies a block of the left matrix multiplied by alpha to the buffer, MATRIX_TILE_ROWS rows at a
+* time stored column after column (the missing rows of the last tile are 0)
+*/
+static void pack_left(const double* a, std::size_t lda, std::size_t rows, std::size_t depth, double alpha, double* packed){
+    for (std::size_t row = 0; row < rows; row += MATRIX_TILE_ROWS){
+        const std::size_t tile_rows = std::min(MATRIX_TILE_ROWS, rows-row);
+        for (std::size_t k = 0; k < depth; ++k){
+            for (std::size_t index = 0; index < tile_rows; ++index)
+                packed[index] = alpha*a[(row+index)*lda+k];
+            for (std::size_t index = tile_rows; index < MATRIX_TILE_ROWS; ++index)
+                packed[index] = 0;
+            packed += MATRIX_TILE_ROWS;
+        }
+    }
+}
+
+/* Copies a block of the right matrix to the buffer, MATRIX_TILE_COLS columns at a time stored
+* row after row (the missing columns of the last tile are 0)
+*/
+static void pack_right(const double* b, std::size_t ldb, std::size_t depth, std::size_t cols, double* packed){
+    for (std::size_t col = 0; col < cols; col += MATRIX_TILE_COLS){
+        const std::size_t tile_cols = std::min(MATRIX_TILE_COLS, cols-col);
+        for (std::size_t k = 0; k < depth; ++k){
+            const double* source = b+k*ldb+col;
+            for (std::size_t index = 0; index < tile_cols; ++index)
+                packed[index] = source[index];
+            for (std::size_t index = tile_cols; index < MATRIX_TILE_COLS; ++index)
+                packed[index] = 0;
+            packed += MATRIX_TILE_COLS;
+        }
+    }
+}
+
+/* Adds the product of a packed tile of rows of the left block and a packed tile of columns of
+* the right block to the given rows and columns of the result
+*/
+static void multiply_tile(std::size_t depth, const double* a, const double* b, double* c, std::size_t ldc, std::size_t rows, std::size_t cols){
+    double tile[MATRIX_TILE_ROWS][MATRIX_TILE_COLS];
+#if MBC_SIMD
+    SimdDouble sums[MATRIX_TILE_ROWS][2] = {};
+    for (std::size_t k = 0; k < depth; ++k){
+        const SimdDouble b_low = *reinterpret_cast<const SimdDouble*>(b);
+        const SimdDouble b_high = *reinterpret_cast<const SimdDouble*>(b+SIMD_LANES);
+        for (std::size_t row = 0; row < MATRIX_TILE_ROWS; ++row){
+            const SimdDouble a_row = simdBroadcast(a[row]);
+            sums[row][0] += a_row*b_low;
+            sums[row][1] += a_row*b_high;
+        }
+        a += MATRIX_TILE_ROWS;
+        b += MATRIX_TILE_COLS;
+    }
+    if (rows == MATRIX_TILE_ROWS && cols == MATRIX_TILE_COLS){
+        for (std::size_t row = 0; row < MATRIX_TILE_ROWS; ++row){
+            SimdDouble* target = reinterpret_cast<SimdDouble*>(c+row*ldc);
+            target[0] += sums[row][0];
+            target[1] += sums[row][1];
+        }
+        return;
+    }
+    std::memcpy(tile, sums, sizeof(tile));
+#else
+    std::fill(&tile[0][0], &tile[0][0]+MATRIX_TILE_ROWS*MATRIX_TILE_COLS, 0.0);
+    for (std::size_t k = 0; k < depth; ++k){
+        for (std::size_t row = 0; row < MATRIX_TILE_ROWS; ++row)
+            for (std::size_t col = 0; col < MATRIX_TILE_COLS; ++col)
+                tile[row][col] += a[row]*b[col];
+        a += MATRIX_TILE_ROWS;
+        b += MATRIX_TILE_COLS;
+    }
+#endif
+    for (std::size_t row = 0; row < rows; ++row)
+        for (std::size_t col = 0; col < cols; ++col)
+            c[row*ldc+col] += tile[row][col];
+}
+
+/* Adds alpha times the product of the left (rows x depth) and the right (depth x cols) matrices to
+* the result, every matrix is given by its first element and the distance between its rows
+*/
+static void multiply_add(std::size_t rows, std::size_t cols, std::size_t depth, double alpha, const double* a, std::size_t lda, const double* b, std::size_t ldb, double* c, std::size_t ldc){
+    const std::size_t max_depth = std::min(depth, MATRIX_BLOCK_DEPTH);
+    const std::size_t max_rows = std::min(rows, MATRIX_BLOCK_ROWS);
+    const std::size_t max_cols = std::min(cols, MATRIX_BLOCK_COLS);
+    std::vector<double> packed_left(max_depth*((max_rows+MATRIX_TILE_ROWS-1)/MATRIX_TILE_ROWS)*MATRIX_TILE_ROWS);
+    std::vector<double> packed_right(max_depth*((max_cols+MATRIX_TILE_COLS-1)/MATRIX_TILE_COLS)*MATRIX_TILE_COLS);
+    for (std::size_t col_block = 0; col_block < cols; col_block += MATRIX_BLOCK_COLS){
+        const std::size_t block_cols = std::min(MATRIX_BLOCK_COLS, cols-col_block);
+        for (std::size_t depth_block = 0; depth_block < depth; depth_block += MATRIX_BLOCK_DEPTH){
+            const std::size_t block_depth = std::min(MATRIX_BLOCK_DEPTH, depth-depth_block);
+            pack_right(b+depth_block*ldb+col_block, ldb, block_depth, block_cols, packed_right.data());
+            for (std::size_t row_block = 0; row_block < rows; row_block += MATRIX_BLOCK_ROWS){
+                const std::size_t block_rows = std::min(MATRIX_BLOCK_ROWS, rows-row_block);
+                pack_left(a+row_block*lda+depth_block, lda, block_rows, block_depth, alpha, packed_left.data());
+                for (std::size_t col = 0; col < block_cols; col += MATRIX_TILE_COLS)
+                    for (std::size_t row = 0; row < block_rows; row += MATRIX_TILE_ROWS)
+                        multiply_tile(block_depth, packed_left.data()+row*block_depth, packed_right.data()+col*block_depth,
+                            c+(row_block+row)*ldc+col_block+col, ldc, std::min(MATRIX_TILE_ROWS, block_rows-row), std::min(MATRIX_TILE_COLS, block_cols-col));
+            }
+        }
+    }
+}
+
+/* Runs multiply_add with the rows of the result split across the reduction threads (large products only) */
+static void multiply_add_parallel(std::size_t rows, std::size_t cols, std::size_t depth, double alpha, const double* a, std::size_t lda, const double* b, std::size_t ldb, double* c, std::size_t ldc){
+#ifdef MBC_THREADS
+    unsigned int thread_count = getReduceThreads();
+    if (thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+#else
+    /* No threads, the whole product runs on the calling thread */
+    unsigned int thread_count = 1;
+#endif
+    if (rows*cols*depth < MATRIX_PARALLEL_MIN_WORK)
+        thread_count = 1;
+    /* Every thread takes whole tiles of rows */
+    const std::size_t tiles = (rows+MATRIX_TILE_ROWS-1)/MATRIX_TILE_ROWS;
+    const std::size_t chunk = ((tiles+thread_count-1)/thread_count)*MATRIX_TILE_ROWS;
+    if (thread_count <= 1 || chunk >= rows){
+        multiply_add(rows, cols, depth, alpha, a, lda, b, ldb, c, ldc);
+        return;
+    }
+#ifdef MBC_THREADS
+    std::vector<std::thread> threads;
+    for (std::size_t first = chunk; first < rows; first += chunk)
+        threads.emplace_back(multiply_add, std::min(chunk, rows-first), cols, depth, alpha, a+first*lda, lda, b, ldb, c+first*ldc, ldc);
+    multiply_add(chunk, cols, depth, alpha, a, lda, b, ldb, c, ldc);
+    for (std::thread& thread : threads)
+        thread.join();
+#endif
+}
+
+Matrix matrixMultiply(const Matrix& left, const Matrix& right){
+    Matrix result(left.rows(), right.cols());
+    if (result.size() != 0 && left.cols() != 0)
+        multiply_add_parallel(left.rows(), right.cols(), left.cols(), 1.0, left.data(), left.cols(), right.data(), right.cols(), result.data(), result.cols());
+    return result;
+}
+
+Matrix matrixTranspose(const Matrix& matrix){
+    const std::size_t rows = matrix.rows();
+    const std::size_t cols = matrix.cols();
+    Matrix result(cols, rows);
+    const double* source = matrix.data();
+    double* target = result.data();
+    /* Tiles are copied whole so the rows read and the rows written stay in the cache */
+    for (std::size_t row_tile = 0; row_tile < rows; row_tile += TRANSPOSE_TILE)
+        for (std::size_t col_tile = 0; col_tile < cols; col_tile += TRANSPOSE_TILE){
+            const std::size_t row_end = std::min(row_tile+TRANSPOSE_TILE, rows);
+            const std::size_t col_end = std::min(col_tile+TRANSPOSE_TILE, cols);
+            for (std::size_t row = row_tile; row < row_end; ++row)
+                for (std::size_t col = col_tile; col < col_end; ++col)
+                    target[col*rows+row] = source[row*cols+col];
+        }
+    return result;
+}
+
+/* LUDecomposition class definitions */
+bool LUDecomposition::factor(const Matrix& matrix){
+    const std::size_t size = matrix.rows();
+    this->_lu = matrix;
+    this->_pivots.assign(size, 0);
+    this->_sign = 1;
+    this->_singular = false;
+    double* lu = this->_lu.data();
+    for (std::size_t block = 0; block < size; block += LU_BLOCK_SIZE){
+        const std::size_t block_end = std::min(block+LU_BLOCK_SIZE, size);
+        /* Factor the columns of the block, the rows are swapped whole */
+        for (std::size_t col = block; col < block_end; ++col){
+            std::size_t pivot = col;
+            for (std::size_t row = col+1; row < size; ++row)
+                if (std::abs(lu[row*size+col]) > std::abs(lu[pivot*size+col]))
+                    pivot = row;
+            this->_pivots[col] = pivot;
+            if (pivot != col){
+                std::swap_ranges(lu+col*size, lu+(col+1)*size, lu+pivot*size);
+                this->_sign = -this->_sign;
+            }
+            const double diagonal = lu[col*size+col];
+            if (diagonal == 0){
+                this->_singular = true;
+                continue;
+            }
+            const double* source = lu+col*size;
+            for (std::size_t row = col+1; row < size; ++row){
+                double* target = lu+row*size;
+                const double factor = target[col] /= diagonal;
+                for (std::size_t index = col+1; index < block_end; ++index)
+                    target[index] -= factor*source[index];
+            }
+        }
+        if (block_end == size)
+            break;
+        /* Rows of U right of the block (forward substitution with the block of L) */
+        for (std::size_t row = block+1; row < block_end; ++row){
+            double* target = lu+row*size;
+            for (std::size_t k = block; k < row; ++k){
+                const double factor = target[k];
+                const double* source = lu+k*size;
+                for (std::size_t index = block_end; index < size; ++index)
+                    target[index] -= factor*source[index];
+            }
+        }
+        /* The rest of the matrix is updated with the product of the block of L and the rows of U */
+        multiply_add_parallel(size-block_end, size-block_end, block_end-block, -1.0, lu+block_end*size+block, size,
+            lu+block*size+block_end, size, lu+block_end*size+block_end, size);
+    }
+    return !this->_singular;
+}
+
+double LUDecomposition::determinant(void) const{
+    if (this->_singular)
+        return 0;
+    double determinant = this->_sign;
+    for (std::size_t index = 0; index < this->_lu.rows(); ++index)
+        determinant *= this->_lu(index, index);
+    return determinant;
+}
+
+Matrix LUDecomposition::solve(const Matrix& rhs) const{
+    const std::size_t size = this->_lu.rows();
+    const std::size_t cols = rhs.cols();
+    const double* lu = this->_lu.data();
+    Matrix result = rhs;
+    double* x = result.data();
+    for (std::size_t row = 0; row < size; ++row)
+        if (this->_pivots[row] != row)
+            std::swap_ranges(x+row*cols, x+(row+1)*cols, x+this->_pivots[row]*cols);
+    /* Forward substitution with L (its diagonal is 1) */
+    for (std::size_t row = 1; row < size; ++row){
+        double* target = x+row*cols;
+        for (std::size_t k = 0; k < row; ++k){
+            const double factor = lu[row*size+k];
+            const double* source = x+k*cols;
+            for (std::size_t index = 0; index < cols; ++index)
+                target[index] -= factor*source[index];
+        }
+    }
+    /* Back substitution with U */
+    for (std::size_t row = size; row-- > 0;){
+        double* target = x+row*cols;
+        for (std::size_t k = row+1; k < size; ++k){
+            const double factor = lu[row*size+k];
+            const double* source = x+k*cols;
+            for (std::size_t index = 0; index < cols; ++index)
+                target[index] -= factor*source[index];
+        }
+        const double diagonal = lu[row*size+row];
+        for (std::size_t index = 0; index < cols; ++index)
+            target[index] /= diagonal;
+    }
+    return result;
+}
+
+Matrix LUDecomposition::inverse(void) const{
+    return this->solve(Matrix::identity(this->_lu.rows()));
+}
+
+}
@@ -0,0 +1,142 @@
+/****************************************************************************
+* File name: mbcmatrix_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine matrix header containing declarations for the
+*  dense matrix type, its product, its transpose and the LU factorisation
+*  used to solve linear systems.
+*
+*  The product is computed a block at a time: a block of the right matrix
+*  (MATRIX_BLOCK_DEPTH x MATRIX_BLOCK_COLS) and of the left matrix
+*  (MATRIX_BLOCK_ROWS x MATRIX_BLOCK_DEPTH) are copied to contiguous
+*  buffers that stay in the caches while a kernel accumulates a tile of
+*  MATRIX_TILE_ROWS rows of the result in SIMD registers. Products larger
+*  than MATRIX_PARALLEL_MIN_WORK multiply-adds split the rows of the result
+*  across the reduction threads (see getReduceThreads). Every element is
+*  accumulated in the same order for every thread count.
+****************************************************************************/
+#ifndef __MB_COMPUTE_MATRIX_LIB__
+
+#define __MB_COMPUTE_MATRIX_LIB__
+/* Includes */
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace mbc{
+
+/* Number of rows of the tile of the result held in registers by the product kernel */
+const std::size_t MATRIX_TILE_ROWS = 4;
+
+/* Blocking of the product (see the description above) */
+const std::size_t MATRIX_BLOCK_ROWS = 128;
+const std::size_t MATRIX_BLOCK_DEPTH = 256;
+const std::size_t MATRIX_BLOCK_COLS = 2048;
+
+/* Number of multiply-adds above which a product is split across threads */
+const std::size_t MATRIX_PARALLEL_MIN_WORK = 128*128*128;
+
+/* Number of columns factored at a time by the LU factorisation, the rest of
+* the matrix is updated with one product per block of columns
+*/
+const std::size_t LU_BLOCK_SIZE = 64;
+
+/* Dense matrix class, the elements are stored contiguously row after row */
+class Matrix{
+private:
+    std::size_t _rows;
+    std::size_t _cols;
+    std::vector<double> _values;
+public:
+    /* Constructors for Matrix class (the elements are given row after row) */
+    Matrix(void) : _rows(0), _cols(0){}
+    Matrix(std::size_t rows, std::size_t cols, double value = 0) : _rows(rows), _cols(cols), _values(rows*cols, value){}
+    Matrix(std::size_t rows, std::size_t cols, std::vector<double> values) : _rows(rows), _cols(cols), _values(std::move(values)){}
+
+    /* Method returns the identity matrix of the given size */
+    static Matrix identity(std::size_t);
+
+    /* Methods return the shape of the matrix */
+    std::size_t rows(void) const{ return this->_rows; }
+    std::size_t cols(void) const{ return this->_cols; }
+    std::size_t size(void) const{ return this->_values.size(); }
+    bool square(void) const{ return this->_rows == this->_cols; }
+
+    /* Method changes the shape of the matrix, the elements are kept in order (the number of
+    * elements must not change)
+    */
+    void reshape(std::size_t rows, std::size_t cols){ this->_rows = rows; this->_cols = cols; }
+
+    /* Methods return the elements (row after row) */
+    double* data(void){ return this->_values.data(); }
+    const double* data(void) const{ return this->_values.data(); }
+    std::vector<double>& values(void){ return this->_values; }
+    const std::vector<double>& values(void) const{ return this->_values; }
+
+    /* Methods return the element at the given row and column */
+    double& operator()(std::size_t row, std::size_t col){ return this->_values[row*this->_cols+col]; }
+    double operator()(std::size_t row, std::size_t col) const{ return this->_values[row*this->_cols+col]; }
+};
+
+/* Function returns the product of the given matrices, the columns of the first
+* must match the rows of the second (checked by the caller)
+*/
+Matrix matrixMultiply(const Matrix&, const Matrix&);
+
+/* Function returns the transpose of the given matrix */
+Matrix matrixTranspose(const Matrix&);
+
+/* LU factorisation class (with partial pivoting) of a square matrix, used to solve
+* linear systems and to compute determinants and inverses
+*/
+class LUDecomposition{
+private:
+    /* Factors L (below the diagonal, its diagonal is 1) and U (the rest) */
+    Matrix _lu;
+    /* Row swapped with row i at step i of the factorisation */
+    std::vector<std::size_t> _pivots;
+    /* Sign of the permutation of the rows */
+    int _sign;
+    bool _singular;
+public:
+    /* Constructor for LUDecomposition class */
+    LUDecomposition(void) : _sign(1), _singular(true){}
+
+    /* Method factors the given square matrix, returns false if it is singular
+    * (a pivot is 0, the factorisation is still completed)
+    */
+    bool factor(const Matrix&);
+
+    /* Method returns true if the factored matrix is singular */
+    bool singular(void) const{ return this->_singular; }
+
+    /* Method returns the determinant of the factored matrix */
+    double determinant(void) const;
+
+    /* Method returns the solution X of A*X = B for the factored matrix A, B must
+    * have as many rows as A (a vector is a matrix of one column)
+    */
+    Matrix solve(const Matrix&) const;
+
+    /* Method returns the inverse of the factored matrix */
+    Matrix inverse(void) const;
+};
+
+}
+
+#endif
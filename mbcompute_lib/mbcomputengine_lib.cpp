@@ -21,6 +21,10 @@
 *  expression parsing and evaluation.
 ****************************************************************************/
 
+#include <cstdio>
+#include <cfloat>
+#include <charconv>
+
 #include "mbcomputengine_lib.hpp"
 
 namespace mbc{
@@ -31,16 +35,42 @@ namespace mbc{
 Engine::Engine(){
     /* Initialise class members */
     this->_evalWiper = 0;
-    this->_error_message.clear();
-    this->_warning_message.clear();
+    this->_last_value = 0;
+    this->_value_index = std::string::npos;
+    this->_errors.clear();
+    this->_warnings.clear();
+    this->_number_mode = MODE_AUTO;
+    this->_call_depth = 0;
+    this->_expansion_limit = MAX_EXPANSION_SIZE;
+    this->_source_command = std::string::npos;
+    this->_source_text = nullptr;
+    this->_call_offset = std::string::npos;
+    this->_call_length = 0;
 
     /* Define all default supported functions */
-    this->_supported_functions = SUPPORTED_FUNS;
+    for (const BuiltinFunction& builtin : SUPPORTED_FUNS)
+        this->_supported_functions.push_back(builtin.getMetaFunction());
 }
 
 Engine::~Engine(void){
 }
 
+void Engine::setVariable(const std::string& name, double value){
+    auto indx_it = std::find(this->_varNames.cbegin(), this->_varNames.cend(), name);
+    /* Make sure that this is a variable and not a function name (in which case the next element will be an opening parentheses)*/
+    if (indx_it != this->_varNames.cend() && !(std::next(indx_it) != this->_varNames.cend() && *(indx_it+1) == "("))
+        /* Update variable value */
+        this->_varValues[indx_it-this->_varNames.cbegin()] = value;
+    else{
+        /* Add new variable */
+        this->_varNames.push_back(name);
+        this->_varValues.push_back(value);
+    }
+    /* A name holds either a scalar, a vector or a matrix */
+    this->_vecValues.erase(name);
+    this->_matValues.erase(name);
+}
+
 bool Engine::checkVarName(std::string name){
     /* If the first character is not an alphabet or _ it is not a valid variable name */
     if (!(isalpha(name[0]) || name[0] == '_'))
@@ -52,15 +82,523 @@ bool Engine::checkVarName(std::string name){
     return true;
 }
 
-const std::string Engine::replaceVars(const std::string cmd){
-    std::string cmd_mod = "";
+/* Returns the name part of a function argument (`name` or `name=default`) */
+static const std::string get_arg_name(const std::string& arg){
+    return arg.substr(0, arg.find("="));
+}
+
+bool Engine::compileFunction(const MetaFunction& fun, Program& program){
+    if (fun.expr.empty())
+        return false;
+    std::vector<std::string> names;
+    for (const std::string& arg : fun.arg_names)
+        names.push_back(get_arg_name(arg));
+
+    /* Postfix of the body with the arguments as operands */
+    Evaluator body;
+    body.parseExpr(fun.expr);
+    body.convertToPostfix();
+    std::vector<std::string> postfix = body.getPostfixBuffer();
+
+    /* Postfix of the body expanded the same way evalFunctions does, with a placeholder value per argument */
+    std::string expanded = fun.expr;
+    std::vector<std::string> placeholders;
+    for (std::size_t index = 0; index < names.size(); ++index){
+        placeholders.push_back(std::to_string(index+1)+".5");
+        expanded = regexReplace(expanded, makeRegex(getRegExEscaped(names[index])), "("+placeholders.back()+")");
+    }
+    Evaluator reference;
+    reference.parseExpr(expanded);
+    reference.convertToPostfix();
+
+    /* Only names of arguments may remain and the expanded body must have the same structure */
+    for (std::string& token : postfix){
+        if (!(std::isalpha(token[0]) || token[0] == '_'))
+            continue;
+        auto name_it = std::find(names.cbegin(), names.cend(), token);
+        if (name_it == names.cend())
+            return false;
+        token = placeholders[name_it-names.cbegin()];
+    }
+    if (postfix != reference.getPostfixBuffer())
+        return false;
+
+    return program.compile(body.getPostfixBuffer(), names) && !program.multipleResults();
+}
+
+bool Engine::evalCompiledCall(const MetaFunction& fun, const std::vector<std::string>& args, std::string& result){
+    /* Compiled bodies run on double, in the other number modes the call is expanded (see evaluateRunner) */
+    if (this->_number_mode != MODE_AUTO && this->_number_mode != MODE_DOUBLE)
+        return false;
+    /* Compile the body on first use and whenever the function is redefined */
+    auto compiled_it = this->_compiled_functions.find(fun.name);
+    if (compiled_it == this->_compiled_functions.end() || compiled_it->second.expr != fun.expr || compiled_it->second.arg_names != fun.arg_names){
+        CompiledFunction& compiled = this->_compiled_functions[fun.name];
+        compiled.expr = fun.expr;
+        compiled.arg_names = fun.arg_names;
+        compiled.compiled = this->compileFunction(fun, compiled.program);
+        compiled_it = this->_compiled_functions.find(fun.name);
+    }
+    if (!compiled_it->second.compiled)
+        return false;
+
+    /* Evaluate the arguments, only plain numeric expressions are accepted */
+    std::vector<double> values;
+    for (std::size_t index = 0; index < fun.arg_names.size(); ++index){
+        std::string arg;
+        if (index < args.size())
+            arg = args[index];
+        else
+            arg = fun.arg_names[index].substr(fun.arg_names[index].find("=")+1);
+        if (arg.empty())
+            return false;
+        Evaluator arg_runner;
+        arg_runner.parseExpr(arg);
+        arg_runner.convertToPostfix();
+        for (const std::string& token : arg_runner.getPostfixBuffer())
+            if (std::isalpha(token[0]) || token[0] == '_')
+                return false;
+        const Program& arg_program = arg_runner.getProgram();
+        if (!arg_program.valid() || arg_program.multipleResults())
+            return false;
+        values.push_back(arg_runner.evaluatePostfix());
+    }
+
+    /* Non finite results can not be written back into the expression */
+    double value = compiled_it->second.program.run(values.data());
+    if (!std::isfinite(value))
+        return false;
+    /* Enough digits to read back the exact value */
+    char str_value[32];
+    std::snprintf(str_value, sizeof(str_value), "%.17G", value);
+    result = str_value;
+    return true;
+}
+
+bool Engine::inlineExpression(const std::string& expr, const std::map<std::string, std::vector<std::string>>& bindings, std::vector<std::string>& postfix, unsigned int depth){
+    if (depth > MAX_INLINE_DEPTH){
+        this->addError(DIAG_INLINE_TOO_DEEP);
+        return false;
+    }
+    Evaluator parsed;
+    parsed.parseExpr(expr);
+    const std::vector<std::string> infix = parsed.getInfixBuffer();
+
+    /* Replace every call with a placeholder operand and inline the call separately */
+    std::vector<std::vector<std::string>> calls;
+    std::string flattened;
+    for (std::size_t index = 0; index < infix.size(); ++index){
+        const std::string& token = infix[index];
+        if (!(std::isalpha(token[0]) || token[0] == '_') || index+1 >= infix.size() || infix[index+1] != "("){
+            flattened += token;
+            continue;
+        }
+        /* Split the arguments at the commas outside of nested parentheses */
+        std::vector<std::string> args(1);
+        unsigned int level = 0;
+        std::size_t close_index = index+1;
+        for (; close_index < infix.size(); ++close_index){
+            const std::string& arg_token = infix[close_index];
+            if (arg_token == "(" && level++ == 0)
+                continue;
+            if (arg_token == ")" && --level == 0)
+                break;
+            if (arg_token == "," && level == 1)
+                args.emplace_back();
+            else
+                args.back() += arg_token;
+        }
+        if (args.size() == 1 && args[0].empty())
+            args.clear();
+        std::vector<std::vector<std::string>> arg_postfixes(args.size());
+        for (std::size_t arg_index = 0; arg_index < args.size(); ++arg_index)
+            if (!this->inlineExpression(args[arg_index], bindings, arg_postfixes[arg_index], depth+1))
+                return false;
+
+        std::vector<std::string> call_postfix;
+        const OpCode op = getOpCode(token);
+        if (token[0] == '_' && op != OP_COUNT){
+            /* Reserved internal functions are kept as function tokens */
+            if (args.size() != OPCODES[op].arity){
+                this->addError(DIAG_OPERATION_ARITY, {token, std::to_string(OPCODES[op].arity)});
+                return false;
+            }
+            for (const std::vector<std::string>& arg_postfix : arg_postfixes)
+                call_postfix.insert(call_postfix.end(), arg_postfix.cbegin(), arg_postfix.cend());
+            call_postfix.push_back(token);
+        } else{
+            auto fun_it = std::find_if(this->_supported_functions.cbegin(), this->_supported_functions.cend(), [&token](const MetaFunction& item){return item.name == token;});
+            if (fun_it == this->_supported_functions.cend()){
+                this->addError(DIAG_UNDEFINED_FUNCTION, {token});
+                return false;
+            }
+            if (!this->inlineCall(*fun_it, arg_postfixes, call_postfix, depth+1))
+                return false;
+        }
+        /* Placeholder names hold no digits so they are parsed as a single name */
+        flattened += "__call"+std::string(calls.size()+1, 'x')+"__";
+        calls.push_back(call_postfix);
+        index = close_index;
+    }
+
+    /* Convert the flattened expression and splice the calls and the bound names back in */
+    Evaluator body;
+    body.parseExpr(flattened);
+    body.convertToPostfix();
+    for (const std::string& token : body.getPostfixBuffer()){
+        if (!(std::isalpha(token[0]) || token[0] == '_')){
+            postfix.push_back(token);
+            continue;
+        }
+        const std::vector<std::string>* spliced = nullptr;
+        if (token.compare(0, 6, "__call") == 0 && token.length() > 8)
+            spliced = &calls[token.length()-9];
+        else{
+            auto binding_it = bindings.find(token);
+            if (binding_it != bindings.cend())
+                spliced = &binding_it->second;
+        }
+        if (spliced == nullptr){
+            this->addError(DIAG_UNDEFINED_VARIABLE, {token});
+            return false;
+        }
+        postfix.insert(postfix.end(), spliced->cbegin(), spliced->cend());
+    }
+    return true;
+}
+
+bool Engine::inlineCall(const MetaFunction& fun, const std::vector<std::vector<std::string>>& args, std::vector<std::string>& postfix, unsigned int depth){
+    if (args.size() > fun.arg_names.size()){
+        this->addError(DIAG_INLINE_TOO_MANY_ARGUMENTS, {fun.name});
+        return false;
+    }
+    /* A function without a body always returns 0 */
+    if (fun.expr.empty()){
+        postfix.push_back("0");
+        return true;
+    }
+    std::map<std::string, std::vector<std::string>> bindings;
+    for (std::size_t index = 0; index < fun.arg_names.size(); ++index){
+        const std::string arg_name = get_arg_name(fun.arg_names[index]);
+        if (index < args.size()){
+            bindings[arg_name] = args[index];
+            continue;
+        }
+        const std::size_t default_pos = fun.arg_names[index].find("=");
+        if (default_pos == std::string::npos){
+            this->addError(DIAG_INLINE_NO_DEFAULT, {fun.name, arg_name});
+            return false;
+        }
+        if (!this->inlineExpression(fun.arg_names[index].substr(default_pos+1), {}, bindings[arg_name], depth+1))
+            return false;
+    }
+    return this->inlineExpression(fun.expr, bindings, postfix, depth);
+}
+
+bool Engine::evalSolverCall(const std::string& solver, const std::vector<std::string>& args, std::string& result){
+    const std::string solver_name = solver.substr(2, solver.size()-4);
+    if (this->_number_mode != MODE_AUTO && this->_number_mode != MODE_DOUBLE)
+        this->addWarning(DIAG_DOUBLE_MODE, {solver_name, NUMBER_MODE_NAMES[this->_number_mode]});
+    /* The first argument is the name of the function, it is solved for its first argument */
+    auto fun_it = std::find_if(this->_supported_functions.cbegin(), this->_supported_functions.cend(), [&args](const MetaFunction& item){return item.name == args[0];});
+    if (fun_it == this->_supported_functions.cend()){
+        this->addError(DIAG_UNDEFINED_FUNCTION_ARGUMENT, {args[0], solver_name});
+        return false;
+    }
+    if (fun_it->arg_names.empty() || fun_it->expr.empty()){
+        this->addError(DIAG_SOLVER_FUNCTION, {args[0], solver_name});
+        return false;
+    }
+
+    /* Evaluate the start value */
+    Evaluator start_runner;
+    start_runner.parseExpr(args[1]);
+    start_runner.convertToPostfix();
+    double x = start_runner.evaluatePostfix();
+    if (!start_runner.getErrors().empty()){
+        this->_errors.append(start_runner.getErrors());
+        return false;
+    }
+
+    /* Inline the body for the first argument, the other arguments take their default values */
+    const std::string input_name = "__x__";
+    std::vector<std::string> postfix;
+    if (!this->inlineCall(*fun_it, {{input_name}}, postfix, 0))
+        return false;
+
+    /* Newton's method, the steps are halved until they improve the objective */
+    const unsigned int max_iterations = 100;
+    bool flag_converged = false;
+    if (solver == "__solve__"){
+        BasicProgram<Dual<double>> program;
+        if (!program.compile(postfix, {input_name}, true) || program.multipleResults()){
+            this->addError(DIAG_SOLVER_NOT_EVALUABLE, {args[0], solver_name});
+            return false;
+        }
+        auto residual = [&program](double at){ Dual<double> input(at, 1.0); return program.run(&input); };
+        Dual<double> current = residual(x);
+        for (unsigned int iteration = 0; iteration < max_iterations && std::isfinite(current.value()); ++iteration){
+            if (current.value() == 0){
+                flag_converged = true;
+                break;
+            }
+            if (current.derivative() == 0 || !std::isfinite(current.derivative()))
+                break;
+            double step = -current.value()/current.derivative();
+            Dual<double> next = residual(x+step);
+            for (unsigned int halving = 0; halving < 60 && !(std::abs(next.value()) < std::abs(current.value())); ++halving){
+                step /= 2;
+                next = residual(x+step);
+            }
+            x += step;
+            current = next;
+            if (std::abs(step) <= 4*DBL_EPSILON*std::max(1.0, std::abs(x))){
+                flag_converged = true;
+                break;
+            }
+        }
+    } else{
+        /* The second derivative comes from nesting the dual numbers */
+        BasicProgram<Dual<Dual<double>>> program;
+        if (!program.compile(postfix, {input_name}, true) || program.multipleResults()){
+            this->addError(DIAG_SOLVER_NOT_EVALUABLE, {args[0], solver_name});
+            return false;
+        }
+        auto objective = [&program](double at){
+            Dual<Dual<double>> input(Dual<double>(at, 1.0), Dual<double>(1.0, 0.0));
+            return program.run(&input);
+        };
+        Dual<Dual<double>> current = objective(x);
+        for (unsigned int iteration = 0; iteration < max_iterations && std::isfinite(current.value().value()); ++iteration){
+            const double slope = current.value().derivative();
+            const double curvature = current.derivative().derivative();
+            if (slope == 0){
+                flag_converged = curvature >= 0;
+                break;
+            }
+            /* Move down the slope where the function is not convex */
+            double step = curvature > 0 ? -slope/curvature : -slope;
+            Dual<Dual<double>> next = objective(x+step);
+            for (unsigned int halving = 0; halving < 60 && !(next.value().value() <= current.value().value()); ++halving){
+                step /= 2;
+                next = objective(x+step);
+            }
+            x += step;
+            current = next;
+            if (std::abs(step) <= 4*DBL_EPSILON*std::max(1.0, std::abs(x))){
+                flag_converged = current.derivative().derivative() >= 0;
+                break;
+            }
+        }
+    }
+    if (!flag_converged || !std::isfinite(x)){
+        this->addError(DIAG_SOLVER_NOT_CONVERGED, {solver_name, args[0], args[1]});
+        return false;
+    }
+    /* Enough digits to read back the exact value */
+    char str_value[32];
+    std::snprintf(str_value, sizeof(str_value), "%.17G", x);
+    result = str_value;
+    return true;
+}
+
+bool Engine::evalBound(const std::string& expr, const std::string& user, double& value){
+    std::string bound = this->evalFunctions(expr);
+    if (!this->_errors.empty())
+        return false;
+    Evaluator bound_runner;
+    bound_runner.parseExpr(bound);
+    bound_runner.convertToPostfix();
+    value = bound_runner.evaluatePostfix();
+    if (!bound_runner.getErrors().empty() || !std::isfinite(value)){
+        this->_errors.append(bound_runner.getErrors());
+        this->addError(DIAG_BOUND_NOT_FINITE, {expr, user});
+        return false;
+    }
+    return true;
+}
+
+bool Engine::evalSweep(const std::string& spec){
+    if (this->_number_mode != MODE_AUTO && this->_number_mode != MODE_DOUBLE)
+        this->addWarning(DIAG_DOUBLE_MODE, {"sweep", NUMBER_MODE_NAMES[this->_number_mode]});
+    /* Axes are `name=start:step:stop` separated by commas, the expression follows the last colon */
+    std::vector<SweepAxis> axes;
+    std::map<std::string, std::vector<std::string>> bindings;
+    std::size_t pos = 0;
+    const std::regex axis_filter = makeRegex(R"(^([a-zA-Z_][a-zA-Z0-9_]*)=([^:,]+):([^:,]+):([^:,]+)([,:]))");
+    std::smatch match;
+    while (true){
+        const std::string rest = spec.substr(pos);
+        if (!regexSearch(rest, match, axis_filter)){
+            this->addError(DIAG_SWEEP_INVALID, {spec});
+            this->addError(DIAG_SWEEP_USAGE);
+            return false;
+        }
+        SweepAxis axis;
+        axis.name = match[1].str();
+        double stop;
+        if (!this->evalBound(this->replaceVars(match[2].str()), "sweep", axis.start)
+            || !this->evalBound(this->replaceVars(match[3].str()), "sweep", axis.step)
+            || !this->evalBound(this->replaceVars(match[4].str()), "sweep", stop))
+            return false;
+        if (axis.step == 0 || (stop-axis.start)/axis.step < 0){
+            this->addError(DIAG_SWEEP_STEP, {axis.name, match[2].str(), match[4].str()});
+            return false;
+        }
+        /* A small tolerance keeps the stop value when it is reached up to rounding */
+        axis.count = static_cast<std::size_t>(std::floor((stop-axis.start)/axis.step*(1+1E-12)+1E-9))+1;
+        bindings[axis.name] = {"__sweep"+std::to_string(axes.size())+"__"};
+        axes.push_back(axis);
+        pos += match.length(0);
+        if (match[5].str() == ":")
+            break;
+    }
+    double row_count = 1;
+    for (const SweepAxis& axis : axes)
+        row_count *= static_cast<double>(axis.count);
+    if (row_count > 9007199254740992.0){
+        this->addError(DIAG_SWEEP_TOO_LARGE);
+        return false;
+    }
+
+    /* Variables are read by value, the axes are the inputs of the program */
+    std::vector<std::string> inputs;
+    for (std::size_t index = 0; index < axes.size(); ++index)
+        inputs.push_back("__sweep"+std::to_string(index)+"__");
+    for (std::size_t index = 0; index < this->_varNames.size(); ++index)
+        if (bindings.find(this->_varNames[index]) == bindings.cend()){
+            char str_value[32];
+            std::snprintf(str_value, sizeof(str_value), "%.17G", this->_varValues[index]);
+            bindings[this->_varNames[index]] = {str_value};
+        }
+    std::vector<std::string> postfix;
+    if (!this->inlineExpression(spec.substr(pos), bindings, postfix, 0))
+        return false;
+    Program program;
+    if (!program.compile(postfix, inputs, true) || program.multipleResults()){
+        this->addError(DIAG_SWEEP_NOT_EVALUABLE);
+        return false;
+    }
+
+    /* Stream the rows to the sink, without one they are added to the results as text */
+    const std::size_t columns = axes.size()+1;
+    sweepGrid(program, axes, [this, columns](const double* rows, std::size_t count){
+        if (this->_sweep_sink){
+            this->_sweep_sink(rows, count, columns);
+            return;
+        }
+        for (std::size_t index = 0; index < count; ++index)
+            this->_evalBuffer.push_back(formatSweepRow(rows+index*columns, columns));
+    });
+    this->_evalBuffer.push_back("[Info] Sweep of "+std::to_string(static_cast<std::size_t>(row_count))+" point(s) done");
+    return true;
+}
+
+bool Engine::evalReductionCall(const std::string& reduction, const std::string& args_text, std::string& result){
+    const std::string reduction_name = reduction.substr(2, reduction.size()-4);
+    if (this->_number_mode != MODE_AUTO && this->_number_mode != MODE_DOUBLE)
+        this->addWarning(DIAG_DOUBLE_MODE, {reduction_name, NUMBER_MODE_NAMES[this->_number_mode]});
+    /* Split the arguments at the commas outside of nested parentheses */
+    std::vector<std::string> args(1);
+    int level = 0;
+    for (char ch : args_text){
+        level += ch == '(' ? 1 : (ch == ')' ? -1 : 0);
+        if (ch == ',' && level == 0)
+            args.emplace_back();
+        else
+            args.back() += ch;
+    }
+    if (args.size() != 3 && args.size() != 4){
+        this->addError(DIAG_REDUCTION_USAGE, {reduction_name});
+        return false;
+    }
+
+    /* Inline the function or the expression with the index/variable as the only input */
+    const std::string input_name = "__x__";
+    std::vector<std::string> postfix;
+    if (args.size() == 3){
+        auto fun_it = std::find_if(this->_supported_functions.cbegin(), this->_supported_functions.cend(), [&args](const MetaFunction& item){return item.name == args[0];});
+        if (fun_it == this->_supported_functions.cend()){
+            this->addError(DIAG_UNDEFINED_FUNCTION_ARGUMENT, {args[0], reduction_name});
+            return false;
+        }
+        if (!this->inlineCall(*fun_it, {{input_name}}, postfix, 0))
+            return false;
+    } else{
+        if (!regexMatch(args[0], makeRegex(R"([a-zA-Z_][a-zA-Z0-9_]*)"))){
+            this->addError(DIAG_REDUCTION_VARIABLE, {args[0], reduction_name});
+            return false;
+        }
+        if (!this->inlineExpression(args[3], {{args[0], {input_name}}}, postfix, 0))
+            return false;
+    }
+    Program program;
+    if (!program.compile(postfix, {input_name}, true) || program.multipleResults()){
+        this->addError(DIAG_REDUCTION_NOT_EVALUABLE, {reduction_name});
+        return false;
+    }
+
+    /* Evaluate the bounds (they may call functions) */
+    double bounds[2];
+    for (std::size_t index = 0; index < 2; ++index)
+        if (!this->evalBound(args[index+1], reduction_name, bounds[index]))
+            return false;
+
+    /* Every index of a summation has to be exact (see REDUCE_MAX_TERMS) */
+    if (reduction == "__sum__" && bounds[1] >= bounds[0] && !(std::floor(bounds[1]-bounds[0])+1 <= REDUCE_MAX_TERMS)){
+        this->addError(DIAG_REDUCTION_TOO_LARGE, {reduction_name, "9007199254740992"});
+        return false;
+    }
+
+    double value;
+    if (reduction == "__sum__")
+        value = reduceSum(program, bounds[0], bounds[1]);
+    else{
+        bool flag_converged;
+        value = reduceIntegral(program, bounds[0], bounds[1], flag_converged);
+        if (!flag_converged)
+            this->addWarning(DIAG_INTEGRATE_INACCURATE);
+    }
+    if (!std::isfinite(value)){
+        this->addError(DIAG_REDUCTION_NOT_FINITE, {reduction_name});
+        return false;
+    }
+    /* Enough digits to read back the exact value */
+    char str_value[32];
+    std::snprintf(str_value, sizeof(str_value), "%.17G", value);
+    result = str_value;
+    return true;
+}
+
+const std::string Engine::replaceVars(const std::string& cmd){
+    std::string cmd_mod;
+    cmd_mod.reserve(cmd.size());
+    /* The result is mapped back to the command (the parser also puts the numbers in parentheses) */
+    this->_vars_map.clear();
     this->_runner.parseExpr(cmd);
-    for (std::string element : this->_runner.getInfixBuffer()){
+    const std::vector<std::string>& infix = this->_runner.getInfixBuffer();
+    const std::vector<std::size_t>& offsets = this->_runner.getInfixOffsets();
+    for (std::size_t index = 0; index < infix.size(); ++index){
+        const std::string& element = infix[index];
+        this->_vars_map.copy(cmd_mod.size(), offsets[index]);
+        /* Only names can be variables (numbers and operators are copied without a lookup) */
+        if (!(std::isalpha(static_cast<unsigned char>(element[0])) || element[0] == '_')){
+            cmd_mod += element;
+            continue;
+        }
         /* Check if this element exists in the list of known variable names */
         auto name_it = std::find(this->_varNames.cbegin(), this->_varNames.cend(), element);
         /* Make sure that this is a variable and not a function name (in which case the next element will be an opening parentheses)*/
-        if (name_it != this->_varNames.cend() && !(std::next(name_it) != this->_varNames.cend() && *(name_it+1) == "("))
-            cmd_mod += "("+std::to_string(this->_varValues[name_it-this->_varNames.cbegin()])+")";
+        if (name_it != this->_varNames.cend() && !(std::next(name_it) != this->_varNames.cend() && *(name_it+1) == "(")){
+            this->_vars_map.replace(cmd_mod.size(), offsets[index], element.size());
+            double value = this->_varValues[name_it-this->_varNames.cbegin()];
+            /* Integer results are substituted exactly while the variable still holds them */
+            auto exact_it = this->_exact_values.find(element);
+            if (exact_it != this->_exact_values.cend() && exact_it->second.first == value)
+                cmd_mod += "("+exact_it->second.second+")";
+            else
+                cmd_mod += "("+std::to_string(value)+")";
+        }
         else
             cmd_mod += element;
     }
@@ -68,239 +606,925 @@ const std::string Engine::replaceVars(const std::string cmd){
     return cmd_mod;
 }
 
-const std::string Engine::evalFunctions(const std::string cmd){
-    std::smatch match;
-    std::regex filter(R"(([a-zA-Z0-9_]+)(\(.*\)+))");
+/* Returns true if the character can be part of a function name */
+static bool is_name_char(char ch){
+    return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_';
+}
+
+/* Returns true if the text contains a function call (a name that is not a number followed by an opening parentheses) */
+static bool contains_call(const std::string& text){
+    bool flag_name = false;
+    for (char ch : text){
+        if (ch == '(' && flag_name)
+            return true;
+        if (!is_name_char(ch))
+            flag_name = false;
+        else if (!std::isdigit(static_cast<unsigned char>(ch)))
+            flag_name = true;
+    }
+    return false;
+}
+
+/* Returns the text with every occurrence of the second argument replaced by the third */
+static std::string replace_text(const std::string& text, const std::string& from, const std::string& to){
+    if (from.empty())
+        return text;
+    std::string replaced;
+    std::size_t last = 0;
+    for (std::size_t next = text.find(from); next != std::string::npos; next = text.find(from, last)){
+        replaced.append(text, last, next-last);
+        replaced += to;
+        last = next+from.size();
+    }
+    replaced.append(text, last, std::string::npos);
+    return replaced;
+}
+
+/* Returns the position of the bracket closing the one at the given position (any kind of
+* bracket opens and closes a level), npos if it is not closed
+*/
+static std::size_t find_closing(const std::string& text, std::size_t open_pos){
+    unsigned int level = 0;
+    for (std::size_t pos = open_pos; pos < text.size(); ++pos){
+        const char ch = text[pos];
+        if (ch == '(' || ch == '[' || ch == '{')
+            ++level;
+        else if ((ch == ')' || ch == ']' || ch == '}') && --level == 0)
+            return pos;
+    }
+    return std::string::npos;
+}
 
+/* Counts the calls being expanded while in scope (see MAX_CALL_DEPTH) */
+class CallDepth{
+private:
+    unsigned int& _depth;
+public:
+    CallDepth(unsigned int& depth) : _depth(depth){ ++this->_depth; }
+    ~CallDepth(void){ --this->_depth; }
+};
+
+std::size_t Engine::expandCalls(const std::string& text, std::size_t pos, std::string& expanded){
+    /* Parentheses opened at this level that are not calls */
+    unsigned int open_count = 0;
+    /* Start of the name characters right before the current position (npos if there are none) */
+    std::size_t name_start = std::string::npos;
+    bool flag_name = false;
+    for (; pos < text.size(); ++pos){
+        const char ch = text[pos];
+        if (ch == '(' && flag_name){
+            /* The name is replaced by the result of the call */
+            const std::string name = text.substr(name_start, pos-name_start);
+            expanded.resize(expanded.size()-name.size());
+            /* Diagnostics raised by a call of the command are located at the call */
+            const std::size_t outer_offset = this->_call_offset;
+            const std::size_t outer_length = this->_call_length;
+            const std::size_t result_pos = expanded.size();
+            if (&text == this->_source_text){
+                this->_call_offset = name_start;
+                this->_call_length = std::min(find_closing(text, pos), text.size()-1)+1-name_start;
+            }
+            pos = this->evalCall(name, text, pos+1, expanded);
+            this->_call_offset = outer_offset;
+            this->_call_length = outer_length;
+            if (!this->_errors.empty())
+                return text.size();
+            /* The results of the calls at the top level of the command are mapped back to the calls */
+            if (&text == this->_source_text && this->_call_depth == 0){
+                this->_calls_map.replace(result_pos, name_start, pos+1-name_start);
+                this->_calls_map.copy(expanded.size(), pos+1);
+            }
+        } else if (ch == ')' && open_count == 0)
+            /* End of the arguments of the call being expanded */
+            return pos;
+        else{
+            if (ch == '(')
+                ++open_count;
+            else if (ch == ')')
+                --open_count;
+            expanded += ch;
+        }
+        /* Track the name characters before the next character */
+        if (!is_name_char(ch)){
+            name_start = std::string::npos;
+            flag_name = false;
+        } else{
+            if (name_start == std::string::npos)
+                name_start = pos;
+            if (!std::isdigit(static_cast<unsigned char>(ch)))
+                flag_name = true;
+        }
+    }
+    return pos;
+}
+
+/* Appends the result of a call to the expanded text */
+static void append_result(std::string& expanded, const std::string& result){
+    expanded += '(';
+    expanded += result;
+    expanded += ')';
+}
+
+std::size_t Engine::evalCall(const std::string& fname, const std::string& text, std::size_t start, std::string& expanded){
+    if (this->_call_depth >= MAX_CALL_DEPTH){
+        this->addError(DIAG_CALLS_TOO_DEEP, {std::to_string(MAX_CALL_DEPTH)});
+        return text.size();
+    }
+    CallDepth call_depth(this->_call_depth);
+
+    /* The reductions and the conditional evaluate their arguments themselves, they are not expanded */
+    auto reduction_it = std::find_if(this->_supported_functions.cbegin(), this->_supported_functions.cend(), [&fname](const MetaFunction& item){return item.name == fname;});
+    if (reduction_it != this->_supported_functions.cend()
+        && ((*reduction_it).expr.compare(0, 7, "__sum__") == 0 || (*reduction_it).expr.compare(0, 13, "__integrate__") == 0
+            || (*reduction_it).expr.compare(0, 7, "__if__(") == 0)){
+        /* Find the end of the arguments */
+        std::size_t end = start;
+        for (unsigned int open_count = 0; end < text.size() && (text[end] != ')' || open_count != 0); ++end)
+            if (text[end] == '(')
+                ++open_count;
+            else if (text[end] == ')')
+                --open_count;
+        TraceSpan reduction_span(this->_profiler, fname, "function");
+        std::string result;
+        if ((*reduction_it).expr.compare(0, 7, "__if__(") == 0)
+            this->evalConditionalCall(fname, text.substr(start, end-start), result);
+        else
+            this->evalReductionCall((*reduction_it).expr.substr(0, (*reduction_it).expr.find("(")), text.substr(start, end-start), result);
+        append_result(expanded, result);
+        return end;
+    }
+
+    /* Expand the calls inside the arguments first, at the end of the output buffer
+    * (the nested calls share the buffer, the arguments are removed from it once split)
+    */
+    const std::size_t args_start = expanded.size();
+    const std::size_t end = this->expandCalls(text, start, expanded);
+    if (!this->_errors.empty())
+        return end;
+
+    /* Split the arguments at the commas outside of parentheses */
+    std::vector<std::string> args;
+    unsigned int open_count = 0;
+    std::size_t split_last = args_start;
+    for (std::size_t split_next = args_start; split_next < expanded.size(); ++split_next){
+        const char ch = expanded[split_next];
+        if (ch == '(' || ch == '[' || ch == '{')
+            ++open_count;
+        else if (ch == ')' || ch == ']' || ch == '}')
+            --open_count;
+        else if (ch == ',' && open_count == 0){
+            args.push_back(expanded.substr(split_last, split_next-split_last));
+            split_last = split_next+1;
+        }
+    }
+    args.push_back(expanded.substr(split_last));
+    expanded.resize(args_start);
+
+    /* Find the function in the supported list */
+    auto fun_it = std::find_if(this->_supported_functions.cbegin(), this->_supported_functions.cend(), [&fname](const MetaFunction& item){return item.name == fname;});
+    if (fun_it == this->_supported_functions.cend()){
+        /* If function is not found set the error string and return */
+        this->addError(DIAG_UNDEFINED_FUNCTION, {fname});
+        return end;
+    }
+    /* Trace the expansion of this call (including nested calls) as a span named after the function */
+    TraceSpan expansion_span(this->_profiler, fname, "function");
+    /* Check the argument list */
+    if (args.size() > (*fun_it).arg_names.size()){
+        /* If function call has more arguments than its definition set the error string and return */
+        this->addError(DIAG_TOO_MANY_ARGUMENTS, {fname, std::to_string(args.size()), std::to_string((*fun_it).arg_names.size())});
+        return end;
+    }
+    /* Count the number of optional arguments in the function definition */
+    size_t optional_count = 0;
+    for (const std::string& item : (*fun_it).arg_names)
+        if (item.find("=") != std::string::npos)
+            ++optional_count;
+    /* Check if the number of arguments passed is enough to cover all standard arguments */
+    if (args.size() < (*fun_it).arg_names.size()-optional_count){
+        /* If function call does not have enough arguments to account for the number of standard arguments set the error string and return */
+        this->addError(DIAG_TOO_FEW_ARGUMENTS, {fname, std::to_string(args.size()), std::to_string((*fun_it).arg_names.size()), std::to_string(optional_count), optional_count == 1 ? "is" : "are"});
+        return end;
+    }
+
+    /* Run the solvers inside the engine instead of expanding the call */
+    std::string result;
+    if ((*fun_it).expr.compare(0, 9, "__solve__") == 0 || (*fun_it).expr.compare(0, 12, "__minimize__") == 0){
+        if (args.size() != 2)
+            this->addError(DIAG_SOLVER_USAGE, {fname});
+        else{
+            this->evalSolverCall((*fun_it).expr.substr(0, (*fun_it).expr.find("(")), args, result);
+            append_result(expanded, result);
+        }
+        return end;
+    }
+
+    /* Evaluate the call directly if the function body is compiled (run as native code once hot) */
+    if (this->evalCompiledCall(*fun_it, args, result)){
+        append_result(expanded, result);
+        return end;
+    }
+
+    /* Reconstruct function expression by replacing arguments */
+    result = (*fun_it).expr;
+    for (auto arg_it = (*fun_it).arg_names.cbegin(); arg_it != (*fun_it).arg_names.cend(); ++arg_it){
+        size_t arg_index = arg_it-(*fun_it).arg_names.cbegin();
+        /* If this argument has a default value separate the name and value */
+        const std::size_t default_pos = (*arg_it).find("=");
+        if (arg_index < args.size())
+            /* If a respective argument has been passed use it */
+            result = replace_text(result, (*arg_it).substr(0, default_pos), "("+args[arg_index]+")");
+        else
+            /* If a respective argument has not been passed use the default */
+            result = replace_text(result, (*arg_it).substr(0, default_pos), "("+(default_pos == std::string::npos ? std::string() : (*arg_it).substr(default_pos+1))+")");
+        /* Bodies using an argument more than once grow with every nested call */
+        if (expanded.size()+result.size() > this->_expansion_limit){
+            this->addError(DIAG_EXPANSION_TOO_LARGE, {std::to_string(this->_expansion_limit)});
+            return end;
+        }
+    }
+
+    /* Evaluate function calls in the function expression (if any) */
+    if (contains_call(result)){
+        /* Check for internal reserved functions (the whole body is a call of `__name__`) */
+        const std::size_t open_pos = result.find('(');
+        if (result.compare(0, 2, "__") == 0 && open_pos > 4 && result.compare(open_pos-2, 2, "__") == 0 && result.back() == ')'
+            && std::all_of(result.cbegin(), result.cbegin()+open_pos, is_name_char)){
+            /* If this is a reserved internal function directly evaluate the function */
+            /* Convert all the arguments into numbers */
+            std::vector<double> converted_args;
+            for (const std::string& arg : args){
+                /* Parse argument and concert for computation */
+                this->_runner.parseExpr(arg);
+                this->_runner.convertToPostfix();
+                /* Add evaluated argument to converted list */
+                converted_args.push_back(this->_runner.evaluatePostfix());
+                /* Clean up the runner */
+                this->_runner.clear();
+            }
+            /* Run the reserved internal function on the virtual machine */
+            Program call;
+            const std::string reserved_name = result.substr(0, open_pos);
+            if (!call.compileCall(getOpCode(reserved_name), converted_args)){
+                /* An unsupported internal function was detected, set the error string and return */
+                this->addError(DIAG_UNKNOWN_RESERVED, {reserved_name});
+                return end;
+            }
+            result = "("+std::to_string(call.run())+")";
+        }
+        else if (std::string logical; this->evalLogical(result, logical)){
+            /* The calls of the right operands of && and || are only expanded if they decide the result */
+            if (this->_errors.empty())
+                append_result(expanded, logical);
+            return end;
+        } else{
+            /* If this is a standard function expand the calls of its body right into the output */
+            expanded += '(';
+            for (std::size_t pos = this->expandCalls(result, 0, expanded); pos < result.size() && this->_errors.empty(); pos = this->expandCalls(result, pos+1, expanded))
+                expanded += ')';
+            expanded += ')';
+            if (expanded.size() > this->_expansion_limit && this->_errors.empty())
+                this->addError(DIAG_EXPANSION_TOO_LARGE, {std::to_string(this->_expansion_limit)});
+            return end;
+        }
+    }
+    append_result(expanded, result);
+    return end;
+}
+
+const std::string Engine::evalFunctions(const std::string& cmd){
     /* Check if an error occurred before (during one of the recursive calls) */
-    if (!this->_error_message.empty())
+    if (!this->_errors.empty())
         return std::string();
 
     /* Check if a function call exists in the cmd */
-    if (!std::regex_search(cmd.cbegin(), cmd.cend(), match, filter))
+    if (!contains_call(cmd))
         /* No function found return incoming command */
         return cmd;
 
-    unsigned int open_count = 0;
-    unsigned int close_count = 0;
-    std::string buffer;
-    bool flag_ch_added = false;
+    /* The expansion of the whole command is limited, relative to its size */
+    if (this->_call_depth == 0)
+        this->_expansion_limit = std::max(MAX_EXPANSION_SIZE, MAX_EXPANSION_RATIO*cmd.size());
+
+    /* Every call is replaced by its result in one pass into a single buffer, the arguments
+    * of a call are expanded (recursively) before the call
+    */
     std::string flattened_cmd;
-    for (char ch : cmd){
-        /* Reset flag */
-        flag_ch_added = false;
-        /* Count parentheses */
-        if (ch == '('){
-            ++open_count;
-            buffer += ch;
-            flag_ch_added = true;
-        } else if (ch == ')'){
-            ++close_count;
-            buffer += ch;
-            flag_ch_added = true;
-        }
-        /* Accumulate the function calls */
-        if (open_count != 0){
-            /* If the open and close counts match a function call has been detected */
-            if (open_count == close_count){
-                /* Evaluate the function call */
-                std::string result;
-                /* Check if this is a function call */
-                if (!std::regex_match(buffer, match, filter)){
-                    /* Clear buffers and continue */
-                    open_count=0;
-                    close_count=0;
-                    continue;
-                }
-                assert(match.size() == 3);
-                std::string match_fname = match[1].str();
-                std::string match_args = match[2].str();
-                /* Check if there are any other function calls inside */
-                if (open_count > 1 && std::regex_search(match_args, filter)){
-                    /* If more function calls are found, remove the outer call and recurse */
-                    /* Recurse after removing the enclosing parentheses */
-                    result = this->evalFunctions(match_args.substr(1, match_args.size() - 2));
-                    /* Check if any errors occurred during the recursion */
-                    if (!this->_error_message.empty())
-                        return std::string();
-                    /* Update buffer with the expanded inner functions */
-                    buffer = std::regex_replace(buffer, std::regex(getRegExEscaped(match_args)), "("+result+")");
-                    /* Update the argument match string */
-                    std::regex_match(buffer, match, filter);
-                    match_fname = match[1].str();
-                    match_args = match[2].str().substr(1, match[2].str().size() - 2);
-                }
-                /* Expand arguments */
-                size_t split_next = 0;
-                size_t split_last = 0;
-                std::vector<std::string> args;
-                while ((split_next = match_args.find(",", split_last)) != std::string::npos) {
-                    args.push_back(match_args.substr(split_last, split_next-split_last));
-                    split_last = split_next+1;
-                }
-                if (args.empty())
-                    args.push_back(match_args);
-                else
-                    args.push_back(match_args.substr(split_last));
-                /* Remove extra brackets from the first and last arguments */
-                if (args[0][0] == '(' && std::count(args[0].cbegin(), args[0].cend(), '(') != std::count(args[0].cbegin(), args[0].cend(), ')'))
-                    args[0].erase(0, 1);
-                if (args[args.size()-1].back() == ')' && std::count(args[args.size()-1].cbegin(), args[args.size()-1].cend(), '(') != std::count(args[args.size()-1].cbegin(), args[args.size()-1].cend(), ')'))
-                    args[args.size()-1].erase(args[args.size()-1].size()-1, 1);
-
-                /* Find the function in the supported list */
-                auto fun_it = std::find_if(this->_supported_functions.cbegin(), this->_supported_functions.cend(), [match_fname](MetaFunction item){return item.name == match_fname;});
-                if (fun_it == this->_supported_functions.cend()){
-                    /* If function is not found set the error string and return */
-                    this->_error_message += "[Engine] ERROR: Undefined function `"+match_fname+"` called!\n";
-                    return std::string();
-                }
-                /* Check the argument list */
-                if (args.size() > (*fun_it).arg_names.size()){
-                    /* If function call has more arguments than its definition set the error string and return */
-                    this->_error_message += "[Engine] ERROR: Too many arguments passed to function `"+match_fname+"`! `"+match_fname+"` got "+std::to_string(args.size())+" argument(s) but it's definition only takes "+std::to_string((*fun_it).arg_names.size())+" argument(s)\n";
-                    return std::string();
-                }
-                /* Count the number of optional arguments in the function definition */
-                size_t optional_count = 0;
-                for (std::string item : (*fun_it).arg_names)
-                    if (item.find("=") != std::string::npos)
-                        ++optional_count;
-                /* Check if the number of arguments passed is enough to cover all standard arguments */
-                if (args.size() < (*fun_it).arg_names.size()-optional_count){
-                    /* If function call does not have enough arguments to account for the number of standard arguments set the error string and return */
-                    if (optional_count == 1)
-                        this->_error_message += "[Engine] ERROR: Insufficent number of arguments passed to function `"+match_fname+"`! `"+match_fname+"` got "+std::to_string(args.size())+" argument(s) but it's definition requires "+std::to_string((*fun_it).arg_names.size())+" argument(s) out of which "+std::to_string(optional_count)+" is optional\n";
-                    else
-                        this->_error_message += "[Engine] ERROR: Insufficent number of arguments passed to function `"+match_fname+"`! `"+match_fname+"` got "+std::to_string(args.size())+" argument(s) but it's definition requires "+std::to_string((*fun_it).arg_names.size())+" argument(s) out of which "+std::to_string(optional_count)+" are optional\n";
-                    return std::string();
-                }
+    flattened_cmd.reserve(cmd.size());
+    for (std::size_t pos = this->expandCalls(cmd, 0, flattened_cmd); pos < cmd.size(); pos = this->expandCalls(cmd, pos+1, flattened_cmd))
+        /* A closing parentheses without an opening one is kept as it is */
+        flattened_cmd += ')';
+    if (!this->_errors.empty())
+        return std::string();
+    return flattened_cmd;
+}
 
-                /* Reconstruct function expression by replacing arguments */
-                result = (*fun_it).expr;
-                std::string arg_name = "";
-                std::string arg_default = "";
-                for (auto arg_it = (*fun_it).arg_names.cbegin(); arg_it != (*fun_it).arg_names.cend(); ++arg_it){
-                    size_t arg_index = arg_it-(*fun_it).arg_names.cbegin();
-                    /* If this argument has a default value separate the name and value */
-                    if (std::regex_match(*arg_it, match, std::regex(R"(([a-zA-z0-9_)]+)=(.*))"))){
-                        assert(match.size() == 3);
-                        arg_name = match[1].str();
-                        arg_default = match[2].str();
-                    } else{
-                        arg_name = *arg_it;
-                        arg_default.clear();
-                    }
-                    if (arg_index < args.size())
-                        /* If a respective argument has been passed use it */
-                        result = std::regex_replace(result, std::regex(getRegExEscaped(arg_name)), "("+args[arg_index]+")");
-                    else
-                        /* If a respective argument has not been passed use the default */
-                        result = std::regex_replace(result, std::regex(getRegExEscaped(arg_name)), "("+arg_default+")");
-                }
+/* Returns true for the characters removed from the expressions (spaces, tabs and line breaks) */
+static bool is_space(char ch){
+    return std::isspace(static_cast<unsigned char>(ch));
+}
 
-                /* Evaluate function calls in the function expression (if any) */
-                if (std::regex_search(result, match, filter)){
-                    /* Check for internal reserved functions */
-                    if (std::regex_match(result, std::regex(R"((__[a-zA-Z0-9_]+__)(\(.*\)+))"))){
-                        /* If this is a reserved internal function directly evaluate the function */
-                        /* Convert all the arguments into numbers */
-                        std::vector<double> converted_args;
-                        for (std::string arg : args){
-                            /* Parse argument and concert for computation */
-                            this->_runner.parseExpr(arg);
-                            this->_runner.convertToPostfix();
-                            /* Add evaluated argument to converted list */
-                            converted_args.push_back(this->_runner.evaluatePostfix());
-                            /* Clean up the runner */
-                            this->_runner.clear();
+/* Returns the position of the colon if the line is a function definition (`name(args) : body`),
+* npos if it is not. The name is the first word of the line, the head of the definition ends at
+* the first closing parentheses followed by the colon.
+*/
+static std::size_t find_definition_colon(const std::string& line){
+    if (line.empty() || is_space(line[0]))
+        return std::string::npos;
+    const std::size_t name_end = std::find_if(line.cbegin(), line.cend(), is_space)-line.cbegin();
+    const std::size_t open_pos = line.find('(', 1);
+    if (open_pos == std::string::npos || (open_pos > name_end && std::find_if_not(line.cbegin()+name_end, line.cbegin()+open_pos, is_space) != line.cbegin()+open_pos))
+        return std::string::npos;
+    for (std::size_t close_pos = line.find(')', open_pos+1); close_pos != std::string::npos; close_pos = line.find(')', close_pos+1)){
+        const std::size_t colon_pos = std::find_if_not(line.cbegin()+close_pos+1, line.cend(), is_space)-line.cbegin();
+        if (colon_pos < line.size() && line[colon_pos] == ':')
+            return colon_pos;
+    }
+    return std::string::npos;
+}
+
+/* Returns true if every bracket of the text is closed by a bracket of its kind after it */
+static bool brackets_balanced(const std::string& text){
+    std::string open_brackets;
+    for (const char ch : text){
+        if (ch == '(' || ch == '[' || ch == '{')
+            open_brackets.push_back(ch);
+        else if (ch == ')' || ch == ']' || ch == '}'){
+            const char open_ch = ch == ')' ? '(' : ch == ']' ? '[' : '{';
+            if (open_brackets.empty() || open_brackets.back() != open_ch)
+                return false;
+            open_brackets.pop_back();
+        }
+    }
+    return open_brackets.empty();
+}
+
+/* Returns true if the quotes of the text are balanced */
+static bool quotes_balanced(const std::string& text){
+    return std::count(text.cbegin(), text.cend(), '\'')%2 == 0 && std::count(text.cbegin(), text.cend(), '"')%2 == 0;
+}
+
+/* Returns the text between the given positions split at the commas outside of nested brackets */
+static std::vector<std::string> split_arguments(const std::string& text, std::size_t begin, std::size_t end){
+    std::vector<std::string> args(1);
+    int level = 0;
+    for (std::size_t pos = begin; pos < end; ++pos){
+        const char ch = text[pos];
+        level += (ch == '(' || ch == '[' || ch == '{') ? 1 : ((ch == ')' || ch == ']' || ch == '}') ? -1 : 0);
+        if (ch == ',' && level == 0)
+            args.emplace_back();
+        else
+            args.back() += ch;
+    }
+    return args;
+}
+
+bool Engine::evalConditionalCall(const std::string& fname, const std::string& args_text, std::string& result){
+    const std::vector<std::string> args = split_arguments(args_text, 0, args_text.size());
+    if (args.size() > 3){
+        this->addError(DIAG_TOO_MANY_ARGUMENTS, {fname, std::to_string(args.size()), "3"});
+        return false;
+    }
+    if (args.size() < 3){
+        this->addError(DIAG_TOO_FEW_ARGUMENTS, {fname, std::to_string(args.size()), "3", "0", "are"});
+        return false;
+    }
+    /* NaN is true */
+    double value;
+    if (!this->evalCondition(args[0], value))
+        return false;
+    result = this->evalFunctions(args[value != 0 ? 1 : 2]);
+    return this->_errors.empty();
+}
+
+bool Engine::evalCondition(const std::string& text, double& value){
+    const std::string condition = this->evalFunctions(text);
+    if (!this->_errors.empty())
+        return false;
+    this->_runner.parseExpr(condition);
+    this->_runner.convertToPostfix();
+    std::string exact_value;
+    this->evaluateRunner(value, exact_value);
+    /* The runner is used again by the command, its diagnostics are kept by the engine */
+    this->takeRunnerDiagnostics(std::string::npos);
+    return this->_errors.empty();
+}
+
+/* Returns the operands of the text split at the given operator outside of brackets */
+static std::vector<std::string> split_operator(const std::string& text, const std::string& op){
+    std::vector<std::string> operands(1);
+    int level = 0;
+    for (std::size_t pos = 0; pos < text.size(); ++pos){
+        const char ch = text[pos];
+        if (ch == '(' || ch == '[' || ch == '{')
+            ++level;
+        else if (ch == ')' || ch == ']' || ch == '}')
+            --level;
+        else if (level == 0 && text.compare(pos, op.size(), op) == 0){
+            operands.emplace_back();
+            pos += op.size()-1;
+            continue;
+        }
+        operands.back() += ch;
+    }
+    return operands;
+}
+
+bool Engine::evalLogical(const std::string& text, std::string& result){
+    /* The operands of ^^ are always evaluated, its operands are not split */
+    if (split_operator(text, "^^").size() > 1)
+        return false;
+    /* || has the lowest precedence, the terms are split at && */
+    std::vector<std::vector<std::string>> terms;
+    bool flag_lazy_call = false;
+    for (const std::string& term : split_operator(text, "||")){
+        terms.push_back(split_operator(term, "&&"));
+        for (std::size_t index = terms.size() == 1 ? 1 : 0; index < terms.back().size(); ++index)
+            flag_lazy_call = flag_lazy_call || contains_call(terms.back()[index]);
+    }
+    if (!flag_lazy_call)
+        return false;
+
+    /* The operands are evaluated in order until the result is decided (NaN is true) */
+    bool flag_value = false;
+    for (const std::vector<std::string>& factors : terms){
+        bool flag_term = true;
+        for (const std::string& factor : factors){
+            double value;
+            if (!this->evalCondition(factor, value))
+                return true;
+            if (value == 0){
+                flag_term = false;
+                break;
+            }
+        }
+        if (flag_term){
+            flag_value = true;
+            break;
+        }
+    }
+    result = flag_value ? "1" : "0";
+    return true;
+}
+
+/* Returns the end of the name or number starting at the given position */
+static std::size_t find_word_end(const std::string& text, std::size_t pos){
+    while (pos < text.size() && (is_name_char(text[pos]) || text[pos] == '.'))
+        ++pos;
+    return pos;
+}
+
+/* Returns the postfix of the given value (non finite values are divisions by 0) */
+static std::vector<std::string> value_postfix(double value){
+    if (std::isnan(value))
+        return {"0", "0", "/"};
+    if (std::isinf(value))
+        return {value > 0 ? "1" : "-1", "0", "/"};
+    char str_value[32];
+    std::snprintf(str_value, sizeof(str_value), "%.17G", value);
+    return {str_value};
+}
+
+/* Returns the reduction of the values with the given name (the number of operands is checked by the caller) */
+static double reduce_vectors(const std::string& name, const std::vector<Matrix>& operands){
+    if (name == "dot")
+        return vectorDot(operands[0].data(), operands[1].data(), operands[0].size());
+    if (name == "min")
+        return vectorMin(operands[0].data(), operands[0].size());
+    if (name == "max")
+        return vectorMax(operands[0].data(), operands[0].size());
+    return vectorSum(operands[0].data(), operands[0].size());
+}
+
+/* Returns true if the text is a single bracketed group (`[...]`) */
+static bool is_bracketed(const std::string& text){
+    return !text.empty() && text[0] == '[' && find_closing(text, 0) == text.size()-1;
+}
+
+/* Returns the shape of the value of the given kind */
+static ValueShape shape_of(const Matrix& value, ValueKind kind){
+    return {kind, value.rows(), value.cols()};
+}
+
+/* Returns the shape as text (`3` for a vector of 3 elements, `2x3` for a matrix) */
+static std::string shape_string(const ValueShape& shape){
+    if (shape.kind == VALUE_SCALAR)
+        return "a scalar";
+    if (shape.kind == VALUE_VECTOR)
+        return std::to_string(shape.cols);
+    return std::to_string(shape.rows)+"x"+std::to_string(shape.cols);
+}
+
+bool Engine::usesVectors(const std::string& cmd) const{
+    /* Most commands hold neither brackets nor vector or matrix variables */
+    const bool flag_brackets = cmd.find('[') != std::string::npos;
+    if (!flag_brackets && this->_vecValues.empty() && this->_matValues.empty())
+        return false;
+    for (std::size_t pos = 0; pos < cmd.size();){
+        if (cmd[pos] == '['){
+            /* A bracket holding a comma is a vector literal, otherwise it groups an expression
+            * (the rows of a matrix literal are vector literals)
+            */
+            const std::size_t close_pos = find_closing(cmd, pos);
+            if (close_pos != std::string::npos && split_arguments(cmd, pos+1, close_pos).size() > 1)
+                return true;
+            ++pos;
+        } else if (is_name_char(cmd[pos])){
+            const std::size_t end = find_word_end(cmd, pos);
+            if (!std::isdigit(static_cast<unsigned char>(cmd[pos])) && (end >= cmd.size() || cmd[end] != '(')){
+                const std::string name = cmd.substr(pos, end-pos);
+                if (this->_vecValues.find(name) != this->_vecValues.cend() || this->_matValues.find(name) != this->_matValues.cend())
+                    return true;
+            }
+            pos = end;
+        } else
+            ++pos;
+    }
+    return false;
+}
+
+bool Engine::evalVectorElement(const std::string& element, double& value){
+    /* Plain numbers are read directly (large literals are mostly numbers) */
+    const char first = element.empty() ? '\0' : element[0];
+    if (std::isdigit(static_cast<unsigned char>(first)) || first == '.' || first == '-'){
+        char* end = nullptr;
+        value = std::strtod(element.c_str(), &end);
+        if (end == element.c_str()+element.size() && std::isfinite(value))
+            return true;
+    }
+    const std::string text = this->evalFunctions(this->replaceVars(element));
+    if (!this->_errors.empty())
+        return false;
+    Evaluator element_runner;
+    element_runner.parseExpr(text);
+    element_runner.convertToPostfix();
+    value = element_runner.evaluatePostfix();
+    this->_errors.append(element_runner.getErrors());
+    return this->_errors.empty();
+}
+
+bool Engine::sameShape(const std::string& expr, const ValueShape& first, const ValueShape& second){
+    if (first.kind == second.kind && first.rows == second.rows && first.cols == second.cols)
+        return true;
+    if (first.kind == VALUE_VECTOR && second.kind == VALUE_VECTOR)
+        this->addError(DIAG_VECTOR_LENGTH, {expr, std::to_string(first.cols), std::to_string(second.cols)});
+    else
+        this->addError(DIAG_MATRIX_SHAPE, {expr, shape_string(first), shape_string(second)});
+    return false;
+}
+
+bool Engine::evalMatrixCall(const std::string& name, const std::vector<std::string>& args, const std::string& call, Matrix& result, ValueKind& kind){
+    const std::size_t arity = (name == "matmul" || name == "linsolve") ? 2 : 1;
+    if (args.size() != arity){
+        this->addError(DIAG_OPERATION_ARITY, {name, std::to_string(arity)});
+        return false;
+    }
+    Matrix operands[2];
+    ValueKind kinds[2] = {VALUE_SCALAR, VALUE_SCALAR};
+    for (std::size_t index = 0; index < arity; ++index)
+        if (!this->evalVectorExpr(args[index], operands[index], kinds[index]))
+            return false;
+
+    if (name == "transpose"){
+        /* A vector is its own transpose */
+        kind = kinds[0];
+        result = kind == VALUE_MATRIX ? matrixTranspose(operands[0]) : std::move(operands[0]);
+        return true;
+    }
+    if (name == "matmul"){
+        /* A vector is a row on the left and a column on the right, the result of a product
+        * with a vector is a vector (a number if both are vectors)
+        */
+        const std::size_t right_rows = kinds[1] == VALUE_VECTOR ? operands[1].cols() : operands[1].rows();
+        if (kinds[0] == VALUE_SCALAR || kinds[1] == VALUE_SCALAR || operands[0].cols() != right_rows){
+            this->addError(DIAG_MATRIX_SHAPE, {call, shape_string(shape_of(operands[0], kinds[0])), shape_string(shape_of(operands[1], kinds[1]))});
+            return false;
+        }
+        operands[1].reshape(right_rows, operands[1].size()/right_rows);
+        result = matrixMultiply(operands[0], operands[1]);
+        if (kinds[0] == VALUE_MATRIX && kinds[1] == VALUE_MATRIX)
+            kind = VALUE_MATRIX;
+        else{
+            kind = kinds[0] == VALUE_VECTOR && kinds[1] == VALUE_VECTOR ? VALUE_SCALAR : VALUE_VECTOR;
+            result.reshape(1, result.size());
+        }
+        return true;
+    }
+
+    /* det, inv and linsolve factor a square matrix */
+    if (kinds[0] != VALUE_MATRIX || !operands[0].square()){
+        this->addError(DIAG_MATRIX_NOT_SQUARE, {call, shape_string(shape_of(operands[0], kinds[0]))});
+        return false;
+    }
+    LUDecomposition decomposition;
+    const bool flag_regular = decomposition.factor(operands[0]);
+    if (name == "det"){
+        kind = VALUE_SCALAR;
+        result = Matrix(1, 1, decomposition.determinant());
+        return true;
+    }
+    if (!flag_regular){
+        this->addError(DIAG_MATRIX_SINGULAR, {call});
+        return false;
+    }
+    if (name == "inv"){
+        kind = VALUE_MATRIX;
+        result = decomposition.inverse();
+        return true;
+    }
+    /* linsolve(A, b) takes a vector or a matrix with as many rows as A */
+    if (kinds[1] == VALUE_SCALAR || (kinds[1] == VALUE_VECTOR ? operands[1].cols() : operands[1].rows()) != operands[0].rows()){
+        this->addError(DIAG_MATRIX_SHAPE, {call, shape_string(shape_of(operands[0], kinds[0])), shape_string(shape_of(operands[1], kinds[1]))});
+        return false;
+    }
+    kind = kinds[1];
+    if (kind == VALUE_VECTOR)
+        operands[1].reshape(operands[1].size(), 1);
+    result = decomposition.solve(operands[1]);
+    if (kind == VALUE_VECTOR)
+        result.reshape(1, result.size());
+    return true;
+}
+
+bool Engine::evalVectorExpr(const std::string& expr, Matrix& values, ValueKind& kind){
+    /* Literals, reductions and matrix functions are replaced by placeholder names bound to their
+    * values, placeholder names hold no digits so they are parsed as a single name (see inlineExpression).
+    */
+    struct Operand{
+        std::string name;
+        Matrix value;
+        ValueKind kind;
+    };
+    std::string flattened;
+    std::map<std::string, std::vector<std::string>> bindings;
+    std::vector<Operand> operands;
+    std::size_t placeholder_count = 0;
+    for (std::size_t pos = 0; pos < expr.size();){
+        const char ch = expr[pos];
+        const std::size_t close_pos = ch == '[' ? find_closing(expr, pos) : std::string::npos;
+        if (close_pos != std::string::npos){
+            const std::vector<std::string> elements = split_arguments(expr, pos+1, close_pos);
+            /* A bracket of bracketed rows is a matrix literal ([[1, 2], [3, 4]] or [[1, 2]]) */
+            const bool flag_matrix = std::all_of(elements.cbegin(), elements.cend(), is_bracketed)
+                && (elements.size() > 1 || split_arguments(elements[0], 1, elements[0].size()-1).size() > 1);
+            if (flag_matrix || elements.size() > 1){
+                Operand literal{"__vec"+std::string(++placeholder_count, 'x')+"__", Matrix(1, elements.size()), VALUE_VECTOR};
+                if (flag_matrix){
+                    std::vector<double>& literal_values = literal.value.values();
+                    literal_values.clear();
+                    std::size_t cols = 0;
+                    for (std::size_t row = 0; row < elements.size(); ++row){
+                        const std::vector<std::string> row_elements = split_arguments(elements[row], 1, elements[row].size()-1);
+                        if (row > 0 && row_elements.size() != cols){
+                            this->addError(DIAG_VECTOR_LENGTH, {expr.substr(pos, close_pos+1-pos), std::to_string(cols), std::to_string(row_elements.size())});
+                            return false;
                         }
-                        /* Check which reserved internal function is being called */
-                        if (match[1].str() == "__log__")
-                            result = "("+std::to_string(std::log(converted_args[0]))+")";
-                        else if (match[1].str() == "__log10__")
-                            result = "("+std::to_string(std::log10(converted_args[0]))+")";
-                        else if (match[1].str() == "_ceil__")
-                            result = "("+std::to_string(std::ceil(converted_args[0]))+")";
-                        else if (match[1].str() == "__floor__")
-                            result = "("+std::to_string(std::floor(converted_args[0]))+")";
-                        else if (match[1].str() == "__abs__")
-                            result = "("+std::to_string(std::abs(converted_args[0]))+")";
-                        else if (match[1].str() == "__cos__")
-                            result = "("+std::to_string(std::cos(converted_args[0]))+")";
-                        else if (match[1].str() == "__sin__")
-                            result = "("+std::to_string(std::sin(converted_args[0]))+")";
-                        else if (match[1].str() == "__tan__")
-                            result = "("+std::to_string(std::tan(converted_args[0]))+")";
-                        else if (match[1].str() == "__cosh__")
-                            result = "("+std::to_string(std::cosh(converted_args[0]))+")";
-                        else if (match[1].str() == "__sinh__")
-                            result = "("+std::to_string(std::sinh(converted_args[0]))+")";
-                        else if (match[1].str() == "__tanh__")
-                            result = "("+std::to_string(std::tanh(converted_args[0]))+")";
-                        else if (match[1].str() == "__pow__")
-                            result = "("+std::to_string(std::pow(converted_args[0], converted_args[1]))+")";
-                        else{
-                            /* An unsupported internal function was detected, set the error string and return */
-                            this->_error_message += "[Engine] ERROR: An unknown function call was detected `"+match[1].str()+"`!\n";
-                            return std::string();
+                        cols = row_elements.size();
+                        for (const std::string& element : row_elements){
+                            literal_values.push_back(0);
+                            if (!this->evalVectorElement(element, literal_values.back()))
+                                return false;
                         }
                     }
-                    else{
-                        /* If this is a standard function evaluate it and store it's result */
-                        result = this->evalFunctions(result);
-                        /* Check if any errors occurred during the recursion */
-                        if (!this->_error_message.empty())
-                            return std::string();
-                    }
-                }
+                    literal.value = Matrix(elements.size(), cols, std::move(literal_values));
+                    literal.kind = VALUE_MATRIX;
+                } else
+                    for (std::size_t index = 0; index < elements.size(); ++index)
+                        if (!this->evalVectorElement(elements[index], literal.value.data()[index]))
+                            return false;
+                bindings[literal.name] = {literal.name};
+                flattened += literal.name;
+                operands.push_back(std::move(literal));
+                pos = close_pos+1;
+                continue;
+            }
+        }
+        if (!is_name_char(ch)){
+            flattened += ch;
+            ++pos;
+            continue;
+        }
+        const std::size_t end = find_word_end(expr, pos);
+        const std::string word = expr.substr(pos, end-pos);
+        const std::size_t args_close = end < expr.size() && expr[end] == '(' ? find_closing(expr, end) : std::string::npos;
+        /* The reductions and the matrix functions are evaluated here unless a user function has the name */
+        const bool flag_user_function = findBuiltin(word) == nullptr
+            && std::any_of(this->_supported_functions.cbegin(), this->_supported_functions.cend(), [&word](const MetaFunction& item){return item.name == word;});
+        const bool flag_scalar_call = word == "solve" || word == "minimize" || word == "integrate" || word == "sum";
+        const bool flag_matrix_call = word == "matmul" || word == "transpose" || word == "linsolve" || word == "det" || word == "inv";
+        if (args_close == std::string::npos || flag_user_function || !(flag_scalar_call || flag_matrix_call || word == "min" || word == "max" || word == "dot")){
+            flattened += word;
+            pos = end;
+            continue;
+        }
+        const std::string call = expr.substr(pos, args_close+1-pos);
+        const std::vector<std::string> args = split_arguments(expr, end+1, args_close);
+        Operand result{"__vec"+std::string(++placeholder_count, 'x')+"__", Matrix(1, 1), VALUE_SCALAR};
+        if (flag_matrix_call){
+            if (!this->evalMatrixCall(word, args, call, result.value, result.kind))
+                return false;
+        } else if (flag_scalar_call && (word != "sum" || args.size() != 1)){
+            /* The solvers and the sums of series can not be inlined, they are evaluated as scalars */
+            if (!this->evalVectorElement(call, result.value.data()[0]))
+                return false;
+        } else{
+            const std::size_t arity = word == "dot" ? 2 : 1;
+            if (args.size() != arity){
+                this->addError(DIAG_OPERATION_ARITY, {word, std::to_string(arity)});
+                return false;
+            }
+            std::vector<Matrix> reduced(arity);
+            ValueKind reduced_kinds[2] = {VALUE_SCALAR, VALUE_SCALAR};
+            for (std::size_t index = 0; index < arity; ++index)
+                if (!this->evalVectorExpr(args[index], reduced[index], reduced_kinds[index]))
+                    return false;
+            if (!this->sameShape(call, shape_of(reduced[0], reduced_kinds[0]), shape_of(reduced.back(), reduced_kinds[arity-1])))
+                return false;
+            result.value.data()[0] = reduce_vectors(word, reduced);
+        }
+        flattened += result.name;
+        if (result.kind == VALUE_SCALAR)
+            bindings[result.name] = value_postfix(result.value.data()[0]);
+        else{
+            bindings[result.name] = {result.name};
+            operands.push_back(std::move(result));
+        }
+        pos = args_close+1;
+    }
 
-                /* Replace function with the evaluated call in the flattened command */
-                flattened_cmd += "("+result+")";
+    /* Vector and matrix variables are the inputs of the program, scalar variables are read by value */
+    for (const auto& vector : this->_vecValues)
+        bindings[vector.first] = {vector.first};
+    for (const auto& matrix : this->_matValues)
+        bindings[matrix.first] = {matrix.first};
+    for (std::size_t index = 0; index < this->_varNames.size(); ++index)
+        if (bindings.find(this->_varNames[index]) == bindings.cend())
+            bindings[this->_varNames[index]] = value_postfix(this->_varValues[index]);
+    std::vector<std::string> postfix;
+    if (!this->inlineExpression(flattened, bindings, postfix, 0))
+        return false;
 
-                /* Clear buffers and continue */
-                buffer.clear();
-                open_count=0;
-                close_count=0;
-            } else if (!flag_ch_added)
-                /* Otherwise append the character to the buffer */
-                buffer += ch;
-        }
-        else
-            if (!flag_ch_added && std::regex_match(std::string(1, ch), std::regex(R"([a-zA-z0-9_])")))
-                /* If the first parentheses has not been reached yet but this is a name compatable character append it to the buffer (could be the name of a function) */
-                buffer += ch;
-            else{
-                /* Add the character to the flattened command */
-                flattened_cmd += buffer+ch;
-                /* If this is not a name like character and the first parentheses has not been reached yet reset the buffer so the function name is not combined with unrelated characters */
-                buffer.clear();
-            }
+    /* Only the values the expression uses are inputs, they must have the same shape */
+    std::vector<std::string> inputs;
+    std::vector<const double*> input_values;
+    ValueShape shape{VALUE_SCALAR, 1, 1};
+    for (const std::string& token : postfix){
+        if (std::find(inputs.cbegin(), inputs.cend(), token) != inputs.cend())
+            continue;
+        ValueShape input_shape;
+        const double* input = nullptr;
+        auto vector_it = this->_vecValues.find(token);
+        auto matrix_it = this->_matValues.find(token);
+        auto operand_it = std::find_if(operands.cbegin(), operands.cend(), [&token](const Operand& item){return item.name == token;});
+        if (operand_it != operands.cend()){
+            input_shape = shape_of(operand_it->value, operand_it->kind);
+            input = operand_it->value.data();
+        } else if (vector_it != this->_vecValues.cend()){
+            input_shape = {VALUE_VECTOR, 1, vector_it->second.size()};
+            input = vector_it->second.data();
+        } else if (matrix_it != this->_matValues.cend()){
+            input_shape = shape_of(matrix_it->second, VALUE_MATRIX);
+            input = matrix_it->second.data();
+        } else
+            continue;
+        if (!inputs.empty() && !this->sameShape(expr, shape, input_shape))
+            return false;
+        shape = input_shape;
+        inputs.push_back(token);
+        input_values.push_back(input);
     }
+    Program program;
+    if (!program.compile(postfix, inputs, true) || program.multipleResults()){
+        this->addError(DIAG_VECTOR_NOT_EVALUABLE, {expr});
+        return false;
+    }
+    kind = shape.kind;
+    if (inputs.empty()){
+        values = Matrix(1, 1, program.run());
+        return true;
+    }
+    values = Matrix(shape.rows, shape.cols);
+    program.map(input_values.data(), values.size(), values.data());
+    return true;
+}
 
-    /* Add the rest of the buffer */
-    if (!buffer.empty())
-        flattened_cmd += "("+buffer+")";
+void Engine::evalVector(const std::string& cmd){
+    if (this->_number_mode != MODE_AUTO && this->_number_mode != MODE_DOUBLE)
+        this->addWarning(DIAG_VECTOR_MODE, {NUMBER_MODE_NAMES[this->_number_mode]});
+
+    /* The names before `=` (not `==`) are assigned the result */
+    std::vector<std::string> names;
+    std::size_t pos = 0;
+    while (true){
+        const std::size_t end = find_word_end(cmd, pos);
+        if (end == pos || end >= cmd.size() || cmd[end] != '=' || (end+1 < cmd.size() && cmd[end+1] == '='))
+            break;
+        names.push_back(cmd.substr(pos, end-pos));
+        pos = end+1;
+    }
+    Matrix values;
+    ValueKind kind;
+    if (!this->evalVectorExpr(cmd.substr(pos), values, kind))
+        return;
+
+    if (kind == VALUE_VECTOR)
+        this->_evalBuffer.push_back(formatVector(values.values()));
+    else if (kind == VALUE_MATRIX)
+        this->_evalBuffer.push_back(formatMatrix(values));
+    else{
+        std::ostringstream str_stream_obj;
+        str_stream_obj << values.data()[0];
+        this->_evalBuffer.push_back(str_stream_obj.str());
+        this->_last_value = values.data()[0];
+        this->_value_index = this->_evalBuffer.size()-1;
+    }
 
-    return flattened_cmd;
+    for (std::size_t index = 0; index < names.size(); ++index){
+        const std::string& name = names[index];
+        if (!this->checkVarName(name))
+            continue;
+        this->_exact_values.erase(name);
+        if (kind == VALUE_SCALAR){
+            this->setVariable(name, values.data()[0]);
+            continue;
+        }
+        /* A name holds either a scalar, a vector or a matrix */
+        auto name_it = std::find(this->_varNames.cbegin(), this->_varNames.cend(), name);
+        if (name_it != this->_varNames.cend()){
+            this->_varValues.erase(this->_varValues.begin()+(name_it-this->_varNames.cbegin()));
+            this->_varNames.erase(name_it);
+        }
+        /* The last name takes the elements */
+        const bool flag_last = index+1 == names.size();
+        if (kind == VALUE_VECTOR){
+            this->_matValues.erase(name);
+            this->_vecValues[name] = flag_last ? std::move(values.values()) : values.values();
+        } else{
+            this->_vecValues.erase(name);
+            this->_matValues[name] = flag_last ? std::move(values) : values;
+        }
+    }
 }
 
-Engine Engine::load(std::string line){
+/* Returns the line without its spaces and comments as it is queued (see Engine::load), the position
+* of every character kept is appended to the last argument if it is given
+*/
+static std::string strip_line(const std::string& line, std::vector<std::size_t>* positions){
+    std::string stripped;
+    stripped.reserve(line.size());
     /* Remove spaces from line if a function definition is NOT found
     * This way the description in the function description will not have its spaces removed
+    * (the spaces are removed from the head and the start of the body)
     */
-    std::smatch match;
-    if (std::regex_match(line, match, std::regex(R"(^(\S+\s*\(.*?\))\s*\:\s*(.*(\".*\")*)$)"))){
-        assert(match.size() == 4);
-        line = std::regex_replace(match[1].str(), std::regex(R"(\s+)"), "")+":"+match[2].str();
+    const std::size_t colon_pos = find_definition_colon(line);
+    const std::size_t body_pos = colon_pos == std::string::npos ? line.size()
+        : std::find_if_not(line.cbegin()+colon_pos+1, line.cend(), is_space)-line.cbegin();
+    for (std::size_t pos = 0; pos < line.size(); ++pos)
+        if (pos >= body_pos || !is_space(line[pos])){
+            stripped += line[pos];
+            if (positions != nullptr)
+                positions->push_back(pos);
+        }
+    /* Remove all comments (everything enclosed between a pair of IGNORE_CHAR) */
+    if (colon_pos != std::string::npos || stripped.find(IGNORE_CHAR) == std::string::npos)
+        return stripped;
+    std::string uncommented;
+    std::vector<std::size_t> uncommented_positions;
+    auto keep = [&](std::size_t begin, std::size_t end){
+        uncommented.append(stripped, begin, end-begin);
+        if (positions != nullptr)
+            uncommented_positions.insert(uncommented_positions.end(), positions->cbegin()+begin, positions->cbegin()+end);
+    };
+    std::size_t last = 0;
+    for (std::size_t open = stripped.find(IGNORE_CHAR); open != std::string::npos; open = stripped.find(IGNORE_CHAR, last)){
+        const std::size_t close = stripped.find(IGNORE_CHAR, open+1);
+        if (close == std::string::npos)
+            break;
+        keep(last, open);
+        last = close+1;
     }
-    else{
-        line  = std::regex_replace(line, std::regex(R"(\s+)"), "");
-        /* Remove all comments
-        * RegEx to remove everything enclosed between IGNORE_CHAR using a lazy match
-        */
-        line = std::regex_replace(line, std::regex(R"(\)"+IGNORE_CHAR+"(.*?)"+R"(\)"+IGNORE_CHAR), "", std::regex_constants::match_any);
+    keep(last, stripped.size());
+    if (positions != nullptr)
+        *positions = std::move(uncommented_positions);
+    return uncommented;
+}
+
+Engine& Engine::load(std::string line){
+    /* A new line starts if nothing is waiting to be evaluated */
+    if (this->_cmdBuffer.empty()){
+        this->_profiler.beginLine();
+        this->_source_lines.clear();
+        this->_command_sources.clear();
     }
+    PhaseTimer timer(this->_profiler, PHASE_LOAD);
+
+    /* The line is kept to locate the diagnostics of its commands */
+    this->_source_lines.push_back(line);
+    line = strip_line(line, nullptr);
+    const std::size_t line_index = this->_source_lines.size()-1;
+    this->_command_sources.push_back({line_index, 0});
+    for (std::size_t sep_pos = line.find(SEP_CHAR); sep_pos != std::string::npos; sep_pos = line.find(SEP_CHAR, sep_pos+1))
+        this->_command_sources.push_back({line_index, sep_pos+1});
 
     /* Split by SEP_CHAR and add line to command queue */
     if (line.find(SEP_CHAR) == std::string::npos)
@@ -321,18 +1545,24 @@ Engine Engine::load(std::string line){
     return *this;
 }
 
-Engine Engine::eval(void){
+Engine& Engine::eval(void){
     /* Check if the command buffer is empty */
     if (this->_cmdBuffer.empty())
         return *this;
 
+    PhaseTimer timer(this->_profiler, PHASE_EVAL);
+
     /* Clear the eval buffer */
     this->_evalBuffer.clear();
-    /* Reset any error messages */
-    this->_error_message.clear();
-    this->_warning_message.clear();
+    this->_value_index = std::string::npos;
+    /* Reset any error messages (including the ones of the last evaluation) */
+    this->_errors.clear();
+    this->_warnings.clear();
+    this->_runner.clear();
     /* Reset the eval wiper */
     this->_evalWiper = 0;
+    /* Special commands are the first command */
+    this->_source_command = 0;
 
     /* Check for special commands */
     std::smatch match;
@@ -346,42 +1576,95 @@ Engine Engine::eval(void){
         /* Clear command buffer */
         this->_cmdBuffer.clear();
         return *this;
-    } else if (this->_cmdBuffer[0] == "reset" || this->_cmdBuffer[0] == "reset*" || std::regex_match(this->_cmdBuffer[0], match, std::regex(R"(reset#([a-zA-Z0-9_]+))"))){
+    } else if (this->_cmdBuffer[0].compare(0, 5, "sweep") == 0 && this->_cmdBuffer[0].find(':') != std::string::npos
+        && regexMatch(this->_cmdBuffer[0], makeRegex(R"(sweep[a-zA-Z_][a-zA-Z0-9_]*=.*)"))){
+        this->evalSweep(this->_cmdBuffer[0].substr(5));
+        /* Clear command buffer */
+        this->_cmdBuffer.clear();
+        return *this;
+    } else if (regexMatch(this->_cmdBuffer[0], match, makeRegex(R"((save|load)#(.+))"))){
+        if (match[1].str() == "save" && this->saveSnapshot(match[2].str()))
+            this->_evalBuffer.push_back("[Info] Snapshot saved");
+        else if (match[1].str() == "load" && this->loadSnapshot(match[2].str()))
+            this->_evalBuffer.push_back("[Info] Snapshot loaded");
+        /* Clear command buffer */
+        this->_cmdBuffer.clear();
+        return *this;
+    } else if (this->_cmdBuffer[0] == "stats" || regexMatch(this->_cmdBuffer[0], match, makeRegex(R"(stats#([a-zA-Z]+))"))){
+        if (this->_cmdBuffer[0] == "stats")
+            this->_evalBuffer.push_back(this->stats());
+        else if (match[1].str() == "on"){
+            this->_profiler.enable(true);
+            this->_evalBuffer.push_back("[Info] Profiling enabled");
+        } else if (match[1].str() == "off"){
+            this->_profiler.enable(false);
+            this->_evalBuffer.push_back("[Info] Profiling disabled");
+        } else if (match[1].str() == "clear"){
+            this->_profiler.reset();
+            this->_evalBuffer.push_back("[Info] Statistics cleared");
+        } else{
+            this->addError(DIAG_STATS_UNKNOWN, {match[1].str()});
+            this->addError(DIAG_STATS_USAGE);
+        }
+        /* Clear command buffer */
+        this->_cmdBuffer.clear();
+        return *this;
+    } else if (this->_cmdBuffer[0] == "mode" || regexMatch(this->_cmdBuffer[0], match, makeRegex(R"(mode#([a-zA-Z0-9]+))"))){
+        if (this->_cmdBuffer[0] != "mode"){
+            auto mode_it = std::find(std::begin(NUMBER_MODE_NAMES), std::end(NUMBER_MODE_NAMES), match[1].str());
+            if (mode_it == std::end(NUMBER_MODE_NAMES)){
+                this->addError(DIAG_MODE_UNKNOWN, {match[1].str()});
+                this->addError(DIAG_MODE_USAGE);
+                /* Clear command buffer */
+                this->_cmdBuffer.clear();
+                return *this;
+            }
+            this->_number_mode = static_cast<NumberMode>(mode_it-std::begin(NUMBER_MODE_NAMES));
+        }
+        this->_evalBuffer.push_back(std::string("[Info] Number mode: ")+NUMBER_MODE_NAMES[this->_number_mode]);
+        /* Clear command buffer */
+        this->_cmdBuffer.clear();
+        return *this;
+    } else if (this->_cmdBuffer[0] == "reset" || this->_cmdBuffer[0] == "reset*" || regexMatch(this->_cmdBuffer[0], match, makeRegex(R"(reset#([a-zA-Z0-9_]+))"))){
         bool flag_reset_all = false;
         /* Check if a function name was given */
         if (this->_cmdBuffer[0] == "reset*"){
             flag_reset_all = true;
-            this->_warning_message += "[Engine] INFO: Resetting all inbuilt functions...\n";
+            this->addWarning(DIAG_RESET_ALL);
         } else if (match.size() != 2){
-            this->_error_message += "[Engine] ERROR: No function name was given for reset operation! Nothing has been reset\n";
-            this->_error_message += "[Engine] INFO: Please use `reset #function_name` to reset a function or `reset *` to reset all functions\n";
+            this->addError(DIAG_RESET_NO_NAME);
+            this->addError(DIAG_RESET_USAGE);
             /* Clear command buffer */
             this->_cmdBuffer.clear();
             return *this;
         }
-        /* Find the function to be reset */
+        /* Find the function(s) to be reset */
+        std::vector<const BuiltinFunction*> builtins;
+        if (flag_reset_all)
+            for (const BuiltinFunction& builtin : SUPPORTED_FUNS)
+                builtins.push_back(&builtin);
+        else if (findBuiltin(match[1].str()) != nullptr)
+            builtins.push_back(findBuiltin(match[1].str()));
         bool flag_function_found = false;
-        for (MetaFunction fun : SUPPORTED_FUNS){
-            /* Process if the reset all flag is set or if the required function found */
-            if (flag_reset_all || match[1].str() == fun.name){
-                /* If the reference definition was found reset the function definition */
-                auto target_fun_it = std::find_if(this->_supported_functions.begin(), this->_supported_functions.end(), [fun](MetaFunction item){return fun.name == item.name;});
-                /* Check if the function definition exists */
-                if (target_fun_it != this->_supported_functions.cend()){
-                    /* If it exists, update it */
-                    (*target_fun_it).arg_names = fun.arg_names;
-                    (*target_fun_it).desc = fun.desc;
-                    (*target_fun_it).expr = fun.expr;
-                } else
-                    /* If it doesn't exist add a new entry */
-                    this->_supported_functions.push_back(fun);
-                this->_error_message += "[Engine] INFO: The function `"+fun.name+"` has been successfully reset\n";
-                flag_function_found = true;
-            }
+        for (const BuiltinFunction* builtin : builtins){
+            const MetaFunction fun = builtin->getMetaFunction();
+            /* If the reference definition was found reset the function definition */
+            auto target_fun_it = std::find_if(this->_supported_functions.begin(), this->_supported_functions.end(), [fun](MetaFunction item){return fun.name == item.name;});
+            /* Check if the function definition exists */
+            if (target_fun_it != this->_supported_functions.cend()){
+                /* If it exists, update it */
+                (*target_fun_it).arg_names = fun.arg_names;
+                (*target_fun_it).desc = fun.desc;
+                (*target_fun_it).expr = fun.expr;
+            } else
+                /* If it doesn't exist add a new entry */
+                this->_supported_functions.push_back(fun);
+            this->addError(DIAG_RESET_DONE, {fun.name});
+            flag_function_found = true;
         }
         if (!flag_reset_all && !flag_function_found)
             /* If the reference definition could not be found set the error string and return */
-            this->_error_message += "[Engine] ERROR: The function `"+match[1].str()+"` could not be reset as it's reference definition could not be found\n";
+            this->addError(DIAG_RESET_NOT_FOUND, {match[1].str()});
         /* Clear command buffer */
         this->_cmdBuffer.clear();
         return *this;
@@ -389,21 +1672,20 @@ Engine Engine::eval(void){
 
     /* Loop through all commands in queue and evaluate them */
     std::ostringstream str_stream_obj;
-    for (std::string cmd : this->_cmdBuffer){
+    for (std::size_t cmd_index = 0; cmd_index < this->_cmdBuffer.size(); ++cmd_index){
+        std::string cmd = this->_cmdBuffer[cmd_index];
+        this->_source_command = cmd_index;
         /* Clear runner's buffers */
         this->_runner.clear();
 
         /* Check if parentheses are balanced */
-        if ((std::count(cmd.cbegin(), cmd.cend(), '(') != std::count(cmd.cbegin(), cmd.cend(), ')'))
-            || (std::count(cmd.cbegin(), cmd.cend(), '[') != std::count(cmd.cbegin(), cmd.cend(), ']'))
-            || (std::count(cmd.cbegin(), cmd.cend(), '{') != std::count(cmd.cbegin(), cmd.cend(), '}'))){
-            this->_error_message += "[Engine] ERROR: Unbalanced parentheses in expression `"+cmd+"`!\n";
+        if (!brackets_balanced(cmd)){
+            this->addError(DIAG_UNBALANCED_PARENTHESES, {cmd});
             continue;
         }
         /* Check if quotes are balanced */
-        if ((std::count(cmd.cbegin(), cmd.cend(), '\'')%2 != 0)
-            || (std::count(cmd.cbegin(), cmd.cend(), '"')%2 != 0)){
-            this->_error_message += "[Engine] ERROR: Unbalanced quotes in expression `"+cmd+"`!\n";
+        if (!quotes_balanced(cmd)){
+            this->addError(DIAG_UNBALANCED_QUOTES, {cmd});
             continue;
         }
 
@@ -415,13 +1697,13 @@ Engine Engine::eval(void){
         *  - Group 4 = Function description (with spaces, optional)
         */
         std::smatch fun_def_match;
-        if (std::regex_match(cmd, fun_def_match, std::regex(R"(^(\S+)\((\S+)\)\:(.*?)\s*(\".*\")*\s*$)"))){
+        if (cmd.find("):") != std::string::npos && regexMatch(cmd, fun_def_match, makeRegex(R"(^(\S+)\((\S+)\)\:(.*?)\s*(\".*\")*\s*$)"))){
             /* Remove comments and extract the function name */
-            std::string fname = std::regex_replace(fun_def_match[1].str(), std::regex(R"(\)"+IGNORE_CHAR+"(.*?)"+R"(\)"+IGNORE_CHAR), "", std::regex_constants::match_any);
+            std::string fname = regexReplace(fun_def_match[1].str(), makeRegex(R"(\)"+IGNORE_CHAR+"(.*?)"+R"(\)"+IGNORE_CHAR), "", std::regex_constants::match_any);
             /* Remove comments and extract the function argument(s) */
-            std::string fargs = std::regex_replace(fun_def_match[2].str(), std::regex(R"(\)"+IGNORE_CHAR+"(.*?)"+R"(\)"+IGNORE_CHAR), "", std::regex_constants::match_any);
+            std::string fargs = regexReplace(fun_def_match[2].str(), makeRegex(R"(\)"+IGNORE_CHAR+"(.*?)"+R"(\)"+IGNORE_CHAR), "", std::regex_constants::match_any);
             /* Remove comments and extract the function expression */
-            std::string expr = std::regex_replace(fun_def_match[3].str(), std::regex(R"(\)"+IGNORE_CHAR+"(.*?)"+R"(\)"+IGNORE_CHAR), "", std::regex_constants::match_any);
+            std::string expr = regexReplace(fun_def_match[3].str(), makeRegex(R"(\)"+IGNORE_CHAR+"(.*?)"+R"(\)"+IGNORE_CHAR), "", std::regex_constants::match_any);
             /* Check if this function has already been defined */
             auto fun_it = std::find_if(this->_supported_functions.begin(), this->_supported_functions.end(), [fname](MetaFunction item){return item.name == fname;});
             if (fun_it != this->_supported_functions.cend()){
@@ -437,7 +1719,7 @@ Engine Engine::eval(void){
                 }
                 (*fun_it).arg_names.push_back(fargs.substr(split_last));
                 /* Update the expression string */
-                (*fun_it).expr = std::regex_replace(expr, std::regex(R"(\s+)"), "");
+                (*fun_it).expr = regexReplace(expr, makeRegex(R"(\s+)"), "");
                 /* Update the description (if available) */
                 (*fun_it).desc = "";
                 if (fun_def_match.size() == 5)
@@ -476,7 +1758,7 @@ Engine Engine::eval(void){
                 if (fun_def_match.size() == 5)
                     new_function.desc = fun_def_match[4];
                 /* Add the expression string */
-                new_function.expr = std::regex_replace(expr, std::regex(R"(\s+)"), "");
+                new_function.expr = regexReplace(expr, makeRegex(R"(\s+)"), "");
                 /* Replace known variables with their values */
                 new_function.expr = this->replaceVars(new_function.expr);
                 /* Verify that only the arguments are remaining */
@@ -484,9 +1766,9 @@ Engine Engine::eval(void){
                 std::vector<std::string> infix_buffer = this->_runner.getInfixBuffer();
                 for (auto element_it = infix_buffer.cbegin(); element_it != infix_buffer.cend(); ++element_it){
                     /* Check if this is a variable name */
-                    if (std::regex_match(*element_it, std::regex(R"([a-zA-Z0-9_]+)")))
+                    if (regexMatch(*element_it, makeRegex(R"([a-zA-Z0-9_]+)")))
                         /* Check if this is an argument */
-                        if (new_function.arg_names.cend() == std::find_if(new_function.arg_names.cbegin(), new_function.arg_names.cend(), [element_it](std::string item){return std::regex_search(item.cbegin(), item.cend(), std::regex(*element_it));})){
+                        if (new_function.arg_names.cend() == std::find_if(new_function.arg_names.cbegin(), new_function.arg_names.cend(), [element_it](std::string item){return regexSearch(item.cbegin(), item.cend(), makeRegex(*element_it));})){
                             /* Check if this is a function call */
                             if (this->_supported_functions.cend() != std::find_if(this->_supported_functions.cbegin(), this->_supported_functions.cend(), [element_it](MetaFunction item){return *element_it == item.name;}))
                                 /* If found confirm that the next element in the buffer is an opening parentheses */
@@ -505,7 +1787,7 @@ Engine Engine::eval(void){
                 this->_supported_functions.push_back(new_function);
                 /* Raise a warning if the function does not have a body */
                 if (new_function.expr.empty())
-                    this->_warning_message += "[Warning] Function `"+fname+"` does not have a body, it will always return 0 by default!\n";
+                    this->addWarning(DIAG_EMPTY_FUNCTION, {fname});
                 /* Push an update message to the result buffer */
                 this->_evalBuffer.push_back("[Info] Definition for function `"+fname+"` added");
             }
@@ -514,13 +1796,29 @@ Engine Engine::eval(void){
             return *this;
         }
 
+        /* Expressions of vectors are evaluated element-wise */
+        if (this->usesVectors(cmd)){
+            PhaseTimer phase_timer(this->_profiler, PHASE_EVALUATE);
+            this->evalVector(cmd);
+            continue;
+        }
+
         /* Check and replace variables with values in expression
         * This does a blind parse, which results in the parsing done twice on the command
         */
-        cmd = this->replaceVars(cmd);
+        {
+            PhaseTimer phase_timer(this->_profiler, PHASE_REPLACE_VARS);
+            cmd = this->replaceVars(cmd);
+        }
 
         /* Check for and evaluate any supported function(s) used */
-        cmd = this->evalFunctions(cmd);
+        {
+            PhaseTimer phase_timer(this->_profiler, PHASE_EVAL_FUNCTIONS);
+            this->_calls_map.clear();
+            this->_source_text = &cmd;
+            cmd = this->evalFunctions(cmd);
+            this->_source_text = nullptr;
+        }
 
         /* Check if an assignment operation is present */
         if (cmd.find("=") != std::string::npos){
@@ -534,25 +1832,34 @@ Engine Engine::eval(void){
             }
 
             /* Evaluate the expression to be assigned */
-            this->_runner.parseExpr(assignment_stack.back());
-            this->_runner.convertToPostfix();
-            double val = this->_runner.evaluatePostfix();
+            double val;
+            {
+                PhaseTimer phase_timer(this->_profiler, PHASE_PARSE);
+                this->_runner.parseExpr(assignment_stack.back());
+            }
+            {
+                PhaseTimer phase_timer(this->_profiler, PHASE_POSTFIX);
+                this->_runner.convertToPostfix();
+            }
+            std::string exact_val;
+            NumberMode mode;
+            {
+                PhaseTimer phase_timer(this->_profiler, PHASE_EVALUATE);
+                mode = this->evaluateRunner(val, exact_val);
+            }
+            this->takeRunnerDiagnostics(cmd.size()-assignment_stack.back().size());
             /* Pop the expression from the assignment stack */
             assignment_stack.pop_back();
 
             /* Assign the result value to all valid variable names */
             for (std::string varName : assignment_stack)
                 if (this->checkVarName(varName)){
-                    auto indx_it = std::find(this->_varNames.cbegin(), this->_varNames.cend(), varName);
-                    /* Make sure that this is a variable and not a function name (in which case the next element will be an opening parentheses)*/
-                    if (indx_it != this->_varNames.cend() && !(std::next(indx_it) != this->_varNames.cend() && *(indx_it+1) == "("))
-                        /* Update variable value */
-                        this->_varValues[indx_it-this->_varNames.cbegin()] = val;
-                    else{
-                        /* Add new variable */
-                        this->_varNames.push_back(varName);
-                        this->_varValues.push_back(val);
-                    }
+                    this->setVariable(varName, val);
+                    /* Keep the exact value of integer and long double results */
+                    if (!exact_val.empty())
+                        this->_exact_values[varName] = {val, exact_val};
+                    else
+                        this->_exact_values.erase(varName);
                 }
 
             /* Push the result to the result buffer
@@ -560,21 +1867,39 @@ Engine Engine::eval(void){
             * when converted to string unlike std::to_string().
             */
             str_stream_obj << val;
-            this->_evalBuffer.push_back(str_stream_obj.str());
+            this->_evalBuffer.push_back(mode == MODE_INT64 || mode == MODE_UINT64 ? exact_val : str_stream_obj.str());
+            this->_last_value = val;
+            this->_value_index = this->_evalBuffer.size()-1;
             /* Clear the string stream */
             str_stream_obj.str("");
             str_stream_obj.clear();
         }
         else{
             /* Parse expression */
-            this->_runner.parseExpr(cmd);
-            this->_runner.convertToPostfix();
+            {
+                PhaseTimer phase_timer(this->_profiler, PHASE_PARSE);
+                this->_runner.parseExpr(cmd);
+            }
+            {
+                PhaseTimer phase_timer(this->_profiler, PHASE_POSTFIX);
+                this->_runner.convertToPostfix();
+            }
             /* Evaluate the expression and push it into the result queue
             * Using a string stream allows for a cleaner number representation
             * when converted to string unlike std::to_string().
             */
-            str_stream_obj << this->_runner.evaluatePostfix();
-            this->_evalBuffer.push_back(str_stream_obj.str());
+            double val;
+            std::string exact_val;
+            NumberMode mode;
+            {
+                PhaseTimer phase_timer(this->_profiler, PHASE_EVALUATE);
+                mode = this->evaluateRunner(val, exact_val);
+            }
+            this->takeRunnerDiagnostics(0);
+            str_stream_obj << val;
+            this->_evalBuffer.push_back(mode == MODE_INT64 || mode == MODE_UINT64 ? exact_val : str_stream_obj.str());
+            this->_last_value = val;
+            this->_value_index = this->_evalBuffer.size()-1;
             /* Clear the string stream */
             str_stream_obj.str("");
             str_stream_obj.clear();
@@ -586,6 +1911,87 @@ Engine Engine::eval(void){
     return *this;
 }
 
+NumberMode Engine::evaluateRunner(double& value, std::string& exact_value){
+    NumberMode mode = this->_runner.getNumberMode(this->_number_mode);
+    if (mode == MODE_INT64 || mode == MODE_UINT64)
+        exact_value = this->_runner.evaluatePostfixInteger(mode, value);
+    else
+        exact_value = this->_runner.evaluatePostfixFloating(mode, value);
+    return mode;
+}
+
+double Engine::evaluate(const Plan& plan){
+    PhaseTimer timer(this->_profiler, PHASE_EVAL);
+
+    /* Reset any error messages */
+    this->_errors.clear();
+    this->_warnings.clear();
+
+    return this->evaluatePlan(plan);
+}
+
+double Engine::evaluatePlan(const Plan& plan){
+    std::vector<double> inputs;
+
+    /* Variables are read as they are, there is no textual round trip */
+    for (const std::string& name : plan.getVariables()){
+        auto name_it = std::find(this->_varNames.cbegin(), this->_varNames.cend(), name);
+        if (name_it == this->_varNames.cend()){
+            this->addError(DIAG_UNDEFINED_VARIABLE, {name});
+            return 0;
+        }
+        inputs.push_back(this->_varValues[name_it-this->_varNames.cbegin()]);
+    }
+
+    /* Calls are evaluated as calls on the values of the arguments (see evalFunctions) */
+    for (const PlanCall& call : plan.getCalls()){
+        std::vector<std::string> args;
+        for (const Plan& arg : call.args){
+            double value = this->evaluatePlan(arg);
+            if (!this->_errors.empty())
+                return 0;
+            char str_value[32];
+            if (std::isfinite(value))
+                std::snprintf(str_value, sizeof(str_value), "%.17G", value);
+            else
+                std::snprintf(str_value, sizeof(str_value), "(%s/0)", std::isnan(value) ? "0" : (value > 0 ? "1" : "-1"));
+            args.push_back(str_value);
+        }
+        std::string call_cmd;
+        {
+            PhaseTimer phase_timer(this->_profiler, PHASE_EVAL_FUNCTIONS);
+            /* Use the compiled body of the function if it has one, otherwise expand the call */
+            auto fun_it = std::find_if(this->_supported_functions.cbegin(), this->_supported_functions.cend(), [&call](const MetaFunction& item){return item.name == call.name;});
+            if (fun_it == this->_supported_functions.cend() || args.size() > (*fun_it).arg_names.size() || !this->evalCompiledCall(*fun_it, args, call_cmd)){
+                call_cmd = call.name+"(";
+                for (const std::string& arg : args)
+                    call_cmd += (&arg == args.data() ? "" : ",")+arg;
+                call_cmd = this->evalFunctions(call_cmd+")");
+            }
+        }
+        if (!this->_errors.empty())
+            return 0;
+        Evaluator call_runner;
+        call_runner.parseExpr(call_cmd);
+        call_runner.convertToPostfix();
+        inputs.push_back(call_runner.evaluatePostfix());
+        this->_errors.append(call_runner.getErrors());
+        this->_warnings.append(call_runner.getWarnings());
+        if (!this->_errors.empty())
+            return 0;
+    }
+
+    PhaseTimer phase_timer(this->_profiler, PHASE_EVALUATE);
+    Program& program = plan.getProgram();
+    if (!program.valid()){
+        this->addError(DIAG_INVALID_EXPRESSION, {plan.str()});
+        return 0;
+    }
+    if (program.multipleResults())
+        this->addWarning(DIAG_MULTIPLE_RESULTS);
+    return program.run(inputs.data());
+}
+
 const std::string Engine::getResult(void){
     if (this->_evalWiper >= this->_evalBuffer.size())
         return RESULT_END;
@@ -594,6 +2000,18 @@ const std::string Engine::getResult(void){
     return this->_evalBuffer[this->_evalWiper++];
 }
 
+bool Engine::getLastResult(std::string& result, double& value) const{
+    if (this->_evalBuffer.empty()){
+        result = RESULT_END;
+        return false;
+    }
+    result = this->_evalBuffer.back();
+    if (this->_value_index != this->_evalBuffer.size()-1)
+        return false;
+    value = this->_last_value;
+    return true;
+}
+
 const std::string Engine::help(void){
     std::string help_str = "-- Help for MB Compute Engine version "+ENGINE_VERSION+" --\n";
 
@@ -604,12 +2022,26 @@ const std::string Engine::help(void){
     help_str += "                           does nothing if given function is not an inbuilt function\n";
     help_str += "   - reset * --------------> Reset all inbuilt function definitions\n";
     help_str += "   - report ---------------> Return a summary all the defined variables and functions\n";
+    help_str += "   - stats ----------------> Return the per-phase timing statistics of the engine\n";
+    help_str += "   - stats #on/#off -------> Enable/disable collection of timing statistics (disabled by default)\n";
+    help_str += "   - stats #clear ---------> Clear all collected timing statistics\n";
+    help_str += "   - mode -----------------> Return the number mode of the session\n";
+    help_str += "   - mode #auto -----------> Evaluate integer bitwise expressions and hex (0x)/binary (0b) literals on int64 (default)\n";
+    help_str += "   - mode #double/#int64/#uint64 -> Evaluate every expression on double, int64 or uint64\n";
+    help_str += "   - mode #float/#longdouble -> Evaluate every expression on float or long double (functions still run on double)\n";
+    help_str += "   - save #file/load #file -> Save the variables and functions of the session to a snapshot file or restore them from one\n";
+    help_str += "   - sweep x=0:0.1:1[, y=..] : expr -> Evaluate expr on the grid (start:step:stop per axis), one row (x [y ..] value) per point\n";
+    help_str += "   - v=[1, 2, 3] ----------> Define a vector, operators and functions apply element-wise (v*2+sin(v))\n";
+    help_str += "   - sum(v)/min(v)/max(v)/dot(v, w) -> Reduce vectors to a number\n";
+    help_str += "   - A=[[1, 2], [3, 4]] ---> Define a matrix (row after row), operators and functions apply element-wise\n";
+    help_str += "   - matmul(A, B)/transpose(A)/inv(A)/det(A) -> Matrix product (a vector is a row on the left and a column on the right), transpose, inverse and determinant\n";
+    help_str += "   - linsolve(A, b) -------> Solve A*x = b (b is a vector or a matrix) by LU factorisation with partial pivoting\n";
     help_str += "\n";
 
     /* Add help for supported operators */
     help_str += "Supported operators:\n";
-    for (MetaOperator imo : SUPPORTED_OOPS)
-        help_str += imo.cat+" "+imo.desc+" [Precedence: "+std::to_string(imo.order)+"]: "+imo.oop+"\n";
+    for (const MetaOperator& imo : SUPPORTED_OOPS)
+        help_str += std::string(imo.cat)+" "+imo.desc+" [Precedence: "+std::to_string(imo.order)+"]: "+imo.oop+"\n";
     help_str += "\n";
 
     /* Add help for supported functions */
@@ -746,68 +2178,412 @@ const std::string Engine::report(void){
 
     /* List all declared variables */
     report_str += IGNORE_CHAR+"Declared variables:"+IGNORE_CHAR+"\n";
-    if (this->_varNames.empty())
+    if (this->_varNames.empty() && this->_vecValues.empty() && this->_matValues.empty())
         report_str += "   "+IGNORE_CHAR+"NO VARIABLES DECLARED"+IGNORE_CHAR+"\n";
-    else
+    else{
         for (size_t index = 0; index < this->_varNames.size(); ++index)
             report_str += "   "+this->_varNames[index]+"="+std::to_string(this->_varValues[index])+"\n";
+        for (const auto& vector : this->_vecValues)
+            report_str += "   "+vector.first+"="+formatVector(vector.second, 8)+" "+IGNORE_CHAR+std::to_string(vector.second.size())+" element(s)"+IGNORE_CHAR+"\n";
+        for (const auto& matrix : this->_matValues)
+            report_str += "   "+matrix.first+"="+formatMatrix(matrix.second, 8)+" "+IGNORE_CHAR+std::to_string(matrix.second.rows())+"x"+std::to_string(matrix.second.cols())+" matrix"+IGNORE_CHAR+"\n";
+    }
 
     return report_str;
 }
 
-const std::string Engine::getErrorMsg(void)
-{
-    if (!this->_runner.getErrorMsg().empty())
-        return this->_runner.getErrorMsg()+this->_error_message;
-    else
-        return this->_error_message;
+const std::string Engine::stats(void){
+    return this->_profiler.summary();
 }
 
-const std::string Engine::getWarningMsg(void)
-{
-    if (!this->_runner.getWarningMsg().empty())
-        return this->_runner.getWarningMsg()+this->_warning_message;
-    else
-        return this->_warning_message;
+Profiler& Engine::getProfiler(void){
+    return this->_profiler;
+}
+
+void Engine::setNumberMode(NumberMode mode){
+    this->_number_mode = mode;
+}
+
+NumberMode Engine::getNumberMode(void){
+    return this->_number_mode;
+}
+
+void Engine::setSweepSink(SweepSink sink){
+    this->_sweep_sink = std::move(sink);
+}
+
+/* Snapshot helpers for lists of strings */
+static void write_strings(SnapshotWriter& writer, const std::vector<std::string>& values){
+    writer.writeU32(static_cast<uint32_t>(values.size()));
+    for (const std::string& value : values)
+        writer.writeString(value);
+}
+
+static bool read_strings(SnapshotReader& reader, std::vector<std::string>& values){
+    uint32_t count;
+    /* Every string takes at least its length */
+    if (!reader.readU32(count) || count > reader.remaining()/sizeof(uint32_t))
+        return false;
+    values.resize(count);
+    for (std::string& value : values)
+        if (!reader.readString(value))
+            return false;
+    return true;
+}
+
+/* Returns true if the function read from a snapshot could have been defined by the load method
+* (a name and arguments without spaces or brackets, and a body without spaces with balanced brackets and quotes)
+*/
+static bool is_valid_definition(const MetaFunction& fun){
+    const auto is_word = [](const std::string& text){
+        return !text.empty() && std::none_of(text.cbegin(), text.cend(), [](char ch){ return is_space(ch) || std::strchr("()[]{}:,", ch) != nullptr; });
+    };
+    return is_word(fun.name) && std::all_of(fun.arg_names.cbegin(), fun.arg_names.cend(), is_word)
+        && std::none_of(fun.expr.cbegin(), fun.expr.cend(), is_space) && brackets_balanced(fun.expr) && quotes_balanced(fun.expr);
+}
+
+bool Engine::saveSnapshot(const std::string& file_name){
+    SnapshotWriter writer;
+    writer.writeU32(static_cast<uint32_t>(this->_number_mode));
+
+    /* Variables with the exact text of their value (if any) */
+    writer.writeU64(this->_varNames.size());
+    for (std::size_t index = 0; index < this->_varNames.size(); ++index){
+        writer.writeString(this->_varNames[index]);
+        writer.writeDouble(this->_varValues[index]);
+        auto exact_it = this->_exact_values.find(this->_varNames[index]);
+        writer.writeU8(exact_it != this->_exact_values.cend());
+        if (exact_it != this->_exact_values.cend()){
+            writer.writeDouble(exact_it->second.first);
+            writer.writeString(exact_it->second.second);
+        }
+    }
+
+    /* Function table in order */
+    writer.writeU64(this->_supported_functions.size());
+    for (const MetaFunction& fun : this->_supported_functions){
+        writer.writeString(fun.name);
+        writer.writeString(fun.desc);
+        write_strings(writer, fun.arg_names);
+        writer.writeString(fun.expr);
+    }
+
+    /* Compiled function bodies, only read back by a virtual machine with the same opcodes */
+    writer.writeU32(OPCODES_TABLE_HASH);
+    writer.writeU64(this->_compiled_functions.size());
+    for (const auto& compiled_it : this->_compiled_functions){
+        const CompiledFunction& compiled = compiled_it.second;
+        writer.writeString(compiled_it.first);
+        writer.writeString(compiled.expr);
+        write_strings(writer, compiled.arg_names);
+        writer.writeU8(compiled.compiled);
+        if (!compiled.compiled)
+            continue;
+        const Program& program = compiled.program;
+        writer.writeU64(program.inputCount());
+        writer.writeU64(program.tempBase());
+        writer.writeU8(program.multipleResults());
+        writer.writeU64(program.getCode().size());
+        for (const Instruction& ins : program.getCode()){
+            writer.writeU32(static_cast<uint32_t>(ins.op));
+            writer.writeU32(ins.dst);
+            writer.writeU32(ins.a);
+            writer.writeU32(ins.b);
+        }
+        writer.writeU64(program.getRegisters().size());
+        writer.writeBytes(program.getRegisters().data(), program.getRegisters().size()*sizeof(double));
+    }
+
+    if (!writer.save(file_name)){
+        this->addError(DIAG_SNAPSHOT_WRITE, {file_name});
+        return false;
+    }
+    return true;
+}
+
+bool Engine::loadSnapshot(const std::string& file_name){
+    SnapshotReader reader;
+    if (!reader.open(file_name)){
+        this->addError(DIAG_SNAPSHOT_OPEN, {reader.getErrorMsg()});
+        return false;
+    }
+
+    /* Everything is read into new tables first so a corrupt file leaves the session unchanged */
+    uint32_t number_mode;
+    uint64_t count;
+    if (!reader.readU32(number_mode) || number_mode >= MODE_COUNT || !reader.readU64(count) || count > reader.remaining()){
+        this->addError(DIAG_SNAPSHOT_CORRUPT, {file_name});
+        return false;
+    }
+    std::vector<std::string> var_names(count);
+    std::vector<double> var_values(count);
+    std::map<std::string, std::pair<double, std::string>> exact_values;
+    for (std::size_t index = 0; index < count; ++index){
+        uint8_t has_exact;
+        if (!reader.readString(var_names[index]) || !reader.readDouble(var_values[index]) || !reader.readU8(has_exact)){
+            this->addError(DIAG_SNAPSHOT_CORRUPT, {file_name});
+            return false;
+        }
+        if (has_exact){
+            std::pair<double, std::string>& exact = exact_values[var_names[index]];
+            if (!reader.readDouble(exact.first) || !reader.readString(exact.second)){
+                this->addError(DIAG_SNAPSHOT_CORRUPT, {file_name});
+                return false;
+            }
+        }
+    }
+
+    if (!reader.readU64(count) || count > reader.remaining()){
+        this->addError(DIAG_SNAPSHOT_CORRUPT, {file_name});
+        return false;
+    }
+    std::vector<MetaFunction> functions(count);
+    for (MetaFunction& fun : functions){
+        if (!reader.readString(fun.name) || !reader.readString(fun.desc) || !read_strings(reader, fun.arg_names) || !reader.readString(fun.expr)){
+            this->addError(DIAG_SNAPSHOT_CORRUPT, {file_name});
+            return false;
+        }
+        /* The bodies are checked like the definitions of the load method */
+        if (!is_valid_definition(fun)){
+            this->addError(DIAG_SNAPSHOT_CORRUPT, {file_name});
+            return false;
+        }
+    }
+
+    uint32_t opcodes_hash;
+    if (!reader.readU32(opcodes_hash) || !reader.readU64(count) || count > reader.remaining()){
+        this->addError(DIAG_SNAPSHOT_CORRUPT, {file_name});
+        return false;
+    }
+    std::map<std::string, CompiledFunction> compiled_functions;
+    for (std::size_t index = 0; index < count; ++index){
+        std::string name;
+        CompiledFunction compiled;
+        uint8_t flag_compiled;
+        if (!reader.readString(name) || !reader.readString(compiled.expr) || !read_strings(reader, compiled.arg_names) || !reader.readU8(flag_compiled)){
+            this->addError(DIAG_SNAPSHOT_CORRUPT, {file_name});
+            return false;
+        }
+        compiled.compiled = flag_compiled;
+        if (compiled.compiled){
+            uint64_t input_count, temp_base, code_size, register_count;
+            uint8_t multiple_results;
+            if (!reader.readU64(input_count) || !reader.readU64(temp_base) || !reader.readU8(multiple_results)
+                || !reader.readU64(code_size) || code_size > reader.remaining()/(4*sizeof(uint32_t))){
+                this->addError(DIAG_SNAPSHOT_CORRUPT, {file_name});
+                return false;
+            }
+            std::vector<Instruction> code(code_size);
+            for (Instruction& ins : code){
+                uint32_t op;
+                if (!reader.readU32(op) || !reader.readU32(ins.dst) || !reader.readU32(ins.a) || !reader.readU32(ins.b)){
+                    this->addError(DIAG_SNAPSHOT_CORRUPT, {file_name});
+                    return false;
+                }
+                ins.op = static_cast<OpCode>(op);
+            }
+            if (!reader.readU64(register_count) || register_count > reader.remaining()/sizeof(double)){
+                this->addError(DIAG_SNAPSHOT_CORRUPT, {file_name});
+                return false;
+            }
+            std::vector<double> registers(register_count);
+            reader.readBytes(registers.data(), registers.size()*sizeof(double));
+            /* Programs of another virtual machine are compiled again when first called */
+            if (opcodes_hash != OPCODES_TABLE_HASH || !compiled.program.restore(std::move(code), std::move(registers), input_count, temp_base, multiple_results))
+                continue;
+        }
+        compiled_functions[name] = std::move(compiled);
+    }
+    if (!reader.atEnd()){
+        this->addError(DIAG_SNAPSHOT_CORRUPT, {file_name});
+        return false;
+    }
+
+    /* Builtins added since the snapshot was saved */
+    for (const BuiltinFunction& builtin : SUPPORTED_FUNS)
+        if (std::find_if(functions.cbegin(), functions.cend(), [&builtin](const MetaFunction& item){return item.name == builtin.name;}) == functions.cend())
+            functions.push_back(builtin.getMetaFunction());
+
+    this->_number_mode = static_cast<NumberMode>(number_mode);
+    this->_varNames = std::move(var_names);
+    this->_varValues = std::move(var_values);
+    this->_exact_values = std::move(exact_values);
+    this->_supported_functions = std::move(functions);
+    this->_compiled_functions = std::move(compiled_functions);
+    /* Vectors and matrices are not kept in snapshots, none of the previous session survives */
+    this->_vecValues.clear();
+    this->_matValues.clear();
+    return true;
+}
+
+bool Engine::hasErrors(void) const{
+    return !this->_errors.empty();
+}
+
+bool Engine::hasWarnings(void) const{
+    return !this->_warnings.empty();
+}
+
+const Diagnostics& Engine::getErrors(void) const{
+    return this->_errors;
+}
+
+const Diagnostics& Engine::getWarnings(void) const{
+    return this->_warnings;
+}
+
+const std::string Engine::getErrorMsg(void) const{
+    return this->_errors.str();
+}
+
+const std::string Engine::getWarningMsg(void) const{
+    return this->_warnings.str();
+}
+
+Diagnostic& Engine::addError(DiagCode code, std::vector<std::string> args){
+    return this->locate(this->_errors.add(code, std::move(args)));
+}
+
+Diagnostic& Engine::addWarning(DiagCode code, std::vector<std::string> args){
+    return this->locate(this->_warnings.add(code, std::move(args)));
+}
+
+/* Returns the offset of the subject in the text if it occurs there once (a name only matches a whole
+* name), npos otherwise
+*/
+static std::size_t find_subject(const std::string& text, const std::string& subject){
+    std::size_t found = std::string::npos;
+    if (subject.empty())
+        return found;
+    for (std::size_t pos = text.find(subject); pos != std::string::npos; pos = text.find(subject, pos+1)){
+        if ((is_name_char(subject.front()) && pos > 0 && is_name_char(text[pos-1]))
+            || (is_name_char(subject.back()) && pos+subject.size() < text.size() && is_name_char(text[pos+subject.size()])))
+            continue;
+        if (found != std::string::npos)
+            return std::string::npos;
+        found = pos;
+    }
+    return found;
+}
+
+Diagnostic& Engine::locate(Diagnostic& record){
+    if (this->_source_command >= this->_cmdBuffer.size())
+        return record;
+    record.command = this->_source_command;
+    if (this->_call_offset != std::string::npos){
+        /* The span of the call is in the command with its variables replaced */
+        std::size_t offset = this->_call_offset;
+        std::size_t length = this->_call_length;
+        this->_vars_map.map(offset, length);
+        this->locateInLine(record, offset, length);
+    } else if (!record.args.empty()){
+        /* Otherwise the subject of a diagnostic is its first argument */
+        const std::size_t offset = find_subject(this->_cmdBuffer[this->_source_command], record.args[0]);
+        if (offset != std::string::npos)
+            this->locateInLine(record, offset, record.args[0].size());
+    }
+    return record;
+}
+
+void Engine::locateInLine(Diagnostic& record, std::size_t offset, std::size_t length) const{
+    if (offset == std::string::npos || this->_source_command >= this->_command_sources.size())
+        return;
+    const CommandSource& source = this->_command_sources[this->_source_command];
+    /* The line is stripped again to find where the characters of the command come from */
+    std::vector<std::size_t> positions;
+    strip_line(this->_source_lines[source.line], &positions);
+    const std::size_t begin = source.start+offset;
+    if (begin >= positions.size())
+        return;
+    const std::size_t last = std::min(begin+std::max<std::size_t>(length, 1), positions.size())-1;
+    record.offset = positions[begin];
+    record.length = length == 0 ? 0 : positions[last]+1-record.offset;
+}
+
+void Engine::takeRunnerDiagnostics(std::size_t base){
+    const Diagnostics* runner_lists[] = {&this->_runner.getErrors(), &this->_runner.getWarnings()};
+    Diagnostics* engine_lists[] = {&this->_errors, &this->_warnings};
+    for (std::size_t list = 0; list < 2; ++list)
+        for (const Diagnostic& runner_record : runner_lists[list]->records()){
+            Diagnostic& record = engine_lists[list]->add(runner_record.code, runner_record.args);
+            if (base == std::string::npos || runner_record.offset == std::string::npos){
+                this->locate(record);
+                continue;
+            }
+            /* The span in the expression evaluated is mapped back through the calls and the variables replaced */
+            record.command = this->_source_command;
+            std::size_t offset = base+runner_record.offset;
+            std::size_t length = runner_record.length;
+            this->_calls_map.map(offset, length);
+            this->_vars_map.map(offset, length);
+            this->locateInLine(record, offset, length);
+        }
+    this->_runner.clear();
 }
 
 /* Evaluator class definitions */
 Evaluator::Evaluator(const std::string expression){
+    this->_program_ready = false;
     this->parseExpr(expression);
 }
 
 Evaluator::Evaluator(void){
-    /* Extract the highest precedence of all supported operators */
-    this->_max_precedence = 0;
-    for (MetaOperator mo : SUPPORTED_OOPS)
-        if (this->_max_precedence < mo.order)
-            this->_max_precedence = mo.order;
+    this->_program_ready = false;
 }
 
 Evaluator::~Evaluator(void){
 }
 
-const std::vector<std::string> Evaluator::getInfixBuffer(void){
+const std::vector<std::string>& Evaluator::getInfixBuffer(void) const{
     return this->_expression_infix;
 }
 
-const std::vector<std::string> Evaluator::getPostfixBuffer(void){
+const std::vector<std::string>& Evaluator::getPostfixBuffer(void) const{
     return this->_expression_postfix;
 }
 
-const std::string Evaluator::getErrorMsg(void){
-    return this->_error_message;
+const std::vector<std::size_t>& Evaluator::getInfixOffsets(void) const{
+    return this->_infix_offsets;
+}
+
+const Diagnostics& Evaluator::getErrors(void) const{
+    return this->_errors;
 }
 
-const std::string Evaluator::getWarningMsg(void){
-    return this->_warning_message;
+const Diagnostics& Evaluator::getWarnings(void) const{
+    return this->_warnings;
+}
+
+const std::string Evaluator::getErrorMsg(void) const{
+    return this->_errors.str();
+}
+
+const std::string Evaluator::getWarningMsg(void) const{
+    return this->_warnings.str();
+}
+
+Diagnostic& Evaluator::locate(Diagnostic& record, std::size_t index){
+    if (index >= this->_postfix_tokens.size()){
+        record.offset = std::string::npos;
+        return record;
+    }
+    const std::size_t token = this->_postfix_tokens[index];
+    record.offset = this->_infix_offsets[token];
+    /* A token spans its text up to the next token of the expression (numbers with SI prefixes are rewritten) */
+    record.length = this->_expression_infix[token].size();
+    for (std::size_t next = token+1; next < this->_infix_offsets.size(); ++next)
+        if (this->_infix_offsets[next] > record.offset){
+            record.length = std::min(record.length, this->_infix_offsets[next]-record.offset);
+            break;
+        }
+    return record;
 }
 
-int Evaluator::getOPP(std::string opr){
-    auto itr = std::find_if(SUPPORTED_OOPS.cbegin(), SUPPORTED_OOPS.cend(), [opr](MetaOperator item){return opr == item.oop;});
+int Evaluator::getOPP(std::string_view opr){
+    const MetaOperator* mo = findOperator(opr);
     /* Check if the requested operator was found */
-    if (itr != SUPPORTED_OOPS.cend())
-        return this->_max_precedence+1 - (*itr).order;
+    if (mo != nullptr)
+        return MAX_OPERATOR_ORDER+1 - mo->order;
     else
         return 0;
 }
@@ -839,7 +2615,7 @@ int Evaluator::getOPP(std::string opr){
 * | yocto |  y     | 1E-24      |  0.000000000000000000000001 |  septillionth         |
 * +-------+--------+------------+-----------------------------+-----------------------+
 */
-Evaluator Evaluator::parseExpr(std::string expr){
+Evaluator& Evaluator::parseExpr(std::string expr){
     /* Remove spaces in input before proceeding */
     expr.erase(std::remove_if(expr.begin(), expr.end(), [](unsigned char x) { return std::isspace(x); }), expr.cend());
 
@@ -848,9 +2624,14 @@ Evaluator Evaluator::parseExpr(std::string expr){
     bool flag_sci_skip = false;
     bool flag_variable = false;
 
+    /* The tokens added for a character take its offset (see locate) */
+    std::size_t offset = 0;
+    auto sync_offsets = [this, &offset](){ this->_infix_offsets.resize(this->_expression_infix.size(), offset); };
+
     /* Iterate input expression */
     unsigned int bracket_count = 0;
     for (std::string::const_iterator it = expr.cbegin(); it != expr.cend(); ++it){
+        offset = it-expr.cbegin();
         if (not std::isdigit(*it))
             if (flag_number){
                 /* If the current character is E */
@@ -875,13 +2656,14 @@ Evaluator Evaluator::parseExpr(std::string expr){
                         if (expr.cend()-it < search_end_offset)
                             search_end_offset = expr.cend()-it;
 
-                        if (std::regex_search(std::string(it-search_start_offset, it+search_end_offset), std::regex("[\\.0-9]+(E[\\-\\+][0-9]+)"))){
+                        static const std::regex sci_regex = makeRegex("[\\.0-9]+(E[\\-\\+][0-9]+)");
+                        if (regexSearch(it-search_start_offset, it+search_end_offset, sci_regex)){
                             this->_expression_infix.back() += "E";
                             /* Set flag to skip the following +/- character */
                             flag_sci_skip = true;
                         }
                         else
-                            this->_expression_infix.back() += "*(1E+28)";
+                            this->_expression_infix.back() += "*(1E+18)";
                         break;
                     case 'P':
                         this->_expression_infix.back() += "*(1E+15)";
@@ -954,15 +2736,16 @@ Evaluator Evaluator::parseExpr(std::string expr){
                         } else{
                             /* Number has ended and a operator has started! */
                             /* Remove trailing opening bracket if nothing has been added since */
-                            if (this->_expression_infix.back() == "(")
+                            if (this->_expression_infix.back() == "("){
                                 this->_expression_infix.pop_back();
-                            else
+                                sync_offsets();
+                            } else
                                 this->_expression_infix.push_back(")");
                             bracket_count--;
                             /* Add the operator */
                             this->_expression_infix.push_back(std::string(1, *it));
                             /* Check if this is a two character operator */
-                            if (SUPPORTED_OOPS.cend() != std::find_if(SUPPORTED_OOPS.cbegin(), SUPPORTED_OOPS.cend(), [it](MetaOperator item){return item.oop == (*it)+std::string(1, *(it+1));}))
+                            if (it+1 != expr.cend() && findOperator(std::string_view(&*it, 2)) != nullptr)
                                 this->_expression_infix.back() += std::string(1, *(++it));
                             /* Mark the end of a number */
                             flag_number = false;
@@ -997,7 +2780,7 @@ Evaluator Evaluator::parseExpr(std::string expr){
                 /* Append all other characters as is */
                 this->_expression_infix.push_back(std::string(1, *it));
                 /* Check if this is a two character operator */
-                if (SUPPORTED_OOPS.cend() != std::find_if(SUPPORTED_OOPS.cbegin(), SUPPORTED_OOPS.cend(), [it](MetaOperator item){return item.oop == (*it)+std::string(1, *(it+1));}))
+                if (it+1 != expr.cend() && findOperator(std::string_view(&*it, 2)) != nullptr)
                     this->_expression_infix.back() += std::string(1, *(++it));
             }
         else{
@@ -1008,9 +2791,10 @@ Evaluator Evaluator::parseExpr(std::string expr){
                 /* Add a final closing bracket to the previous section if needed */
                 if (bracket_count == 1){
                     /* Remove trailing opening bracket if nothing has been added since */
-                    if (this->_expression_infix.back() == "(")
+                    if (this->_expression_infix.back() == "("){
                         this->_expression_infix.pop_back();
-                    else
+                        sync_offsets();
+                    } else
                         this->_expression_infix.push_back(")");
                     bracket_count--;
                 }
@@ -1023,7 +2807,17 @@ Evaluator Evaluator::parseExpr(std::string expr){
             /* Reinforce that both the number and variable flags are not the same */
             assert(flag_number != flag_variable);
             }
+            /* Hex (0x) and binary (0b) integer literals are kept as they are so they can be read exactly */
+            if (flag_number && (this->_expression_infix.back() == "0" || this->_expression_infix.back() == "-0") && expr.cend()-it > 2){
+                const char* digits = std::tolower(*(it+1)) == 'x' ? "0123456789abcdefABCDEF" : (std::tolower(*(it+1)) == 'b' ? "01" : "");
+                if (*digits != '\0' && std::strchr(digits, *(it+2)) != nullptr){
+                    this->_expression_infix.back() += *(++it);
+                    while (it+1 != expr.cend() && std::strchr(digits, *(it+1)) != nullptr)
+                        this->_expression_infix.back() += *(++it);
+                }
+            }
         }
+        sync_offsets();
     }
 
     /* Add a final closing bracket if needed */
@@ -1034,6 +2828,7 @@ Evaluator Evaluator::parseExpr(std::string expr){
         else
             this->_expression_infix.push_back(")");
         bracket_count--;
+        sync_offsets();
     }
 
     /* Reinforce that no extra brackets exist */
@@ -1058,57 +2853,67 @@ Evaluator Evaluator::parseExpr(std::string expr){
 * Step 7 : Print the output.
 * Step 8 : Pop and output from the stack until it is not empty.
 */
-Evaluator Evaluator::convertToPostfix(void){
-    std::stack<std::string> stack;
-
-    for (auto it = this->_expression_infix.cbegin(); it != this->_expression_infix.cend(); ++it){
+Evaluator& Evaluator::convertToPostfix(void){
+    /* The stack holds the indices of the infix tokens so the postfix tokens can be located */
+    std::stack<std::size_t> stack;
+    /* The compiled program no longer matches the postfix buffer */
+    this->_program_ready = false;
+    auto push_postfix = [this](std::size_t token){
+        this->_expression_postfix.push_back(this->_expression_infix[token]);
+        this->_postfix_tokens.push_back(token);
+    };
+
+    for (std::size_t index = 0; index < this->_expression_infix.size(); ++index){
+        const std::string& token = this->_expression_infix[index];
         /* If scanned character is open bracket push it on stack */
-        if(*it == "(" || *it == "[" || *it == "{")
-            stack.push(*it);
+        if(token == "(" || token == "[" || token == "{")
+            stack.push(index);
         /* If scanned character is opened bracket pop all literals from stack till matching open bracket gets popped */
-        else if(*it == ")" || *it == "]" || *it == "}"){
-            if(*it == ")")
-                while(stack.top() != "("){
-                    this->_expression_postfix.push_back(stack.top());
-                    stack.pop();
-                }
-            else if(*it == "]")
-                while(stack.top() != "["){
-                    this->_expression_postfix.push_back(stack.top());
-                    stack.pop();
-                }
-            else if(*it == "}")
-                while(stack.top() != "{"){
-                    this->_expression_postfix.push_back(stack.top());
-                    stack.pop();
-                }
+        else if(token == ")" || token == "]" || token == "}"){
+            const std::string open_bracket = token == ")" ? "(" : token == "]" ? "[" : "{";
+            while(!stack.empty() && this->_expression_infix[stack.top()] != open_bracket){
+                push_postfix(stack.top());
+                stack.pop();
+            }
+            /* A closing bracket without its opening bracket (the engine checks the commands, not the bodies it expands) */
+            if(stack.empty()){
+                std::string expression;
+                for (const std::string& infix_token : this->_expression_infix)
+                    expression += infix_token;
+                Diagnostic& record = this->_errors.add(DIAG_UNBALANCED_PARENTHESES, {expression});
+                record.offset = this->_infix_offsets[index];
+                record.length = 1;
+                this->_expression_postfix.clear();
+                this->_postfix_tokens.clear();
+                return *this;
+            }
             stack.pop();
-        } else if(SUPPORTED_OOPS.cend() != std::find_if(SUPPORTED_OOPS.cbegin(), SUPPORTED_OOPS.cend(), [it](MetaOperator item){return item.oop == *it;}))
+        } else if(findOperator(token) != nullptr)
             /* If scanned character is operator */
             /* very first operator of expression is to be pushed on stack */
             if(stack.empty())
-                stack.push(*it);
+                stack.push(index);
             else
                 /* Check the precedence order of instack(means the one on top of stack) and incoming operator,
                 * if instack operator has higher priority than incoming operator pop it out of stack&put it in
                 * final postfix expression, on other side if precedence order of instack operator is less than i
                 * coming operator, push incoming operator on stack.
                 */
-                if(getOPP(stack.top()) >= getOPP(*it)){
-                    this->_expression_postfix.push_back(stack.top());
+                if(getOPP(this->_expression_infix[stack.top()]) >= getOPP(token)){
+                    push_postfix(stack.top());
                     stack.pop();
-                    stack.push(*it);
+                    stack.push(index);
                 } else
-                    stack.push(*it);
+                    stack.push(index);
         else
             /* If literal is operand, put it on to final postfix expression */
-            this->_expression_postfix.push_back(*it);
+            push_postfix(index);
     }
 
     /* Popping out all remaining operator literals & adding to final postfix expression */
     if(!stack.empty()){
         while(!stack.empty()){
-            this->_expression_postfix.push_back(stack.top());
+            push_postfix(stack.top());
             stack.pop();
         }
     }
@@ -1118,10 +2923,109 @@ Evaluator Evaluator::convertToPostfix(void){
 }
 
 void Evaluator::clear(void){
-    this->_error_message.clear();
-    this->_warning_message.clear();
+    this->_errors.clear();
+    this->_warnings.clear();
     this->_expression_infix.clear();
     this->_expression_postfix.clear();
+    this->_infix_offsets.clear();
+    this->_postfix_tokens.clear();
+    this->_program_ready = false;
+}
+
+const Program& Evaluator::getProgram(void){
+    if (!this->_program_ready){
+        this->_program.compile(this->_expression_postfix);
+        this->_program_ready = true;
+    }
+    return this->_program;
+}
+
+double Evaluator::evaluatePostfix(void){
+    this->getProgram();
+    /* Let the string interpreter produce the diagnostics of erroneous expressions */
+    if (!this->_program.valid())
+        return this->interpretPostfix();
+    /* Raise a warning if the stack has multiple results */
+    if (this->_program.multipleResults())
+        this->_warnings.add(DIAG_MULTIPLE_RESULTS);
+    return this->_program.run();
+}
+
+NumberMode Evaluator::getNumberMode(NumberMode session_mode){
+    if (session_mode != MODE_AUTO)
+        return session_mode;
+    bool flag_integer = false;
+    bool flag_unsigned = false;
+    for (const std::string& token : this->_expression_postfix){
+        uint64_t magnitude;
+        bool negative;
+        if (std::isdigit(token[0]) || (token[0] == '-' && token.length() > 1 && std::isdigit(token[1]))){
+            if (!getIntegerValue(token, magnitude, negative))
+                return MODE_DOUBLE;
+            flag_integer |= isBaseLiteral(token);
+            flag_unsigned |= !negative && magnitude > static_cast<uint64_t>(INT64_MAX);
+        } else if (token == "<<" || token == ">>" || token == "&" || token == "^" || token == "|")
+            flag_integer = true;
+        else if (token == "/" || token == "**" || std::isalpha(token[0]) || token[0] == '_')
+            /* Divisions and powers keep their fractional results */
+            return MODE_DOUBLE;
+    }
+    if (!flag_integer)
+        return MODE_DOUBLE;
+    return flag_unsigned ? MODE_UINT64 : MODE_INT64;
+}
+
+/* Runs the postfix expression on the given integer type and returns the exact result as text */
+template<typename T>
+static const std::string evaluate_integer(const std::vector<std::string>& postfix, double& value, Diagnostics& errors, Diagnostics& warnings){
+    IntegerProgram<T> program;
+    T result = 0;
+    if (!program.compile(postfix) || !program.run(result)){
+        errors.append(program.getErrors());
+        value = 0;
+        return "0";
+    }
+    if (program.multipleResults())
+        warnings.add(DIAG_MULTIPLE_RESULTS);
+    value = static_cast<double>(result);
+    return std::to_string(result);
+}
+
+const std::string Evaluator::evaluatePostfixInteger(NumberMode mode, double& value){
+    const std::size_t first_error = this->_errors.size();
+    const std::string result = mode == MODE_UINT64 ? evaluate_integer<uint64_t>(this->_expression_postfix, value, this->_errors, this->_warnings)
+        : evaluate_integer<int64_t>(this->_expression_postfix, value, this->_errors, this->_warnings);
+    /* The errors of the program hold the index of their postfix token */
+    for (std::size_t index = first_error; index < this->_errors.size(); ++index)
+        this->locate(this->_errors.at(index), this->_errors.at(index).offset);
+    return result;
+}
+
+/* Runs the postfix expression on the given floating point type */
+template<typename T>
+static T evaluate_floating(Evaluator& evaluator, const std::vector<std::string>& postfix, Diagnostics& warnings){
+    BasicProgram<T> program;
+    /* Let the string interpreter produce the diagnostics of erroneous expressions */
+    if (!program.compile(postfix))
+        return static_cast<T>(evaluator.interpretPostfix());
+    if (program.multipleResults())
+        warnings.add(DIAG_MULTIPLE_RESULTS);
+    return program.run();
+}
+
+const std::string Evaluator::evaluatePostfixFloating(NumberMode mode, double& value){
+    if (mode == MODE_FLOAT){
+        value = evaluate_floating<float>(*this, this->_expression_postfix, this->_warnings);
+        return "";
+    } else if (mode == MODE_LONG_DOUBLE){
+        long double result = evaluate_floating<long double>(*this, this->_expression_postfix, this->_warnings);
+        value = static_cast<double>(result);
+        char str_value[48];
+        std::snprintf(str_value, sizeof(str_value), "%.21LG", result);
+        return str_value;
+    }
+    value = this->evaluatePostfix();
+    return "";
 }
 
 /* Algorithm to evaluate a postfix expression
@@ -1133,13 +3037,13 @@ void Evaluator::clear(void){
 *      Evaluate the operator and push the result back to the stack.
 * 3) When the expression is ended, the number in the stack is the final answer
 */
-double Evaluator::evaluatePostfix(void){
+double Evaluator::interpretPostfix(void){
     std::stack<double> stack;
     /* Scan all elements one by one */
     for (auto it = this->_expression_postfix.cbegin(); it != this->_expression_postfix.cend(); ++it){
         /* If the scanned element is an operand (number), push it to the stack. */
         if (isdigit((*it)[0]) || ((*it)[0] == '-' && (*it).length() > 1 && isdigit((*it)[1]))){
-            stack.push(std::atof((*it).c_str()));
+            stack.push(getNumberValue(*it));
         }
         /* Process alphabets/variables */
         else if (isalpha((*it)[0]) || (*it)[0] == '_'){
@@ -1151,7 +3055,7 @@ double Evaluator::evaluatePostfix(void){
         else{
             /* If the stack is empty set the error message and return 0 */
             if (stack.empty()){
-                this->_error_message += "[Evaluator] ERROR: No operands where given to the operator "+*it+"!\n";
+                this->locate(this->_errors.add(DIAG_NO_OPERANDS, {*it}), it-this->_expression_postfix.cbegin());
                 return 0;
             }
             double val1 = stack.top();
@@ -1162,10 +3066,10 @@ double Evaluator::evaluatePostfix(void){
                 /* If the stack is empty set the error message and return 0 */
                 if (stack.empty()){
                     /* Check if this is a supported operator */
-                    if (SUPPORTED_OOPS.cend() == std::find_if(SUPPORTED_OOPS.cbegin(), SUPPORTED_OOPS.cend(), [it](MetaOperator item){return item.oop == *it;}))
-                        this->_error_message += "[Evaluator] ERROR: Unsupported operator `"+*it+"`! You can use the `help` command to get a list of supported operators.\n";
+                    if (findOperator(*it) == nullptr)
+                        this->locate(this->_errors.add(DIAG_UNSUPPORTED_OPERATOR, {*it}), it-this->_expression_postfix.cbegin());
                     else
-                        this->_error_message += "[Evaluator] ERROR: Operator "+*it+" requires 2 operands however only one ("+std::to_string(val1)+") was given!\n";
+                        this->locate(this->_errors.add(DIAG_MISSING_OPERAND, {*it, std::to_string(val1)}), it-this->_expression_postfix.cbegin());
                     return 0;
                 }
                 val2 = stack.top();
@@ -1219,7 +3123,7 @@ double Evaluator::evaluatePostfix(void){
 
     /* Raise a warning if the stack has multiple results */
     if (stack.size() > 1)
-        this->_warning_message += "[Evaluator] WARNING: Multiple results in stack!\n";
+        this->_warnings.add(DIAG_MULTIPLE_RESULTS);
 
     /* Return 0 if the stack is empty */
     if (stack.empty())
@@ -1228,12 +3132,64 @@ double Evaluator::evaluatePostfix(void){
         return stack.top();
 }
 
+const std::string formatSweepRow(const double* row, std::size_t columns){
+    std::string row_str;
+    char str_value[32];
+    for (std::size_t index = 0; index < columns; ++index){
+        std::snprintf(str_value, sizeof(str_value), "%.15G", row[index]);
+        if (index > 0)
+            row_str += " ";
+        row_str += str_value;
+    }
+    return row_str;
+}
+
+/* Appends the given number of values to the text as a vector (`[1, 2, 3]`), values past the given number are left out */
+static void append_vector(std::string& vector_str, const double* values, std::size_t count, std::size_t max_elements){
+    /* The elements are printed as the results of scalar expressions are (as %g would print them) */
+    vector_str += "[";
+    char str_value[32];
+    for (std::size_t index = 0; index < count; ++index){
+        if (index > 0)
+            vector_str += ", ";
+        if (index == max_elements){
+            vector_str += "...";
+            break;
+        }
+        const std::to_chars_result converted = std::to_chars(str_value, str_value+sizeof(str_value), values[index], std::chars_format::general, 6);
+        vector_str.append(str_value, converted.ptr);
+    }
+    vector_str += "]";
+}
+
+const std::string formatVector(const std::vector<double>& values, std::size_t max_elements){
+    std::string vector_str;
+    vector_str.reserve(std::min(values.size(), max_elements)*10+8);
+    append_vector(vector_str, values.data(), values.size(), max_elements);
+    return vector_str;
+}
+
+const std::string formatMatrix(const Matrix& matrix, std::size_t max_elements){
+    std::string matrix_str = "[";
+    matrix_str.reserve(std::min(matrix.rows(), max_elements)*(std::min(matrix.cols(), max_elements)*10+8)+8);
+    for (std::size_t row = 0; row < matrix.rows(); ++row){
+        if (row > 0)
+            matrix_str += ", ";
+        if (row == max_elements){
+            matrix_str += "...";
+            break;
+        }
+        append_vector(matrix_str, matrix.data()+row*matrix.cols(), matrix.cols(), max_elements);
+    }
+    return matrix_str+"]";
+}
+
 const std::string getRegExEscaped(const std::string str){
     /* Regex escape
     * Matches any characters that need to be escaped in RegEx
     */
-    std::regex regExSpecialChars { R"([-[\]{}()*+?.,\^$|#\s])" };
-    return std::regex_replace( str, regExSpecialChars, R"(\$&)" );
+    std::regex regExSpecialChars = makeRegex(R"([-[\]{}()*+?.,\^$|#\s])");
+    return regexReplace( str, regExSpecialChars, R"(\$&)" );
 }
 
 }
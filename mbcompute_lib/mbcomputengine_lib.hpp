@@ -26,6 +26,9 @@
 /* Includes */
 #include <vector>
 #include <string>
+#include <string_view>
+#include <iterator>
+#include <map>
 #include <cstring>
 #include <algorithm>
 #include <stack>
@@ -33,6 +36,19 @@
 #include <cassert>
 #include <regex>
 #include <cmath>
+#include <functional>
+
+/* Custom libraries */
+#include "mbcprofiler_lib.hpp"
+#include "mbcphash_lib.hpp"
+#include "mbcdiag_lib.hpp"
+#include "mbcvm_lib.hpp"
+#include "mbcjit_lib.hpp"
+#include "mbcdsl_lib.hpp"
+#include "mbcdual_lib.hpp"
+#include "mbcreduce_lib.hpp"
+#include "mbcmatrix_lib.hpp"
+#include "mbcsnapshot_lib.hpp"
 
 namespace mbc{
 
@@ -48,15 +64,15 @@ struct MetaOperator{
     /* Operator precedence (lower value = higher precedence) */
     unsigned int order;
     /* Operator symbol */
-    std::string oop;
+    const char* oop;
     /* Operator category */
-    std::string cat;
+    const char* cat;
     /* Operator description */
-    std::string desc;
+    const char* desc;
 };
 
 /* List of supported operators */
-const std::vector<MetaOperator> SUPPORTED_OOPS{
+constexpr MetaOperator SUPPORTED_OOPS[]{
     {1,  "++", "Arithmetic", "Increment"},
     {1,  "--", "Arithmetic", "Decrement"},
     {2,  "**", "Arithmetic", "Power"},
@@ -80,6 +96,26 @@ const std::vector<MetaOperator> SUPPORTED_OOPS{
     {15, "||", "Logical",    "OR"},
 };
 
+/* Function returns the highest order (lowest precedence) of the supported operators */
+constexpr unsigned int getMaxOperatorOrder(void){
+    unsigned int max_order = 0;
+    for (const MetaOperator& mo : SUPPORTED_OOPS)
+        if (max_order < mo.order)
+            max_order = mo.order;
+    return max_order;
+}
+constexpr unsigned int MAX_OPERATOR_ORDER = getMaxOperatorOrder();
+
+/* Perfect hash of the operator symbols (see findOperator) */
+constexpr auto SUPPORTED_OOPS_HASH = makePerfectHash(SUPPORTED_OOPS, [](const MetaOperator& item){ return std::string_view(item.oop); });
+static_assert(SUPPORTED_OOPS_HASH.valid(), "No perfect hash found for the operator symbols");
+
+/* Function returns the operator with the given symbol, nullptr if it is not an operator */
+constexpr const MetaOperator* findOperator(std::string_view oop){
+    const std::size_t index = SUPPORTED_OOPS_HASH.find(oop);
+    return index < std::size(SUPPORTED_OOPS) ? &SUPPORTED_OOPS[index] : nullptr;
+}
+
 /* Structure to hold metadata of supported functions
 *   Functions will always take 0 of more double(s) as arguments
 *   and return a single double.
@@ -95,25 +131,130 @@ struct MetaFunction{
     std::string expr;
 };
 
+/* Structure to hold the compiled body of a user function
+*   The body is compiled with the argument names as program inputs, it is
+*   only used if evaluating it gives the same result as expanding the call.
+*/
+struct CompiledFunction{
+    /* Definition the program was compiled from */
+    std::string expr;
+    std::vector<std::string> arg_names;
+    /* True if the body could be compiled */
+    bool compiled;
+    /* Compiled body */
+    Program program;
+};
+
 /* Supported function argument type */
 const std::string FUNCTION_ARG_TYPE = "double";
 
+/* Maximum number of arguments of a builtin function */
+const std::size_t MAX_BUILTIN_ARGS = 4;
+
+/* Structure to hold the definition of a builtin function (see MetaFunction)
+*   Unused argument names are nullptr.
+*/
+struct BuiltinFunction{
+    /* Function name symbol */
+    const char* name;
+    /* Function description */
+    const char* desc;
+    /* Function argument names */
+    const char* arg_names[MAX_BUILTIN_ARGS];
+    /* Function implementation/expression */
+    const char* expr;
+
+    /* Method returns the builtin as a function definition of the engine */
+    const MetaFunction getMetaFunction(void) const{
+        MetaFunction fun{this->name, this->desc, {}, this->expr};
+        for (const char* arg_name : this->arg_names)
+            if (arg_name != nullptr)
+                fun.arg_names.push_back(arg_name);
+        return fun;
+    }
+};
+
 /* List of supported internal functions
 * Function that start and end with double underscores (__) are reserved for internal implementations!
 */
-const std::vector<MetaFunction> SUPPORTED_FUNS{
-    {"ln", "Log base e", std::vector<std::string>{"var1"}, "__log__(var1)"},
-    {"log", "Log base 10", std::vector<std::string>{"var1"}, "__log10__(var1)"},
-    {"ceil", "Ceiling", std::vector<std::string>{"var1"}, "__ceil__(var1)"},
-    {"floor", "Floor", std::vector<std::string>{"var1"}, "__floor__(var1)"},
-    {"abs", "Absolute", std::vector<std::string>{"var1"}, "__abs__(var1)"},
-    {"cos", "Cosine", std::vector<std::string>{"var1"}, "__cos__(var1)"},
-    {"sin", "Sine", std::vector<std::string>{"var1"}, "__sin__(var1)"},
-    {"tan", "Tangent", std::vector<std::string>{"var1"}, "__tan__(var1)"},
-    {"cosh", "Hyperbolic cosine", std::vector<std::string>{"var1"}, "__cosh__(var1)"},
-    {"sinh", "Hyperbolic sine", std::vector<std::string>{"var1"}, "__sinh__(var1)"},
-    {"tanh", "Hyperbolic tangent", std::vector<std::string>{"var1"}, "__tanh__(var1)"},
-    {"pow", "Power", std::vector<std::string>{"var1", "var2"}, "__pow__(var1,var2)"},
+constexpr BuiltinFunction SUPPORTED_FUNS[]{
+    {"ln", "Log base e", {"var1"}, "__log__(var1)"},
+    {"log", "Log base 10", {"var1"}, "__log10__(var1)"},
+    {"ceil", "Ceiling", {"var1"}, "__ceil__(var1)"},
+    {"floor", "Floor", {"var1"}, "__floor__(var1)"},
+    {"abs", "Absolute", {"var1"}, "__abs__(var1)"},
+    {"cos", "Cosine", {"var1"}, "__cos__(var1)"},
+    {"sin", "Sine", {"var1"}, "__sin__(var1)"},
+    {"tan", "Tangent", {"var1"}, "__tan__(var1)"},
+    {"cosh", "Hyperbolic cosine", {"var1"}, "__cosh__(var1)"},
+    {"sinh", "Hyperbolic sine", {"var1"}, "__sinh__(var1)"},
+    {"tanh", "Hyperbolic tangent", {"var1"}, "__tanh__(var1)"},
+    {"pow", "Power", {"var1", "var2"}, "__pow__(var1,var2)"},
+    {"if", "Value of then if cond is not 0, else of else (only the branch taken is evaluated)", {"cond", "then", "else"}, "__if__(cond,then,else)"},
+    {"solve", "Root of the function named fun near x0 (Newton's method)", {"fun", "x0"}, "__solve__(fun,x0)"},
+    {"minimize", "Point of the local minimum of the function named fun near x0 (Newton's method)", {"fun", "x0"}, "__minimize__(fun,x0)"},
+    {"sum", "Sum of fun(i) for i = first, first+1, ..., last, or of expr if fun names the index", {"fun", "first", "last", "expr="}, "__sum__(fun,first,last,expr)"},
+    {"integrate", "Integral of fun(x) over [a, b], or of expr if fun names the variable (adaptive quadrature)", {"fun", "a", "b", "expr="}, "__integrate__(fun,a,b,expr)"},
+};
+
+/* Perfect hash of the builtin function names (see findBuiltin) */
+constexpr auto SUPPORTED_FUNS_HASH = makePerfectHash(SUPPORTED_FUNS, [](const BuiltinFunction& item){ return std::string_view(item.name); });
+static_assert(SUPPORTED_FUNS_HASH.valid(), "No perfect hash found for the builtin function names");
+
+/* Function returns the builtin function with the given name, nullptr if it is not a builtin */
+constexpr const BuiltinFunction* findBuiltin(std::string_view name){
+    const std::size_t index = SUPPORTED_FUNS_HASH.find(name);
+    return index < std::size(SUPPORTED_FUNS) ? &SUPPORTED_FUNS[index] : nullptr;
+}
+
+/* Maximum depth of nested calls when a function body is inlined (see solve and minimize) */
+const unsigned int MAX_INLINE_DEPTH = 64;
+
+/* Maximum depth of nested calls when the calls of an expression are evaluated (see evalFunctions) */
+const unsigned int MAX_CALL_DEPTH = 256;
+
+/* Maximum size of an expression once its calls are expanded (see evalFunctions), the
+* larger of MAX_EXPANSION_SIZE bytes and MAX_EXPANSION_RATIO times the size of the command
+*/
+const std::size_t MAX_EXPANSION_SIZE = 64*1024*1024;
+const std::size_t MAX_EXPANSION_RATIO = 16;
+
+/* Number modes of a session (see the mode command) */
+enum NumberMode{
+    /* Integer expressions using a bitwise operator or a hex/binary literal run on int64, the rest on double */
+    MODE_AUTO,
+    MODE_FLOAT,
+    MODE_DOUBLE,
+    MODE_LONG_DOUBLE,
+    MODE_INT64,
+    MODE_UINT64,
+    /* Number of modes (not a mode) */
+    MODE_COUNT
+};
+
+/* Printable names of the number modes (indexed by NumberMode) */
+const char* const NUMBER_MODE_NAMES[MODE_COUNT] = {"auto", "float", "double", "longdouble", "int64", "uint64"};
+
+/* Kinds of the value of a vector expression (see Engine::evalVectorExpr) */
+enum ValueKind{
+    VALUE_SCALAR,
+    VALUE_VECTOR,
+    VALUE_MATRIX
+};
+
+/* Structure to hold the kind and the shape of a value (a vector is one row, a scalar one element) */
+struct ValueShape{
+    ValueKind kind;
+    std::size_t rows;
+    std::size_t cols;
+};
+
+/* Structure to hold the line a command was loaded from and the start of the command in the
+* line once its spaces and comments are removed (see Engine::load)
+*/
+struct CommandSource{
+    std::size_t line;
+    std::size_t start;
 };
 
 /* Class declarations */
@@ -123,15 +264,28 @@ class Evaluator{
 private:
     std::vector<std::string> _expression_infix;
     std::vector<std::string> _expression_postfix;
+    /* Offset of every infix token in the parsed expression and index of the infix token of
+    * every postfix token (used to locate the diagnostics)
+    */
+    std::vector<std::size_t> _infix_offsets;
+    std::vector<std::size_t> _postfix_tokens;
+
+    /* Bytecode of the postfix expression, compiled on the first evaluation */
+    Program _program;
+    bool _program_ready;
 
-    unsigned int _max_precedence;
-    std::string _error_message;
-    std::string _warning_message;
+    Diagnostics _errors;
+    Diagnostics _warnings;
 
     /* Method returns precedence of the operator given.
     * The return value will be in the range [0, 3]
     */
-    int getOPP(std::string);
+    int getOPP(std::string_view);
+
+    /* Method sets the span of the given record to the postfix token at the given index
+    * (the offset is npos if there is no such token)
+    */
+    Diagnostic& locate(Diagnostic&, std::size_t);
 public:
     /* Constructors for Evaluator class */
     Evaluator(const std::string);
@@ -143,40 +297,97 @@ public:
     /* Method parses the given string expression into a workable list.
     * The given string will be split into numbers (double in string form)
     * and all other characters while taking SI prefixes into consideration.
+    * The offset of every token is kept to locate diagnostics (see getInfixOffsets).
     * 
     * This method returns its object so operations can be cascaded.
     */
-    Evaluator parseExpr(std::string);
+    Evaluator& parseExpr(std::string);
 
     /* Method converts internal infix expression buffer to postfix.
     * This method returns its object so operations can be cascaded.
     */
-    Evaluator convertToPostfix(void);
+    Evaluator& convertToPostfix(void);
 
     /* Method evaluates the given postfix expression.
+    * The postfix buffer is compiled to bytecode once and run on the virtual
+    * machine, expressions that would raise an error are passed on to
+    * interpretPostfix so the diagnostics are unchanged.
     * Returns 0 if no result was generated.
     */
     double evaluatePostfix(void);
 
+    /* Method evaluates the given postfix expression by interpreting the string tokens.
+    * This is the reference implementation the virtual machine is checked against.
+    * Returns 0 if no result was generated.
+    */
+    double interpretPostfix(void);
+
+    /* Method returns the number mode the postfix expression is evaluated in for the given session mode.
+    * In MODE_AUTO an expression of integers that uses a bitwise operator or a hex/binary
+    * literal is evaluated on int64 (uint64 if a literal only fits in uint64) unless it
+    * divides or raises to a power, anything else is evaluated on double.
+    */
+    NumberMode getNumberMode(NumberMode);
+
+    /* Method evaluates the postfix expression on 64 bit integers (MODE_INT64 or MODE_UINT64).
+    * Returns the exact result as text, the result is also stored as a double in the last argument.
+    * Returns "0" if no result was generated.
+    */
+    const std::string evaluatePostfixInteger(NumberMode, double&);
+
+    /* Method evaluates the postfix expression in the precision of the given mode (MODE_FLOAT,
+    * MODE_DOUBLE or MODE_LONG_DOUBLE), literals are read in that precision as well.
+    * The result is stored as a double in the last argument, a long double result is
+    * also returned as text with enough digits to read it back exactly (otherwise "" is
+    * returned as the double holds the exact result).
+    */
+    const std::string evaluatePostfixFloating(NumberMode, double&);
+
+    /* Method returns the bytecode of the postfix expression (compiling it if needed) */
+    const Program& getProgram(void);
+
     /* Method clears all buffers. */
     void clear(void);
 
     /* Method returns the internal infix expression buffer. */
-    const std::vector<std::string> getInfixBuffer(void);
+    const std::vector<std::string>& getInfixBuffer(void) const;
 
     /* Method returns the internal postfix expression buffer. */
-    const std::vector<std::string> getPostfixBuffer(void);
+    const std::vector<std::string>& getPostfixBuffer(void) const;
+
+    /* Method returns the offset of every token of the infix buffer in the parsed expression (without its spaces). */
+    const std::vector<std::size_t>& getInfixOffsets(void) const;
+
+    /* Methods return the errors and warnings of the last evaluation */
+    const Diagnostics& getErrors(void) const;
+    const Diagnostics& getWarnings(void) const;
 
-    /* Method to return the internal error message (if any) */
-    const std::string getErrorMsg(void);
+    /* Method to return the internal error message (if any), formatted on each call */
+    const std::string getErrorMsg(void) const;
 
-    /* Method to return the internal error message (if any) */
-    const std::string getWarningMsg(void);
+    /* Method to return the internal warning message (if any), formatted on each call */
+    const std::string getWarningMsg(void) const;
 };
 
 /* Result end marker */
 const std::string RESULT_END = "null";
 
+/* Sink receiving the rows of a sweep (see Engine::setSweepSink), the arguments are
+* the rows, the number of rows and the number of columns of every row.
+*/
+using SweepSink = std::function<void(const double*, std::size_t, std::size_t)>;
+
+/* Function returns a row of a sweep as text (the values separated by spaces) */
+const std::string formatSweepRow(const double*, std::size_t);
+
+/* Function returns a vector as text (`[1, 2, 3]`), elements past the given number are left out */
+const std::string formatVector(const std::vector<double>&, std::size_t = std::string::npos);
+
+/* Function returns a matrix as text (`[[1, 2], [3, 4]]`), rows and elements of a row past the
+* given number are left out
+*/
+const std::string formatMatrix(const Matrix&, std::size_t = std::string::npos);
+
 /* Core compute engine class */
 class Engine{
 private:
@@ -189,26 +400,231 @@ private:
     /* Result queue and wiper */
     std::vector<std::string> _evalBuffer;
     std::size_t _evalWiper;
+    /* Exact value of the result at _value_index of the result queue (the last value of an expression) */
+    double _last_value;
+    std::size_t _value_index;
 
     /* List of supported functions */
     std::vector<MetaFunction> _supported_functions;
 
     /* Variables for diagnostics */
-    std::string _error_message;
-    std::string _warning_message;
+    Diagnostics _errors;
+    Diagnostics _warnings;
+    /* Index of the command being evaluated (used to locate diagnostics), npos outside of eval */
+    std::size_t _source_command;
+    /* Lines loaded since the command queue was last empty and the source of every command queued */
+    std::vector<std::string> _source_lines;
+    std::vector<CommandSource> _command_sources;
+    /* Command whose calls are being expanded (see evalFunctions) and the span of the call in it
+    * being evaluated (offset is npos outside of a call), diagnostics raised by a call are located
+    * at the call
+    */
+    const std::string* _source_text;
+    std::size_t _call_offset;
+    std::size_t _call_length;
+    /* Maps of the command with its variables replaced back to the command and of the command
+    * with its calls replaced back to the command with its variables replaced
+    */
+    SourceMap _vars_map;
+    SourceMap _calls_map;
+
+    /* Per-phase timing statistics */
+    Profiler _profiler;
+
+    /* Compiled bodies of the user functions (by function name) */
+    std::map<std::string, CompiledFunction> _compiled_functions;
+
+    /* Number mode of the session */
+    NumberMode _number_mode;
+
+    /* Exact text of the variables assigned an integer result (by variable name),
+    * used as long as the variable still holds the same value.
+    */
+    std::map<std::string, std::pair<double, std::string>> _exact_values;
+
+    /* Sink receiving the rows of the sweeps (rows go to the results queue if not set) */
+    SweepSink _sweep_sink;
+
+    /* Number of calls being evaluated by evalFunctions (see MAX_CALL_DEPTH) */
+    unsigned int _call_depth;
+    /* Maximum size of the expansion of the command being evaluated (see MAX_EXPANSION_SIZE) */
+    std::size_t _expansion_limit;
 
     /* Method returns true if given variable name is valid */
     bool checkVarName(std::string);
 
-    /* Replace variable names with their respective values */
-    const std::string replaceVars(const std::string);
+    /* Method assigns the value to the named scalar variable (a vector or matrix of the name is removed) */
+    void setVariable(const std::string&, double);
 
-    /* Replace function calls with their evaluated results */
-    const std::string evalFunctions(const std::string);
+    /* Method compiles the body of the given function, returns false if the
+    * body can not be evaluated on its own (function calls, unknown names or
+    * a structure that differs from the expanded call).
+    */
+    bool compileFunction(const MetaFunction&, Program&);
+
+    /* Method evaluates a call of the given function with the given arguments
+    * using its compiled body and stores the result in the last argument.
+    * Returns false if the call has to be expanded instead.
+    */
+    bool evalCompiledCall(const MetaFunction&, const std::vector<std::string>&, std::string&);
+
+    /* Method appends the given text from the given position to the last argument with every
+    * call replaced by its result. Stops at the closing parentheses of the enclosing call and
+    * returns its position (the size of the text if there is none).
+    */
+    std::size_t expandCalls(const std::string&, std::size_t, std::string&);
+
+    /* Method evaluates the call of the named function whose arguments start at the given
+    * position of the text and appends its result (in parentheses) to the last argument.
+    * The arguments and the body of the call are expanded in the same buffer, nothing is
+    * copied per nested call. Returns the position of the closing parentheses of the call
+    * (sets the error message if the call fails or its expansion is too large).
+    */
+    std::size_t evalCall(const std::string&, const std::string&, std::size_t, std::string&);
+
+    /* Method appends the postfix of the given expression to the last but one argument with
+    * every call inlined, the bodies of the functions called are expanded in place and the
+    * reserved internal functions are kept as function tokens (see BasicProgram::compile).
+    * Names are replaced by the postfix they are bound to in the map. Returns false (and sets
+    * the error message) if a name is not bound or a call can not be inlined.
+    */
+    bool inlineExpression(const std::string&, const std::map<std::string, std::vector<std::string>>&, std::vector<std::string>&, unsigned int);
+
+    /* Method appends the postfix of a call of the given function on the given argument
+    * postfixes (missing arguments take their default values), see inlineExpression.
+    */
+    bool inlineCall(const MetaFunction&, const std::vector<std::vector<std::string>>&, std::vector<std::string>&, unsigned int);
+
+    /* Method runs the solver builtin with the given reserved name (__solve__ or __minimize__)
+    * on the arguments of the call (a function name and a start value) and stores the result
+    * in the last argument. The derivatives come from evaluating the inlined function body on
+    * dual numbers. Returns false (and sets the error message) if the solver fails.
+    */
+    bool evalSolverCall(const std::string&, const std::vector<std::string>&, std::string&);
+
+    /* Method runs the reduction builtin with the given reserved name (__sum__ or __integrate__)
+    * on the argument text of the call and stores the result in the last argument. The
+    * expression (or function) is inlined and compiled once, the work is split across the
+    * reduction threads (see mbcreduce_lib.hpp). Returns false (and sets the error message)
+    * if the arguments are invalid or the result is not finite.
+    */
+    bool evalReductionCall(const std::string&, const std::string&, std::string&);
+
+    /* Method runs the conditional builtin named by the first argument on the argument text
+    * of the call and stores the result in the last argument. The condition is expanded and
+    * evaluated first, then only the branch it selects is expanded (the other one is never
+    * evaluated). Returns false (and sets the error message) if the arguments are invalid.
+    */
+    bool evalConditionalCall(const std::string&, const std::string&, std::string&);
+
+    /* Method expands and evaluates the given condition in the number mode of the session and
+    * stores its value in the last argument. Returns false (and keeps the errors) on failure.
+    */
+    bool evalCondition(const std::string&, double&);
+
+    /* Method evaluates the given function body if its top level operators of lowest precedence
+    * are && or || and a call is used right of the first one. The operands are evaluated in order
+    * (see evalCondition) until they decide the result (1 or 0), stored in the last argument. Returns
+    * false (and does nothing) if the body does not have such operators, it is then expanded at once.
+    */
+    bool evalLogical(const std::string&, std::string&);
+
+    /* Method evaluates the given bound (or limit) of the builtin or command named by the second
+    * argument and stores it in the last argument, returns false (and sets the error message) if
+    * the bound is not a finite number.
+    */
+    bool evalBound(const std::string&, const std::string&, double&);
+
+    /* Method runs the sweep command on the given specification (the command without `sweep`),
+    * the expression is inlined and compiled once and the grid is evaluated in blocks across the
+    * reduction threads. Rows are streamed in order to the sweep sink, see sweepGrid.
+    * Returns false (and sets the error message) if the specification is invalid.
+    */
+    bool evalSweep(const std::string&);
+
+    /* Method returns true if the command uses a vector or a matrix (a literal or a variable) */
+    bool usesVectors(const std::string&) const;
+
+    /* Method evaluates a command of vectors or matrices (see evalVectorExpr), the names before
+    * `=` are assigned the result which is pushed to the results queue.
+    */
+    void evalVector(const std::string&);
+
+    /* Method evaluates the given expression of vectors and matrices. Vector literals (`[a, b, ...]`),
+    * matrix literals (`[[a, b], [c, d]]`), the reductions sum(v), min(v), max(v) and dot(v, w) and
+    * the matrix functions (see evalMatrixCall) are evaluated first, the rest of the expression is
+    * inlined and compiled once and run element-wise over the vectors and matrices it uses (see
+    * BasicProgram::map), scalars are used in every element. A vector is stored as a matrix of one
+    * row, the kind of the result is set in the last argument (a scalar result is the only element).
+    * Returns false (and sets the error message) if the values used have different shapes or the
+    * expression can not be evaluated element-wise.
+    */
+    bool evalVectorExpr(const std::string&, Matrix&, ValueKind&);
+
+    /* Method evaluates the call (the last but two argument) of the matrix function of the given
+    * name on the given arguments: matmul(A, B) (a vector is a row on the left and a column on the
+    * right), transpose(A), linsolve(A, b) (b is a vector or a matrix), det(A) and inv(A). Returns
+    * false (and sets the error message) if the shapes do not fit or the matrix is singular.
+    */
+    bool evalMatrixCall(const std::string&, const std::vector<std::string>&, const std::string&, Matrix&, ValueKind&);
+
+    /* Method returns true if the given shapes are the same, sets the error message on the
+    * given expression otherwise
+    */
+    bool sameShape(const std::string&, const ValueShape&, const ValueShape&);
+
+    /* Method evaluates an element of a vector literal (a scalar expression) */
+    bool evalVectorElement(const std::string&, double&);
+
+    /* Method evaluates the given plan, the calls are evaluated first (see evaluate) */
+    double evaluatePlan(const Plan&);
+
+    /* Method evaluates the postfix expression of the runner in the number mode of the session
+    * and returns the mode used. The value is stored in the first argument, in the integer
+    * modes the exact result is also stored as text in the second argument.
+    */
+    NumberMode evaluateRunner(double&, std::string&);
+
+    /* Methods record an error / a warning with the given arguments, see locate */
+    Diagnostic& addError(DiagCode, std::vector<std::string> = {});
+    Diagnostic& addWarning(DiagCode, std::vector<std::string> = {});
+
+    /* Method sets the span of the given record to the call being evaluated or else to its first
+    * argument if it is found once in the command being evaluated. Only called when a diagnostic
+    * is raised.
+    */
+    Diagnostic& locate(Diagnostic&);
+
+    /* Method sets the span of the given record to the given span (offset and length) of the
+    * command being evaluated mapped to the line the command was loaded from
+    */
+    void locateInLine(Diagnostic&, std::size_t, std::size_t) const;
+
+    /* Method moves the diagnostics of the runner to the engine and clears the runner. The runner
+    * evaluated the command with its calls replaced from the given offset on, npos if it evaluated
+    * another text (the diagnostics are then located at the call being evaluated).
+    */
+    void takeRunnerDiagnostics(std::size_t);
 public:
+    /* Replace variable names with their respective values
+    * This is one of the individual phases of eval, it is public so that
+    * it can be exercised on its own (see bench/).
+    */
+    const std::string replaceVars(const std::string&);
+
+    /* Replace function calls with their evaluated results
+    * This is one of the individual phases of eval, it is public so that
+    * it can be exercised on its own (see bench/).
+    */
+    const std::string evalFunctions(const std::string&);
+
     /* Expression variables */
     std::vector<std::string> _varNames;
     std::vector<double> _varValues;
+    /* Vector variables (by name), the elements are stored contiguously */
+    std::map<std::string, std::vector<double>> _vecValues;
+    /* Matrix variables (by name) */
+    std::map<std::string, Matrix> _matValues;
     /* Constructor for Engine class */
     Engine();
 
@@ -216,15 +632,22 @@ public:
     ~Engine(void);
 
     /* Method to load an expression line into the command buffer.
-    * This method returns its object so operations can be cascaded.
+    * This method returns a reference to its object so operations can be cascaded.
     */
-    Engine load(std::string);
+    Engine& load(std::string);
 
     /* Method will try to evaluate all the expression(s) loaded into the command buffer.
     * If the evaluation was successful the command buffer will be cleared.
-    * This method returns its object so operations can be cascaded.
+    * This method returns a reference to its object so operations can be cascaded.
     */
-    Engine eval(void);
+    Engine& eval(void);
+
+    /* Method evaluates an expression built in C++ (see mbcdsl_lib.hpp) and returns its result.
+    * Variables are read from the engine without rounding and function calls are
+    * evaluated by the same function machinery as eval (including user functions).
+    * On an error 0 is returned and the error message is set (see getErrorMsg).
+    */
+    double evaluate(const Plan&);
 
     /* Method returns the oldest result that hasn't been returned form the results queue
     * If there are no further results the method will return RESULT_END.
@@ -240,17 +663,64 @@ public:
     */
     const std::string getResult(void);
 
+    /* Method returns the last result of the last eval without removing it from the results queue
+    * (RESULT_END if there is none). Returns true and sets the given value to the exact number if
+    * the result is the value of an expression.
+    */
+    bool getLastResult(std::string&, double&) const;
+
     /* Returns the help message */
     const std::string help(void);
 
     /* Returns a summary of all declared variables and defined functions */
     const std::string report(void);
 
-    /* Method to return the internal error message (if any) */
-    const std::string getErrorMsg(void);
+    /* Returns a summary of the per-phase timing statistics */
+    const std::string stats(void);
+
+    /* Methods to set and get the number mode of the session (MODE_AUTO by default) */
+    void setNumberMode(NumberMode);
+    NumberMode getNumberMode(void);
+
+    /* Method saves the variables, the function table and the compiled function bodies of the
+    * session to the given binary snapshot file (see mbcsnapshot_lib.hpp).
+    * Returns false (and sets the error message) if the file could not be written.
+    */
+    bool saveSnapshot(const std::string&);
+
+    /* Method replaces the variables, the function table and the compiled function bodies of the
+    * session with the ones of the given snapshot file, nothing is parsed or compiled again.
+    * Builtin functions missing from the snapshot are added. Returns false (and sets the error
+    * message) if the file is not a valid snapshot, the session is left unchanged in that case.
+    * Vectors and matrices are not kept in snapshots, the ones of the session are removed.
+    */
+    bool loadSnapshot(const std::string&);
+
+    /* Method sets the sink receiving the rows of the sweeps, an empty sink adds the
+    * rows to the results queue as text (see formatSweepRow).
+    */
+    void setSweepSink(SweepSink);
+
+    /* Method returns the profiler holding the per-phase timing statistics.
+    * Profiling is disabled by default, use getProfiler().enable(true) to start it.
+    */
+    Profiler& getProfiler(void);
+
+    /* Methods return true if the last operation raised an error / a warning.
+    * These do not format anything, use them to check for errors on the hot path.
+    */
+    bool hasErrors(void) const;
+    bool hasWarnings(void) const;
+
+    /* Methods return the errors / warnings raised by the last operation in order */
+    const Diagnostics& getErrors(void) const;
+    const Diagnostics& getWarnings(void) const;
+
+    /* Method to return the internal error message (if any), formatted on each call */
+    const std::string getErrorMsg(void) const;
 
-    /* Method to return the internal error message (if any) */
-    const std::string getWarningMsg(void);
+    /* Method to return the internal warning message (if any), formatted on each call */
+    const std::string getWarningMsg(void) const;
 };
 
 /* Escape any special characters used by RegEx */
@@ -0,0 +1,123 @@
+/****************************************************************************
+* File name: mbcphash_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine perfect hash header (header only) used to look up
+*  the symbols of the constant tables (operators, opcodes and builtins).
+*
+*  Usage:
+*   constexpr auto TABLE_HASH = mbc::makePerfectHash(TABLE, [](const Entry& item){ return std::string_view(item.name); });
+*   std::size_t index = TABLE_HASH.find("name");
+*  The seed of the hash is searched at compile time so that every key has
+*  a slot of its own, a lookup is one hash of the key, one slot load and
+*  one comparison. find returns the number of keys if the key is not known.
+****************************************************************************/
+#ifndef __MB_COMPUTE_PHASH_LIB__
+
+#define __MB_COMPUTE_PHASH_LIB__
+/* Includes */
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace mbc{
+
+/* Function returns the hash of the given key for the given seed (FNV-1a)
+* The high bits are mixed into the low bits used for the slot, otherwise only
+* the low bits of the seed would change the slots.
+*/
+constexpr uint32_t perfectHashKey(std::string_view key, uint32_t seed){
+    uint32_t hash = 2166136261u^seed;
+    for (char character : key){
+        hash ^= static_cast<uint8_t>(character);
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x45D9F3Bu;
+    return hash ^ (hash >> 16);
+}
+
+/* Function returns the number of slots used for the given number of keys (a power of 2, at least 4 per key) */
+constexpr std::size_t perfectHashSlots(std::size_t key_count){
+    std::size_t slots = 1;
+    while (slots < 4*key_count)
+        slots *= 2;
+    return slots;
+}
+
+/* Number of seeds tried before giving up (see PerfectHash::valid) */
+const uint32_t PERFECT_HASH_MAX_SEEDS = 4096;
+
+/* PerfectHash class mapping a fixed set of N keys to their index */
+template<std::size_t N>
+class PerfectHash{
+private:
+    static constexpr std::size_t SLOTS = perfectHashSlots(N);
+    std::string_view _keys[N];
+    uint32_t _seed;
+    bool _valid;
+    /* Index of the key in every slot (N if empty) */
+    uint16_t _slots[SLOTS];
+
+    /* Method fills the slots for the given seed, returns false if two keys share a slot */
+    constexpr bool fill(uint32_t seed){
+        for (std::size_t slot = 0; slot < SLOTS; ++slot)
+            this->_slots[slot] = static_cast<uint16_t>(N);
+        for (std::size_t index = 0; index < N; ++index){
+            uint16_t& slot = this->_slots[perfectHashKey(this->_keys[index], seed)&(SLOTS-1)];
+            if (slot != N)
+                return false;
+            slot = static_cast<uint16_t>(index);
+        }
+        return true;
+    }
+public:
+    /* Constructor for PerfectHash class, the keys must be distinct */
+    constexpr PerfectHash(const std::string_view (&keys)[N]) : _keys(), _seed(0), _valid(false), _slots(){
+        for (std::size_t index = 0; index < N; ++index)
+            this->_keys[index] = keys[index];
+        for (uint32_t seed = 0; seed < PERFECT_HASH_MAX_SEEDS && !this->_valid; ++seed){
+            this->_valid = this->fill(seed);
+            this->_seed = seed;
+        }
+    }
+
+    /* Method returns true if a seed giving every key its own slot was found */
+    constexpr bool valid(void) const{ return this->_valid; }
+
+    /* Method returns the index of the given key, N if it is not a key */
+    constexpr std::size_t find(std::string_view key) const{
+        const std::size_t index = this->_slots[perfectHashKey(key, this->_seed)&(SLOTS-1)];
+        return index < N && this->_keys[index] == key ? index : N;
+    }
+};
+
+/* Function returns the perfect hash of the keys of the given table, the key of
+* an entry is returned by the given function as a string view.
+*/
+template<typename T, std::size_t N, typename K>
+constexpr PerfectHash<N> makePerfectHash(const T (&table)[N], K key){
+    std::string_view keys[N] = {};
+    for (std::size_t index = 0; index < N; ++index)
+        keys[index] = key(table[index]);
+    return PerfectHash<N>(keys);
+}
+
+}
+
+#endif
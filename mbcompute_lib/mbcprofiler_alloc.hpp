@@ -0,0 +1,71 @@
+/****************************************************************************
+* File name: mbcprofiler_alloc.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  Replacement of the global allocation functions that counts every heap
+*  allocation in the profiler's resource counters.
+*  The replacement belongs to the program, not to a library: include this
+*  header in exactly one source file of an executable that wants its
+*  allocations counted (the benchmarks, or the console built with
+*  -DMBC_COUNT_ALLOCATIONS). Without it the allocation counters stay zero
+*  and allocations cost nothing extra.
+****************************************************************************/
+#ifndef __MB_COMPUTE_PROFILER_ALLOC__
+
+#define __MB_COMPUTE_PROFILER_ALLOC__
+/* Includes */
+#include <new>
+#include <cstdlib>
+
+#include "mbcprofiler_lib.hpp"
+
+/* The replacement pairs malloc with free, GCC flags the pair once operator new is inlined into the caller */
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+/* The array and nothrow forms of operator new forward to this one */
+void* operator new(std::size_t size){
+    mbc::countAllocation(size);
+    if (size == 0)
+        size = 1;
+    /* Retry through the new handler until it frees memory, throws or is removed */
+    for (;;){
+        if (void* ptr = std::malloc(size))
+            return ptr;
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void* ptr) noexcept{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept{
+    std::free(ptr);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+#endif
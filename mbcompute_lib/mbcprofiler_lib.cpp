@@ -0,0 +1,304 @@
+/****************************************************************************
+* File name: mbcprofiler_lib.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine profiler containing implementations for
+*  the per-phase timers, allocation counters, regex counters and the
+*  trace event writer used by the compute engine.
+****************************************************************************/
+
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <iomanip>
+#include <atomic>
+
+#include "mbcprofiler_lib.hpp"
+
+namespace mbc{
+
+/* Running resource counters of each thread */
+static thread_local ResourceCounters thread_counters = {0, 0, 0, 0};
+
+/* Installed allocation hook (if any) */
+static std::atomic<AllocationHook> allocation_hook(nullptr);
+
+/* Set by the first counted allocation */
+static std::atomic<bool> allocations_counted(false);
+
+ResourceCounters& resourceCounters(void){
+    return thread_counters;
+}
+
+void setAllocationHook(AllocationHook hook){
+    allocation_hook.store(hook);
+}
+
+void countAllocation(std::size_t size){
+    ResourceCounters& counters = thread_counters;
+    ++counters.allocs;
+    counters.bytes += size;
+    if (!allocations_counted.load(std::memory_order_relaxed))
+        allocations_counted.store(true, std::memory_order_relaxed);
+    AllocationHook hook = allocation_hook.load(std::memory_order_relaxed);
+    if (hook != nullptr)
+        hook(size);
+}
+
+bool allocationsCounted(void){
+    return allocations_counted.load(std::memory_order_relaxed);
+}
+
+ResourceCounters& ResourceCounters::operator+=(const ResourceCounters& other){
+    this->allocs += other.allocs;
+    this->bytes += other.bytes;
+    this->regex_built += other.regex_built;
+    this->regex_runs += other.regex_runs;
+    return *this;
+}
+
+ResourceCounters operator-(const ResourceCounters& lhs, const ResourceCounters& rhs){
+    return {lhs.allocs-rhs.allocs, lhs.bytes-rhs.bytes, lhs.regex_built-rhs.regex_built, lhs.regex_runs-rhs.regex_runs};
+}
+
+/* Returns a duration in the most readable unit */
+static const std::string format_ns(double ns){
+    std::ostringstream str_stream_obj;
+    str_stream_obj << std::setprecision(3);
+    if (ns < 1e3)
+        str_stream_obj << ns << "ns";
+    else if (ns < 1e6)
+        str_stream_obj << ns/1e3 << "us";
+    else if (ns < 1e9)
+        str_stream_obj << ns/1e6 << "ms";
+    else
+        str_stream_obj << ns/1e9 << "s";
+    return str_stream_obj.str();
+}
+
+/* Returns the string escaped for use in a JSON string */
+static const std::string json_escape(const std::string& str){
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (char ch : str){
+        if (ch == '"' || ch == '\\'){
+            escaped += '\\';
+            escaped += ch;
+        } else if (static_cast<unsigned char>(ch) < 0x20){
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", ch);
+            escaped += code;
+        } else
+            escaped += ch;
+    }
+    return escaped;
+}
+
+/* Size of the trace buffer that triggers a write to the trace file */
+static const std::size_t TRACE_BUFFER_SIZE = 1 << 20;
+
+/* TraceWriter class definitions */
+TraceWriter::TraceWriter(void){
+    this->_first_event = true;
+}
+
+TraceWriter::~TraceWriter(void){
+    this->close();
+}
+
+bool TraceWriter::open(const std::string trace_file){
+    this->close();
+    this->_fout.open(trace_file);
+    if (!this->_fout.good()){
+        this->_fout.close();
+        return false;
+    }
+    this->_buffer.reserve(TRACE_BUFFER_SIZE+4096);
+    this->_buffer = "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    this->_buffer += "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"mbconsole\"}}";
+    this->_first_event = false;
+    this->_origin = std::chrono::steady_clock::now();
+    return true;
+}
+
+void TraceWriter::complete(const std::string& name, const char* category, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point stop, const std::string& detail){
+    if (!this->_fout.is_open())
+        return;
+    /* Timestamps are in microseconds, kept to nanosecond resolution */
+    long long ts = std::chrono::duration_cast<std::chrono::nanoseconds>(start-this->_origin).count();
+    long long dur = std::chrono::duration_cast<std::chrono::nanoseconds>(stop-start).count();
+    char times[96];
+    std::snprintf(times, sizeof(times), "\"ts\": %lld.%03lld, \"dur\": %lld.%03lld", ts/1000, ts%1000, dur/1000, dur%1000);
+    this->_buffer += this->_first_event ? "" : ",\n";
+    this->_buffer += "{\"name\": \"";
+    this->_buffer += json_escape(name);
+    this->_buffer += "\", \"cat\": \"";
+    this->_buffer += category;
+    this->_buffer += "\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, ";
+    this->_buffer += times;
+    if (!detail.empty()){
+        this->_buffer += ", \"args\": {\"detail\": \"";
+        this->_buffer += json_escape(detail);
+        this->_buffer += "\"}";
+    }
+    this->_buffer += "}";
+    this->_first_event = false;
+    if (this->_buffer.size() >= TRACE_BUFFER_SIZE)
+        this->flush();
+}
+
+void TraceWriter::flush(void){
+    if (!this->_fout.is_open())
+        return;
+    this->_fout.write(this->_buffer.data(), this->_buffer.size());
+    this->_fout.flush();
+    this->_buffer.clear();
+}
+
+void TraceWriter::close(void){
+    if (!this->_fout.is_open())
+        return;
+    this->_buffer += "\n]}\n";
+    this->flush();
+    this->_fout.close();
+}
+
+/* PhaseStats definitions */
+void PhaseStats::record(uint64_t ns, const ResourceCounters& used){
+    /* Find the log2 bucket of the measurement */
+    unsigned int bucket = 0;
+    while (bucket < STATS_BUCKETS-1 && (ns >> (bucket+1)) != 0)
+        ++bucket;
+    if (this->count == 0 || ns < this->min_ns)
+        this->min_ns = ns;
+    if (ns > this->max_ns)
+        this->max_ns = ns;
+    ++this->count;
+    this->total_ns += ns;
+    ++this->histogram[bucket];
+    this->resources += used;
+}
+
+/* Profiler class definitions */
+Profiler::Profiler(void){
+    this->_enabled = false;
+    this->_trace = nullptr;
+    this->reset();
+}
+
+Profiler::~Profiler(void){
+}
+
+void Profiler::enable(bool flag){
+    this->_enabled = flag;
+}
+
+void Profiler::reset(void){
+    std::memset(this->_phases, 0, sizeof(this->_phases));
+    this->beginLine();
+}
+
+void Profiler::record(Phase phase, uint64_t ns, const ResourceCounters& used){
+    this->_phases[phase].record(ns, used);
+    this->_line[phase] += used;
+}
+
+void Profiler::beginLine(void){
+    std::memset(this->_line, 0, sizeof(this->_line));
+}
+
+const PhaseStats& Profiler::get(Phase phase) const{
+    return this->_phases[phase];
+}
+
+const ResourceCounters& Profiler::getLine(Phase phase) const{
+    return this->_line[phase];
+}
+
+const std::string Profiler::summary(void) const{
+    std::ostringstream str_stream_obj;
+    str_stream_obj << "-- Engine statistics (profiling " << (this->_enabled ? "enabled" : "disabled") << ") --\n";
+    str_stream_obj << std::left << std::setw(18) << "Phase" << std::right
+        << std::setw(10) << "Count" << std::setw(12) << "Total" << std::setw(12) << "Mean"
+        << std::setw(12) << "Min" << std::setw(12) << "Max" << "\n";
+    for (unsigned int phase = 0; phase < PHASE_COUNT; ++phase){
+        const PhaseStats& stats = this->_phases[phase];
+        str_stream_obj << std::left << std::setw(18) << PHASE_NAMES[phase] << std::right << std::setw(10) << stats.count;
+        if (stats.count == 0){
+            str_stream_obj << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(12) << "-" << "\n";
+            continue;
+        }
+        str_stream_obj << std::setw(12) << format_ns(stats.total_ns)
+            << std::setw(12) << format_ns(static_cast<double>(stats.total_ns)/stats.count)
+            << std::setw(12) << format_ns(stats.min_ns)
+            << std::setw(12) << format_ns(stats.max_ns) << "\n";
+    }
+
+    /* Add the average resources used per measurement of every phase */
+    str_stream_obj << "\n" << std::left << std::setw(18) << "Resources/op" << std::right
+        << std::setw(12) << "Allocs" << std::setw(12) << "Bytes" << std::setw(14) << "Regex built" << std::setw(14) << "Regex runs" << "\n";
+    str_stream_obj << std::fixed << std::setprecision(1);
+    for (unsigned int phase = 0; phase < PHASE_COUNT; ++phase){
+        const PhaseStats& stats = this->_phases[phase];
+        if (stats.count == 0)
+            continue;
+        str_stream_obj << std::left << std::setw(18) << PHASE_NAMES[phase] << std::right
+            << std::setw(12) << static_cast<double>(stats.resources.allocs)/stats.count
+            << std::setw(12) << static_cast<double>(stats.resources.bytes)/stats.count
+            << std::setw(14) << static_cast<double>(stats.resources.regex_built)/stats.count
+            << std::setw(14) << static_cast<double>(stats.resources.regex_runs)/stats.count << "\n";
+    }
+    str_stream_obj.unsetf(std::ios_base::floatfield);
+    if (!allocationsCounted())
+        str_stream_obj << "(allocations are not counted, build with -DMBC_COUNT_ALLOCATIONS to count them)\n";
+
+    /* Add the non empty histogram buckets of every phase */
+    str_stream_obj << "\nLatency histograms (count per [lower, upper) bucket):\n";
+    for (unsigned int phase = 0; phase < PHASE_COUNT; ++phase){
+        const PhaseStats& stats = this->_phases[phase];
+        if (stats.count == 0)
+            continue;
+        str_stream_obj << "   " << PHASE_NAMES[phase] << ":\n";
+        for (unsigned int bucket = 0; bucket < STATS_BUCKETS; ++bucket){
+            if (stats.histogram[bucket] == 0)
+                continue;
+            str_stream_obj << "      [" << format_ns(static_cast<double>(uint64_t(1) << bucket)) << ", ";
+            if (bucket == STATS_BUCKETS-1)
+                str_stream_obj << "inf";
+            else
+                str_stream_obj << format_ns(static_cast<double>(uint64_t(1) << (bucket+1)));
+            str_stream_obj << "): " << stats.histogram[bucket] << "\n";
+        }
+    }
+    return str_stream_obj.str();
+}
+
+const std::string Profiler::lineSummary(void) const{
+    std::ostringstream str_stream_obj;
+    for (unsigned int phase = 0; phase < PHASE_COUNT; ++phase){
+        const ResourceCounters& used = this->_line[phase];
+        if (phase != 0)
+            str_stream_obj << " ";
+        str_stream_obj << PHASE_NAMES[phase] << "{allocs=" << used.allocs << ", bytes=" << used.bytes
+            << ", regex_built=" << used.regex_built << ", regex_runs=" << used.regex_runs << "}";
+    }
+    return str_stream_obj.str();
+}
+
+}
@@ -0,0 +1,294 @@
+/****************************************************************************
+* File name: mbcprofiler_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine profiler header containing declarations for
+*  the per-phase timers, allocation counters, regex counters and the
+*  trace event writer used by the compute engine.
+****************************************************************************/
+#ifndef __MB_COMPUTE_PROFILER_LIB__
+
+#define __MB_COMPUTE_PROFILER_LIB__
+/* Includes */
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <regex>
+
+namespace mbc{
+
+/* Phases of the compute engine that are timed by the profiler */
+enum Phase{
+    /* Engine::load, line normalisation and splitting */
+    PHASE_LOAD,
+    /* Engine::eval, the whole evaluation of the loaded line(s) */
+    PHASE_EVAL,
+    /* Engine::replaceVars */
+    PHASE_REPLACE_VARS,
+    /* Engine::evalFunctions */
+    PHASE_EVAL_FUNCTIONS,
+    /* Evaluator::parseExpr */
+    PHASE_PARSE,
+    /* Evaluator::convertToPostfix */
+    PHASE_POSTFIX,
+    /* Evaluator::evaluatePostfix */
+    PHASE_EVALUATE,
+    /* Number of phases (not a phase) */
+    PHASE_COUNT
+};
+
+/* Printable names of the phases (indexed by Phase) */
+const char* const PHASE_NAMES[PHASE_COUNT] = {
+    "load", "eval", "replaceVars", "evalFunctions", "parseExpr", "convertToPostfix", "evaluatePostfix"
+};
+
+/* Number of log2 buckets in the latency histograms
+* Bucket i counts durations in [2^i, 2^(i+1)) ns, the last bucket is open ended.
+*/
+const unsigned int STATS_BUCKETS = 32;
+
+/* Structure to hold resource usage counters */
+struct ResourceCounters{
+    /* Number of heap allocations */
+    uint64_t allocs;
+    /* Number of bytes requested from the heap */
+    uint64_t bytes;
+    /* Number of std::regex objects constructed */
+    uint64_t regex_built;
+    /* Number of regex match/search/replace operations run */
+    uint64_t regex_runs;
+
+    ResourceCounters& operator+=(const ResourceCounters&);
+};
+
+ResourceCounters operator-(const ResourceCounters&, const ResourceCounters&);
+
+/* Method returns the running resource counters of the calling thread.
+* The allocation counters are updated by countAllocation and the regex
+* counters by the regex helpers below.
+*/
+ResourceCounters& resourceCounters(void);
+
+/* Allocation hook, called with the requested size on every heap allocation.
+* Set to nullptr (default) to disable. The hook must not allocate itself.
+*/
+typedef void (*AllocationHook)(std::size_t);
+void setAllocationHook(AllocationHook);
+
+/* Method counts a heap allocation of the given size in the calling thread's
+* counters and passes it to the allocation hook, it does not allocate.
+* The library does not replace the global allocation functions, programs
+* that want their allocations counted include mbcprofiler_alloc.hpp once
+* which calls this from operator new.
+*/
+void countAllocation(std::size_t);
+
+/* Method returns true once an allocation has been counted */
+bool allocationsCounted(void);
+
+/* Regex helpers
+*  All regex usage in the engine goes through these so that regex
+*  constructions and runs are counted.
+*/
+inline std::regex makeRegex(const std::string& pattern){
+    ++resourceCounters().regex_built;
+    return std::regex(pattern);
+}
+
+template<typename... Args> bool regexMatch(Args&&... args){
+    ++resourceCounters().regex_runs;
+    return std::regex_match(std::forward<Args>(args)...);
+}
+
+template<typename... Args> bool regexSearch(Args&&... args){
+    ++resourceCounters().regex_runs;
+    return std::regex_search(std::forward<Args>(args)...);
+}
+
+template<typename... Args> std::string regexReplace(Args&&... args){
+    ++resourceCounters().regex_runs;
+    return std::regex_replace(std::forward<Args>(args)...);
+}
+
+/* Structure to hold the aggregated statistics of a single phase */
+struct PhaseStats{
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t histogram[STATS_BUCKETS];
+    /* Total resources used over all measurements */
+    ResourceCounters resources;
+
+    /* Add a single measurement */
+    void record(uint64_t, const ResourceCounters&);
+};
+
+/* TraceWriter class to write Chrome/Perfetto trace events
+*  Spans are written as complete ("X") events to a JSON file in the
+*  trace event format, events are buffered in memory and written out in
+*  large blocks so tracing does not distort the measured timings much.
+*  Reference link: https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+*/
+class TraceWriter{
+private:
+    std::ofstream _fout;
+    std::string _buffer;
+    bool _first_event;
+    std::chrono::steady_clock::time_point _origin;
+public:
+    /* Constructor for TraceWriter class (no file is open) */
+    TraceWriter(void);
+
+    /* Destructor for TraceWriter class, closes the trace file if open */
+    ~TraceWriter(void);
+
+    /* Method to open the given trace file, returns false on failure */
+    bool open(const std::string);
+
+    /* Method returns true if a trace file is open */
+    bool isOpen(void) const{ return this->_fout.is_open(); }
+
+    /* Method to add a complete event with the given name, category, start time and duration
+    * The optional detail string is added as the `detail` argument of the event.
+    */
+    void complete(const std::string&, const char*, std::chrono::steady_clock::time_point, std::chrono::steady_clock::time_point, const std::string& = "");
+
+    /* Method writes all buffered events to the trace file */
+    void flush(void);
+
+    /* Method writes the remaining events and closes the trace file */
+    void close(void);
+};
+
+/* Profiler class to aggregate the time spent in each engine phase
+*  Timers are always compiled in but only read the clock when the
+*  profiler is enabled or a trace is attached, otherwise the cost is a
+*  single branch.
+*/
+class Profiler{
+private:
+    bool _enabled;
+    TraceWriter* _trace;
+    PhaseStats _phases[PHASE_COUNT];
+    /* Resources used by each phase of the current/last line */
+    ResourceCounters _line[PHASE_COUNT];
+public:
+    /* Constructor for Profiler class (profiling starts disabled) */
+    Profiler(void);
+
+    /* Destructor for Profiler class */
+    ~Profiler(void);
+
+    /* Method to enable or disable profiling, collected statistics are kept */
+    void enable(bool);
+
+    /* Method returns true if profiling is enabled */
+    bool enabled(void) const{ return this->_enabled; }
+
+    /* Method to attach a trace writer (nullptr to detach), the writer is not owned */
+    void setTrace(TraceWriter* trace){ this->_trace = trace; }
+
+    /* Method returns the attached trace writer or nullptr */
+    TraceWriter* trace(void) const{ return this->_trace; }
+
+    /* Method clears all collected statistics */
+    void reset(void);
+
+    /* Method adds a measurement to the given phase */
+    void record(Phase, uint64_t, const ResourceCounters&);
+
+    /* Method clears the per-line counters, called when a new line is loaded */
+    void beginLine(void);
+
+    /* Method returns the statistics of the given phase */
+    const PhaseStats& get(Phase) const;
+
+    /* Method returns the resources used by the given phase of the current/last line */
+    const ResourceCounters& getLine(Phase) const;
+
+    /* Method returns a printable summary of all phases */
+    const std::string summary(void) const;
+
+    /* Method returns a single line summary of the resources used by the current/last line */
+    const std::string lineSummary(void) const;
+};
+
+/* Scoped timer for a single phase
+*  The elapsed time between construction and destruction is recorded
+*  to the given profiler if it was enabled at construction and written
+*  as a trace span if a trace was attached at construction.
+*/
+class PhaseTimer{
+private:
+    Profiler& _profiler;
+    Phase _phase;
+    bool _active;
+    TraceWriter* _trace;
+    std::chrono::steady_clock::time_point _start;
+    ResourceCounters _start_resources;
+public:
+    PhaseTimer(Profiler& profiler, Phase phase) : _profiler(profiler), _phase(phase), _active(profiler.enabled()), _trace(profiler.trace()){
+        if (this->_active)
+            this->_start_resources = resourceCounters();
+        if (this->_active || this->_trace != nullptr)
+            this->_start = std::chrono::steady_clock::now();
+    }
+    ~PhaseTimer(void){
+        if (!this->_active && this->_trace == nullptr)
+            return;
+        std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+        if (this->_active)
+            this->_profiler.record(this->_phase, std::chrono::duration_cast<std::chrono::nanoseconds>(stop-this->_start).count(), resourceCounters()-this->_start_resources);
+        if (this->_trace != nullptr)
+            this->_trace->complete(PHASE_NAMES[this->_phase], "phase", this->_start, stop);
+    }
+};
+
+/* Scoped trace span
+*  Writes a span with the given name and detail covering its lifetime to
+*  the trace attached to the profiler (if any), nothing is done otherwise.
+*  The name is held by reference and must outlive the span.
+*/
+class TraceSpan{
+private:
+    TraceWriter* _trace;
+    const std::string& _name;
+    const char* _category;
+    std::string _detail;
+    std::chrono::steady_clock::time_point _start;
+public:
+    TraceSpan(Profiler& profiler, const std::string& name, const char* category) : _trace(profiler.trace()), _name(name), _category(category){
+        if (this->_trace != nullptr)
+            this->_start = std::chrono::steady_clock::now();
+    }
+    ~TraceSpan(void){
+        if (this->_trace != nullptr)
+            this->_trace->complete(this->_name, this->_category, this->_start, std::chrono::steady_clock::now(), this->_detail);
+    }
+    /* Method returns true if the span is written, use to skip building details otherwise */
+    bool active(void) const{ return this->_trace != nullptr; }
+    /* Method to set the detail string of the span */
+    void setDetail(const std::string& detail){ this->_detail = detail; }
+};
+
+}
+
+#endif
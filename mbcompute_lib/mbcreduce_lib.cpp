@@ -0,0 +1,461 @@
+/****************************************************************************
+* File name: mbcreduce_lib.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine reduction library containing implementations for
+*  the summation, numerical integration and grid sweeps of compiled programs.
+****************************************************************************/
+
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include <functional>
+
+#include "mbcreduce_lib.hpp"
+#include "mbcjit_lib.hpp"
+#include "mbcsimd_lib.hpp"
+#include "mbcthreads_lib.hpp"
+
+#ifdef MBC_THREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace mbc{
+
+static std::atomic<unsigned int> reduce_threads(0);
+
+unsigned int getReduceThreads(void){
+    return reduce_threads.load(std::memory_order_relaxed);
+}
+
+void setReduceThreads(unsigned int threads){
+    reduce_threads.store(threads, std::memory_order_relaxed);
+}
+
+/* Returns the sum of the values added pairwise (the order only depends on the count) */
+static double pairwise_sum(const double* values, std::size_t count){
+    if (count == 0)
+        return 0;
+    if (count == 1)
+        return values[0];
+    const std::size_t half = count/2;
+    return pairwise_sum(values, half)+pairwise_sum(values+half, count-half);
+}
+
+/* Adds the value to the sum (Neumaier's compensated summation) */
+static void accumulate(double& sum, double& compensation, double value){
+    double total = sum+value;
+    if (std::abs(sum) >= std::abs(value))
+        compensation += (sum-total)+value;
+    else
+        compensation += (value-total)+sum;
+    sum = total;
+}
+
+/* Returns the compensated sum, the compensation of a sum that overflowed is not a number (inf-inf) and is left out */
+static double compensated_sum(double sum, double compensation){
+    return std::isfinite(sum) ? sum+compensation : sum;
+}
+
+/* Returns a copy of the program compiled to native code once (the copies made from it share the native code) */
+static Program prepare_program(const Program& program){
+    Program base = program;
+    if (getJitThreshold() != 0)
+        base.jit();
+    return base;
+}
+
+/* Returns the number of threads to run the given number of blocks on */
+static unsigned int get_thread_count(std::size_t block_count){
+#ifdef MBC_THREADS
+    unsigned int thread_count = getReduceThreads();
+    if (thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+#else
+    /* No threads, every block runs on the calling thread */
+    unsigned int thread_count = 1;
+#endif
+    if (thread_count > block_count)
+        thread_count = static_cast<unsigned int>(block_count);
+    return thread_count;
+}
+
+/* Runs the block function for the blocks [first, first+count) on the reduction threads
+* Every thread gets its own copy of the program as running a program writes its registers.
+*/
+static void run_parallel(const Program& base, std::size_t first, std::size_t count, const std::function<void(Program&, std::size_t)>& block){
+    unsigned int thread_count = get_thread_count(count);
+    if (thread_count <= 1){
+        Program local = base;
+        for (std::size_t index = first; index < first+count; ++index)
+            block(local, index);
+        return;
+    }
+
+#ifdef MBC_THREADS
+    /* The threads take the next block until none are left */
+    std::atomic<std::size_t> next_block(first);
+    auto worker = [&next_block, &block, &base, first, count](void){
+        Program local = base;
+        for (std::size_t index = next_block++; index < first+count; index = next_block++)
+            block(local, index);
+    };
+    std::vector<std::thread> threads;
+    for (unsigned int index = 1; index < thread_count; ++index)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread& thread : threads)
+        thread.join();
+#endif
+}
+
+/* Runs the produce function for the blocks [0, block_count) on the reduction threads and passes every
+* block to the consume function in order on the calling thread. The threads live for the whole run,
+* a block is produced into the slot `block index % slot_count` once the consumer is done with the
+* block before it in that slot, so at most slot_count blocks are held ahead of the consumer.
+* Both functions are given the block index and its slot.
+*/
+static void run_ordered(const Program& base, std::size_t block_count, std::size_t slot_count,
+    const std::function<void(Program&, std::size_t, std::size_t)>& produce, const std::function<void(std::size_t, std::size_t)>& consume){
+    unsigned int thread_count = get_thread_count(block_count);
+    if (thread_count <= 1 || slot_count <= 1){
+        Program local = base;
+        for (std::size_t index = 0; index < block_count; ++index){
+            produce(local, index, index%slot_count);
+            consume(index, index%slot_count);
+        }
+        return;
+    }
+
+#ifdef MBC_THREADS
+    std::mutex lock;
+    std::condition_variable produced;
+    std::condition_variable consumed;
+    /* Next block to produce, number of blocks consumed and the slots holding a produced block (guarded by the lock) */
+    std::size_t next_block = 0;
+    std::size_t consumed_count = 0;
+    std::vector<char> ready(slot_count, 0);
+    auto worker = [&](void){
+        Program local = base;
+        while (true){
+            std::size_t index;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                consumed.wait(guard, [&]{ return next_block >= block_count || next_block < consumed_count+slot_count; });
+                if (next_block >= block_count)
+                    return;
+                index = next_block++;
+            }
+            produce(local, index, index%slot_count);
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                ready[index%slot_count] = 1;
+            }
+            produced.notify_one();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned int index = 0; index < thread_count; ++index)
+        threads.emplace_back(worker);
+    for (std::size_t index = 0; index < block_count; ++index){
+        const std::size_t slot = index%slot_count;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            produced.wait(guard, [&]{ return ready[slot] != 0; });
+        }
+        consume(index, slot);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            ready[slot] = 0;
+            ++consumed_count;
+        }
+        consumed.notify_all();
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+#endif
+}
+
+/* PairwiseStack class adding values pairwise as they come in (in order), only one partial
+* sum per power of two is kept. The order of the additions only depends on the number of values.
+*/
+class PairwiseStack{
+private:
+    /* Partial sums and the number of values added in each */
+    std::vector<std::pair<double, std::size_t>> _sums;
+public:
+    /* Method adds the next value */
+    void push(double value){
+        std::pair<double, std::size_t> partial(value, 1);
+        while (!this->_sums.empty() && this->_sums.back().second == partial.second){
+            partial = {this->_sums.back().first+partial.first, 2*partial.second};
+            this->_sums.pop_back();
+        }
+        this->_sums.push_back(partial);
+    }
+
+    /* Method returns the sum of the values added so far */
+    double sum(void) const{
+        double total = 0;
+        for (auto it = this->_sums.crbegin(); it != this->_sums.crend(); ++it)
+            total = it->first+total;
+        return total;
+    }
+};
+
+/* Runs the block function for every block and returns the block results */
+static std::vector<double> run_blocks(const Program& program, std::size_t block_count, const std::function<double(Program&, std::size_t)>& block){
+    std::vector<double> results(block_count, 0.0);
+    run_parallel(prepare_program(program), 0, block_count, [&results, &block](Program& local, std::size_t index){
+        results[index] = block(local, index);
+    });
+    return results;
+}
+
+/* Runs the block function for every block and returns the block results added pairwise
+* At most REDUCE_WINDOW_BLOCKS results are held so the memory does not depend on the number of blocks.
+*/
+static double sum_blocks(const Program& program, std::size_t block_count, const std::function<double(Program&, std::size_t)>& block){
+    std::vector<double> results(std::min(block_count, REDUCE_WINDOW_BLOCKS), 0.0);
+    PairwiseStack sums;
+    run_ordered(prepare_program(program), block_count, results.size(), [&results, &block](Program& local, std::size_t index, std::size_t slot){
+        results[slot] = block(local, index);
+    }, [&results, &sums](std::size_t, std::size_t slot){
+        sums.push(results[slot]);
+    });
+    return sums.sum();
+}
+
+double reduceSum(const Program& program, double first, double last){
+    if (!(last >= first))
+        return 0;
+    const double count = std::floor(last-first)+1;
+    if (!(count <= REDUCE_MAX_TERMS))
+        return NAN;
+    const std::size_t block_count = static_cast<std::size_t>(std::ceil(count/REDUCE_BLOCK_SIZE));
+    return sum_blocks(program, block_count, [first, count](Program& local, std::size_t block_index){
+        double sum = 0;
+        double compensation = 0;
+        const double start = static_cast<double>(block_index*REDUCE_BLOCK_SIZE);
+        const double end = std::min(count, start+REDUCE_BLOCK_SIZE);
+        for (double offset = start; offset < end; ++offset){
+            double input = first+offset;
+            accumulate(sum, compensation, local.run(&input));
+        }
+        return compensated_sum(sum, compensation);
+    });
+}
+
+#if MBC_SIMD
+/* Adds the values to the sums of the lanes (compensated summation per lane) */
+static void simd_accumulate(SimdDouble& sum, SimdDouble& compensation, SimdDouble value){
+    const SimdDouble total = sum+value;
+    compensation += simdAbs(sum) >= simdAbs(value) ? (sum-total)+value : (value-total)+sum;
+    sum = total;
+}
+
+/* Adds the lanes of the compensated sums to the given sum in order */
+static void simd_accumulate_lanes(double& sum, double& compensation, SimdDouble lane_sum, SimdDouble lane_compensation){
+    for (std::size_t lane = 0; lane < SIMD_LANES; ++lane){
+        accumulate(sum, compensation, lane_sum[lane]);
+        if (std::isfinite(lane_sum[lane]))
+            compensation += lane_compensation[lane];
+    }
+}
+#endif
+
+double vectorSum(const double* values, std::size_t count){
+    double sum = 0;
+    double compensation = 0;
+    std::size_t index = 0;
+#if MBC_SIMD
+    SimdDouble lane_sum{};
+    SimdDouble lane_compensation{};
+    for (; index+SIMD_LANES <= count; index += SIMD_LANES)
+        simd_accumulate(lane_sum, lane_compensation, *reinterpret_cast<const SimdDouble*>(values+index));
+    simd_accumulate_lanes(sum, compensation, lane_sum, lane_compensation);
+#endif
+    for (; index < count; ++index)
+        accumulate(sum, compensation, values[index]);
+    return compensated_sum(sum, compensation);
+}
+
+double vectorDot(const double* lhs, const double* rhs, std::size_t count){
+    double sum = 0;
+    double compensation = 0;
+    std::size_t index = 0;
+#if MBC_SIMD
+    SimdDouble lane_sum{};
+    SimdDouble lane_compensation{};
+    for (; index+SIMD_LANES <= count; index += SIMD_LANES)
+        simd_accumulate(lane_sum, lane_compensation, *reinterpret_cast<const SimdDouble*>(lhs+index)**reinterpret_cast<const SimdDouble*>(rhs+index));
+    simd_accumulate_lanes(sum, compensation, lane_sum, lane_compensation);
+#endif
+    for (; index < count; ++index)
+        accumulate(sum, compensation, lhs[index]*rhs[index]);
+    return compensated_sum(sum, compensation);
+}
+
+/* Returns the minimum (or the maximum) of the values, NaN if a value is NaN or if there are none */
+template<bool maximum>
+static double vector_extremum(const double* values, std::size_t count){
+    if (count == 0)
+        return NAN;
+    double extremum = values[0];
+    bool flag_nan = false;
+    std::size_t index = 0;
+#if MBC_SIMD
+    if (count >= SIMD_LANES){
+        SimdDouble lane_extremum = *reinterpret_cast<const SimdDouble*>(values);
+        SimdMask lane_nan{};
+        for (; index+SIMD_LANES <= count; index += SIMD_LANES){
+            const SimdDouble value = *reinterpret_cast<const SimdDouble*>(values+index);
+            lane_extremum = (maximum ? value > lane_extremum : value < lane_extremum) ? value : lane_extremum;
+            lane_nan |= value != value;
+        }
+        for (std::size_t lane = 0; lane < SIMD_LANES; ++lane){
+            extremum = (maximum ? lane_extremum[lane] > extremum : lane_extremum[lane] < extremum) ? lane_extremum[lane] : extremum;
+            flag_nan = flag_nan || lane_nan[lane] != 0;
+        }
+    }
+#endif
+    for (; index < count; ++index){
+        extremum = (maximum ? values[index] > extremum : values[index] < extremum) ? values[index] : extremum;
+        flag_nan = flag_nan || std::isnan(values[index]);
+    }
+    return flag_nan ? NAN : extremum;
+}
+
+double vectorMin(const double* values, std::size_t count){
+    return vector_extremum<false>(values, count);
+}
+
+double vectorMax(const double* values, std::size_t count){
+    return vector_extremum<true>(values, count);
+}
+
+/* Gauss-Kronrod 7/15 point rule on [a, b], returns the Kronrod estimate and stores the error estimate */
+static double gauss_kronrod(Program& program, double a, double b, double& error){
+    static const double nodes[8] = {
+        0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+        0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+        0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+        0.207784955007898467600689403773245, 0.000000000000000000000000000000000};
+    static const double kronrod_weights[8] = {
+        0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+        0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+        0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+        0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+    /* Gauss weights of the odd nodes (1, 3, 5 and the centre) */
+    static const double gauss_weights[4] = {
+        0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+        0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+    const double centre = (a+b)/2;
+    const double half = (b-a)/2;
+    double input = centre;
+    const double centre_value = program.run(&input);
+    double kronrod = kronrod_weights[7]*centre_value;
+    double gauss = gauss_weights[3]*centre_value;
+    for (unsigned int index = 0; index < 7; ++index){
+        input = centre-half*nodes[index];
+        double value = program.run(&input);
+        input = centre+half*nodes[index];
+        value += program.run(&input);
+        kronrod += kronrod_weights[index]*value;
+        if (index%2 == 1)
+            gauss += gauss_weights[index/2]*value;
+    }
+    error = std::abs((kronrod-gauss)*half);
+    return kronrod*half;
+}
+
+/* Integrates [a, b] bisecting it until the error estimate is within the tolerance */
+static double adaptive_integral(Program& program, double a, double b, double tolerance, unsigned int depth, bool& converged){
+    double error;
+    double estimate = gauss_kronrod(program, a, b, error);
+    if (error <= tolerance || !std::isfinite(estimate))
+        return estimate;
+    if (depth >= INTEGRATE_MAX_DEPTH){
+        converged = false;
+        return estimate;
+    }
+    const double middle = (a+b)/2;
+    return adaptive_integral(program, a, middle, tolerance/2, depth+1, converged)
+        +adaptive_integral(program, middle, b, tolerance/2, depth+1, converged);
+}
+
+double reduceIntegral(const Program& program, double a, double b, bool& converged){
+    converged = true;
+    if (a == b)
+        return 0;
+    /* A first estimate of every panel sets the absolute tolerance */
+    const double width = (b-a)/INTEGRATE_PANELS;
+    std::vector<double> estimates = run_blocks(program, INTEGRATE_PANELS, [a, width](Program& local, std::size_t panel){
+        double error;
+        return gauss_kronrod(local, a+width*panel, a+width*(panel+1), error);
+    });
+    double magnitude = 0;
+    for (double estimate : estimates)
+        magnitude += std::abs(estimate);
+    const double tolerance = std::max(INTEGRATE_TOLERANCE*magnitude, 1E-300)/INTEGRATE_PANELS;
+
+    std::vector<char> panel_converged(INTEGRATE_PANELS, 1);
+    std::vector<double> results = run_blocks(program, INTEGRATE_PANELS, [a, b, width, tolerance, &panel_converged](Program& local, std::size_t panel){
+        bool flag_converged = true;
+        /* The last panel ends exactly at b */
+        double value = adaptive_integral(local, a+width*panel, panel+1 == INTEGRATE_PANELS ? b : a+width*(panel+1), tolerance, 0, flag_converged);
+        panel_converged[panel] = flag_converged;
+        return value;
+    });
+    for (char flag_converged : panel_converged)
+        converged = converged && flag_converged;
+    return pairwise_sum(results.data(), results.size());
+}
+
+void sweepGrid(const Program& program, const std::vector<SweepAxis>& axes, const std::function<void(const double*, std::size_t)>& sink){
+    std::size_t row_count = 1;
+    for (const SweepAxis& axis : axes)
+        row_count *= axis.count;
+    const std::size_t columns = axes.size()+1;
+    const std::size_t block_count = (row_count+SWEEP_BLOCK_ROWS-1)/SWEEP_BLOCK_ROWS;
+
+    /* Blocks are evaluated into two buffers per thread and passed on in order */
+    std::vector<std::vector<double>> buffers(2*static_cast<std::size_t>(get_thread_count(block_count)));
+    run_ordered(prepare_program(program), block_count, buffers.size(), [&](Program& local, std::size_t block_index, std::size_t slot){
+        std::vector<double>& rows = buffers[slot];
+        const std::size_t start = block_index*SWEEP_BLOCK_ROWS;
+        const std::size_t end = std::min(row_count, start+SWEEP_BLOCK_ROWS);
+        rows.resize((end-start)*columns);
+        double* row = rows.data();
+        for (std::size_t index = start; index < end; ++index, row += columns){
+            /* The last axis varies fastest, coordinates are computed from the index (no accumulated error) */
+            std::size_t rest = index;
+            for (std::size_t axis = axes.size(); axis-- > 0;){
+                row[axis] = axes[axis].start+static_cast<double>(rest%axes[axis].count)*axes[axis].step;
+                rest /= axes[axis].count;
+            }
+            row[axes.size()] = local.run(row);
+        }
+    }, [&buffers, &sink, columns](std::size_t, std::size_t slot){
+        sink(buffers[slot].data(), buffers[slot].size()/columns);
+    });
+}
+
+}
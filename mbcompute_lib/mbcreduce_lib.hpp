@@ -0,0 +1,109 @@
+/****************************************************************************
+* File name: mbcreduce_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine reduction header containing declarations for the
+*  summation, numerical integration and grid sweeps of compiled programs.
+*
+*  The work is split into blocks whose size does not depend on the number
+*  of threads, each block is reduced in order (compensated summation) and
+*  the block results are added pairwise in order. The results are the same
+*  for every thread count.
+****************************************************************************/
+#ifndef __MB_COMPUTE_REDUCE_LIB__
+
+#define __MB_COMPUTE_REDUCE_LIB__
+/* Includes */
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <functional>
+
+/* Custom libraries */
+#include "mbcvm_lib.hpp"
+
+namespace mbc{
+
+/* Number of terms summed by one block of a summation */
+const std::size_t REDUCE_BLOCK_SIZE = 65536;
+
+/* Maximum number of terms of a summation (2^53, every index up to it is exact in a double) */
+const double REDUCE_MAX_TERMS = 9007199254740992.0;
+
+/* Number of block results of a summation held at once, the results are added in order as they come in */
+const std::size_t REDUCE_WINDOW_BLOCKS = 256;
+
+/* Number of panels an integration interval is split into (one block per panel) */
+const std::size_t INTEGRATE_PANELS = 64;
+
+/* Maximum number of bisections of a panel by the adaptive quadrature */
+const unsigned int INTEGRATE_MAX_DEPTH = 40;
+
+/* Relative tolerance of numerical integration */
+const double INTEGRATE_TOLERANCE = 1E-10;
+
+/* Number of rows evaluated by one block of a sweep */
+const std::size_t SWEEP_BLOCK_ROWS = 4096;
+
+/* Structure to hold an axis of a sweep (start, start+step, ... count values) */
+struct SweepAxis{
+    std::string name;
+    double start;
+    double step;
+    std::size_t count;
+};
+
+/* Methods to get and set the number of threads used by the reductions,
+* 0 (the default) uses one thread per core.
+*/
+unsigned int getReduceThreads(void);
+void setReduceThreads(unsigned int);
+
+/* Method returns the sum of the program (which takes one input) over the
+* inputs first, first+1, ... up to last. Returns 0 if last is less than first
+* and NaN if there are more than REDUCE_MAX_TERMS terms.
+*/
+double reduceSum(const Program&, double, double);
+
+/* Methods return the sum (compensated summation), the minimum and the maximum of the given
+* number of values and the dot product of two arrays of the given size. The values are
+* processed SIMD_LANES at a time (see mbcsimd_lib.hpp). The minimum and the maximum are NaN
+* if a value is NaN or if there are no values.
+*/
+double vectorSum(const double*, std::size_t);
+double vectorMin(const double*, std::size_t);
+double vectorMax(const double*, std::size_t);
+double vectorDot(const double*, const double*, std::size_t);
+
+/* Method returns the integral of the program (which takes one input) over
+* [a, b] using adaptive Gauss-Kronrod (7/15 point) quadrature. The last
+* argument is set to false if a panel did not reach the tolerance.
+*/
+double reduceIntegral(const Program&, double, double, bool&);
+
+/* Method evaluates the program (which takes one input per axis) at every point of
+* the grid of the axes, the last axis varies fastest. The rows (the coordinates
+* followed by the value) are passed to the sink in grid order in blocks of at most
+* SWEEP_BLOCK_ROWS rows on the calling thread, only two blocks per thread are held in
+* memory. The threads are started once per sweep.
+*/
+void sweepGrid(const Program&, const std::vector<SweepAxis>&, const std::function<void(const double*, std::size_t)>&);
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+/****************************************************************************
+* File name: mbcsimd_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine SIMD header (header only) containing the vector
+*  type of the element-wise kernels (see BasicProgram::map and the vector
+*  reductions of mbcreduce_lib.hpp).
+*
+*  With GCC and Clang SimdDouble is a vector extension type of SIMD_LANES
+*  doubles, the compiler emits the SIMD instructions of the target (SSE2 on
+*  a baseline x86-64 build, AVX with -mavx, NEON on AArch64) whatever the
+*  optimisation level. Define MBC_NO_SIMD to use the scalar kernels.
+****************************************************************************/
+#ifndef __MB_COMPUTE_SIMD_LIB__
+
+#define __MB_COMPUTE_SIMD_LIB__
+/* Includes */
+#include <cstddef>
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(MBC_NO_SIMD)
+#define MBC_SIMD 1
+#else
+#define MBC_SIMD 0
+#endif
+
+namespace mbc{
+
+/* Number of doubles processed together by the SIMD kernels (the width of the SIMD registers
+* of the target so the vectors are passed in registers)
+*/
+#if defined(__AVX__)
+const std::size_t SIMD_LANES = 4;
+#else
+const std::size_t SIMD_LANES = 2;
+#endif
+
+#if MBC_SIMD
+/* SIMD vectors of doubles and of the masks of their comparisons.
+* They may be loaded from and stored to any address of a double.
+*/
+typedef double SimdDouble __attribute__((vector_size(SIMD_LANES*sizeof(double)), aligned(alignof(double)), __may_alias__));
+typedef int64_t SimdMask __attribute__((vector_size(SIMD_LANES*sizeof(int64_t)), aligned(alignof(double)), __may_alias__));
+
+/* Function returns a vector with every lane set to the given value */
+inline SimdDouble simdBroadcast(double value){
+    return SimdDouble{} + value;
+}
+
+/* Function returns the absolute values (the sign bits are cleared, vector casts reinterpret the bits) */
+inline SimdDouble simdAbs(SimdDouble value){
+    return (SimdDouble)((SimdMask)value & (SimdMask{}+INT64_MAX));
+}
+
+/* Function returns 1 in the lanes where the mask is set and 0 in the others */
+inline SimdDouble simdSelectOne(SimdMask mask){
+    return __builtin_convertvector(-mask, SimdDouble);
+}
+
+/* Function returns the lanes of the first vector where the mask is set and of the second in the others */
+inline SimdDouble simdSelect(SimdMask mask, SimdDouble first, SimdDouble second){
+    return (SimdDouble)(((SimdMask)first & mask) | ((SimdMask)second & ~mask));
+}
+#endif
+
+}
+
+#endif
@@ -0,0 +1,222 @@
+/****************************************************************************
+* File name: mbcsnapshot_lib.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine snapshot library containing implementations for
+*  the binary snapshot files of engine sessions.
+****************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define MBC_SNAPSHOT_MMAP
+#endif
+
+#include "mbcsnapshot_lib.hpp"
+
+namespace mbc{
+
+uint64_t snapshotChecksum(const char* data, std::size_t size){
+    uint64_t hash = 14695981039346656037ull;
+    for (std::size_t index = 0; index < size; ++index){
+        hash ^= static_cast<uint8_t>(data[index]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/* SnapshotWriter class definitions */
+SnapshotWriter::SnapshotWriter(void){
+    this->writeBytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    this->writeU32(SNAPSHOT_VERSION);
+    this->writeU32(SNAPSHOT_BYTE_ORDER);
+}
+
+void SnapshotWriter::writeU8(uint8_t value){
+    this->writeBytes(&value, sizeof(value));
+}
+
+void SnapshotWriter::writeU32(uint32_t value){
+    this->writeBytes(&value, sizeof(value));
+}
+
+void SnapshotWriter::writeU64(uint64_t value){
+    this->writeBytes(&value, sizeof(value));
+}
+
+void SnapshotWriter::writeDouble(double value){
+    this->writeBytes(&value, sizeof(value));
+}
+
+void SnapshotWriter::writeString(const std::string& value){
+    this->writeU32(static_cast<uint32_t>(value.size()));
+    this->writeBytes(value.data(), value.size());
+}
+
+void SnapshotWriter::writeBytes(const void* data, std::size_t size){
+    this->_buffer.append(static_cast<const char*>(data), size);
+}
+
+bool SnapshotWriter::save(const std::string& file_name) const{
+    /* Write a temporary file first so a failed save keeps the old snapshot */
+    const std::string temp_name = file_name+".tmp";
+    {
+        std::ofstream fout(temp_name, std::ios::binary | std::ios::trunc);
+        if (!fout.good())
+            return false;
+        const uint64_t checksum = snapshotChecksum(this->_buffer.data(), this->_buffer.size());
+        fout.write(this->_buffer.data(), static_cast<std::streamsize>(this->_buffer.size()));
+        fout.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+        if (!fout.good()){
+            fout.close();
+            std::remove(temp_name.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp_name.c_str(), file_name.c_str()) != 0){
+        std::remove(temp_name.c_str());
+        return false;
+    }
+    return true;
+}
+
+/* SnapshotReader class definitions */
+SnapshotReader::SnapshotReader(void) : _data(nullptr), _size(0), _pos(0), _mapping(nullptr), _mapping_size(0){
+}
+
+SnapshotReader::~SnapshotReader(void){
+    this->close();
+}
+
+void SnapshotReader::close(void){
+#ifdef MBC_SNAPSHOT_MMAP
+    if (this->_mapping != nullptr)
+        munmap(this->_mapping, this->_mapping_size);
+#endif
+    this->_mapping = nullptr;
+    this->_contents.clear();
+    this->_data = nullptr;
+    this->_size = 0;
+    this->_pos = 0;
+}
+
+bool SnapshotReader::open(const std::string& file_name){
+    this->close();
+    this->_error_message.clear();
+#ifdef MBC_SNAPSHOT_MMAP
+    int fd = ::open(file_name.c_str(), O_RDONLY);
+    if (fd < 0){
+        this->_error_message = "The snapshot file `"+file_name+"` could not be opened";
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0){
+        void* mapping = mmap(nullptr, static_cast<std::size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED){
+            this->_mapping = mapping;
+            this->_data = static_cast<const char*>(mapping);
+            this->_size = static_cast<std::size_t>(file_stat.st_size);
+        }
+    }
+    ::close(fd);
+#endif
+    /* Read the whole file if it could not be mapped */
+    if (this->_data == nullptr){
+        std::ifstream fin(file_name, std::ios::binary);
+        if (!fin.good()){
+            this->_error_message = "The snapshot file `"+file_name+"` could not be opened";
+            return false;
+        }
+        this->_contents.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+        this->_data = this->_contents.data();
+        this->_size = this->_contents.size();
+    }
+
+    /* Check the header */
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    uint32_t version;
+    uint32_t byte_order;
+    if (!this->readBytes(magic, sizeof(magic)) || std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0
+        || !this->readU32(version) || !this->readU32(byte_order)){
+        this->_error_message = "The file `"+file_name+"` is not a snapshot";
+        this->close();
+        return false;
+    }
+    if (version != SNAPSHOT_VERSION || byte_order != SNAPSHOT_BYTE_ORDER){
+        this->_error_message = "The snapshot `"+file_name+"` was written by an incompatible version or machine";
+        this->close();
+        return false;
+    }
+    /* The checksum is not a record, nothing is read before it has been checked */
+    uint64_t checksum;
+    if (this->remaining() < sizeof(checksum)){
+        this->_error_message = "The snapshot `"+file_name+"` is corrupt";
+        this->close();
+        return false;
+    }
+    std::memcpy(&checksum, this->_data+this->_size-sizeof(checksum), sizeof(checksum));
+    if (checksum != snapshotChecksum(this->_data, this->_size-sizeof(checksum))){
+        this->_error_message = "The snapshot `"+file_name+"` is corrupt";
+        this->close();
+        return false;
+    }
+    this->_size -= sizeof(checksum);
+    return true;
+}
+
+bool SnapshotReader::readU8(uint8_t& value){
+    return this->readBytes(&value, sizeof(value));
+}
+
+bool SnapshotReader::readU32(uint32_t& value){
+    return this->readBytes(&value, sizeof(value));
+}
+
+bool SnapshotReader::readU64(uint64_t& value){
+    return this->readBytes(&value, sizeof(value));
+}
+
+bool SnapshotReader::readDouble(double& value){
+    return this->readBytes(&value, sizeof(value));
+}
+
+bool SnapshotReader::readString(std::string& value){
+    uint32_t size;
+    if (!this->readU32(size) || size > this->remaining())
+        return false;
+    value.assign(this->_data+this->_pos, size);
+    this->_pos += size;
+    return true;
+}
+
+bool SnapshotReader::readBytes(void* data, std::size_t size){
+    if (size > this->remaining())
+        return false;
+    std::memcpy(data, this->_data+this->_pos, size);
+    this->_pos += size;
+    return true;
+}
+
+}
@@ -0,0 +1,129 @@
+/****************************************************************************
+* File name: mbcsnapshot_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine snapshot header containing declarations for the
+*  binary snapshot files of engine sessions (see Engine::saveSnapshot).
+*
+*  A snapshot starts with a header (magic, format version and byte order
+*  mark) followed by the records written by the engine. Numbers are stored
+*  in the byte order of the machine that wrote the file (the byte order
+*  mark rejects files of the other order) and strings are stored as their
+*  length followed by their bytes, nothing in the file has to be parsed.
+*  The file ends with a checksum of everything before it, a snapshot is
+*  only read once its checksum matches. Snapshots are read from a memory
+*  mapping of the file where supported.
+****************************************************************************/
+#ifndef __MB_COMPUTE_SNAPSHOT_LIB__
+
+#define __MB_COMPUTE_SNAPSHOT_LIB__
+/* Includes */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mbc{
+
+/* Magic bytes at the start of every snapshot */
+const char SNAPSHOT_MAGIC[8] = {'M', 'B', 'C', 'S', 'N', 'A', 'P', '\0'};
+
+/* Version of the snapshot format, files of other versions are rejected */
+const uint32_t SNAPSHOT_VERSION = 2;
+
+/* Byte order mark (read back swapped on a machine of the other byte order) */
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+/* Function returns the checksum of the given bytes (64 bit FNV-1a) */
+uint64_t snapshotChecksum(const char*, std::size_t);
+
+/* SnapshotWriter class collecting the records of a snapshot in memory */
+class SnapshotWriter{
+private:
+    std::string _buffer;
+public:
+    /* Constructor for SnapshotWriter class (the header is written first) */
+    SnapshotWriter(void);
+
+    /* Methods append a record */
+    void writeU8(uint8_t);
+    void writeU32(uint32_t);
+    void writeU64(uint64_t);
+    void writeDouble(double);
+    void writeString(const std::string&);
+    void writeBytes(const void*, std::size_t);
+
+    /* Method writes the snapshot to the given file, the file is replaced only
+    * once the snapshot has been written completely. Returns false on failure.
+    */
+    bool save(const std::string&) const;
+};
+
+/* SnapshotReader class reading the records of a snapshot file in order
+*  Every read method returns false (and leaves the reader failed) if the
+*  file ends before the record, the caller checks the result of each read.
+*/
+class SnapshotReader{
+private:
+    const char* _data;
+    std::size_t _size;
+    std::size_t _pos;
+    /* Memory mapping of the file (if mapped) or its contents */
+    void* _mapping;
+    std::size_t _mapping_size;
+    std::string _contents;
+    std::string _error_message;
+
+    /* Method unmaps the file */
+    void close(void);
+public:
+    /* Constructor for SnapshotReader class (no file) */
+    SnapshotReader(void);
+
+    /* Destructor for SnapshotReader class */
+    ~SnapshotReader(void);
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    /* Method opens the given snapshot file and checks its header and checksum.
+    * Returns false (and sets the error message) if the file can not be read,
+    * is not a snapshot of this format version or is corrupt.
+    */
+    bool open(const std::string&);
+
+    /* Methods read the next record */
+    bool readU8(uint8_t&);
+    bool readU32(uint32_t&);
+    bool readU64(uint64_t&);
+    bool readDouble(double&);
+    bool readString(std::string&);
+    bool readBytes(void*, std::size_t);
+
+    /* Method returns true if every record has been read */
+    bool atEnd(void) const{ return this->_pos == this->_size; }
+
+    /* Method returns the number of bytes not read yet */
+    std::size_t remaining(void) const{ return this->_size-this->_pos; }
+
+    /* Method to return the error message of open (if any) */
+    const std::string getErrorMsg(void) const{ return this->_error_message; }
+};
+
+}
+
+#endif
@@ -0,0 +1,39 @@
+/****************************************************************************
+* File name: mbcthreads_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine thread support header (header only).
+*  MBC_THREADS is defined when the standard library provides std::thread
+*  and std::mutex. It does not with the win32 thread model of mingw-w64
+*  (the TARGETOS=WIN64/WIN32 builds), the reductions, the matrix product
+*  and the asynchronous log then run on the calling thread and the
+*  evaluation server is not built. Define MBC_NO_THREADS to build the
+*  serial fallbacks with any toolchain.
+****************************************************************************/
+#ifndef __MB_COMPUTE_THREADS_LIB__
+
+#define __MB_COMPUTE_THREADS_LIB__
+/* Includes (any standard header defines the library configuration macros) */
+#include <cstddef>
+
+/* libstdc++ only provides std::thread and std::mutex on top of a gthreads implementation */
+#if !defined(MBC_NO_THREADS) && (!defined(__GLIBCXX__) || defined(_GLIBCXX_HAS_GTHREADS))
+#define MBC_THREADS
+#endif
+
+#endif
@@ -0,0 +1,822 @@
+/****************************************************************************
+* File name: mbcvm_lib.cpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine virtual machine containing implementations for
+*  the bytecode compiler and the register based virtual machine used
+*  to evaluate postfix expressions.
+****************************************************************************/
+
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+#include <type_traits>
+
+#include "mbcvm_lib.hpp"
+#include "mbcjit_lib.hpp"
+#include "mbcdual_lib.hpp"
+#include "mbcsimd_lib.hpp"
+
+/* Use direct threaded (computed goto) dispatch where the compiler supports it
+* Define MBC_VM_NO_COMPUTED_GOTO to force the portable switch based dispatch.
+*/
+#if defined(__GNUC__) && !defined(MBC_VM_NO_COMPUTED_GOTO)
+#define MBC_VM_COMPUTED_GOTO 1
+#else
+#define MBC_VM_COMPUTED_GOTO 0
+#endif
+
+namespace mbc{
+
+/* Function returns true if every opcode symbol and every alias is found by getOpCode */
+static constexpr bool check_opcode_lookup(void){
+    for (unsigned int op = 0; op < OP_COUNT; ++op)
+        if (getOpCode(OPCODES[op].symbol) != op)
+            return false;
+    for (const OpCodeAlias& alias : OPCODE_ALIASES)
+        if (getOpCode(alias.symbol) != alias.op)
+            return false;
+    return getOpCode("") == OP_COUNT && getOpCode("pow") == OP_COUNT;
+}
+static_assert(check_opcode_lookup(), "The opcode lookup does not match the opcode table");
+
+/* Operations of the virtual machine (every opcode before OP_RET)
+* Each entry is the opcode and the value stored to the destination register,
+* the entries must be in the order of the OpCode enum (this is the dispatch table).
+* The semantics match Evaluator::interpretPostfix exactly, T is the type of the registers.
+* The math functions are called unqualified so the overloads of Dual are found as well.
+*/
+#define MBC_VM_OPERATIONS(OPERATION) \
+    OPERATION(OP_INC,     reg[ip->a] + 1) \
+    OPERATION(OP_DEC,     reg[ip->a] - 1) \
+    OPERATION(OP_POW,     pow(reg[ip->a], reg[ip->b])) \
+    OPERATION(OP_MUL,     reg[ip->a] * reg[ip->b]) \
+    OPERATION(OP_DIV,     reg[ip->a] / reg[ip->b]) \
+    OPERATION(OP_MOD,     fmod(reg[ip->a], reg[ip->b])) \
+    OPERATION(OP_ADD,     reg[ip->a] + reg[ip->b]) \
+    OPERATION(OP_SUB,     reg[ip->a] - reg[ip->b]) \
+    OPERATION(OP_SHL,     static_cast<T>(static_cast<long long>(reg[ip->a]) << static_cast<long long>(reg[ip->b]))) \
+    OPERATION(OP_SHR,     static_cast<T>(static_cast<long long>(reg[ip->a]) >> static_cast<long long>(reg[ip->b]))) \
+    OPERATION(OP_LT,      static_cast<T>(reg[ip->a] < reg[ip->b])) \
+    OPERATION(OP_GT,      static_cast<T>(reg[ip->a] > reg[ip->b])) \
+    OPERATION(OP_EQ,      static_cast<T>(reg[ip->a] == reg[ip->b])) \
+    OPERATION(OP_NE,      static_cast<T>(reg[ip->a] != reg[ip->b])) \
+    OPERATION(OP_BIT_AND, static_cast<T>(static_cast<long long>(reg[ip->a]) & static_cast<long long>(reg[ip->b]))) \
+    OPERATION(OP_BIT_XOR, static_cast<T>(static_cast<long long>(reg[ip->a]) ^ static_cast<long long>(reg[ip->b]))) \
+    OPERATION(OP_BIT_OR,  static_cast<T>(static_cast<long long>(reg[ip->a]) | static_cast<long long>(reg[ip->b]))) \
+    OPERATION(OP_NOT,     static_cast<T>(!reg[ip->a])) \
+    OPERATION(OP_AND,     static_cast<T>(reg[ip->a] && reg[ip->b])) \
+    OPERATION(OP_XOR,     static_cast<T>(!reg[ip->a] != !reg[ip->b])) \
+    OPERATION(OP_OR,      static_cast<T>(reg[ip->a] || reg[ip->b])) \
+    OPERATION(OP_LN,      log(reg[ip->a])) \
+    OPERATION(OP_LOG10,   log10(reg[ip->a])) \
+    OPERATION(OP_CEIL,    ceil(reg[ip->a])) \
+    OPERATION(OP_FLOOR,   floor(reg[ip->a])) \
+    OPERATION(OP_ABS,     abs(reg[ip->a])) \
+    OPERATION(OP_COS,     cos(reg[ip->a])) \
+    OPERATION(OP_SIN,     sin(reg[ip->a])) \
+    OPERATION(OP_TAN,     tan(reg[ip->a])) \
+    OPERATION(OP_COSH,    cosh(reg[ip->a])) \
+    OPERATION(OP_SINH,    sinh(reg[ip->a])) \
+    OPERATION(OP_TANH,    tanh(reg[ip->a])) \
+    OPERATION(OP_IF,      !reg[ip->dst] ? reg[ip->b] : reg[ip->a])
+
+/* Make sure every opcode before OP_RET has an operation */
+#define MBC_VM_COUNT_OPERATION(opcode, expr) +1
+static_assert(0 MBC_VM_OPERATIONS(MBC_VM_COUNT_OPERATION) == OP_RET, "MBC_VM_OPERATIONS must list every opcode before OP_RET");
+
+/* Returns true if the postfix token is a number (same check as the string interpreter) */
+static bool is_number_token(const std::string& token){
+    return std::isdigit(token[0]) || (token[0] == '-' && token.length() > 1 && std::isdigit(token[1]));
+}
+
+/* Returns true if the postfix token is a reserved internal function (for example __sin__ or __pow__) */
+static bool is_function_token(const std::string& token){
+    const OpCode op = getOpCode(token);
+    return token[0] == '_' && (op == OP_POW || (op >= OP_LN && op < OP_RET));
+}
+
+/* Marker of the tokens that start no lazy operand (see find_lazy_operands) */
+static const uint32_t NOT_LAZY = UINT32_MAX;
+
+/* Returns for every postfix token the index of the operator whose lazy operand starts at
+* that token (the right operand of && and ||, either branch of __if__ if the reserved
+* functions are compiled), NOT_LAZY for the other tokens. The tokens are classified as
+* the compilers do, the operands are found from the first token of every stack entry.
+*/
+static std::vector<uint32_t> find_lazy_operands(const std::vector<std::string>& postfix, bool flag_functions){
+    std::vector<uint32_t> lazy(postfix.size(), NOT_LAZY);
+    std::vector<uint32_t> starts;
+    for (uint32_t index = 0; index < postfix.size(); ++index){
+        const std::string& token = postfix[index];
+        const OpCode op = getOpCode(token);
+        std::size_t arity = 0;
+        bool flag_result = true;
+        if (is_number_token(token))
+            arity = 0;
+        else if (flag_functions && is_function_token(token))
+            arity = OPCODES[op].arity;
+        else if (std::isalpha(token[0]) || token[0] == '_')
+            arity = 0;
+        else{
+            /* Unsupported operators consume two operands without a result */
+            flag_result = op < OP_LN;
+            arity = flag_result ? OPCODES[op].arity : 2;
+        }
+        if (starts.size() < arity)
+            break;
+        if (op == OP_AND || op == OP_OR)
+            lazy[starts.back()] = index;
+        else if (op == OP_IF && arity == 3){
+            lazy[starts[starts.size()-2]] = index;
+            lazy[starts.back()] = index;
+        }
+        const uint32_t start = arity == 0 ? index : starts[starts.size()-arity];
+        starts.resize(starts.size()-arity);
+        if (flag_result)
+            starts.push_back(start);
+    }
+    return lazy;
+}
+
+bool isBaseLiteral(const std::string& token){
+    std::size_t start = token[0] == '-' ? 1 : 0;
+    return token.length() > start+2 && token[start] == '0' && std::strchr("xXbB", token[start+1]) != nullptr;
+}
+
+bool getIntegerValue(const std::string& token, uint64_t& magnitude, bool& negative){
+    negative = !token.empty() && token[0] == '-';
+    std::size_t index = negative ? 1 : 0;
+    unsigned int base = 10;
+    if (isBaseLiteral(token)){
+        base = std::tolower(token[index+1]) == 'x' ? 16 : 2;
+        index += 2;
+    }
+    if (index >= token.length())
+        return false;
+    magnitude = 0;
+    for (; index < token.length(); ++index){
+        char digit = static_cast<char>(std::tolower(token[index]));
+        unsigned int value;
+        if (digit >= '0' && digit <= '9')
+            value = static_cast<unsigned int>(digit-'0');
+        else if (digit >= 'a' && digit <= 'f')
+            value = static_cast<unsigned int>(digit-'a'+10);
+        else if (digit == '.' && base == 10)
+            /* A fraction is only allowed if it is all zeros (for example 5.000000) */
+            return token.find_first_not_of('0', index+1) == std::string::npos;
+        else
+            return false;
+        if (value >= base || magnitude > (UINT64_MAX-value)/base)
+            return false;
+        magnitude = magnitude*base+value;
+    }
+    return true;
+}
+
+double getNumberValue(const std::string& token){
+    uint64_t magnitude;
+    bool negative;
+    if (isBaseLiteral(token) && getIntegerValue(token, magnitude, negative))
+        return negative ? -static_cast<double>(magnitude) : static_cast<double>(magnitude);
+    return std::atof(token.c_str());
+}
+
+template<>
+float getNumberValueAs<float>(const std::string& token){
+    return isBaseLiteral(token) ? static_cast<float>(getNumberValue(token)) : std::strtof(token.c_str(), nullptr);
+}
+
+template<>
+double getNumberValueAs<double>(const std::string& token){
+    return getNumberValue(token);
+}
+
+template<>
+long double getNumberValueAs<long double>(const std::string& token){
+    /* Integer literals are exact up to 64 bits in long double */
+    uint64_t magnitude;
+    bool negative;
+    if (isBaseLiteral(token) && getIntegerValue(token, magnitude, negative))
+        return negative ? -static_cast<long double>(magnitude) : static_cast<long double>(magnitude);
+    return std::strtold(token.c_str(), nullptr);
+}
+
+/* Dual numbers read their literals as constants (see Dual) */
+template<>
+Dual<double> getNumberValueAs<Dual<double>>(const std::string& token){
+    return Dual<double>(getNumberValue(token));
+}
+
+template<>
+Dual<Dual<double>> getNumberValueAs<Dual<Dual<double>>>(const std::string& token){
+    return Dual<Dual<double>>(getNumberValue(token));
+}
+
+/* BasicProgram class definitions */
+template<typename T>
+BasicProgram<T>::BasicProgram(void){
+    this->reset(0);
+}
+
+template<typename T>
+BasicProgram<T>::~BasicProgram(void){
+}
+
+template<typename T>
+void BasicProgram<T>::reset(std::size_t input_count){
+    this->_code.clear();
+    this->_registers.clear();
+    this->_input_count = input_count;
+    this->_temp_base = 0;
+    this->_valid = false;
+    this->_multiple_results = false;
+    this->_runs = 0;
+    this->_jit_failed = false;
+    this->_native.reset();
+}
+
+template<typename T>
+bool BasicProgram<T>::compile(const std::vector<std::string>& postfix, const std::vector<std::string>& inputs, bool flag_functions){
+    this->reset(inputs.size());
+
+    /* Count the constants first so the temporaries can be placed after them
+    * An extra constant holding 0 is used when there is no result.
+    */
+    std::size_t const_count = std::count_if(postfix.cbegin(), postfix.cend(), is_number_token);
+    const uint32_t zero_reg = static_cast<uint32_t>(inputs.size()+const_count);
+    const uint32_t temp_base = zero_reg+1;
+    this->_registers.assign(temp_base, 0.0);
+    this->_temp_base = temp_base;
+
+    /* Stack of the registers holding the values of the postfix evaluation stack */
+    std::vector<uint32_t> stack;
+    uint32_t next_const = static_cast<uint32_t>(inputs.size());
+    std::size_t temp_count = 0;
+    /* Jump of every lazy operator waiting for its target (the instruction of the operator) */
+    const std::vector<uint32_t> lazy = find_lazy_operands(postfix, flag_functions);
+    std::vector<std::size_t> jumps(postfix.size(), std::string::npos);
+    for (std::size_t index = 0; index < postfix.size(); ++index){
+        const std::string& token = postfix[index];
+        const uint32_t owner = lazy[index];
+        if (owner != NOT_LAZY && getOpCode(postfix[owner]) != OP_IF){
+            /* The right operand is skipped if the left one decides the result, the
+            * operator gives the same result without reading it
+            */
+            jumps[owner] = this->_code.size();
+            this->_code.push_back({getOpCode(postfix[owner]) == OP_AND ? OP_JUMP_IF_ZERO : OP_JUMP_IF_NONZERO, 0, stack.back(), 0});
+        } else if (owner != NOT_LAZY && jumps[owner] == std::string::npos){
+            /* The condition is kept in the register of the result, the then branch is skipped if it is 0 */
+            const uint32_t dst = temp_base+static_cast<uint32_t>(stack.size()-1);
+            if (stack.back() != dst){
+                this->_code.push_back({OP_NE, dst, stack.back(), zero_reg});
+                stack.back() = dst;
+                temp_count = std::max(temp_count, stack.size());
+            }
+            jumps[owner] = this->_code.size();
+            this->_code.push_back({OP_JUMP_IF_ZERO, 0, dst, 0});
+        } else if (owner != NOT_LAZY){
+            /* The then branch skips the else branch */
+            this->_code[jumps[owner]].b = static_cast<uint32_t>(this->_code.size()+1);
+            jumps[owner] = this->_code.size();
+            this->_code.push_back({OP_JUMP, 0, 0, 0});
+        }
+
+        if (is_number_token(token)){
+            this->_registers[next_const] = getNumberValueAs<T>(token);
+            stack.push_back(next_const++);
+        } else if (flag_functions && is_function_token(token)){
+            /* Reserved internal functions take their arguments from the stack as operators do */
+            const OpCode op = getOpCode(token);
+            if (stack.size() < OPCODES[op].arity)
+                return false;
+            uint32_t rhs = stack.back();
+            stack.pop_back();
+            uint32_t lhs = rhs;
+            if (OPCODES[op].arity >= 2){
+                lhs = stack.back();
+                stack.pop_back();
+            }
+            /* The condition of __if__ is already in the register of the result */
+            if (OPCODES[op].arity == 3)
+                stack.pop_back();
+            uint32_t dst = temp_base+static_cast<uint32_t>(stack.size());
+            temp_count = std::max(temp_count, stack.size()+1);
+            if (jumps[index] != std::string::npos)
+                this->_code[jumps[index]].b = static_cast<uint32_t>(this->_code.size());
+            this->_code.push_back({op, dst, lhs, rhs});
+            stack.push_back(dst);
+        } else if (std::isalpha(token[0]) || token[0] == '_'){
+            auto input_it = std::find(inputs.cbegin(), inputs.cend(), token);
+            if (input_it == inputs.cend()){
+                /* The string interpreter stops and returns 0 on an unknown name */
+                this->_code.assign(1, {OP_RET, 0, zero_reg, 0});
+                this->_registers.resize(temp_base);
+                this->_valid = true;
+                return true;
+            }
+            stack.push_back(static_cast<uint32_t>(input_it-inputs.cbegin()));
+        } else{
+            /* Any missing operand is an error */
+            if (stack.empty())
+                return false;
+            OpCode op = getOpCode(token);
+            if (op >= OP_LN)
+                /* Reserved internal function names are not operators */
+                op = OP_COUNT;
+            uint32_t rhs = stack.back();
+            stack.pop_back();
+            uint32_t lhs = rhs;
+            if (op == OP_COUNT || OPCODES[op].arity == 2){
+                if (stack.empty())
+                    return false;
+                lhs = stack.back();
+                stack.pop_back();
+            }
+            /* Unsupported operators consume their operands without a result as the string interpreter does */
+            if (op == OP_COUNT)
+                continue;
+            uint32_t dst = temp_base+static_cast<uint32_t>(stack.size());
+            temp_count = std::max(temp_count, stack.size()+1);
+            if (jumps[index] != std::string::npos)
+                this->_code[jumps[index]].b = static_cast<uint32_t>(this->_code.size());
+            this->_code.push_back({op, dst, lhs, rhs});
+            stack.push_back(dst);
+        }
+    }
+
+    this->_multiple_results = stack.size() > 1;
+    this->_code.push_back({OP_RET, 0, stack.empty() ? zero_reg : stack.back(), 0});
+    this->_registers.resize(temp_base+temp_count, 0.0);
+    this->_valid = true;
+    return true;
+}
+
+template<typename T>
+bool BasicProgram<T>::compileCall(OpCode op, const std::vector<T>& args){
+    this->reset(0);
+    if (op >= OP_RET || args.size() < OPCODES[op].arity)
+        return false;
+    /* Extra arguments are ignored */
+    this->_registers.assign(args.cbegin(), args.cbegin()+OPCODES[op].arity);
+    uint32_t dst = static_cast<uint32_t>(this->_registers.size());
+    this->_temp_base = dst;
+    /* The condition of __if__ is placed in the register of the result */
+    this->_registers.push_back(op == OP_IF ? args[0] : 0.0);
+    if (op == OP_IF)
+        this->_code.push_back({op, dst, 1, 2});
+    else
+        this->_code.push_back({op, dst, 0, dst > 1 ? 1u : 0u});
+    this->_code.push_back({OP_RET, 0, dst, 0});
+    this->_valid = true;
+    return true;
+}
+
+template<typename T>
+bool BasicProgram<T>::restore(std::vector<Instruction> code, std::vector<T> registers, std::size_t input_count, std::size_t temp_base, bool multiple_results){
+    this->reset(input_count);
+    if (input_count > temp_base || temp_base > registers.size() || code.empty() || code.back().op != OP_RET)
+        return false;
+    for (std::size_t index = 0; index < code.size(); ++index){
+        const Instruction& ins = code[index];
+        /* Jumps only go forward so every program ends */
+        const bool flag_jump = ins.op > OP_RET && ins.op < OP_COUNT;
+        if (ins.op >= OP_COUNT || ins.dst >= registers.size() || ins.a >= registers.size()
+            || (flag_jump ? (ins.b <= index || ins.b >= code.size()) : ins.b >= registers.size()))
+            return false;
+    }
+    this->_code = std::move(code);
+    this->_registers = std::move(registers);
+    this->_temp_base = temp_base;
+    this->_multiple_results = multiple_results;
+    this->_valid = true;
+    return true;
+}
+
+template<typename T>
+T BasicProgram<T>::run(const T* inputs){
+    T* reg = this->_registers.data();
+    for (std::size_t index = 0; index < this->_input_count; ++index)
+        reg[index] = inputs[index];
+    using std::pow;
+    using std::fmod;
+    using std::log;
+    using std::log10;
+    using std::ceil;
+    using std::floor;
+    using std::abs;
+    using std::cos;
+    using std::sin;
+    using std::tan;
+    using std::cosh;
+    using std::sinh;
+    using std::tanh;
+
+    /* Run hot programs as native code (double programs only) */
+    if constexpr (std::is_same<T, double>::value){
+        if (this->_native != nullptr)
+            return this->_native->run(reg);
+        if (!this->_jit_failed && getJitThreshold() != 0 && ++this->_runs >= getJitThreshold() && this->jit())
+            return this->_native->run(reg);
+    }
+
+    const Instruction* const code = this->_code.data();
+    const Instruction* ip = code;
+
+#if MBC_VM_COMPUTED_GOTO
+    /* Direct threaded dispatch, every handler jumps straight to the handler of the next instruction */
+#define MBC_VM_LABEL_ADDRESS(opcode, expr) &&label_##opcode,
+#define MBC_VM_HANDLER(opcode, expr) label_##opcode: reg[ip->dst] = (expr); ++ip; goto *dispatch_table[ip->op];
+    static void* const dispatch_table[OP_COUNT] = {
+        MBC_VM_OPERATIONS(MBC_VM_LABEL_ADDRESS)
+        &&label_OP_RET, &&label_OP_JUMP, &&label_OP_JUMP_IF_ZERO, &&label_OP_JUMP_IF_NONZERO
+    };
+    goto *dispatch_table[ip->op];
+    MBC_VM_OPERATIONS(MBC_VM_HANDLER)
+label_OP_RET:
+    return reg[ip->a];
+label_OP_JUMP:
+    ip = code+ip->b;
+    goto *dispatch_table[ip->op];
+label_OP_JUMP_IF_ZERO:
+    ip = !reg[ip->a] ? code+ip->b : ip+1;
+    goto *dispatch_table[ip->op];
+label_OP_JUMP_IF_NONZERO:
+    ip = !reg[ip->a] ? ip+1 : code+ip->b;
+    goto *dispatch_table[ip->op];
+#undef MBC_VM_LABEL_ADDRESS
+#undef MBC_VM_HANDLER
+#else
+    /* Portable switch based dispatch */
+#define MBC_VM_CASE(opcode, expr) case opcode: reg[ip->dst] = (expr); break;
+    while (true){
+        switch (ip->op){
+            MBC_VM_OPERATIONS(MBC_VM_CASE)
+            case OP_JUMP:
+                ip = code+ip->b;
+                continue;
+            case OP_JUMP_IF_ZERO:
+                ip = !reg[ip->a] ? code+ip->b : ip+1;
+                continue;
+            case OP_JUMP_IF_NONZERO:
+                ip = !reg[ip->a] ? ip+1 : code+ip->b;
+                continue;
+            default:
+                return reg[ip->a];
+        }
+        ++ip;
+    }
+#undef MBC_VM_CASE
+#endif
+}
+
+/* Lane of the register blocks of BasicProgram::map, reg[r] is the value of register r in the lane
+* so the operations of MBC_VM_OPERATIONS can be applied lane by lane.
+*/
+template<typename T>
+struct MapLane{
+    T* blocks;
+    std::size_t lane;
+    T& operator[](uint32_t reg) const{ return this->blocks[reg*MAP_BLOCK_SIZE+this->lane]; }
+};
+
+/* Applies the instruction to the lanes of the register blocks with SIMD vectors,
+* returns false if the opcode has no SIMD kernel.
+*/
+static bool map_simd(const Instruction& ins, double* blocks, std::size_t width){
+#if MBC_SIMD
+    double* dst = blocks+ins.dst*MAP_BLOCK_SIZE;
+    const double* lhs = blocks+ins.a*MAP_BLOCK_SIZE;
+    const double* rhs = blocks+ins.b*MAP_BLOCK_SIZE;
+    const SimdDouble one = simdBroadcast(1);
+    const SimdDouble zero = simdBroadcast(0);
+    /* The blocks are padded to a multiple of SIMD_LANES, the lanes past the width are not read back */
+#define MBC_SIMD_KERNEL(opcode, expr) case opcode: \
+        for (std::size_t lane = 0; lane < width; lane += SIMD_LANES){ \
+            const SimdDouble a = *reinterpret_cast<const SimdDouble*>(lhs+lane); \
+            [[maybe_unused]] const SimdDouble b = *reinterpret_cast<const SimdDouble*>(rhs+lane); \
+            [[maybe_unused]] const SimdDouble d = *reinterpret_cast<const SimdDouble*>(dst+lane); \
+            *reinterpret_cast<SimdDouble*>(dst+lane) = (expr); \
+        } \
+        return true;
+    switch (ins.op){
+        MBC_SIMD_KERNEL(OP_INC, a+one)
+        MBC_SIMD_KERNEL(OP_DEC, a-one)
+        MBC_SIMD_KERNEL(OP_MUL, a*b)
+        MBC_SIMD_KERNEL(OP_DIV, a/b)
+        MBC_SIMD_KERNEL(OP_ADD, a+b)
+        MBC_SIMD_KERNEL(OP_SUB, a-b)
+        MBC_SIMD_KERNEL(OP_LT, simdSelectOne(a < b))
+        MBC_SIMD_KERNEL(OP_GT, simdSelectOne(a > b))
+        MBC_SIMD_KERNEL(OP_EQ, simdSelectOne(a == b))
+        MBC_SIMD_KERNEL(OP_NE, simdSelectOne(a != b))
+        /* NaN is true as it is in C++ (it does not compare equal to 0) */
+        MBC_SIMD_KERNEL(OP_NOT, simdSelectOne(a == zero))
+        MBC_SIMD_KERNEL(OP_AND, simdSelectOne((a != zero) & (b != zero)))
+        MBC_SIMD_KERNEL(OP_XOR, simdSelectOne((a == zero) != (b == zero)))
+        MBC_SIMD_KERNEL(OP_OR, simdSelectOne((a != zero) | (b != zero)))
+        MBC_SIMD_KERNEL(OP_ABS, simdAbs(a))
+        /* The condition of OP_IF is in the destination */
+        MBC_SIMD_KERNEL(OP_IF, simdSelect(d != zero, a, b))
+        default:
+            return false;
+    }
+#undef MBC_SIMD_KERNEL
+#else
+    return false;
+#endif
+}
+
+template<typename T>
+void BasicProgram<T>::map(const T* const* inputs, std::size_t count, T* result) const{
+    using std::pow;
+    using std::fmod;
+    using std::log;
+    using std::log10;
+    using std::ceil;
+    using std::floor;
+    using std::abs;
+    using std::cos;
+    using std::sin;
+    using std::tan;
+    using std::cosh;
+    using std::sinh;
+    using std::tanh;
+
+    /* One block of MAP_BLOCK_SIZE lanes per register, the constants are set in every lane once */
+    std::vector<T> blocks(this->_registers.size()*MAP_BLOCK_SIZE);
+    for (std::size_t reg = this->_input_count; reg < this->_temp_base; ++reg)
+        std::fill_n(blocks.begin()+reg*MAP_BLOCK_SIZE, MAP_BLOCK_SIZE, this->_registers[reg]);
+
+    for (std::size_t start = 0; start < count; start += MAP_BLOCK_SIZE){
+        const std::size_t width = std::min(MAP_BLOCK_SIZE, count-start);
+        for (std::size_t index = 0; index < this->_input_count; ++index)
+            std::copy_n(inputs[index]+start, width, blocks.begin()+index*MAP_BLOCK_SIZE);
+        for (const Instruction& ins : this->_code){
+            if (ins.op == OP_RET){
+                std::copy_n(blocks.cbegin()+ins.a*MAP_BLOCK_SIZE, width, result+start);
+                break;
+            }
+            if constexpr (std::is_same<T, double>::value)
+                if (map_simd(ins, blocks.data(), width))
+                    continue;
+            const Instruction* ip = &ins;
+            T* dst = blocks.data()+ins.dst*MAP_BLOCK_SIZE;
+#define MBC_VM_MAP_CASE(opcode, expr) case opcode: \
+                for (std::size_t lane = 0; lane < width; ++lane){ \
+                    const MapLane<T> reg{blocks.data(), lane}; \
+                    dst[lane] = (expr); \
+                } \
+                break;
+            switch (ins.op){
+                MBC_VM_OPERATIONS(MBC_VM_MAP_CASE)
+                default:
+                    /* Jumps are not taken (see map) */
+                    break;
+            }
+#undef MBC_VM_MAP_CASE
+        }
+    }
+}
+
+template<typename T>
+bool BasicProgram<T>::jit(void){
+    if (this->_native != nullptr)
+        return true;
+    if (!std::is_same<T, double>::value || !this->_valid || this->_jit_failed)
+        return false;
+    this->_native = JitCode::compile(this->_code);
+    /* Keep interpreting the program if it could not be compiled */
+    this->_jit_failed = this->_native == nullptr;
+    return !this->_jit_failed;
+}
+
+template<typename T>
+const std::string BasicProgram<T>::disassemble(void) const{
+    std::ostringstream str_stream_obj;
+    if (!this->_valid)
+        return "(invalid program)\n";
+    /* List the inputs and constants, temporaries are not listed */
+    for (std::size_t index = 0; index < this->_temp_base; ++index){
+        if (index < this->_input_count)
+            str_stream_obj << "r" << index << " = input " << index << "\n";
+        else
+            str_stream_obj << "r" << index << " = " << this->_registers[index] << "\n";
+    }
+    for (const Instruction& ins : this->_code){
+        if (ins.op == OP_RET)
+            str_stream_obj << "ret r" << ins.a << "\n";
+        else if (ins.op == OP_JUMP)
+            str_stream_obj << "jmp " << ins.b << "\n";
+        else if (ins.op > OP_RET)
+            /* Jump targets are instruction numbers (the first instruction is 0) */
+            str_stream_obj << OPCODES[ins.op].symbol << " r" << ins.a << ", " << ins.b << "\n";
+        else if (ins.op == OP_IF)
+            str_stream_obj << "r" << ins.dst << " = r" << ins.dst << " ? r" << ins.a << " : r" << ins.b << "\n";
+        else if (OPCODES[ins.op].arity == 1)
+            str_stream_obj << "r" << ins.dst << " = " << OPCODES[ins.op].symbol << " r" << ins.a << "\n";
+        else
+            str_stream_obj << "r" << ins.dst << " = r" << ins.a << " " << OPCODES[ins.op].symbol << " r" << ins.b << "\n";
+    }
+    return str_stream_obj.str();
+}
+
+/* The supported floating point types */
+template class BasicProgram<float>;
+template class BasicProgram<double>;
+template class BasicProgram<long double>;
+template class BasicProgram<Dual<double>>;
+template class BasicProgram<Dual<Dual<double>>>;
+
+/* IntegerProgram class definitions */
+template<typename T>
+IntegerProgram<T>::IntegerProgram(void) : _valid(false), _multiple_results(false){
+}
+
+template<typename T>
+bool IntegerProgram<T>::compile(const std::vector<std::string>& postfix){
+    this->_code.clear();
+    this->_tokens.clear();
+    this->_registers.clear();
+    this->_valid = false;
+    this->_multiple_results = false;
+    this->_errors.clear();
+
+    /* Constants are stored as they are read, temporaries are added after them per stack level */
+    std::vector<uint32_t> stack;
+    std::vector<std::pair<uint32_t, std::size_t>> temps;
+    /* The right operand of && and || is skipped as BasicProgram::compile does */
+    const std::vector<uint32_t> lazy = find_lazy_operands(postfix, false);
+    std::vector<std::size_t> jumps(postfix.size(), std::string::npos);
+    for (std::size_t index = 0; index < postfix.size(); ++index){
+        const std::string& token = postfix[index];
+        const uint32_t owner = lazy[index];
+        if (owner != NOT_LAZY){
+            jumps[owner] = this->_code.size();
+            this->_code.push_back({getOpCode(postfix[owner]) == OP_AND ? OP_JUMP_IF_ZERO : OP_JUMP_IF_NONZERO, 0, stack.back(), 0});
+            this->_tokens.push_back(owner);
+        }
+        uint64_t magnitude;
+        bool negative;
+        if (is_number_token(token)){
+            if (!getIntegerValue(token, magnitude, negative)){
+                this->_errors.add(DIAG_NOT_INT64, {token}).offset = index;
+                return false;
+            }
+            /* Negative literals wrap around for unsigned integers */
+            this->_registers.push_back(static_cast<T>(negative ? 0-magnitude : magnitude));
+            stack.push_back(static_cast<uint32_t>(this->_registers.size()-1));
+            continue;
+        }
+        OpCode op = getOpCode(token);
+        if (op >= OP_LN){
+            this->_errors.add(DIAG_NOT_INTEGER_OPERATION, {token}).offset = index;
+            return false;
+        }
+        if (stack.size() < OPCODES[op].arity){
+            this->_errors.add(DIAG_NO_OPERANDS, {token}).offset = index;
+            return false;
+        }
+        uint32_t rhs = stack.back();
+        stack.pop_back();
+        uint32_t lhs = rhs;
+        if (OPCODES[op].arity == 2){
+            lhs = stack.back();
+            stack.pop_back();
+        }
+        /* Temporary registers are numbered by stack level and resolved to indices once the constants are known */
+        if (jumps[index] != std::string::npos)
+            this->_code[jumps[index]].b = static_cast<uint32_t>(this->_code.size());
+        this->_code.push_back({op, static_cast<uint32_t>(stack.size()) | 0x80000000u, lhs, rhs});
+        this->_tokens.push_back(index);
+        stack.push_back(static_cast<uint32_t>(stack.size()) | 0x80000000u);
+    }
+
+    /* Place the temporaries after the constants */
+    const uint32_t temp_base = static_cast<uint32_t>(this->_registers.size());
+    auto resolve = [temp_base](uint32_t reg){ return (reg & 0x80000000u) ? temp_base+(reg & 0x7FFFFFFFu) : reg; };
+    std::size_t temp_count = 0;
+    for (Instruction& ins : this->_code){
+        ins.a = resolve(ins.a);
+        /* Jumps hold the index of their target in b */
+        if (ins.op > OP_RET)
+            continue;
+        ins.dst = resolve(ins.dst);
+        ins.b = resolve(ins.b);
+        temp_count = std::max<std::size_t>(temp_count, ins.dst-temp_base+1);
+    }
+    this->_registers.resize(temp_base+temp_count+1, 0);
+    /* The last register holds 0 for an empty expression */
+    this->_multiple_results = stack.size() > 1;
+    this->_code.push_back({OP_RET, 0, stack.empty() ? static_cast<uint32_t>(this->_registers.size()-1) : resolve(stack.back()), 0});
+    this->_tokens.push_back(std::string::npos);
+    this->_valid = true;
+    return true;
+}
+
+template<typename T>
+bool IntegerProgram<T>::run(T& result){
+    /* Wrapping arithmetic is done on uint64_t where it is well defined */
+    T* reg = this->_registers.data();
+    for (std::size_t index = 0; index < this->_code.size(); ++index){
+        const Instruction& ins = this->_code[index];
+        /* Jumps go to the instruction before their target as the loop moves on */
+        if (ins.op == OP_JUMP_IF_ZERO || ins.op == OP_JUMP_IF_NONZERO){
+            if ((reg[ins.a] == 0) == (ins.op == OP_JUMP_IF_ZERO))
+                index = ins.b-1;
+            continue;
+        }
+        const T lhs = reg[ins.a];
+        const T rhs = reg[ins.b];
+        const uint64_t ulhs = static_cast<uint64_t>(lhs);
+        const uint64_t urhs = static_cast<uint64_t>(rhs);
+        T& dst = reg[ins.dst];
+        switch (ins.op){
+            case OP_INC: dst = static_cast<T>(ulhs+1); break;
+            case OP_DEC: dst = static_cast<T>(ulhs-1); break;
+            case OP_POW:{
+                if (rhs < 0){
+                    /* Negative powers are truncated as an integer division is */
+                    if (lhs == 0){
+                        this->_errors.add(DIAG_DIVISION_BY_ZERO).offset = this->_tokens[index];
+                        return false;
+                    }
+                    dst = lhs == 1 ? 1 : (lhs == static_cast<T>(-1) ? ((urhs & 1) ? lhs : 1) : 0);
+                    break;
+                }
+                uint64_t power = 1;
+                uint64_t base = ulhs;
+                for (uint64_t exponent = urhs; exponent != 0; exponent >>= 1){
+                    if (exponent & 1)
+                        power *= base;
+                    base *= base;
+                }
+                dst = static_cast<T>(power);
+                break;
+            }
+            case OP_MUL: dst = static_cast<T>(ulhs*urhs); break;
+            case OP_DIV:
+            case OP_MOD:
+                if (rhs == 0){
+                    this->_errors.add(DIAG_DIVISION_BY_ZERO).offset = this->_tokens[index];
+                    return false;
+                }
+                /* The only overflowing division, INT64_MIN/-1, wraps around */
+                if (std::is_signed<T>::value && rhs == static_cast<T>(-1))
+                    dst = ins.op == OP_DIV ? static_cast<T>(0-ulhs) : 0;
+                else
+                    dst = ins.op == OP_DIV ? lhs/rhs : lhs%rhs;
+                break;
+            case OP_ADD: dst = static_cast<T>(ulhs+urhs); break;
+            case OP_SUB: dst = static_cast<T>(ulhs-urhs); break;
+            case OP_SHL:
+            case OP_SHR:
+                if (rhs < 0 || urhs > 63){
+                    this->_errors.add(DIAG_SHIFT_RANGE, {std::to_string(rhs)}).offset = this->_tokens[index];
+                    return false;
+                }
+                /* Right shifts of signed integers are arithmetic */
+                dst = ins.op == OP_SHL ? static_cast<T>(ulhs << urhs) : static_cast<T>(lhs >> urhs);
+                break;
+            case OP_LT: dst = lhs < rhs; break;
+            case OP_GT: dst = lhs > rhs; break;
+            case OP_EQ: dst = lhs == rhs; break;
+            case OP_NE: dst = lhs != rhs; break;
+            case OP_BIT_AND: dst = lhs & rhs; break;
+            case OP_BIT_XOR: dst = lhs ^ rhs; break;
+            case OP_BIT_OR: dst = lhs | rhs; break;
+            case OP_NOT: dst = !lhs; break;
+            case OP_AND: dst = lhs && rhs; break;
+            case OP_XOR: dst = !lhs != !rhs; break;
+            case OP_OR: dst = lhs || rhs; break;
+            default:
+                result = reg[ins.a];
+                return true;
+        }
+    }
+    return false;
+}
+
+/* The supported integer types */
+template class IntegerProgram<int64_t>;
+template class IntegerProgram<uint64_t>;
+
+}
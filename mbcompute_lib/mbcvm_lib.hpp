@@ -0,0 +1,365 @@
+/****************************************************************************
+* File name: mbcvm_lib.hpp
+* Version: v1.0
+* Dev: GitHub@Rr42
+* License:
+*  Copyright 2023 Ramana R
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+* Description:
+*  The MB compute engine virtual machine header containing declarations
+*  for the bytecode compiler and the register based virtual machine used
+*  to evaluate postfix expressions.
+****************************************************************************/
+#ifndef __MB_COMPUTE_VM_LIB__
+
+#define __MB_COMPUTE_VM_LIB__
+/* Includes */
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <string_view>
+
+/* Custom libraries */
+#include "mbcphash_lib.hpp"
+#include "mbcdiag_lib.hpp"
+
+namespace mbc{
+
+/* Native code of a program (see mbcjit_lib.hpp) */
+class JitCode;
+
+/* Virtual machine opcodes
+* There is one opcode for every entry of SUPPORTED_OOPS and for every
+* reserved internal function (see SUPPORTED_FUNS), followed by the jumps
+* the compiler emits so the operands of &&, || and __if__ are only run
+* when they decide the result (there are no tokens for the jumps).
+* The order of the enum is the order of the dispatch table in BasicProgram::run.
+*/
+enum OpCode : uint8_t{
+    /* Operators (SUPPORTED_OOPS) */
+    OP_INC,
+    OP_DEC,
+    OP_POW,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_ADD,
+    OP_SUB,
+    OP_SHL,
+    OP_SHR,
+    OP_LT,
+    OP_GT,
+    OP_EQ,
+    OP_NE,
+    OP_BIT_AND,
+    OP_BIT_XOR,
+    OP_BIT_OR,
+    OP_NOT,
+    OP_AND,
+    OP_XOR,
+    OP_OR,
+    /* Reserved internal functions */
+    OP_LN,
+    OP_LOG10,
+    OP_CEIL,
+    OP_FLOOR,
+    OP_ABS,
+    OP_COS,
+    OP_SIN,
+    OP_TAN,
+    OP_COSH,
+    OP_SINH,
+    OP_TANH,
+    /* Conditional, dst = dst ? a : b (the condition is placed in dst) */
+    OP_IF,
+    /* Return the given register (ends the program) */
+    OP_RET,
+    /* Jumps to instruction b, unconditionally or if register a is (not) 0 */
+    OP_JUMP,
+    OP_JUMP_IF_ZERO,
+    OP_JUMP_IF_NONZERO,
+    /* Number of opcodes (not an opcode) */
+    OP_COUNT
+};
+
+/* Structure to hold metadata of an opcode */
+struct MetaOpCode{
+    /* Operator symbol or reserved internal function name */
+    const char* symbol;
+    /* Number of operands */
+    unsigned int arity;
+};
+
+/* Metadata of the opcodes (indexed by OpCode) */
+inline constexpr MetaOpCode OPCODES[OP_COUNT] = {
+    {"++", 1}, {"--", 1}, {"**", 2}, {"*", 2}, {"/", 2}, {"%", 2}, {"+", 2}, {"-", 2},
+    {"<<", 2}, {">>", 2}, {"<", 2}, {">", 2}, {"==", 2}, {"!=", 2},
+    {"&", 2}, {"^", 2}, {"|", 2}, {"!", 1}, {"&&", 2}, {"^^", 2}, {"||", 2},
+    {"__log__", 1}, {"__log10__", 1}, {"__ceil__", 1}, {"__floor__", 1}, {"__abs__", 1},
+    {"__cos__", 1}, {"__sin__", 1}, {"__tan__", 1}, {"__cosh__", 1}, {"__sinh__", 1}, {"__tanh__", 1},
+    {"__if__", 3}, {"ret", 1}, {"jmp", 0}, {"jz", 1}, {"jnz", 1},
+};
+
+/* Function returns the hash of the opcode table (the symbols and arities in order) */
+constexpr uint32_t opcodeTableHash(void){
+    uint32_t hash = 0;
+    for (const MetaOpCode& opcode : OPCODES)
+        hash = perfectHashKey(opcode.symbol, hash^opcode.arity);
+    return hash;
+}
+
+/* Hash of the opcode table, compiled programs are only kept by a virtual machine with the same hash (see Engine::loadSnapshot) */
+inline constexpr uint32_t OPCODES_TABLE_HASH = opcodeTableHash();
+
+/* Structure to hold a reserved internal function evaluated by the opcode of an operator */
+struct OpCodeAlias{
+    const char* symbol;
+    OpCode op;
+};
+
+/* Reserved internal functions sharing the opcode of an operator (see getOpCode) */
+inline constexpr OpCodeAlias OPCODE_ALIASES[] = {
+    {"__pow__", OP_POW},
+};
+
+/* Number of symbols looked up by getOpCode (the opcode symbols and the aliases) */
+inline constexpr std::size_t OPCODE_SYMBOL_COUNT = OP_COUNT+sizeof(OPCODE_ALIASES)/sizeof(OPCODE_ALIASES[0]);
+
+/* Structure to hold the symbols looked up by getOpCode, the opcode symbols (indexed by OpCode) followed by the aliases */
+struct OpCodeSymbols{
+    std::string_view keys[OPCODE_SYMBOL_COUNT];
+};
+
+/* Function returns the symbols looked up by getOpCode */
+constexpr OpCodeSymbols opcodeSymbols(void){
+    OpCodeSymbols symbols = {};
+    for (std::size_t op = 0; op < OP_COUNT; ++op)
+        symbols.keys[op] = OPCODES[op].symbol;
+    for (std::size_t index = OP_COUNT; index < OPCODE_SYMBOL_COUNT; ++index)
+        symbols.keys[index] = OPCODE_ALIASES[index-OP_COUNT].symbol;
+    return symbols;
+}
+
+/* Perfect hash of the opcode symbols and their aliases (see getOpCode) */
+inline constexpr PerfectHash<OPCODE_SYMBOL_COUNT> OPCODE_HASH = PerfectHash<OPCODE_SYMBOL_COUNT>(opcodeSymbols().keys);
+static_assert(OPCODE_HASH.valid(), "No perfect hash found for the opcode symbols");
+
+/* Method returns the opcode of the given operator symbol or reserved
+* internal function name (for example "+" or "__sin__"), aliases give
+* the opcode they share (see OPCODE_ALIASES).
+* OP_COUNT is returned if the symbol is not known.
+*/
+constexpr OpCode getOpCode(std::string_view symbol){
+    const std::size_t index = OPCODE_HASH.find(symbol);
+    if (index < OP_COUNT)
+        return static_cast<OpCode>(index);
+    return index < OPCODE_SYMBOL_COUNT ? OPCODE_ALIASES[index-OP_COUNT].op : OP_COUNT;
+}
+
+/* Method returns the value of a number token of a postfix expression.
+* Hex (0x) and binary (0b) integer literals are read exactly, other numbers with std::atof.
+*/
+double getNumberValue(const std::string&);
+
+/* Method reads a number token that holds an integer (decimal, hex or binary with
+* an optional minus sign, a decimal fraction of zeros is allowed) without going
+* through double. Returns false if the token is not an integer or its magnitude
+* does not fit in 64 bits.
+*/
+bool getIntegerValue(const std::string&, uint64_t&, bool&);
+
+/* Method returns true if the token is a hex (0x) or binary (0b) integer literal */
+bool isBaseLiteral(const std::string&);
+
+/* Method returns the value of a number token as the given floating point type.
+* Decimal numbers are read with the precision of the type (std::strtof, std::atof
+* or std::strtold), integer literals are read as getNumberValue does.
+*/
+template<typename T>
+T getNumberValueAs(const std::string&);
+
+/* Number of elements run together by BasicProgram::map (a multiple of SIMD_LANES) */
+const std::size_t MAP_BLOCK_SIZE = 256;
+
+/* Structure to hold a single instruction
+*   dst = op(a, b), b is unused by unary opcodes, jumps hold the index
+*   of the target instruction in b (always a later instruction)
+*/
+struct Instruction{
+    OpCode op;
+    uint32_t dst;
+    uint32_t a;
+    uint32_t b;
+};
+
+/* BasicProgram class holding a postfix expression compiled for the floating point type T
+*  T is float, double or long double (see Program for the double program the
+*  engine uses) or a dual number of double (see mbcdual_lib.hpp). The register file is laid out as [inputs][constants][temporaries],
+*  the temporaries are allocated by the depth of the postfix evaluation stack
+*  so a program uses at most one temporary per stack level.
+*  Once a double program has been run getJitThreshold() times it is compiled
+*  to native code (where supported), if that fails the virtual machine keeps
+*  running it. Programs of the other types are always run by the virtual machine.
+*/
+template<typename T>
+class BasicProgram{
+private:
+    std::vector<Instruction> _code;
+    std::vector<T> _registers;
+    std::size_t _input_count;
+    /* Index of the first temporary register */
+    std::size_t _temp_base;
+    bool _valid;
+    bool _multiple_results;
+    /* Number of runs so far and the native code (if compiled) */
+    unsigned int _runs;
+    bool _jit_failed;
+    std::shared_ptr<JitCode> _native;
+
+    /* Method clears the program */
+    void reset(std::size_t);
+public:
+    /* Constructor for BasicProgram class (empty, invalid program) */
+    BasicProgram(void);
+
+    /* Destructor for BasicProgram class */
+    ~BasicProgram(void);
+
+    /* Method compiles the given postfix expression buffer.
+    * Operands named in the inputs list are read from the inputs given to run
+    * (in the same order), any other name makes the program return 0 as the
+    * string interpreter does.
+    * Returns false (and the program is invalid) if the expression would
+    * raise an error, the caller is expected to fall back to the string
+    * interpreter to get the exact diagnostics.
+    * If the last argument is set the reserved internal function names (for
+    * example __sin__) take their arguments from the stack as operators do,
+    * the string interpreter does not support this.
+    * The right operand of && and || is skipped when the left one decides the
+    * result, only the branch __if__(cond,then,else) takes is run.
+    */
+    bool compile(const std::vector<std::string>&, const std::vector<std::string>& = {}, bool = false);
+
+    /* Method compiles a call of a single opcode on the given constant arguments.
+    * Returns false if the opcode is not known or takes more arguments than given,
+    * extra arguments are ignored.
+    */
+    bool compileCall(OpCode, const std::vector<T>&);
+
+    /* Method restores a program from its parts (see getCode, getRegisters, inputCount and
+    * tempBase), used to read back saved programs. Returns false (and the program is
+    * invalid) if an instruction is not known, uses a register outside the register file
+    * or jumps backwards or past the end.
+    */
+    bool restore(std::vector<Instruction>, std::vector<T>, std::size_t, std::size_t, bool);
+
+    /* Method returns true if the program was compiled successfully */
+    bool valid(void) const{ return this->_valid; }
+
+    /* Method returns true if the expression leaves more than one result */
+    bool multipleResults(void) const{ return this->_multiple_results; }
+
+    /* Method compiles the program to native code now instead of waiting for the
+    * run threshold, returns false if that is not possible (the virtual machine
+    * keeps running the program). Only double programs can be compiled.
+    */
+    bool jit(void);
+
+    /* Method returns true if the program is run as native code */
+    bool native(void) const{ return this->_native != nullptr; }
+
+    /* Method returns the number of inputs the program reads */
+    std::size_t inputCount(void) const{ return this->_input_count; }
+
+    /* Method returns the index of the first temporary register */
+    std::size_t tempBase(void) const{ return this->_temp_base; }
+
+    /* Method returns the compiled instructions */
+    const std::vector<Instruction>& getCode(void) const{ return this->_code; }
+
+    /* Method returns the initial register file (inputs are zero) */
+    const std::vector<T>& getRegisters(void) const{ return this->_registers; }
+
+    /* Method runs the program and returns its result.
+    * The program must be valid and inputs must hold inputCount() values.
+    */
+    T run(const T* = nullptr);
+
+    /* Method runs the program element-wise on the given number of elements, input k of
+    * element i is read from inputs[k][i] and the result of element i is stored to result[i].
+    * The elements are run in blocks of MAP_BLOCK_SIZE, every instruction is applied to a
+    * whole block before the next one (the arithmetic, comparison and logical opcodes of
+    * double programs use SIMD vectors, see mbcsimd_lib.hpp). The jumps are not taken,
+    * both operands of && and || and both branches of __if__ are run for the whole block
+    * and OP_IF selects the result of every element. The results are the ones run would
+    * give element by element, the program is never run as native code.
+    */
+    void map(const T* const*, std::size_t, T*) const;
+
+    /* Method returns a printable listing of the program */
+    const std::string disassemble(void) const;
+};
+
+/* The program type of the engine */
+using Program = BasicProgram<double>;
+
+/* IntegerProgram class holding a postfix expression compiled for 64 bit integers
+*  T is int64_t or uint64_t. Literals are read exactly, +, -, *, ** and the
+*  increment/decrement operators wrap around on overflow, / and % truncate
+*  (division by zero is an error) and shift counts must be in [0, 63].
+*  The comparison and logical operators give 0 or 1, the right operand of
+*  && and || is only run if the left one does not decide the result (so
+*  x != 0 && 10/x > 1 is not a division by zero). The errors hold the index
+*  of the postfix token they were raised at in their offset.
+*/
+template<typename T>
+class IntegerProgram{
+private:
+    std::vector<Instruction> _code;
+    /* Index of the postfix token of every instruction (npos for the return) */
+    std::vector<std::size_t> _tokens;
+    std::vector<T> _registers;
+    bool _valid;
+    bool _multiple_results;
+    Diagnostics _errors;
+public:
+    /* Constructor for IntegerProgram class (empty, invalid program) */
+    IntegerProgram(void);
+
+    /* Method compiles the given postfix expression buffer.
+    * Returns false (and records an error) if a token is not an integer
+    * literal or an integer operator or if an operator is missing an operand.
+    */
+    bool compile(const std::vector<std::string>&);
+
+    /* Method returns true if the program was compiled successfully */
+    bool valid(void) const{ return this->_valid; }
+
+    /* Method returns true if the expression leaves more than one result */
+    bool multipleResults(void) const{ return this->_multiple_results; }
+
+    /* Method runs the program and stores its result in the given value.
+    * Returns false (and records an error) on a division by zero or a
+    * shift count out of range.
+    */
+    bool run(T&);
+
+    /* Method returns the errors of the last compile or run */
+    const Diagnostics& getErrors(void) const{ return this->_errors; }
+};
+
+}
+
+#endif
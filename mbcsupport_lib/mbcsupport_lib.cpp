@@ -27,6 +27,11 @@ namespace mbcs{
 
 /* Class definitions */
 
+/* Returns true if the token is the given option or an `option=value` pair */
+static bool match_option(const std::string& token, const std::string& option){
+    return token == option || token.compare(0, option.size()+1, option+"=") == 0;
+}
+
 /* Definitions for CLIParser class */
 CLIParser::CLIParser (int argc, char **argv){
     for (int i=1; i < argc; ++i)
@@ -37,16 +42,16 @@ CLIParser::~CLIParser(void){
 }
 
 const std::string CLIParser::getCmdOption(const std::string option){
-    /* Searchfor the substring option in the loaded tokens */
+    /* Search for the option in the loaded tokens */
     std::vector<std::string>::const_iterator itr;
-    itr = std::find_if(this->tokens.cbegin(), this->tokens.cend(), [option](const std::string& str){ return str.find(option) != std::string::npos; });
+    itr = std::find_if(this->tokens.cbegin(), this->tokens.cend(), [option](const std::string& str){ return match_option(str, option); });
     if (itr != this->tokens.cend())
         return *itr;
     return "";
 }
 
 bool CLIParser::cmdOptionExists(const std::string option){
-    return std::find_if(this->tokens.cbegin(), this->tokens.cend(), [option](const std::string& str){ return str.find(option) != std::string::npos; }) != this->tokens.cend();
+    return std::find_if(this->tokens.cbegin(), this->tokens.cend(), [option](const std::string& str){ return match_option(str, option); }) != this->tokens.cend();
 }
 
 /* Common function definitions */
@@ -45,10 +45,14 @@ public:
     /* Destructor for CLIParser class */
     ~CLIParser(void);
 
-    /* Method returns non empty string is a value is found for given argument */
+    /* Method returns the whole matching argument (`option` or `option=value`) if the option is found
+    * otherwise an empty string is returned
+    */
     const std::string getCmdOption(const std::string option);
 
-    /* Method returns true if option exists in the argument list */
+    /* Method returns true if option exists in the argument list
+    * An argument matches if it is the option itself or an `option=value` pair
+    */
     bool cmdOptionExists(const std::string option);
 
 };
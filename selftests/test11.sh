@@ -0,0 +1,57 @@
+#!/bin/bash
+#############################################################################
+# File name: test11.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Eleventh self test for console application.
+#  This test checks the trace event output.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+
+# Execution options
+options="--silent"
+
+trace_file=/tmp/mbconsole_test11_trace.json
+
+# Run test commands and count the line, phase and function spans in the trace for comparison
+printf "Running test: --trace, sq(x):x*x, sq(3)+1\n"
+$mb_app $options --trace=$trace_file --command="sq(x):x*x\nsq(3)+1\nexit" > /dev/null
+lines=`grep -c '"cat": "line"' $trace_file`
+evals=`grep -c '"name": "eval", "cat": "phase"' $trace_file`
+funs=`grep -c '"name": "sq", "cat": "function"' $trace_file`
+closed=`tail -n 1 $trace_file`
+result="$lines $evals $funs $closed"
+printf "Result: $result"
+if [ "$result" == "2 2 1 ]}" ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+rm -f $trace_file
+pkill -SIGKILL mbconsole
+exit
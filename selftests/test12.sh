@@ -0,0 +1,50 @@
+#!/bin/bash
+#############################################################################
+# File name: test12.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Twelfth self test for console application.
+#  This test checks that native code gives the same results as the virtual machine.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent"
+
+# Run the same commands with the JIT disabled and with every program compiled to native code
+commands="sq(x,y=2.5):x*x+y\nsq(3)\nsq(1.5,4)\nsq(-2)<sq(2)\nsq(0.5)*3-1\nexit"
+printf "Running test: --jit-threshold=0 vs --jit-threshold=1, sq(x,y=2.5):x*x+y\n"
+vm_result=`$mb_app $options --jit-threshold=0 --command="$commands" | tr '\n' ' '`
+jit_result=`$mb_app $options --jit-threshold=1 --command="$commands" | tr '\n' ' '`
+printf "Result: $jit_result"
+if [ "$vm_result" == "$jit_result" ] && [ -n "$jit_result" ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
@@ -0,0 +1,48 @@
+#!/bin/bash
+#############################################################################
+# File name: test13.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Thirteenth self test for console application.
+#  This test checks the 64 bit integer number modes and hex/binary literals.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent"
+
+# Run test commands and compare the exact integer results
+printf "Running test: 0xFFFFFFFFFFFFFFFF&0xF0, (1<<62)|0b1, mode #uint64, 0-1\n"
+result=`$mb_app $options --command="0xFFFFFFFFFFFFFFFF&0xF0\n(1<<62)|0b1\nmode #uint64\n0-1\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "240 4611686018427387905 [Info] Number mode: uint64 18446744073709551615 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
@@ -0,0 +1,59 @@
+#!/bin/bash
+#############################################################################
+# File name: test14.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Fourteenth self test for console application.
+#  This test checks the float and long double number modes, function calls
+#  evaluated in the number mode and the warning of the builtins run on double.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent"
+
+# Run test commands and compare the results of each precision
+printf "Running test: 16777217-16777216, (1+1E-17-1)>0, mode #float, mode #longdouble\n"
+result=`$mb_app $options --command="16777217-16777216\n(1+1E-17-1)>0\nmode #float\n16777217-16777216\nmode #longdouble\n(1+1E-17-1)>0\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "1 0 [Info] Number mode: float 0 [Info] Number mode: longdouble 1 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+# Function calls are evaluated in the number mode, sum warns that it runs on double
+printf "Running test: mode #float, f(x,y=16777216.5):x-y, f(16777217.5), sum(i,1,3,16777217.5-16777216.5)\n"
+result=`$mb_app $options --command="mode #float\nf(x,y=16777216.5):x-y\nf(16777217.5)\nsum(i,1,3,16777217.5-16777216.5)\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "[Info] Number mode: float [Info] Definition for function \`f\` added 2 [Engine] WARNING: \`sum\` is evaluated on double, the number mode \`float\` is not used! 3 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
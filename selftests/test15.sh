@@ -0,0 +1,48 @@
+#!/bin/bash
+#############################################################################
+# File name: test15.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Fifteenth self test for console application.
+#  This test checks the solve and minimize builtins on user functions.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent"
+
+# Run test commands and compare the root and the minimum found
+printf "Running test: f(x) : x*x-2.0, solve(f,1), h(x,c=3.0) : (x-c)**2.0+1.5, minimize(h,0)\n"
+result=`$mb_app $options --command="f(x) : x*x-2.0\nsolve(f,1)\nh(x,c=3.0) : (x-c)**2.0+1.5\nminimize(h,0)\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "[Info] Definition for function \`f\` added 1.41421 [Info] Definition for function \`h\` added 3 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
@@ -0,0 +1,59 @@
+#!/bin/bash
+#############################################################################
+# File name: test16.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Sixteenth self test for console application.
+#  This test checks the sum and integrate builtins on several threads and
+#  that sums of more terms than can be counted exactly are rejected.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent --threads=3"
+
+# Run test commands and compare the sums and the integral
+printf "Running test: sum(i,1,100,i), f(x) : x*x, sum(f,1,1E+6), integrate(x,0,3,f(x))\n"
+result=`$mb_app $options --command="sum(i,1,100,i)\nf(x) : x*x\nsum(f,1,1E+6)\nintegrate(x,0,3,f(x))\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "5050 [Info] Definition for function \`f\` added 3.33334e+17 9 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+# Sums of more than 2^53 terms are rejected
+printf "Running test: sum(i,1,1E+18,i), sum(i,1,1E+300,i)\n"
+result=`$mb_app $options --command="sum(i,1,1E+18,i)\nsum(i,1,1E+300,i)\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "[Engine] ERROR: \`sum\` can not add more than 9007199254740992 terms! [Engine] ERROR: \`sum\` can not add more than 9007199254740992 terms! " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
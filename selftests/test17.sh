@@ -0,0 +1,48 @@
+#!/bin/bash
+#############################################################################
+# File name: test17.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Seventeenth self test for console application.
+#  This test checks the sweep command on several threads.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent --threads=3"
+
+# Run test commands and compare the rows of the sweeps
+printf "Running test: sweep x=0:1:2 : x*x, sweep x=0:0.5:1, y=1:1:2 : x+y\n"
+result=`$mb_app $options --command="sweep x=0:1:2 : x*x\nsweep x=0:0.5:1, y=1:1:2 : x+y\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "0 0 1 1 2 4 [Info] Sweep of 3 point(s) done 0 1 1 0 2 2 0.5 1 1.5 0.5 2 2.5 1 1 2 1 2 3 [Info] Sweep of 6 point(s) done " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
@@ -0,0 +1,79 @@
+#!/bin/bash
+#############################################################################
+# File name: test18.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Eighteenth self test for console application.
+#  This test checks saving and restoring snapshots of a session and that
+#  loading a snapshot removes the vectors of the previous session and
+#  that a corrupt snapshot is rejected before anything is restored.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent"
+snapshot_file="/tmp/mbconsole_test18_$$.snap"
+
+# Save a session and restore it with the startup option and the load command
+printf "Running test: f(x) : x*x, a=3, save #file, --snapshot=file f(a), load #file f(a)+a\n"
+result=`$mb_app $options --command="f(x) : x*x\na=3\nsave #$snapshot_file\nexit" | tr '\n' ' '`
+result+=`$mb_app $options --snapshot=$snapshot_file --command="f(a)\nexit" | tr '\n' ' '`
+result+=`$mb_app $options --command="load #$snapshot_file\nf(a)+a\nexit" | tr '\n' ' '`
+rm -f $snapshot_file
+printf "Result: $result"
+if [ "$result" == "[Info] Definition for function \`f\` added 3 [Info] Snapshot saved 9 [Info] Snapshot loaded 12 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+# Vectors are not kept in snapshots, loading one removes them
+printf "Running test: a=3, save #file, v=[1, 2] load #file v a\n"
+result=`$mb_app $options --command="a=3\nsave #$snapshot_file\nexit" | tr '\n' ' '`
+result+=`$mb_app $options --command="v=[1, 2]\nload #$snapshot_file\nv\na\nexit" | tr '\n' ' '`
+rm -f $snapshot_file
+printf "Result: $result"
+if [ "$result" == "3 [Info] Snapshot saved [1, 2] [Info] Snapshot loaded 0 3 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+# A changed byte fails the checksum, the session is left unchanged
+printf "Running test: f(x) : (x*x), save #file, change (x*x) to )x*x), a=3, load #file f(2) a\n"
+result=`$mb_app $options --command="f(x) : (x*x)\nsave #$snapshot_file\nexit" | tr '\n' ' '`
+perl -pi -e 's/\(x\*x\)/)x*x)/' $snapshot_file
+result+=`$mb_app $options --command="a=3\nload #$snapshot_file\nf(2)\na\nexit" | tr '\n' ' '`
+rm -f $snapshot_file
+printf "Result: $result"
+if [ "$result" == "[Info] Definition for function \`f\` added [Info] Snapshot saved 3 [Engine] ERROR: The snapshot \`$snapshot_file\` is corrupt! [Engine] ERROR: Undefined function \`f\` called! 3 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
@@ -0,0 +1,74 @@
+#!/bin/bash
+#############################################################################
+# File name: test19.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Nineteenth self test for console application.
+#  This test checks the evaluation server with two sessions and both protocols
+#  and that a text line over the request size limit closes its session.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent"
+socket_file="/tmp/mbconsole_test19_$$.sock"
+# Client sending the given lines (text) or length prefixed requests (binary) to the server
+client='use IO::Socket::UNIX;
+my ($path, $binary, @lines) = @ARGV;
+$SIG{PIPE} = "IGNORE";
+@lines = map { $_ eq "<oversized>" ? "1" x (17*1024*1024) : $_ } @lines;
+my $socket;
+for (1..100){ last if $socket = IO::Socket::UNIX->new(Type => SOCK_STREAM, Peer => $path); select(undef, undef, undef, 0.05); }
+die "connect failed\n" unless $socket;
+print $socket ($binary ? "\0".join("", map { pack("V", length $_).$_ } @lines) : join("", map { "$_\n" } @lines));
+shutdown($socket, 1);
+local $/;
+my $response = <$socket>;
+while ($binary && length $response){ my ($status, $size) = unpack("CV", $response); my $text = substr($response, 5, $size); $text =~ s/\n+$//; print "$status:$text\n"; $response = substr($response, 5+$size); }
+print $response unless $binary;'
+
+# Start a server and check that sessions are isolated and both protocols are answered
+printf "Running test: --serve=socket, text session a=3 a*2, text session a, oversized text session, binary session 2**10 f(x)\n"
+$mb_app $options --serve=$socket_file --workers=2 > /dev/null &
+server_pid=$!
+result=`perl -e "$client" $socket_file 0 "a=3" "a*2" "exit" | tr '\n' ' '`
+result+=`perl -e "$client" $socket_file 0 "a" | tr '\n' ' '`
+result+="[`perl -e "$client" $socket_file 0 "<oversized>"`] "
+result+=`perl -e "$client" $socket_file 1 "2**10" "f(x)" | tr '\n' ' '`
+kill -SIGTERM $server_pid
+wait $server_pid
+if [ -e $socket_file ]; then
+    result+="socket left behind"
+fi
+printf "Result: $result"
+if [ "$result" == "3 6 0 [] 0:1024 1:[Engine] ERROR: Undefined function \`f\` called! " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
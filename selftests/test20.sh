@@ -0,0 +1,52 @@
+#!/bin/bash
+#############################################################################
+# File name: test20.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Twentieth self test for console application.
+#  This test checks the bounded history, recalling entries and the history file.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent"
+history_file="/tmp/mbconsole_test20_$$.history"
+
+# Keep two lines in memory, recall one of them and check the spilled lines
+printf "Running test: --history=2 --history-file=file a=1 b=2 a+b history recall #2 recall #1, history file\n"
+rm -f $history_file
+result=`$mb_app $options --history=2 --history-file=$history_file --command="a=1\nb=2\na+b\nhistory\nrecall #2\nrecall #1\nexit" | tr '\n' ' '`
+result+=`cat $history_file | tr '\n' ' '`
+rm -f $history_file
+printf "Result: $result"
+if [ "$result" == "1 2 3 2 b=2 3 a+b 2 [ERROR] History entry 1 is not in memory a=1 b=2 a+b b=2 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
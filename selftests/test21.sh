@@ -0,0 +1,56 @@
+#!/bin/bash
+#############################################################################
+# File name: test21.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Twenty first self test for console application.
+#  This test checks that the asynchronous log holds the same lines as the log.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--piped-input"
+log_file="/tmp/mbconsole_test21_$$.log"
+async_log_file="/tmp/mbconsole_test21_$$.async.log"
+
+# Log the same session with and without the background writer
+printf "Running test: --log=file and --async-log --log=file for a=2, a*3, foo(\n"
+printf "a=2\na*3\nfoo(\nexit\n" | $mb_app $options --log=$log_file > /dev/null
+printf "a=2\na*3\nfoo(\nexit\n" | $mb_app $options --async-log --log=$async_log_file > /dev/null
+result=`cat $async_log_file | tr '\n' ' '`
+if ! cmp -s $log_file $async_log_file; then
+    result+="differs from the log"
+fi
+rm -f $log_file $async_log_file
+printf "Result: $result"
+if [ "$result" == "MB> a=2 2 MB> a*3 6 MB> foo( [Engine] ERROR: Unbalanced parentheses in expression \`foo(\`! MB> exit Exiting... " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
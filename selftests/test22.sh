@@ -0,0 +1,67 @@
+#!/bin/bash
+#############################################################################
+# File name: test22.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Twenty second self test for console application.
+#  This test checks recording a journal of a session and replaying it, and
+#  that an entry larger than the rest of the journal is a partial entry.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent"
+journal_file="/tmp/mbconsole_test22_$$.journal"
+
+# Record a session and replay it, every result has to match
+printf "Running test: --journal=file a=0.1, b=a*3, foo(, mode #int64, 2**62+1 then --replay=file\n"
+result=`$mb_app $options --journal=$journal_file --command="a=0.1\nb=a*3\nfoo(\nmode #int64\n2**62+1\nexit" | tr '\n' ' '`
+result+=`$mb_app $options --replay=$journal_file | sed -e 's/ in .* ms (recorded .* ms)//' | tr '\n' ' '`
+$mb_app $options --replay=$journal_file > /dev/null
+result+="exit code $?"
+rm -f $journal_file
+printf "Result: $result"
+if [ "$result" == "0.1 0.3 [Engine] ERROR: Unbalanced parentheses in expression \`foo(\`! [Info] Number mode: int64 4611686018427387905 [Info] Replayed 5 entries, 0 mismatch(es) exit code 0" ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+# An entry whose size does not fit in the rest of the file is a partial entry
+printf "Running test: --journal=file a=1, append a size of 4GB, --replay=file\n"
+result=`$mb_app $options --journal=$journal_file --command="a=1\nexit" | tr '\n' ' '`
+printf '\xff\xff\xff\xff\x01\x02' >> $journal_file
+result+=`$mb_app $options --replay=$journal_file 2>&1 | sed -e 's/ in .* ms (recorded .* ms)//' | tr '\n' ' '`
+rm -f $journal_file
+printf "Result: $result"
+if [ "$result" == "1 [WARNING] The journal ends in a partial entry (ignored) [Info] Replayed 1 entries, 0 mismatch(es) " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
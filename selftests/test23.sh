@@ -0,0 +1,58 @@
+#!/bin/bash
+#############################################################################
+# File name: test23.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Twenty third self test for console application.
+#  This test checks vectors evaluated element-wise and their reductions.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent"
+
+# Define a vector, evaluate expressions on it element-wise and reduce it
+printf "Running test: v=[1,2,3], w=v*2+1, v+w, sum(w), dot(v,w), max(v-w), [1,2]+[1,2,3]\n"
+result=`$mb_app $options --command="v=[1,2,3]\nw=v*2+1\nv+w\nsum(w)\ndot(v,w)\nmax(v-w)\n[1,2]+[1,2,3]\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "[1, 2, 3] [3, 5, 7] [4, 7, 10] 15 34 -2 [Engine] ERROR: The vectors used by \`[1,2]+[1,2,3]\` have different lengths (2 and 3)! " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+# Sums that overflow are infinite, not NaN
+printf "Running test: v=[1E+308,1E+308], sum(v), dot(v,v), sum([1,2]/0)\n"
+result=`$mb_app $options --command="v=[1E+308,1E+308]\nsum(v)\ndot(v,v)\nsum([1,2]/0)\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "[1e+308, 1e+308] inf inf inf " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
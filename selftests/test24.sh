@@ -0,0 +1,48 @@
+#!/bin/bash
+#############################################################################
+# File name: test24.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Twenty fourth self test for console application.
+#  This test checks matrices, their product and linear solves.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent"
+
+# Define a matrix, evaluate it element-wise, multiply, factor and solve
+printf "Running test: A=[[1,2],[3,4]], A*2, matmul(A,A), matmul(A,[1,1]), transpose(A), det(A), linsolve(A,[5,11]), inv(A), det([[1,2],[2,4]]), linsolve([[1,2],[2,4]],[1,1])\n"
+result=`$mb_app $options --command="A=[[1,2],[3,4]]\nA*2\nmatmul(A,A)\nmatmul(A,[1,1])\ntranspose(A)\ndet(A)\nlinsolve(A,[5,11])\ninv(A)\ndet([[1,2],[2,4]])\nlinsolve([[1,2],[2,4]],[1,1])\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "[[1, 2], [3, 4]] [[2, 4], [6, 8]] [[7, 10], [15, 22]] [3, 7] [[1, 3], [2, 4]] -2 [1, 2] [[-2, 1], [1.5, -0.5]] 0 [Engine] ERROR: The matrix used by \`linsolve([[1,2],[2,4]],[1,1])\` is singular! " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
@@ -0,0 +1,68 @@
+#!/bin/bash
+#############################################################################
+# File name: test25.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Twenty fifth self test for console application.
+#  This test checks the lazy conditional and short-circuit logical operators.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent"
+
+# Only the branch of if() taken is evaluated (so fib ends), && and || skip the right operand if the left one decides
+printf "Running test: if(1,2,3), if(0,2,3), if(0,1/0,5), 1||1/0, sum(i,1,1000,if(i%%3==0&&i%%5==0,i,0)), v=[0,1,2,3], if(v>1&&v<3,v,0-v), fib(n,o):o, fib(n,o):if(n>o,fib(n-o,o)+fib(n-o-o,o),n), fib(15,1), mode #int64, 0!=0&&10/0>1\n"
+result=`$mb_app $options --command="if(1,2,3)\nif(0,2,3)\nif(0,1/0,5)\n1||1/0\nsum(i,1,1000,if(i%3==0&&i%5==0,i,0))\nv=[0,1,2,3]\nif(v>1&&v<3,v,0-v)\nfib(n,o):o\nfib(n,o):if(n>o,fib(n-o,o)+fib(n-o-o,o),n)\nfib(15,1)\nmode #int64\n0!=0&&10/0>1\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "2 3 5 1 33165 [0, 1, 2, 3] [0, -1, 2, -3] [Info] Definition for function \`fib\` added [Info] Definition for function \`fib\` updated 610 [Info] Number mode: int64 0 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+# The calls right of && and || in a function body are only expanded if they decide the result (r never ends)
+printf "Running test: r(n):n, r(n):r(n), h(x,t=0.5):x>t&&r(x), h(0.1), g(x,t=0.5):x<t||r(x), g(0.1), k(x):x||x&&r(x), k(0), k(2)\n"
+result=`$mb_app $options --command="r(n):n\nr(n):r(n)\nh(x,t=0.5):x>t&&r(x)\nh(0.1)\ng(x,t=0.5):x<t||r(x)\ng(0.1)\nk(x):x||x&&r(x)\nk(0)\nk(2)\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "[Info] Definition for function \`r\` added [Info] Definition for function \`r\` updated [Info] Definition for function \`h\` added 0 [Info] Definition for function \`g\` added 1 [Info] Definition for function \`k\` added 0 1 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+# The errors of the condition are reported and the condition is evaluated in the number mode
+printf "Running test: if(1+,2,3), if(3@4,2,3), mode #int64, if(9007199254740993==9007199254740992,1,2)\n"
+result=`$mb_app $options --command="if(1+,2,3)\nif(3@4,2,3)\nmode #int64\nif(9007199254740993==9007199254740992,1,2)\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "[Evaluator] ERROR: Operator + requires 2 operands however only one (1.000000) was given! [Evaluator] ERROR: Unsupported operator \`@\`! You can use the \`help\` command to get a list of supported operators. [Info] Number mode: int64 2 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit
@@ -0,0 +1,49 @@
+#!/bin/bash
+#############################################################################
+# File name: test26.sh
+# Version: v1.0
+# Dev: GitHub@Rr42
+# License:
+#  Copyright 2023 Ramana R
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# Description:
+#  Twenty sixth self test for console application.
+#  This test checks the limit on the size of expanded function calls.
+#############################################################################
+
+# Check if the console application name+path was passed
+if [[ -z $1 ]]; then
+    printf "Application name not provided!\n"
+    exit
+else
+    mb_app=$1
+    printf "Testing $mb_app\n"
+fi
+# Execution options
+options="--silent"
+
+# Every nested call of f repeats its argument four times, 14 levels grow past the expansion limit
+deep="f(f(f(f(f(f(f(f(f(f(f(f(f(f(1))))))))))))))"
+printf "Running test: f(x):if(x,x+x+x+x,x), f(...) 14 levels deep, f(...) 8 levels deep\n"
+result=`$mb_app $options --command="f(x):if(x,x+x+x+x,x)\n$deep\nf(f(f(f(f(f(f(f(1))))))))\nexit" | tr '\n' ' '`
+printf "Result: $result"
+if [ "$result" == "[Info] Definition for function \`f\` added [Engine] ERROR: The expression grows beyond 67108864 bytes once its function calls are expanded! 65536 " ]; then
+    printf " - PASS\n"
+else
+    printf " - FAIL\n"
+fi
+
+printf "Cleaning up...\n"
+pkill -SIGKILL mbconsole
+exit